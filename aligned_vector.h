@@ -0,0 +1,439 @@
+/***********************************************************************
+ * Header:
+ *    ALIGNED VECTOR
+ * Summary:
+ *    A version of our custom vector whose buffer always starts on an
+ *    Align-byte boundary (a cache line or a SIMD register) and whose
+ *    capacity is always a whole number of Align-byte blocks. A SIMD loop
+ *    can therefore use aligned loads and run through padded_size()
+ *    without a scalar remainder loop.
+ *
+ *    This will contain the class definition of:
+ *        aligned_vector          : A vector with an aligned, padded buffer
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>  // because I am paranoid
+#include <cstddef>  // for size_t
+#include <cstdlib>  // for posix_memalign and free
+#include <new>      // std::bad_alloc and placement new
+#include <utility>  // for std::move and std::swap
+#include <initializer_list>
+
+#ifdef _WIN32
+#include <malloc.h> // for _aligned_malloc
+#endif
+
+#include "vector.h" // for vector::iterator
+
+namespace custom
+{
+
+/*****************************************
+ * ALLOCATE ALIGNED
+ * Get numBytes of raw memory starting on
+ * an align-byte boundary
+ ****************************************/
+inline void * allocate_aligned(size_t numBytes, size_t align)
+{
+   void * p = nullptr;
+#ifdef _WIN32
+   p = _aligned_malloc(numBytes, align);
+#else
+   // posix_memalign() insists on at least pointer alignment
+   if (align < sizeof(void *))
+      align = sizeof(void *);
+   if (posix_memalign(&p, align, numBytes) != 0)
+      p = nullptr;
+#endif
+   if (p == nullptr)
+      throw std::bad_alloc();
+   return p;
+}
+
+/*****************************************
+ * FREE ALIGNED
+ * Give back memory from allocate_aligned()
+ ****************************************/
+inline void free_aligned(void * p)
+{
+#ifdef _WIN32
+   _aligned_free(p);
+#else
+   free(p);
+#endif
+}
+
+/*****************************************
+ * ALIGNED VECTOR
+ * Just like our vector, but the buffer is
+ * aligned to Align bytes and the capacity is
+ * rounded up to a multiple of lanes().
+ *
+ * Every slot from size() up to capacity()
+ * holds T(), so a kernel that runs to
+ * padded_size() sees zeros in the tail.
+ ****************************************/
+template <typename T, size_t Align = 64>
+class aligned_vector
+{
+   static_assert(Align != 0 && (Align & (Align - 1)) == 0,
+                 "alignment must be a power of two");
+   static_assert(Align >= alignof(T),
+                 "alignment must be at least alignof(T)");
+
+public:
+
+   //
+   // Construct
+   //
+
+   aligned_vector();
+   aligned_vector(size_t numElements                );
+   aligned_vector(size_t numElements, const T & t   );
+   aligned_vector(const std::initializer_list<T> & l);
+   aligned_vector(const aligned_vector &  rhs);
+   aligned_vector(      aligned_vector && rhs);
+   ~aligned_vector();
+
+   //
+   // Assign
+   //
+
+   void swap(aligned_vector & rhs)
+   {
+      std::swap(data,        rhs.data);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numCapacity, rhs.numCapacity);
+   }
+   aligned_vector & operator = (const aligned_vector &  rhs);
+   aligned_vector & operator = (      aligned_vector && rhs);
+
+   //
+   // Iterator
+   //
+
+   typedef typename vector<T>::iterator iterator;
+   iterator begin() { return iterator(data);               }
+   iterator end()   { return iterator(data + numElements); }
+
+   //
+   // Access
+   //
+
+         T & operator [] (size_t index)       { return data[index]; }
+   const T & operator [] (size_t index) const { return data[index]; }
+         T & front()                          { return data[0];     }
+   const T & front()                    const { return data[0];     }
+         T & back()                           { return data[numElements - 1]; }
+   const T & back()                     const { return data[numElements - 1]; }
+
+   // the buffer, with a promise to the optimizer about its alignment
+         T * assume_aligned()       { return assumeAligned(data); }
+   const T * assume_aligned() const { return assumeAligned(data); }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T &  t);
+   void push_back(      T && t);
+   void reserve(size_t newCapacity);
+   void resize(size_t newElements);
+   void resize(size_t newElements, const T & t);
+
+   //
+   // Remove
+   //
+
+   void clear()
+   {
+      for (size_t i = 0; i < numElements; i++)
+         data[i] = T();
+      numElements = 0;
+   }
+   void pop_back()
+   {
+      if (numElements > 0)
+         data[--numElements] = T();
+   }
+   void shrink_to_fit();
+
+   //
+   // Status
+   //
+
+   size_t size()        const { return numElements;      }
+   size_t capacity()    const { return numCapacity;      }
+   bool   empty()       const { return numElements == 0; }
+   size_t padded_size() const { return roundUp(numElements); }
+
+   // how many elements fit in one Align-byte block
+   static constexpr size_t lanes()
+   {
+      return Align / sizeof(T) == 0 ? 1 : Align / sizeof(T);
+   }
+   static constexpr size_t alignment() { return Align; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   static size_t roundUp(size_t num)
+   {
+      return (num + lanes() - 1) / lanes() * lanes();
+   }
+   static T * assumeAligned(T * p)
+   {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<T *>(__builtin_assume_aligned(p, Align));
+#else
+      return p;
+#endif
+   }
+   static const T * assumeAligned(const T * p)
+   {
+      return assumeAligned(const_cast<T *>(p));
+   }
+
+   void reallocate(size_t newCapacity);
+   static T *  allocate(size_t capacity);
+   static void release(T * p, size_t capacity);
+
+   T *     data;              // user data, aligned to Align bytes
+   size_t  numCapacity;       // the capacity of the array, a multiple of lanes()
+   size_t  numElements;       // the number of items currently used
+};
+
+/*****************************************
+ * ALIGNED VECTOR :: DEFAULT constructor
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector() :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+}
+
+/*****************************************
+ * ALIGNED VECTOR :: NON-DEFAULT constructors
+ * Allocate room for num (rounded up to a whole
+ * block) and fill with T() or with t
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector(size_t num) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   resize(num);
+}
+
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector(size_t num, const T & t) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   resize(num, t);
+}
+
+/*****************************************
+ * ALIGNED VECTOR :: INITIALIZATION LIST constructor
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector(const std::initializer_list<T> & l) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   reserve(l.size());
+   for (const T & item : l)
+      data[numElements++] = item;
+}
+
+/*****************************************
+ * ALIGNED VECTOR :: COPY CONSTRUCTOR
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector(const aligned_vector & rhs) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   *this = rhs;
+}
+
+/*****************************************
+ * ALIGNED VECTOR :: MOVE CONSTRUCTOR
+ * Steal the buffer from the RHS
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: aligned_vector(aligned_vector && rhs) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   swap(rhs);
+}
+
+/*****************************************
+ * ALIGNED VECTOR :: DESTRUCTOR
+ ****************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> :: ~aligned_vector()
+{
+   release(data, numCapacity);
+}
+
+/***************************************
+ * ALIGNED VECTOR :: ASSIGNMENT
+ **************************************/
+template <typename T, size_t Align>
+aligned_vector <T, Align> &
+aligned_vector <T, Align> :: operator = (const aligned_vector & rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   clear();
+   reserve(rhs.numElements);
+   for (size_t i = 0; i < rhs.numElements; i++)
+      data[i] = rhs.data[i];
+   numElements = rhs.numElements;
+   return *this;
+}
+
+template <typename T, size_t Align>
+aligned_vector <T, Align> &
+aligned_vector <T, Align> :: operator = (aligned_vector && rhs)
+{
+   aligned_vector empty;
+   swap(rhs);
+   rhs.swap(empty);   // our old buffer is freed with "empty"
+   return *this;
+}
+
+/***************************************
+ * ALIGNED VECTOR :: PUSH BACK
+ * Doubles the capacity, which stays a
+ * multiple of lanes()
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: push_back(const T & t)
+{
+   if (numElements == numCapacity)
+      reserve(numCapacity == 0 ? 1 : numCapacity * 2);
+   data[numElements++] = t;
+}
+
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: push_back(T && t)
+{
+   if (numElements == numCapacity)
+      reserve(numCapacity == 0 ? 1 : numCapacity * 2);
+   data[numElements++] = std::move(t);
+}
+
+/***************************************
+ * ALIGNED VECTOR :: RESERVE
+ * Grow to at least newCapacity, rounded
+ * up to a whole block
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: reserve(size_t newCapacity)
+{
+   if (newCapacity <= numCapacity)
+      return;
+   reallocate(roundUp(newCapacity));
+}
+
+/***************************************
+ * ALIGNED VECTOR :: RESIZE
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: resize(size_t newElements)
+{
+   resize(newElements, T());
+}
+
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: resize(size_t newElements, const T & t)
+{
+   reserve(newElements);
+
+   // keep the tail full of T() when we shrink
+   for (size_t i = newElements; i < numElements; i++)
+      data[i] = T();
+   for (size_t i = numElements; i < newElements; i++)
+      data[i] = t;
+   numElements = newElements;
+}
+
+/***************************************
+ * ALIGNED VECTOR :: SHRINK TO FIT
+ * Drop any whole blocks we are not using
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: shrink_to_fit()
+{
+   if (numElements == 0)
+   {
+      release(data, numCapacity);
+      data = nullptr;
+      numCapacity = 0;
+      return;
+   }
+
+   if (roundUp(numElements) < numCapacity)
+      reallocate(roundUp(numElements));
+}
+
+/***************************************
+ * ALIGNED VECTOR :: REALLOCATE
+ * Move into a new buffer of exactly newCapacity
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: reallocate(size_t newCapacity)
+{
+   T * dataNew = allocate(newCapacity);
+   for (size_t i = 0; i < numElements; i++)
+      dataNew[i] = std::move(data[i]);
+
+   release(data, numCapacity);
+   data = dataNew;
+   numCapacity = newCapacity;
+}
+
+/***************************************
+ * ALIGNED VECTOR :: ALLOCATE
+ * Like new T[capacity], but aligned
+ **************************************/
+template <typename T, size_t Align>
+T * aligned_vector <T, Align> :: allocate(size_t capacity)
+{
+   T * p = static_cast<T *>(allocate_aligned(capacity * sizeof(T), Align));
+
+   size_t i = 0;
+   try
+   {
+      for (; i < capacity; i++)
+         new (p + i) T();
+   }
+   catch (...)
+   {
+      release(p, i);
+      throw;
+   }
+   return p;
+}
+
+/***************************************
+ * ALIGNED VECTOR :: RELEASE
+ * Like delete [] p
+ **************************************/
+template <typename T, size_t Align>
+void aligned_vector <T, Align> :: release(T * p, size_t capacity)
+{
+   if (p == nullptr)
+      return;
+   for (size_t i = 0; i < capacity; i++)
+      p[i].~T();
+   free_aligned(p);
+}
+
+} // namespace custom
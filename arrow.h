@@ -0,0 +1,1099 @@
+/***********************************************************************
+ * Header:
+ *    ARROW
+ * Summary:
+ *    Hand a vector to an Apache Arrow library, or take one back, without
+ *    copying it, and read or write Arrow IPC files without linking Arrow.
+ *
+ *    In memory we speak the Arrow C data interface: an ArrowArray whose
+ *    buffers are a validity bitmap (null here: a vector has no nulls)
+ *    and the values. export_arrow() gives the vector's own buffer away;
+ *    import_arrow() takes someone else's into a vector, and arrow_view
+ *    looks at it in place, nulls and all.
+ *
+ *    On the disk we speak the Arrow IPC file format:
+ *       +---------+--------+---------------+-----+-----+--------+--------+
+ *       | ARROW1  | schema | record batch  | ... | end | footer | length |
+ *       | padding | message| message       |     |     |        | ARROW1 |
+ *       +---------+--------+---------------+-----+-----+--------+--------+
+ *    Every message is a FlatBuffers table of metadata followed by a body
+ *    of 8-byte aligned buffers. Only the FlatBuffers we need are here.
+ *
+ *    Arrow types we know: int8 through int64, uint8 through uint64,
+ *    float, and double, with no nulls.
+ *
+ *    This will contain:
+ *        ArrowSchema, ArrowArray : The Arrow C data interface
+ *        export_arrow            : Give a vector's buffer to Arrow
+ *        import_arrow            : Take Arrow's buffer into a vector
+ *        arrow_view              : Read an Arrow array in place
+ *        arrow_file_writer       : Write vectors as an Arrow IPC file
+ *        arrow_file_reader       : Read vectors from an Arrow IPC file
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // because I am paranoid
+#include <cstdint>     // for int64_t and friends
+#include <cstring>     // for memcpy and memcmp
+#include <stdexcept>   // for std::runtime_error
+#include <string>
+#include <vector>      // for the FlatBuffers and the footer
+
+#include "serialize.h" // for readAll and writeAll
+#include "vector.h"
+
+/*****************************************
+ * THE ARROW C DATA INTERFACE
+ * Exactly as the Arrow spec has it, guarded
+ * the same way, so these agree with Arrow's
+ * own headers if both are included
+ ****************************************/
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C"
+{
+struct ArrowSchema
+{
+   const char *          format;
+   const char *          name;
+   const char *          metadata;
+   int64_t               flags;
+   int64_t               n_children;
+   struct ArrowSchema ** children;
+   struct ArrowSchema *  dictionary;
+   void (*release)(struct ArrowSchema *);
+   void *                private_data;
+};
+
+struct ArrowArray
+{
+   int64_t              length;
+   int64_t              null_count;
+   int64_t              offset;
+   int64_t              n_buffers;
+   int64_t              n_children;
+   const void **        buffers;
+   struct ArrowArray ** children;
+   struct ArrowArray *  dictionary;
+   void (*release)(struct ArrowArray *);
+   void *               private_data;
+};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace custom
+{
+
+/*****************************************
+ * ARROW TYPE
+ * What Arrow calls T: its format string for
+ * the C data interface, and its Int or
+ * FloatingPoint description for IPC files
+ ****************************************/
+template <typename T>
+struct arrow_type;
+
+#define CUSTOM_ARROW_INT(T, FORMAT, BITS, SIGNED)                  \
+   template <> struct arrow_type<T>                                \
+   {                                                               \
+      static const char * format()  { return FORMAT; }             \
+      enum { IS_FLOAT = false, BIT_WIDTH = BITS, IS_SIGNED = SIGNED }; \
+   };
+CUSTOM_ARROW_INT(int8_t,   "c",  8, true)
+CUSTOM_ARROW_INT(uint8_t,  "C",  8, false)
+CUSTOM_ARROW_INT(int16_t,  "s", 16, true)
+CUSTOM_ARROW_INT(uint16_t, "S", 16, false)
+CUSTOM_ARROW_INT(int32_t,  "i", 32, true)
+CUSTOM_ARROW_INT(uint32_t, "I", 32, false)
+CUSTOM_ARROW_INT(int64_t,  "l", 64, true)
+CUSTOM_ARROW_INT(uint64_t, "L", 64, false)
+#undef CUSTOM_ARROW_INT
+
+template <> struct arrow_type<float>
+{
+   static const char * format() { return "f"; }
+   enum { IS_FLOAT = true, BIT_WIDTH = 32, IS_SIGNED = true };
+};
+template <> struct arrow_type<double>
+{
+   static const char * format() { return "g"; }
+   enum { IS_FLOAT = true, BIT_WIDTH = 64, IS_SIGNED = true };
+};
+
+/*****************************************
+ * ARROW EXPORT
+ * What an exported ArrowArray owns: the
+ * vector itself and the buffer list
+ ****************************************/
+template <typename T>
+struct arrow_export
+{
+   vector<T>    values;
+   const void * buffers[2];
+
+   static void releaseArray(ArrowArray * array)
+   {
+      delete static_cast<arrow_export *>(array->private_data);
+      array->release = nullptr;
+   }
+   static void releaseSchema(ArrowSchema * schema)
+   {
+      schema->release = nullptr;
+   }
+};
+
+/*****************************************
+ * EXPORT ARROW
+ * Give v's buffer to Arrow. v is left empty;
+ * the buffer is freed when Arrow calls
+ * array->release(). No element is copied.
+ ****************************************/
+template <typename T>
+void export_arrow(vector<T> & v, ArrowArray * array, ArrowSchema * schema = nullptr)
+{
+   arrow_export<T> * pExport = new arrow_export<T>;
+   pExport->values.swap(v);
+   pExport->buffers[0] = nullptr;   // no validity bitmap: nothing is null
+   pExport->buffers[1] = pExport->values.size() ? &pExport->values[0] : nullptr;
+
+   array->length       = int64_t(pExport->values.size());
+   array->null_count   = 0;
+   array->offset       = 0;
+   array->n_buffers    = 2;
+   array->n_children   = 0;
+   array->buffers      = pExport->buffers;
+   array->children     = nullptr;
+   array->dictionary   = nullptr;
+   array->release      = &arrow_export<T>::releaseArray;
+   array->private_data = pExport;
+
+   if (schema != nullptr)
+   {
+      schema->format       = arrow_type<T>::format();
+      schema->name         = "";
+      schema->metadata     = nullptr;
+      schema->flags        = 0;
+      schema->n_children   = 0;
+      schema->children     = nullptr;
+      schema->dictionary   = nullptr;
+      schema->release      = &arrow_export<T>::releaseSchema;
+      schema->private_data = nullptr;
+   }
+}
+
+/*****************************************
+ * ARROW VIEW
+ * Read an Arrow array of T where it sits.
+ * The view takes the array over, and
+ * releases it when the view goes away.
+ ****************************************/
+template <typename T>
+class arrow_view
+{
+public:
+   //
+   // Construct
+   //
+
+   arrow_view(ArrowArray * pArray, const ArrowSchema * pSchema = nullptr);
+   arrow_view(const arrow_view & rhs) = delete;
+   arrow_view & operator = (const arrow_view & rhs) = delete;
+   ~arrow_view()
+   {
+      if (array.release != nullptr)
+         array.release(&array);
+   }
+
+   //
+   // Access
+   //
+
+   const T & operator [] (size_t index) const { return values[index]; }
+   const T * begin()                    const { return values;        }
+   const T * end()                      const { return values + size(); }
+   bool is_valid(size_t index) const
+   {
+      if (validity == nullptr)
+         return true;
+      size_t bit = size_t(array.offset) + index;
+      return (validity[bit / 8] >> (bit % 8)) & 1;
+   }
+
+   // copy the elements out into a vector of our own
+   void copy_to(vector<T> & v) const
+   {
+      v.resize(size(), T());
+      if (size())
+         memcpy(&v[0], values, size() * sizeof(T));
+   }
+
+   //
+   // Status
+   //
+
+   size_t size()       const { return size_t(array.length); }
+   bool   empty()      const { return array.length == 0;    }
+   size_t null_count() const;
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   ArrowArray            array;      // our copy of the array, which we now own
+   const T *             values;     // the values buffer, offset applied
+   const unsigned char * validity;   // the validity bitmap, or null
+};
+
+/*****************************************
+ * ARROW VIEW :: CONSTRUCTOR
+ * Move the array into the view, the way the
+ * C data interface moves arrays: copy the
+ * struct and mark the original released
+ ****************************************/
+template <typename T>
+arrow_view <T> :: arrow_view(ArrowArray * pArray, const ArrowSchema * pSchema)
+{
+   if (pArray == nullptr || pArray->release == nullptr)
+      throw std::runtime_error("arrow: the array was already released");
+   array = *pArray;
+   pArray->release = nullptr;
+
+   if ((pSchema != nullptr && strcmp(pSchema->format, arrow_type<T>::format()) != 0) ||
+       array.n_buffers != 2 || array.n_children != 0 || array.length < 0 || array.offset < 0 ||
+       (array.length > 0 && array.buffers[1] == nullptr))
+   {
+      array.release(&array);
+      throw std::runtime_error("arrow: not an array of this type");
+   }
+
+   values   = static_cast<const T *>(array.buffers[1]);
+   values   = values ? values + array.offset : nullptr;
+   validity = static_cast<const unsigned char *>(array.buffers[0]);
+}
+
+/*****************************************
+ * ARROW VIEW :: NULL COUNT
+ * Arrow may say -1: "count them yourself"
+ ****************************************/
+template <typename T>
+size_t arrow_view <T> :: null_count() const
+{
+   if (validity == nullptr)
+      return 0;
+   if (array.null_count >= 0)
+      return size_t(array.null_count);
+   size_t num = 0;
+   for (size_t i = 0; i < size(); i++)
+      if (!is_valid(i))
+         num++;
+   return num;
+}
+
+/*****************************************
+ * ARROW IMPORT
+ * The deleter of an imported vector. The
+ * context is the array, moved to the heap,
+ * and releasing it frees the buffer.
+ ****************************************/
+template <typename T>
+struct arrow_import
+{
+   static void releaseArray(T *, void * context)
+   {
+      ArrowArray * pArray = static_cast<ArrowArray *>(context);
+      if (pArray->release != nullptr)
+         pArray->release(pArray);
+      delete pArray;
+   }
+};
+
+/*****************************************
+ * IMPORT ARROW
+ * Take an Arrow array into a vector without
+ * copying: the vector adopts the values
+ * buffer, offset applied, and releases the
+ * array when it lets the buffer go, which
+ * growing it will. array is moved from, even
+ * when it is refused. A vector has no nulls,
+ * so an array with any is refused; read
+ * those with arrow_view.
+ ****************************************/
+template <typename T>
+vector<T> import_arrow(ArrowArray && array, const ArrowSchema * pSchema = nullptr)
+{
+   if (array.release == nullptr)
+      throw std::runtime_error("arrow: the array was already released");
+   ArrowArray * pArray = new ArrowArray(array);
+   array.release = nullptr;
+
+   const T * values = nullptr;
+   bool ok = (pSchema == nullptr || strcmp(pSchema->format, arrow_type<T>::format()) == 0) &&
+             pArray->n_buffers == 2 && pArray->n_children == 0 &&
+             pArray->length >= 0 && pArray->offset >= 0 &&
+             (pArray->length == 0 || pArray->buffers[1] != nullptr);
+   if (ok && pArray->length > 0)
+   {
+      values = static_cast<const T *>(pArray->buffers[1]) + pArray->offset;
+      ok = reinterpret_cast<uintptr_t>(values) % alignof(T) == 0;
+   }
+
+   // any null at all, counted if Arrow did not say
+   const unsigned char * validity = ok && pArray->length > 0 ?
+      static_cast<const unsigned char *>(pArray->buffers[0]) : nullptr;
+   if (validity != nullptr && pArray->null_count != 0)
+      for (int64_t i = 0; ok && i < pArray->length; i++)
+      {
+         int64_t bit = pArray->offset + i;
+         ok = (validity[bit / 8] >> (bit % 8)) & 1;
+      }
+
+   if (!ok || values == nullptr)
+   {
+      arrow_import<T>::releaseArray(nullptr, pArray);
+      if (!ok)
+         throw std::runtime_error("arrow: not an array of this type without nulls");
+      return vector<T>();
+   }
+
+   vector<T> v;
+   v.adopt(const_cast<T *>(values), size_t(pArray->length), size_t(pArray->length),
+           &arrow_import<T>::releaseArray, pArray);
+   return v;
+}
+
+/*****************************************
+ * ARROW DETAIL
+ * The pieces of FlatBuffers and of the Arrow
+ * schema that the IPC file format needs
+ ****************************************/
+namespace arrow_detail
+{
+   // from Arrow's Schema.fbs and Message.fbs
+   enum { METADATA_V5 = 4 };
+   enum { HEADER_SCHEMA = 1, HEADER_RECORD_BATCH = 3 };
+   enum { TYPE_INT = 2, TYPE_FLOATING_POINT = 3 };
+   enum { PRECISION_SINGLE = 1, PRECISION_DOUBLE = 2 };
+
+   // the Block, FieldNode, and Buffer structs
+   struct block
+   {
+      int64_t offset;
+      int32_t metaDataLength;
+      int32_t padding;
+      int64_t bodyLength;
+   };
+   struct field_node
+   {
+      int64_t length;
+      int64_t nullCount;
+   };
+   struct buffer
+   {
+      int64_t offset;
+      int64_t length;
+   };
+
+   inline size_t padTo8(size_t n) { return (n + 7) / 8 * 8; }
+
+   /*****************************************
+    * FLATBUFFER BUILDER
+    * Like the FlatBuffers library, this builds
+    * from the back of the buffer toward the
+    * front, so whatever a table points to is
+    * finished before the table starts. An
+    * object is known by its distance from the
+    * back of the buffer.
+    ****************************************/
+   class fb_builder
+   {
+   public:
+      fb_builder() : buf(256), head(256), minAlign(1), tableStart(0) { }
+
+      const uint8_t * data() const { return &buf[head];         }
+      uint32_t        size() const { return uint32_t(buf.size() - head); }
+
+      // a scalar, a string, or a vector of structs or of tables
+      template <typename S>
+      uint32_t scalar(S s)
+      {
+         align(sizeof(S), sizeof(S));
+         push(&s, sizeof(S));
+         return size();
+      }
+      uint32_t string(const std::string & s)
+      {
+         align(s.size() + 1, 4);
+         push("", 1);
+         push(s.data(), s.size());
+         return scalar(uint32_t(s.size()));
+      }
+      template <typename S>
+      uint32_t structs(const S * p, size_t num)
+      {
+         align(num * sizeof(S), 4);
+         align(num * sizeof(S), alignof(S));
+         push(p, num * sizeof(S));
+         return scalar(uint32_t(num));
+      }
+      uint32_t tables(const uint32_t * objects, size_t num)
+      {
+         align(num * 4, 4);
+         for (size_t i = num; i > 0; i--)
+            refer(objects[i - 1]);
+         return scalar(uint32_t(num));
+      }
+
+      // a table: start it, add its fields, end it
+      void startTable()
+      {
+         fields.clear();
+         tableStart = size();
+      }
+      template <typename S>
+      void add(uint16_t id, S s)
+      {
+         fields.push_back(field(id, scalar(s)));
+      }
+      void addObject(uint16_t id, uint32_t object)
+      {
+         fields.push_back(field(id, refer(object)));
+      }
+      uint32_t endTable()
+      {
+         uint32_t object = scalar(int32_t(0));   // soon the distance to the vtable
+
+         // the vtable: its size, the table's size, and where each field is
+         uint16_t numSlots = 0;
+         for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i].id + 1 > numSlots)
+               numSlots = uint16_t(fields[i].id + 1);
+         std::vector<uint16_t> vtable(2 + numSlots, 0);
+         vtable[0] = uint16_t(vtable.size() * 2);
+         vtable[1] = uint16_t(object - tableStart);
+         for (size_t i = 0; i < fields.size(); i++)
+            vtable[2 + fields[i].id] = uint16_t(object - fields[i].position);
+         push(&vtable[0], vtable.size() * 2);
+
+         int32_t toVtable = int32_t(size() - object);
+         memcpy(&buf[buf.size() - object], &toVtable, 4);
+         return object;
+      }
+
+      // point at the root table; the buffer is done
+      void finish(uint32_t root)
+      {
+         align(4, minAlign > 4 ? minAlign : 4);
+         refer(root);
+      }
+
+   private:
+      struct field
+      {
+         field(uint16_t id, uint32_t position) : id(id), position(position) { }
+         uint16_t id;
+         uint32_t position;
+      };
+
+      // an offset to an object already in the buffer
+      uint32_t refer(uint32_t object)
+      {
+         align(4, 4);
+         return scalar(uint32_t(size() + 4 - object));
+      }
+
+      // pad so that numBytes from now we are on an alignment boundary
+      void align(size_t numBytes, size_t alignment)
+      {
+         if (alignment > minAlign)
+            minAlign = alignment;
+         static const uint8_t zeros[8] = {};
+         push(zeros, (alignment - (size() + numBytes) % alignment) % alignment);
+      }
+
+      void push(const void * p, size_t numBytes)
+      {
+         if (numBytes > head)
+         {
+            // double the buffer, keeping what we have at the back
+            size_t used = size();
+            size_t newSize = buf.size() * 2 > used + numBytes ? buf.size() * 2 : used + numBytes;
+            std::vector<uint8_t> bufNew(newSize);
+            if (used)
+               memcpy(&bufNew[newSize - used], &buf[head], used);
+            buf.swap(bufNew);
+            head = newSize - used;
+         }
+         head -= numBytes;
+         if (numBytes)
+            memcpy(&buf[head], p, numBytes);
+      }
+
+      std::vector<uint8_t> buf;          // the finished part is buf[head, end)
+      size_t               head;
+      size_t               minAlign;     // the biggest alignment we have used
+      uint32_t             tableStart;   // where the open table's fields start
+      std::vector<field>   fields;       // the open table's fields
+   };
+
+   /*****************************************
+    * FLATBUFFER TABLE
+    * Read a table out of a FlatBuffer, checking
+    * every offset against the end of the buffer
+    ****************************************/
+   class fb_table
+   {
+   public:
+      // the root table of a whole buffer
+      fb_table(const uint8_t * base, size_t numBytes) : base(base), numBytes(numBytes), position(0)
+      {
+         position = read<uint32_t>(0);
+      }
+
+      bool has(uint16_t id) const { return slot(id) != 0; }
+
+      template <typename S>
+      S get(uint16_t id, S value) const
+      {
+         size_t offset = slot(id);
+         return offset ? read<S>(position + offset) : value;
+      }
+      fb_table table(uint16_t id) const
+      {
+         return fb_table(base, numBytes, follow(id));
+      }
+      std::string string(uint16_t id) const
+      {
+         size_t p = follow(id);
+         size_t len = read<uint32_t>(p);
+         check(p + 4, len);
+         return std::string(reinterpret_cast<const char *>(base + p + 4), len);
+      }
+
+      // a vector: how long it is, and its elements
+      size_t length(uint16_t id) const
+      {
+         return has(id) ? read<uint32_t>(follow(id)) : 0;
+      }
+      template <typename S>
+      S structAt(uint16_t id, size_t index) const
+      {
+         size_t p = follow(id);
+         if (index >= read<uint32_t>(p))
+            throw std::runtime_error("arrow: damaged metadata");
+         return read<S>(p + 4 + index * sizeof(S));
+      }
+      fb_table tableAt(uint16_t id, size_t index) const
+      {
+         size_t p = follow(id);
+         if (index >= read<uint32_t>(p))
+            throw std::runtime_error("arrow: damaged metadata");
+         p += 4 + index * 4;
+         return fb_table(base, numBytes, p + read<uint32_t>(p));
+      }
+
+   private:
+      fb_table(const uint8_t * base, size_t numBytes, size_t position) :
+         base(base), numBytes(numBytes), position(position) { }
+
+      void check(size_t p, size_t len) const
+      {
+         if (p > numBytes || len > numBytes - p)
+            throw std::runtime_error("arrow: damaged metadata");
+      }
+      template <typename S>
+      S read(size_t p) const
+      {
+         check(p, sizeof(S));
+         S s;
+         memcpy(&s, base + p, sizeof(S));
+         return s;
+      }
+
+      // where the field is, from the start of the table, or 0 if it is absent
+      size_t slot(uint16_t id) const
+      {
+         size_t vtable = size_t(int64_t(position) - read<int32_t>(position));
+         uint16_t vtableSize = read<uint16_t>(vtable);
+         if (4u + 2u * id >= vtableSize)
+            return 0;
+         return read<uint16_t>(vtable + 4 + 2 * id);
+      }
+      size_t follow(uint16_t id) const
+      {
+         size_t offset = slot(id);
+         if (offset == 0)
+            throw std::runtime_error("arrow: damaged metadata");
+         size_t p = position + offset;
+         return p + read<uint32_t>(p);
+      }
+
+      const uint8_t * base;
+      size_t          numBytes;
+      size_t          position;   // where the table starts
+   };
+
+   /*****************************************
+    * SCHEMA
+    * One non-nullable column of T
+    ****************************************/
+   template <typename T>
+   uint32_t schema(fb_builder & b, const std::string & columnName)
+   {
+      uint8_t typeType;
+      b.startTable();
+      if (arrow_type<T>::IS_FLOAT)
+      {
+         typeType = TYPE_FLOATING_POINT;
+         b.add<int16_t>(0, arrow_type<T>::BIT_WIDTH == 32 ? PRECISION_SINGLE : PRECISION_DOUBLE);
+      }
+      else
+      {
+         typeType = TYPE_INT;
+         b.add<int32_t>(0, arrow_type<T>::BIT_WIDTH);
+         b.add<uint8_t>(1, arrow_type<T>::IS_SIGNED);
+      }
+      uint32_t type = b.endTable();
+      uint32_t name = b.string(columnName);
+      uint32_t children = b.tables(nullptr, 0);   // Arrow wants it, even empty
+
+      b.startTable();
+      b.addObject(0, name);
+      b.add<uint8_t>(1, 0);          // nullable: no
+      b.add<uint8_t>(2, typeType);
+      b.addObject(3, type);
+      b.addObject(5, children);
+      uint32_t field = b.endTable();
+      uint32_t fields = b.tables(&field, 1);
+
+      b.startTable();
+      b.add<int16_t>(0, 0);          // little endian
+      b.addObject(1, fields);
+      return b.endTable();
+   }
+
+   // does this Field describe T?
+   template <typename T>
+   bool isType(const fb_table & field)
+   {
+      uint8_t typeType = field.get<uint8_t>(2, 0);
+      if (!field.has(3))
+         return false;
+      fb_table type = field.table(3);
+      if (arrow_type<T>::IS_FLOAT)
+         return typeType == TYPE_FLOATING_POINT &&
+                type.get<int16_t>(0, 0) ==
+                   (arrow_type<T>::BIT_WIDTH == 32 ? PRECISION_SINGLE : PRECISION_DOUBLE);
+      return typeType == TYPE_INT &&
+             type.get<int32_t>(0, 0) == arrow_type<T>::BIT_WIDTH &&
+             bool(type.get<uint8_t>(1, 0)) == bool(arrow_type<T>::IS_SIGNED);
+   }
+
+   // a Message around a Schema or a RecordBatch
+   inline void message(fb_builder & b, uint8_t headerType, uint32_t header, int64_t bodyLength)
+   {
+      b.startTable();
+      b.add<int16_t>(0, METADATA_V5);
+      b.add<uint8_t>(1, headerType);
+      b.addObject(2, header);
+      b.add<int64_t>(3, bodyLength);
+      b.finish(b.endTable());
+   }
+
+   // the Arrow files we make and read are little endian
+   inline void checkEndian()
+   {
+      const uint32_t one = 1;
+      if (*reinterpret_cast<const uint8_t *>(&one) != 1)
+         throw std::runtime_error("arrow: only little endian machines are supported");
+   }
+
+   inline int64_t seek(int fd, int64_t offset, int whence)
+   {
+#ifdef _WIN32
+      return _lseeki64(fd, offset, whence);
+#else
+      return int64_t(lseek(fd, off_t(offset), whence));
+#endif
+   }
+}
+
+/*****************************************
+ * ARROW FILE WRITER
+ * Write an Arrow IPC file holding one column
+ * of T, one record batch per write()
+ ****************************************/
+template <typename T>
+class arrow_file_writer
+{
+public:
+   //
+   // Construct
+   //
+
+   arrow_file_writer(const std::string & fileName, const std::string & columnName = "values");
+   arrow_file_writer(const arrow_file_writer & rhs) = delete;
+   arrow_file_writer & operator = (const arrow_file_writer & rhs) = delete;
+   ~arrow_file_writer();
+
+   //
+   // Write
+   //
+
+   void write(const vector<T> & v);
+   void close();
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   int64_t writeMessage(const arrow_detail::fb_builder & b, const void * pBody, size_t bodyBytes);
+
+   int                               fd;
+   std::string                       columnName;
+   int64_t                           position;   // where the next message goes
+   std::vector<arrow_detail::block> batches;    // for the footer
+};
+
+/*****************************************
+ * ARROW FILE WRITER :: CONSTRUCTOR
+ * Create the file, with the magic and the schema
+ ****************************************/
+template <typename T>
+arrow_file_writer <T> :: arrow_file_writer(const std::string & fileName,
+                                           const std::string & columnName) :
+   fd(-1), columnName(columnName), position(0)
+{
+   arrow_detail::checkEndian();
+#ifdef _WIN32
+   fd = _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+   fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("arrow: unable to create " + fileName);
+
+   try
+   {
+      writeAll(fd, "ARROW1\0\0", 8, nullptr, 0);
+      position = 8;
+
+      arrow_detail::fb_builder b;
+      uint32_t schema = arrow_detail::schema<T>(b, columnName);
+      arrow_detail::message(b, arrow_detail::HEADER_SCHEMA, schema, 0);
+      writeMessage(b, nullptr, 0);
+   }
+   catch (...)
+   {
+      ::close(fd);
+      throw;
+   }
+}
+
+/*****************************************
+ * ARROW FILE WRITER :: DESTRUCTOR
+ ****************************************/
+template <typename T>
+arrow_file_writer <T> :: ~arrow_file_writer()
+{
+   try
+   {
+      close();
+   }
+   catch (...)
+   {
+      // nowhere to report it from a destructor
+   }
+}
+
+/*****************************************
+ * ARROW FILE WRITER :: WRITE
+ * One record batch: no validity buffer, then
+ * the values straight out of the vector
+ ****************************************/
+template <typename T>
+void arrow_file_writer <T> :: write(const vector<T> & v)
+{
+   if (fd == -1)
+      throw std::runtime_error("arrow: the file is closed");
+
+   arrow_detail::field_node node = { int64_t(v.size()), 0 };
+   arrow_detail::buffer buffers[2] = { { 0, 0 }, { 0, int64_t(v.size() * sizeof(T)) } };
+
+   arrow_detail::fb_builder b;
+   uint32_t nodes = b.structs(&node, 1);
+   uint32_t bufs  = b.structs(buffers, 2);
+   b.startTable();
+   b.add<int64_t>(0, int64_t(v.size()));
+   b.addObject(1, nodes);
+   b.addObject(2, bufs);
+   uint32_t batch = b.endTable();
+   size_t bodyBytes = v.size() * sizeof(T);
+   arrow_detail::message(b, arrow_detail::HEADER_RECORD_BATCH, batch,
+                         int64_t(arrow_detail::padTo8(bodyBytes)));
+
+   arrow_detail::block block = {};
+   block.offset = position;
+   block.metaDataLength = int32_t(writeMessage(b, v.size() ? &v[0] : nullptr, bodyBytes));
+   block.bodyLength = int64_t(arrow_detail::padTo8(bodyBytes));
+   batches.push_back(block);
+}
+
+/*****************************************
+ * ARROW FILE WRITER :: CLOSE
+ * The end-of-stream marker, then the footer
+ * that lets a reader find every batch
+ ****************************************/
+template <typename T>
+void arrow_file_writer <T> :: close()
+{
+   if (fd == -1)
+      return;
+   int fdClose = fd;
+   fd = -1;
+   try
+   {
+      const uint32_t endOfStream[2] = { 0xffffffff, 0 };
+      writeAll(fdClose, endOfStream, sizeof(endOfStream), nullptr, 0);
+
+      arrow_detail::fb_builder b;
+      uint32_t schema = arrow_detail::schema<T>(b, columnName);
+      uint32_t dictionaries = b.structs<arrow_detail::block>(nullptr, 0);
+      uint32_t recordBatches = b.structs(batches.empty() ? nullptr : &batches[0], batches.size());
+      b.startTable();
+      b.add<int16_t>(0, arrow_detail::METADATA_V5);
+      b.addObject(1, schema);
+      b.addObject(2, dictionaries);
+      b.addObject(3, recordBatches);
+      b.finish(b.endTable());
+
+      int32_t footerSize = int32_t(b.size());
+      writeAll(fdClose, b.data(), b.size(), &footerSize, sizeof(footerSize));
+      writeAll(fdClose, "ARROW1", 6, nullptr, 0);
+   }
+   catch (...)
+   {
+      ::close(fdClose);
+      throw;
+   }
+   ::close(fdClose);
+}
+
+/*****************************************
+ * ARROW FILE WRITER :: WRITE MESSAGE
+ * The continuation marker, the metadata size,
+ * the metadata, and the body, each padded to
+ * 8 bytes. Returns the size of everything up
+ * to the body.
+ ****************************************/
+template <typename T>
+int64_t arrow_file_writer <T> :: writeMessage(const arrow_detail::fb_builder & b,
+                                              const void * pBody, size_t bodyBytes)
+{
+   size_t metaBytes = arrow_detail::padTo8(b.size());
+   std::string meta(8 + metaBytes, '\0');
+   uint32_t prefix[2] = { 0xffffffff, uint32_t(metaBytes) };
+   memcpy(&meta[0], prefix, 8);
+   memcpy(&meta[8], b.data(), b.size());
+
+   static const char zeros[8] = {};
+   writeAll(fd, meta.data(), meta.size(), pBody, bodyBytes);
+   writeAll(fd, zeros, arrow_detail::padTo8(bodyBytes) - bodyBytes, nullptr, 0);
+   position += int64_t(meta.size() + arrow_detail::padTo8(bodyBytes));
+   return int64_t(meta.size());
+}
+
+/*****************************************
+ * ARROW FILE READER
+ * Read one column of T out of an Arrow IPC
+ * file, a record batch at a time
+ ****************************************/
+template <typename T>
+class arrow_file_reader
+{
+public:
+   //
+   // Construct
+   //
+
+   arrow_file_reader(const std::string & fileName, size_t column = 0);
+   arrow_file_reader(const arrow_file_reader & rhs) = delete;
+   arrow_file_reader & operator = (const arrow_file_reader & rhs) = delete;
+   ~arrow_file_reader() { ::close(fd); }
+
+   //
+   // Read
+   //
+
+   size_t num_batches() const { return batches.size(); }
+   void   read(size_t batch, vector<T> & v);
+   void   read_all(vector<T> & v);
+   const std::string & column_name() const { return columnName; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   void readAt(int64_t offset, void * p, size_t numBytes);
+
+   int                               fd;
+   size_t                            column;       // which column we read
+   size_t                            numColumns;   // how many the file has
+   std::string                       columnName;
+   std::vector<arrow_detail::block> batches;      // from the footer
+};
+
+/*****************************************
+ * ARROW FILE READER :: CONSTRUCTOR
+ * Check both magic strings, then read the
+ * footer for the schema and the batches
+ ****************************************/
+template <typename T>
+arrow_file_reader <T> :: arrow_file_reader(const std::string & fileName, size_t column) :
+   fd(-1), column(column), numColumns(0)
+{
+   arrow_detail::checkEndian();
+#ifdef _WIN32
+   fd = _open(fileName.c_str(), _O_RDONLY | _O_BINARY);
+#else
+   fd = open(fileName.c_str(), O_RDONLY);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("arrow: unable to open " + fileName);
+
+   try
+   {
+      int64_t fileSize = arrow_detail::seek(fd, 0, SEEK_END);
+      char magic[6];
+      char trailer[10];
+      if (fileSize < 8 + 10)
+         throw std::runtime_error("arrow: " + fileName + " is not an Arrow file");
+      readAt(0, magic, 6);
+      readAt(fileSize - 10, trailer, 10);
+      if (memcmp(magic, "ARROW1", 6) != 0 || memcmp(trailer + 4, "ARROW1", 6) != 0)
+         throw std::runtime_error("arrow: " + fileName + " is not an Arrow file");
+
+      int32_t footerSize;
+      memcpy(&footerSize, trailer, 4);
+      if (footerSize <= 0 || footerSize > fileSize - 18)
+         throw std::runtime_error("arrow: damaged metadata");
+      std::vector<uint8_t> footerBytes(footerSize);
+      readAt(fileSize - 10 - footerSize, &footerBytes[0], footerSize);
+
+      arrow_detail::fb_table footer(&footerBytes[0], footerBytes.size());
+      arrow_detail::fb_table schema = footer.table(1);
+      if (schema.get<int16_t>(0, 0) != 0)
+         throw std::runtime_error("arrow: big endian files are not supported");
+
+      // every column must be a fixed width number for us to find our buffers
+      numColumns = schema.length(1);
+      if (column >= numColumns)
+         throw std::runtime_error("arrow: there is no such column");
+      for (size_t i = 0; i < numColumns; i++)
+      {
+         arrow_detail::fb_table field = schema.tableAt(1, i);
+         uint8_t typeType = field.get<uint8_t>(2, 0);
+         if (typeType != arrow_detail::TYPE_INT && typeType != arrow_detail::TYPE_FLOATING_POINT)
+            throw std::runtime_error("arrow: only number columns are supported");
+         if (i == column)
+         {
+            if (!arrow_detail::isType<T>(field))
+               throw std::runtime_error("arrow: the column is not of this type");
+            if (field.has(0))
+               columnName = field.string(0);
+         }
+      }
+
+      for (size_t i = 0; i < footer.length(3); i++)
+         batches.push_back(footer.structAt<arrow_detail::block>(3, i));
+   }
+   catch (...)
+   {
+      ::close(fd);
+      throw;
+   }
+}
+
+/*****************************************
+ * ARROW FILE READER :: READ
+ * Our column of one record batch
+ ****************************************/
+template <typename T>
+void arrow_file_reader <T> :: read(size_t batch, vector<T> & v)
+{
+   assert(batch < batches.size());
+   const arrow_detail::block & block = batches[batch];
+   if (block.metaDataLength < 8)
+      throw std::runtime_error("arrow: damaged metadata");
+
+   // the metadata, after the continuation marker and its length
+   std::vector<uint8_t> meta(block.metaDataLength);
+   readAt(block.offset, &meta[0], meta.size());
+   uint32_t prefix[2];
+   memcpy(prefix, &meta[0], 8);
+   size_t start = prefix[0] == 0xffffffff ? 8 : 4;   // old files have no marker
+   arrow_detail::fb_table message(&meta[start], meta.size() - start);
+   if (message.get<uint8_t>(1, 0) != arrow_detail::HEADER_RECORD_BATCH)
+      throw std::runtime_error("arrow: the block is not a record batch");
+
+   arrow_detail::fb_table recordBatch = message.table(2);
+   if (recordBatch.has(3))
+      throw std::runtime_error("arrow: compressed files are not supported");
+   arrow_detail::field_node node = recordBatch.structAt<arrow_detail::field_node>(1, column);
+   arrow_detail::buffer values = recordBatch.structAt<arrow_detail::buffer>(2, 2 * column + 1);
+   if (node.nullCount != 0)
+      throw std::runtime_error("arrow: the column has nulls");
+   if (node.length < 0 || values.offset < 0 ||
+       values.length < node.length * int64_t(sizeof(T)) ||
+       values.offset + values.length > block.bodyLength)
+      throw std::runtime_error("arrow: damaged metadata");
+
+   vector<T> vNew;
+   vNew.resize(size_t(node.length), T());
+   if (node.length)
+      readAt(block.offset + block.metaDataLength + values.offset, &vNew[0],
+             size_t(node.length) * sizeof(T));
+   v.swap(vNew);
+}
+
+/*****************************************
+ * ARROW FILE READER :: READ ALL
+ * Our column of every record batch, end to end
+ ****************************************/
+template <typename T>
+void arrow_file_reader <T> :: read_all(vector<T> & v)
+{
+   vector<T> vNew;
+   vector<T> batch;
+   for (size_t i = 0; i < batches.size(); i++)
+   {
+      read(i, batch);
+      for (size_t j = 0; j < batch.size(); j++)
+         vNew.push_back(batch[j]);
+   }
+   v.swap(vNew);
+}
+
+/*****************************************
+ * ARROW FILE READER :: READ AT
+ ****************************************/
+template <typename T>
+void arrow_file_reader <T> :: readAt(int64_t offset, void * p, size_t numBytes)
+{
+   if (arrow_detail::seek(fd, offset, SEEK_SET) != offset)
+      throw std::runtime_error("arrow: unable to seek");
+   readAll(fd, p, numBytes);
+}
+
+} // namespace custom
@@ -0,0 +1,114 @@
+/***********************************************************************
+ * Header:
+ *    BENCH CHECKPOINT
+ * Summary:
+ *    Checkpoints of a 256 MB tracked_vector with 1% and 5% of its pages
+ *    changed: rewriting everything against writing only the dirty pages,
+ *    and replaying that delta onto the base. Then reading the base back
+ *    into a tracked_vector, and what the tracking itself costs a loop
+ *    that writes every element. The files are not synced, so these are
+ *    the bytes handed to the kernel.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "checkpoint.h" // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <cstdint>
+#include <cstdio>       // for std::remove
+#include <string>
+
+/***********************************************
+ * BENCH CHECKPOINT
+ * Full against delta
+ ***********************************************/
+class BenchCheckpoint : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 25;
+      custom::tracked_vector<uint64_t> v;
+      v.resize(num, 1);
+      custom::save_base(BASE_NAME, v);
+
+      // Checkpoint
+      checkpoint(v, 1);
+      checkpoint(v, 5);
+
+      // Restore
+      measure("restore 256M", "load_base", double(num * sizeof(uint64_t)), [&]
+      {
+         custom::tracked_vector<uint64_t> vLoad;
+         custom::load_base(BASE_NAME, vLoad);
+         keep(vLoad.size());
+      });
+
+      // Tracking
+      custom::vector<uint64_t> plain(num, 1);
+      measure("write every element", "vector", 2.0 * num * sizeof(uint64_t), [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            plain[i] += 1;
+      });
+      measure("write every element", "tracked_vector", 2.0 * num * sizeof(uint64_t), [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            v[i] += 1;
+      });
+
+      std::remove(BASE_NAME);
+      std::remove(DELTA_NAME);
+      report("Checkpoint");
+   }
+
+   /***************************************
+    * CHECKPOINT
+    * Change one element on percent of the
+    * pages, then write them out both ways
+    ***************************************/
+   void checkpoint(custom::tracked_vector<uint64_t> & v, size_t percent)
+   {
+      const size_t pageElements = v.page_elements();
+      const size_t numPages = v.size() / pageElements;
+      const size_t step = 100 / percent;
+      auto change = [&]
+      {
+         for (size_t page = 0; page < numPages; page += step)
+            v[page * pageElements + page % pageElements] += 1;
+      };
+      std::string group = "checkpoint 256M, " + std::to_string(percent) + "% dirty";
+      const size_t numDirty = (numPages + step - 1) / step;
+      double dirtyBytes = double(numDirty * pageElements * sizeof(uint64_t));
+
+      measure(group, "whole vector", double(v.size() * sizeof(uint64_t)), [&]
+      {
+         change();
+         custom::save_base(BASE_NAME, v);
+      });
+      measure(group, "dirty pages", dirtyBytes, [&]
+      {
+         change();
+         custom::save_delta(DELTA_NAME, v);
+      }, std::to_string(numDirty) + " of " + std::to_string(numPages) + " pages");
+      change();
+      custom::save_delta(DELTA_NAME, v);
+      measure(group, "replay delta", 2.0 * dirtyBytes, [&]
+      {
+         custom::apply_delta(BASE_NAME, DELTA_NAME);
+      });
+   }
+
+   static constexpr const char * BASE_NAME  = "benchCheckpoint.base";
+   static constexpr const char * DELTA_NAME = "benchCheckpoint.delta";
+};
+
+#endif // !_WIN32
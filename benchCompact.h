@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    BENCH COMPACT
+ * Summary:
+ *    copy_if() on 4M random int32s, keeping half of them, where a branch
+ *    on the predicate is wrong every other element, and keeping 95%,
+ *    where it is almost always right. Each is timed as the plain loop
+ *    with the branch, then the branch-free loop and the compress-store
+ *    kernel at every level, then parallel::copy_if(). partition() gets
+ *    the same next to std::stable_partition().
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "compact.h"    // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/***********************************************
+ * BENCH COMPACT
+ * Branchy, branch-free, compress-store
+ ***********************************************/
+class BenchCompact : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 22;
+      custom::vector<int32_t> in;
+      uint64_t x = 1;
+      for (size_t i = 0; i < num; i++)
+      {
+         x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+         in.push_back(int32_t((x >> 33) % 1000));
+      }
+
+      // Copy if
+      copyIf("copy_if 4M, keep 50%", in, 500);
+      copyIf("copy_if 4M, keep 95%", in, 950);
+
+      // Partition
+      const std::string group = "partition 4M, 50%";
+      const double bytes = 2.0 * num * sizeof(int32_t);
+      custom::vector<int32_t> out(num, 0);
+      measure(group, "std::stable_part", bytes, [&]
+      {
+         out = in;
+         std::stable_partition(&out[0], &out[0] + num, [](int32_t v) { return v < 500; });
+         keep(out[0]);
+      }, "includes a copy");
+      measure(group, "partition", bytes, [&]
+      {
+         out = in;
+         keep(custom::partition(in, out, custom::where::less(int32_t(500))));
+      }, "includes a copy");
+
+      report("Compact");
+   }
+
+   /***************************************
+    * COPY IF
+    * Keep the elements of in below limit,
+    * every way there is
+    ***************************************/
+   void copyIf(const std::string & group, const custom::vector<int32_t> & in, int32_t limit)
+   {
+      typedef custom::where::less_than<int32_t> Pred;
+      typedef custom::compact_detail::kernels<int32_t, Pred> table;
+      const size_t num = in.size();
+      const Pred pred = custom::where::less(limit);
+      custom::vector<int32_t> out(num, 0);
+      const int32_t * p = &in[0];
+      int32_t * q = &out[0];
+
+      size_t kept = 0;
+      for (size_t i = 0; i < num; i++)
+         kept += p[i] < limit;
+      const double bytes = double((num + kept) * sizeof(int32_t));
+
+      measure(group, "branch", bytes, [&]
+      {
+         size_t k = 0;
+         for (size_t i = 0; i < num; i++)
+            if (p[i] < limit)
+               q[k++] = p[i];
+         keep(k);
+      });
+      measure(group, "branch-free", bytes, [&]
+      {
+         keep(custom::compact_detail::scalarCompress(p, num, q, num, pred));
+      });
+      const table scalar = table::at(custom::simd::SCALAR);
+      for (int l = custom::simd::SSE42; l <= custom::simd::detected_level(); l++)
+      {
+         table k = table::at(custom::simd::level(l));
+         measure(group, custom::simd::level_name(custom::simd::level(l)), bytes,
+                 [&] { keep(k.compress(p, num, q, num, pred)); },
+                 k.compress == scalar.compress ? "the branch-free loop" : "");
+      }
+      const size_t most = std::max(size_t(4), size_t(std::thread::hardware_concurrency()));
+      for (size_t n = 2; n <= most; n *= 2)
+      {
+         custom::thread_pool pool(n);
+         measure(group, "parallel, " + std::to_string(n) + " threads", bytes, [&]
+         {
+            keep(custom::parallel::copy_if(in.slice(0, num), out.slice(0, num), pred, pool));
+         });
+      }
+   }
+};
@@ -0,0 +1,103 @@
+/***********************************************************************
+ * Header:
+ *    BENCH DISPATCH
+ * Summary:
+ *    What picking the kernel at run time costs a call. On a few floats
+ *    the call is most of the work, so sum() is timed three ways: calling
+ *    the kernel for the active level by name, through a kernels table
+ *    looked up once, and through simd::sum(), which finds the table
+ *    every call. Times are for 1000 calls.
+ *
+ *    Then the level itself: a big sum at the detected level against the
+ *    active one. They are the same row unless CUSTOM_SIMD_LEVEL was set,
+ *    as in CUSTOM_SIMD_LEVEL=sse42 ./benchmark dispatch
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "simd.h"       // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <string>
+
+/***********************************************
+ * BENCH DISPATCH
+ * Small calls, then the override
+ ***********************************************/
+class BenchDispatch : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Small calls
+      const size_t sizes[] = { 4, 16, 64, 1024 };
+      for (size_t num : sizes)
+         calls(num);
+
+      // The override
+      const size_t num = size_t(1) << 16;
+      custom::vector<float> x(num, 1.0f);
+      const float * p = &x[0];
+      custom::simd::level detected = custom::simd::detected_level();
+      custom::simd::level active = custom::simd::active_level();
+      custom::simd::kernels<float> k = custom::simd::kernels<float>::at(detected);
+      measure("sum<float> 256K", std::string("detected ") + custom::simd::level_name(detected),
+              double(num * sizeof(float)), [&] { keep(k.sum(p, num)); });
+      measure("sum<float> 256K", std::string("active ") + custom::simd::level_name(active),
+              double(num * sizeof(float)), [&] { keep(custom::simd::sum(p, num)); },
+              active == detected ? "" : "CUSTOM_SIMD_LEVEL");
+
+      report("Dispatch");
+   }
+
+   /***************************************
+    * CALLS
+    * sum() of num floats three ways, as the
+    * time of 1000 calls
+    ***************************************/
+   void calls(size_t num)
+   {
+      custom::vector<float> x(num, 1.0f);
+      const float * p = &x[0];
+      std::string group = "sum of " + std::to_string(num) + " floats";
+      auto thousand = [&](const std::string & variant, auto f)
+      {
+         const size_t numCalls = 100000;
+         double seconds = best([&]
+         {
+            float total = 0.0f;
+            for (size_t i = 0; i < numCalls; i++)
+               total += f();
+            keep(total);
+         });
+         record(group, variant, seconds * 1000.0 / numCalls,
+                double(num * sizeof(float)) * 1000.0, "1000 calls");
+      };
+
+      switch (custom::simd::active_level())
+      {
+#ifdef CUSTOM_SIMD_X86
+         case custom::simd::AVX512:
+            thousand("by name", [&] { return custom::simd::avx512::sum<float>(p, num); });
+            break;
+         case custom::simd::AVX2:
+            thousand("by name", [&] { return custom::simd::avx2::sum<float>(p, num); });
+            break;
+         case custom::simd::SSE42:
+            thousand("by name", [&] { return custom::simd::sse42::sum<float>(p, num); });
+            break;
+#endif
+         default:
+            thousand("by name", [&] { return custom::simd::scalar::sum<float>(p, num); });
+            break;
+      }
+      const custom::simd::kernels<float> & k = custom::simd::kernels<float>::active();
+      thousand("table found once", [&] { return k.sum(p, num); });
+      thousand("simd::sum", [&] { return custom::simd::sum(p, num); });
+   }
+};
@@ -0,0 +1,153 @@
+/***********************************************************************
+ * Header:
+ *    BENCH EXPR
+ * Summary:
+ *    The memory traffic of a fused expression against the same
+ *    arithmetic done the old way, one temporary vector per operation.
+ *    Each row counts the bytes its own way of working reads and
+ *    writes: a new temporary is filled when it is made, written once
+ *    more with the answer, and read by the next step, while the fused
+ *    loop reads each operand once and writes the answer once.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "expr.h"       // class under test
+#include "benchmark.h"  // benchmark baseclass
+
+#include <string>
+
+/***********************************************
+ * BENCH EXPR
+ * Fused trees against temporaries
+ ***********************************************/
+class BenchExpr : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // a + b * c
+      threeOperands<float> ("a + b * c <float>",  size_t(1) << 22);
+      threeOperands<double>("a + b * c <double>", size_t(1) << 22);
+
+      // (a + b) * (c - d) + a * 2
+      fourOperands<float>("(a+b)*(c-d)+a*2 <float>", size_t(1) << 22);
+
+      report("Expr");
+   }
+
+   /***************************************
+    * THREE OPERANDS
+    * r = a + b * c: one temporary
+    ***************************************/
+   template <typename T>
+   void threeOperands(const std::string & group, size_t num)
+   {
+      custom::vector<T> a(num, T(1));
+      custom::vector<T> b(num, T(2));
+      custom::vector<T> c(num, T(3));
+      custom::vector<T> r(num, T());
+      double size = double(num * sizeof(T));
+
+      // the old way: b * c is a vector of its own, then a + it
+      measure(group, "temporaries", 7.0 * size, [&]
+      {
+         custom::vector<T> t(num, T());                // fill: write 1
+         for (size_t i = 0; i < num; i++)
+            t[i] = b[i] * c[i];                        // read 2, write 1
+         for (size_t i = 0; i < num; i++)
+            r[i] = a[i] + t[i];                        // read 2, write 1
+      }, temporaries(7.0 * size));
+
+      // the same temporary, with each step through the SIMD loop
+      measure(group, "temps+simd", 7.0 * size, [&]
+      {
+         custom::vector<T> t(b * c);
+         r = a + t;
+      }, temporaries(7.0 * size));
+
+      // one loop: read a, b and c once, write r once
+      auto tree = a + b * c;
+      fused(group, tree, &r[0], num, 4.0 * size);
+   }
+
+   /***************************************
+    * FOUR OPERANDS
+    * r = (a + b) * (c - d) + a * 2: four
+    * temporaries
+    ***************************************/
+   template <typename T>
+   void fourOperands(const std::string & group, size_t num)
+   {
+      custom::vector<T> a(num, T(1));
+      custom::vector<T> b(num, T(2));
+      custom::vector<T> c(num, T(3));
+      custom::vector<T> d(num, T(4));
+      custom::vector<T> r(num, T());
+      double size = double(num * sizeof(T));
+
+      // each of a + b, c - d, a * 2 and their product is a fill, a
+      // write, and one or two reads; the last step writes into r
+      measure(group, "temporaries", 18.0 * size, [&]
+      {
+         custom::vector<T> sum(num, T());
+         for (size_t i = 0; i < num; i++)
+            sum[i] = a[i] + b[i];
+         custom::vector<T> difference(num, T());
+         for (size_t i = 0; i < num; i++)
+            difference[i] = c[i] - d[i];
+         custom::vector<T> product(num, T());
+         for (size_t i = 0; i < num; i++)
+            product[i] = sum[i] * difference[i];
+         custom::vector<T> twice(num, T());
+         for (size_t i = 0; i < num; i++)
+            twice[i] = a[i] * T(2);
+         for (size_t i = 0; i < num; i++)
+            r[i] = product[i] + twice[i];
+      }, temporaries(18.0 * size));
+
+      measure(group, "temps+simd", 18.0 * size, [&]
+      {
+         custom::vector<T> sum(a + b);
+         custom::vector<T> difference(c - d);
+         custom::vector<T> product(sum * difference);
+         custom::vector<T> twice(a * T(2));
+         r = product + twice;
+      }, temporaries(18.0 * size));
+
+      // a is read twice in the same pass, so it only comes from memory once
+      auto tree = (a + b) * (c - d) + a * T(2);
+      fused(group, tree, &r[0], num, 5.0 * size);
+   }
+
+   /***************************************
+    * FUSED
+    * The tree's one loop at every level
+    ***************************************/
+   template <class E>
+   void fused(const std::string & group, const E & tree,
+              typename E::value_type * out, size_t num, double moved)
+   {
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         typename custom::expr::evaluate_detail::loop<E>::fn loop =
+            custom::expr::evaluate_detail::loop<E>::at(custom::simd::level(l));
+         measure(group, std::string("fused ") + custom::simd::level_name(custom::simd::level(l)),
+                 moved, [&] { loop(out, tree, num); }, traffic(moved));
+      }
+   }
+
+   // how many MB one run moves
+   static std::string traffic(double moved)
+   {
+      return std::to_string(int(moved / double(1 << 20))) + " MB moved";
+   }
+   static std::string temporaries(double moved)
+   {
+      return traffic(moved) + ", allocates";
+   }
+};
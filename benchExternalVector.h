@@ -0,0 +1,106 @@
+/***********************************************************************
+ * Header:
+ *    BENCH EXTERNAL VECTOR
+ * Summary:
+ *    Sequential and random reads of an external_vector ten times the
+ *    size of its memory budget, next to the same reads of a vector in
+ *    memory. The budget stands in for RAM: it is what decides how
+ *    often a page goes out to the file and comes back. The file itself
+ *    sits in the page cache here, so on a real disk the misses cost
+ *    far more than they do in these rows.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "external_vector.h" // class under test
+#include "vector.h"
+#include "benchmark.h"       // benchmark baseclass
+
+#include <cstdint>
+#include <string>
+
+/***********************************************
+ * BENCH EXTERNAL VECTOR
+ * In order and at random, in memory and not
+ ***********************************************/
+class BenchExternalVector : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t budget = size_t(16) << 20;
+      const size_t num = 10 * budget / sizeof(uint64_t);
+      const size_t numRandom = 20000;
+      custom::external_vector<uint64_t> outside(budget);
+      custom::vector<uint64_t> inside;
+      measure("push_back 160M", "vector", num * sizeof(uint64_t), [&]
+      {
+         inside.clear();
+         for (size_t i = 0; i < num; i++)
+            inside.push_back(i);
+      });
+      measure("push_back 160M", "external_vector", num * sizeof(uint64_t), [&]
+      {
+         outside.clear();
+         for (size_t i = 0; i < num; i++)
+            outside.push_back(i);
+      }, "budget 16 MB");
+
+      // In order
+      auto sequential = [&](const auto & v)
+      {
+         uint64_t total = 0;
+         for (size_t i = 0; i < num; i++)
+            total += v[i];
+         keep(total);
+      };
+      measure("sequential 160M", "vector", num * sizeof(uint64_t),
+              [&] { sequential(inside); });
+      measure("sequential 160M", "external_vector", num * sizeof(uint64_t),
+              [&] { sequential(static_cast<const custom::external_vector<uint64_t> &>(outside)); },
+              misses(outside, [&] { sequential(static_cast<const custom::external_vector<uint64_t> &>(outside)); }));
+
+      // At random
+      auto random = [&](const auto & v)
+      {
+         uint64_t total = 0;
+         uint64_t index = 1;
+         for (size_t i = 0; i < numRandom; i++)
+         {
+            index = index * 6364136223846793005ULL + 1442695040888963407ULL;
+            total += v[(index >> 17) % num];
+         }
+         keep(total);
+      };
+      measure("random 20K reads", "vector", numRandom * sizeof(uint64_t),
+              [&] { random(inside); });
+      measure("random 20K reads", "external_vector", numRandom * sizeof(uint64_t),
+              [&] { random(static_cast<const custom::external_vector<uint64_t> &>(outside)); },
+              misses(outside, [&] { random(static_cast<const custom::external_vector<uint64_t> &>(outside)); }));
+
+      report("ExternalVector");
+   }
+
+   /***************************************
+    * MISSES
+    * The page misses and read-aheads of one
+    * call of f, as a note for its row
+    ***************************************/
+   template <class F>
+   static std::string misses(const custom::external_vector<uint64_t> & v, F f)
+   {
+      custom::external_vector<uint64_t>::statistics before = v.stats();
+      f();
+      const custom::external_vector<uint64_t>::statistics & after = v.stats();
+      return std::to_string(after.misses - before.misses) + " misses, " +
+             std::to_string(after.prefetches - before.prefetches) + " pages read ahead";
+   }
+};
+
+#endif // !_WIN32
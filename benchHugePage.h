@@ -0,0 +1,147 @@
+/***********************************************************************
+ * Header:
+ *    BENCH HUGE PAGE
+ * Summary:
+ *    A 256 MB table in a plain vector, on 4K pages, and in a huge_vector,
+ *    on transparent huge pages where the kernel has them. Each is read
+ *    in order and at random, and the dTLB misses of one pass are counted
+ *    with perf_event_open where the kernel lets us. Growing each one by
+ *    push_back shows mremap against copying.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "huge_page.h"  // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <cstdint>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>  // for perf_event_attr
+#include <sys/ioctl.h>         // for ioctl
+#include <sys/syscall.h>       // for SYS_perf_event_open
+#include <unistd.h>            // for syscall, read, and close
+#endif
+
+/***********************************************
+ * BENCH HUGE PAGE
+ * 4K pages against huge pages
+ ***********************************************/
+class BenchHugePage : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 25;
+      custom::vector<uint64_t> small(num, 1);
+      custom::huge_vector<uint64_t> huge(num, 1);
+      std::string pages = custom::huge_page_allocator::huge_pages_available()
+                        ? "huge pages" : "huge pages (not available)";
+
+      // In order
+      scan("scan 256M", "4K pages", &small[0], num);
+      scan("scan 256M", pages, &huge[0], num);
+
+      // At random
+      gather("random reads 256M", "4K pages", &small[0], num);
+      gather("random reads 256M", pages, &huge[0], num);
+
+      // Growth
+      measure("push_back 256M", "vector", num * sizeof(uint64_t), [&]
+      {
+         custom::vector<uint64_t> v;
+         for (size_t i = 0; i < num; i++)
+            v.push_back(i);
+         keep(v.size());
+      });
+      measure("push_back 256M", "huge_vector", num * sizeof(uint64_t), [&]
+      {
+         custom::huge_vector<uint64_t> v;
+         for (size_t i = 0; i < num; i++)
+            v.push_back(i);
+         keep(v.size());
+      });
+
+      report("HugePage");
+   }
+
+   /***************************************
+    * SCAN
+    * Sum every element, in order
+    ***************************************/
+   void scan(const std::string & group, const std::string & variant,
+             const uint64_t * p, size_t num)
+   {
+      auto pass = [&]
+      {
+         uint64_t total = 0;
+         for (size_t i = 0; i < num; i++)
+            total += p[i];
+         keep(total);
+      };
+      measure(group, variant, num * sizeof(uint64_t), pass, misses(pass));
+   }
+
+   /***************************************
+    * GATHER
+    * Read num / 16 elements at random. num
+    * has to be a power of two.
+    ***************************************/
+   void gather(const std::string & group, const std::string & variant,
+               const uint64_t * p, size_t num)
+   {
+      auto pass = [&]
+      {
+         uint64_t total = 0;
+         uint64_t index = 1;
+         for (size_t i = 0; i < num / 16; i++)
+         {
+            index = index * 6364136223846793005ULL + 1442695040888963407ULL;
+            total += p[(index >> 17) & (num - 1)];
+         }
+         keep(total);
+      };
+      measure(group, variant, num / 16 * 64.0, pass, misses(pass));
+   }
+
+   /***************************************
+    * MISSES
+    * The dTLB read misses of one call of f,
+    * as a note for its row
+    ***************************************/
+   template <class F>
+   static std::string misses(F f)
+   {
+#ifdef __linux__
+      perf_event_attr attr = { };
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.size = sizeof(attr);
+      attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      int fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fd >= 0)
+      {
+         ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+         ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+         f();
+         ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+         uint64_t count = 0;
+         bool counted = read(fd, &count, sizeof(count)) == ssize_t(sizeof(count));
+         close(fd);
+         if (counted)
+            return std::to_string(count) + " dTLB misses";
+      }
+#endif
+      return "no dTLB counter";
+   }
+};
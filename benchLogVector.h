@@ -0,0 +1,113 @@
+/***********************************************************************
+ * Header:
+ *    BENCH LOG VECTOR
+ * Summary:
+ *    Throughput against durability: appends to a log_vector at commit
+ *    intervals from every 64K appends down to every append, next to a
+ *    plain vector that keeps nothing. The time is that of one append,
+ *    and each row notes how many appends a crash could lose. Then the
+ *    cost of folding a long log into a snapshot.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "log_vector.h" // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>       // for std::remove
+#include <string>
+
+/***********************************************
+ * BENCH LOG VECTOR
+ * Commit intervals
+ ***********************************************/
+class BenchLogVector : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Append: the time of one append, averaged over many
+      const size_t num = size_t(1) << 20;
+      double seconds = best([&]
+      {
+         custom::vector<Event> v;
+         for (size_t i = 0; i < num; i++)
+            v.push_back(event(i));
+         keep(v.size());
+      });
+      record("append 32-byte events", "vector", seconds / num, sizeof(Event), "loses everything");
+      const size_t intervals[] = { 65536, 4096, 256, 16, 1 };
+      for (size_t interval : intervals)
+         append(interval, std::min(size_t(2000) * interval, num));
+
+      // Compact
+      double bytes = double(num * sizeof(Event));
+      measure("compact 32M", "log to snapshot", bytes, [&]
+      {
+         cleanup();
+         custom::log_vector<Event> v(BASE_NAME, num);
+         for (size_t i = 0; i < num; i++)
+            v.push_back(event(i));
+         v.compact();
+      });
+      cleanup();
+
+      report("LogVector");
+   }
+
+   /***************************************
+    * APPEND
+    * num appends, committed every interval,
+    * as the time of one
+    ***************************************/
+   void append(size_t interval, size_t num)
+   {
+      double seconds = best([&]
+      {
+         cleanup();
+         custom::log_vector<Event> v(BASE_NAME, interval);
+         for (size_t i = 0; i < num; i++)
+            v.push_back(event(i));
+         keep(v.durable_size());
+      });
+      cleanup();
+      record("append 32-byte events", "commit every " + std::to_string(interval),
+             seconds / num, sizeof(Event),
+             interval == 1 ? "loses nothing" : "loses under " + std::to_string(interval));
+   }
+
+   // an event as we record them: a time, a kind, and a little data
+   struct Event
+   {
+      uint64_t time;
+      uint32_t kind;
+      uint32_t source;
+      double   value;
+      uint64_t tag;
+   };
+
+   static Event event(size_t i)
+   {
+      Event e = { uint64_t(i), uint32_t(i % 7), uint32_t(i % 13), double(i), uint64_t(i * 31) };
+      return e;
+   }
+
+   static void cleanup()
+   {
+      std::remove((std::string(BASE_NAME) + ".log").c_str());
+      std::remove((std::string(BASE_NAME) + ".snap").c_str());
+   }
+
+   static constexpr const char * BASE_NAME = "benchLogVector";
+};
+
+#endif // !_WIN32
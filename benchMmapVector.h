@@ -0,0 +1,112 @@
+/***********************************************************************
+ * Header:
+ *    BENCH MMAP VECTOR
+ * Summary:
+ *    Start-up from a 256 MB table on disk: reading it into a vector one
+ *    element at a time, the way the tables were rebuilt before, against
+ *    opening it as an mmap_vector. Both files are in the page cache, so
+ *    this is the cost of the copy and not of the disk.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "mmap_vector.h" // class under test
+#include "vector.h"
+#include "benchmark.h"   // benchmark baseclass
+
+#include <cstdint>
+#include <cstdio>        // for FILE and std::remove
+
+/***********************************************
+ * BENCH MMAP VECTOR
+ * Rebuild against map
+ ***********************************************/
+class BenchMmapVector : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 25;
+      const double bytes = double(num * sizeof(uint64_t));
+      setup(num);
+
+      // Open: nothing is read from a mapped file until it is used
+      measure("open 256M", "read+push_back", 0.0, [&]
+      {
+         custom::vector<uint64_t> v;
+         rebuild(v);
+         keep(v.size());
+      });
+      measure("open 256M", "mmap_vector", 0.0, [&]
+      {
+         const custom::mmap_vector<uint64_t> v(MAPPED_NAME, custom::mmap_vector<uint64_t>::READ_ONLY);
+         keep(v.size());
+      });
+
+      // Open and read every element
+      measure("open+scan 256M", "read+push_back", bytes, [&]
+      {
+         custom::vector<uint64_t> v;
+         rebuild(v);
+         keep(sum(&v[0], v.size()));
+      });
+      measure("open+scan 256M", "mmap_vector", bytes, [&]
+      {
+         const custom::mmap_vector<uint64_t> v(MAPPED_NAME, custom::mmap_vector<uint64_t>::READ_ONLY);
+         keep(sum(&v[0], v.size()));
+      });
+
+      std::remove(RAW_NAME);
+      std::remove(MAPPED_NAME);
+      report("MmapVector");
+   }
+
+   /***************************************
+    * SETUP
+    * The same num elements as a raw file and
+    * as an mmap_vector file
+    ***************************************/
+   void setup(size_t num)
+   {
+      custom::mmap_vector<uint64_t> mapped(MAPPED_NAME, custom::mmap_vector<uint64_t>::CREATE);
+      mapped.resize(num);
+      for (size_t i = 0; i < num; i++)
+         mapped[i] = i;
+      mapped.sync();
+
+      FILE * f = fopen(RAW_NAME, "wb");
+      fwrite(&mapped[0], sizeof(uint64_t), num, f);
+      fclose(f);
+   }
+
+   // the table read back the old way, an element at a time
+   static void rebuild(custom::vector<uint64_t> & v)
+   {
+      FILE * f = fopen(RAW_NAME, "rb");
+      uint64_t buffer[4096];
+      size_t got;
+      while ((got = fread(buffer, sizeof(uint64_t), 4096, f)) > 0)
+         for (size_t i = 0; i < got; i++)
+            v.push_back(buffer[i]);
+      fclose(f);
+   }
+
+   static uint64_t sum(const uint64_t * p, size_t num)
+   {
+      uint64_t total = 0;
+      for (size_t i = 0; i < num; i++)
+         total += p[i];
+      return total;
+   }
+
+   static constexpr const char * RAW_NAME    = "benchMmapVector.raw";
+   static constexpr const char * MAPPED_NAME = "benchMmapVector.bin";
+};
+
+#endif // !_WIN32
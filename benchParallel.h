@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    BENCH PARALLEL
+ * Summary:
+ *    How the parallel algorithms scale on a vector of 100M floats: each
+ *    one as a plain loop, then on a thread_pool of 1, 2, 4 ... threads,
+ *    and last on at least 4 or every core. Past the memory bandwidth of
+ *    the machine more threads stop helping, which is where these level
+ *    off.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "parallel.h"   // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <thread>
+
+/***********************************************
+ * BENCH PARALLEL
+ * Each algorithm on more and more threads
+ ***********************************************/
+class BenchParallel : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = 100000000;
+      custom::vector<float> v(num, 1.0f);
+      custom::vector<float> out(num, 0.0f);
+      const double bytes = double(num * sizeof(float));
+
+      scale("for_each 100M", 2.0 * bytes, [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            v[i] = v[i] * 0.5f + 1.0f;
+      }, [&](custom::thread_pool & pool)
+      {
+         custom::parallel::for_each(v, [](float & x) { x = x * 0.5f + 1.0f; }, pool);
+      });
+      scale("transform 100M", 2.0 * bytes, [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            out[i] = v[i] * 2.0f;
+      }, [&](custom::thread_pool & pool)
+      {
+         custom::parallel::transform(v, out, [](float x) { return x * 2.0f; }, pool);
+      });
+      scale("reduce 100M", bytes, [&]
+      {
+         double total = 0.0;
+         for (size_t i = 0; i < num; i++)
+            total += v[i];
+         keep(total);
+      }, [&](custom::thread_pool & pool)
+      {
+         keep(custom::parallel::reduce(v, 0.0, std::plus<double>(), pool));
+      });
+      scale("transform_reduce 100M", bytes, [&]
+      {
+         double total = 0.0;
+         for (size_t i = 0; i < num; i++)
+            total += double(v[i]) * v[i];
+         keep(total);
+      }, [&](custom::thread_pool & pool)
+      {
+         keep(custom::parallel::transform_reduce(v, 0.0, std::plus<double>(),
+                                                 [](float x) { return double(x) * x; }, pool));
+      });
+      scale("fill 100M", bytes, [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            out[i] = 3.0f;
+      }, [&](custom::thread_pool & pool)
+      {
+         custom::parallel::fill(out, 3.0f, pool);
+      });
+      scale("copy 100M", 2.0 * bytes, [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            out[i] = v[i];
+      }, [&](custom::thread_pool & pool)
+      {
+         custom::parallel::copy(v, out, pool);
+      });
+
+      report("Parallel");
+   }
+
+   /***************************************
+    * SCALE
+    * The loop on one thread, then the
+    * algorithm on pools of 1, 2, 4 ... and
+    * last of most threads, even when most is
+    * not a power of two
+    ***************************************/
+   template <class Serial, class Parallel>
+   void scale(const std::string & group, double bytes, Serial serial, Parallel parallel)
+   {
+      measure(group, "plain loop", bytes, serial);
+      const size_t most = std::max(size_t(4), size_t(std::thread::hardware_concurrency()));
+      for (size_t n = 1; ; n = std::min(n * 2, most))
+      {
+         custom::thread_pool pool(n);
+         measure(group, std::to_string(n) + (n == 1 ? " thread" : " threads"), bytes,
+                 [&] { parallel(pool); });
+         if (n == most)
+            break;
+      }
+   }
+};
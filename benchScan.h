@@ -0,0 +1,125 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SCAN
+ * Summary:
+ *    Prefix sums at every SIMD level against the scalar loop, and the
+ *    parallel two-pass scans on more and more threads. The kernels are
+ *    timed in the L1 cache, where the shuffles decide the speed, and on
+ *    the 1M ints the scan kernels were first measured on.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "scan.h"       // class under test
+#include "benchmark.h"  // benchmark baseclass
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/***********************************************
+ * BENCH SCAN
+ * Sequential levels, then threads
+ ***********************************************/
+class BenchScan : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Sequential, in the cache
+      levels<int32_t>("inclusive<int32> 16K", size_t(1) << 14, false);
+      levels<int32_t>("exclusive<int32> 16K", size_t(1) << 14, true);
+      levels<int64_t>("inclusive<int64> 16K", size_t(1) << 14, false);
+      levels<float>  ("inclusive<float> 16K", size_t(1) << 14, false);
+
+      // Sequential, in memory
+      levels<int32_t>("inclusive<int32> 1M", size_t(1) << 20, false);
+
+      // Parallel
+      threads("parallel inclusive 16M", size_t(1) << 24);
+      segmented("segmented inclusive 16M", size_t(1) << 24);
+
+      report("Scan");
+   }
+
+   /***************************************
+    * LEVELS
+    * One scan kernel at every level
+    ***************************************/
+   template <typename T>
+   void levels(const std::string & group, size_t num, bool exclusive)
+   {
+      custom::vector<T> in(num, T());
+      custom::vector<T> out(num, T());
+      for (size_t i = 0; i < num; i++)
+         in[i] = T(i % 5);
+      const T * pin = &in[0];
+      T * pout = &out[0];
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         custom::simd::kernels<T> k = custom::simd::kernels<T>::at(custom::simd::level(l));
+         measure(group, custom::simd::level_name(custom::simd::level(l)), 2.0 * num * sizeof(T), [&]
+         {
+            keep(exclusive ? k.exclusive_scan(pin, pout, num, T()) : k.inclusive_scan(pin, pout, num, T()));
+         });
+      }
+   }
+
+   /***************************************
+    * THREADS
+    * The two-pass scan on 1, 2, 4 ... threads,
+    * after the one-pass scan on one thread
+    ***************************************/
+   void threads(const std::string & group, size_t num)
+   {
+      custom::vector<int32_t> in(num, 0);
+      custom::vector<int32_t> out(num, 0);
+      for (size_t i = 0; i < num; i++)
+         in[i] = int32_t(i % 5);
+      double bytes = 2.0 * num * sizeof(int32_t);
+
+      measure(group, "sequential", bytes, [&] { keep(custom::inclusive_scan(in, out)); });
+      for (size_t n = 1; n <= maxThreads(); n *= 2)
+      {
+         custom::thread_pool pool(n);
+         measure(group, std::to_string(n) + " threads", bytes,
+                 [&] { keep(custom::parallel::inclusive_scan(in, out, 0, pool)); });
+      }
+   }
+
+   /***************************************
+    * SEGMENTED
+    * Rows of 1 to 64 elements, on one thread
+    * and on every thread
+    ***************************************/
+   void segmented(const std::string & group, size_t num)
+   {
+      custom::vector<int32_t> in(num, 0);
+      custom::vector<char> flags(num, 0);
+      custom::vector<int32_t> out(num, 0);
+      for (size_t i = 0; i < num; i++)
+      {
+         in[i] = int32_t(i % 5);
+         flags[i] = (i * 2654435761u) % 64 == 0;
+      }
+      double bytes = num * (2.0 * sizeof(int32_t) + sizeof(char));
+
+      measure(group, "sequential", bytes, [&] { keep(custom::segmented_inclusive_scan(in, flags, out)); });
+      for (size_t n = 1; n <= maxThreads(); n *= 2)
+      {
+         custom::thread_pool pool(n);
+         measure(group, std::to_string(n) + " threads", bytes,
+                 [&] { keep(custom::parallel::segmented_inclusive_scan(in, flags, out, 0, pool)); });
+      }
+   }
+
+   // at least 4, to show the cost of the second pass on a small machine
+   static size_t maxThreads()
+   {
+      return std::max(size_t(4), size_t(std::thread::hardware_concurrency()));
+   }
+};
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SCHEDULER
+ * Summary:
+ *    Work stealing against static chunking when some elements cost far
+ *    more than others. Each element of a 64K vector spins for as many
+ *    steps as its cost says, with the costs laid out four ways: all the
+ *    same, rising steadily, one hot block at the front, and a few heavy
+ *    ones scattered at random. Every layout averages about 64 steps.
+ *
+ *    Each is run as a plain loop, then on a thread_pool cut into one
+ *    fixed block per thread, then on the pool's own chunks that threads
+ *    take in turn, and last on task_scheduler::for_range(). All of them
+ *    use at least four threads, or every core.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "scheduler.h"  // class under test
+#include "parallel.h"   // for thread_pool and for_chunks
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/***********************************************
+ * BENCH SCHEDULER
+ * Each way of splitting the work on each layout
+ ***********************************************/
+class BenchScheduler : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 16;
+      custom::vector<uint32_t> cost(num, uint32_t(64));
+      imbalance("even 64K", cost);
+
+      for (size_t i = 0; i < num; i++)
+         cost[i] = uint32_t(i * 128 / num);
+      imbalance("rising 64K", cost);
+
+      for (size_t i = 0; i < num; i++)
+         cost[i] = i < num / 16 ? 512 : 32;
+      imbalance("hot front 64K", cost);
+
+      uint64_t x = 1;
+      for (size_t i = 0; i < num; i++)
+      {
+         x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+         cost[i] = (x >> 58) == 0 ? 2048 : 32;
+      }
+      imbalance("scattered 64K", cost);
+
+      report("Scheduler");
+   }
+
+   /***************************************
+    * IMBALANCE
+    * The four ways of running the same work
+    ***************************************/
+   void imbalance(const std::string & group, const custom::vector<uint32_t> & cost)
+   {
+      const size_t num = cost.size();
+      const size_t threads = std::max(size_t(4), size_t(std::thread::hardware_concurrency()));
+      custom::thread_pool pool(threads);
+      custom::task_scheduler scheduler(threads);
+      custom::vector<float> out(num, 0.0f);
+
+      auto range = [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; i++)
+            out[i] = spin(cost[i], float(i));
+      };
+
+      measure(group, "plain loop", 0.0, [&]
+      {
+         range(0, num);
+         keep(out[num - 1]);
+      });
+      measure(group, "static blocks", 0.0, [&]
+      {
+         pool.run(threads, [&](size_t t)
+         {
+            range(t * num / threads, (t + 1) * num / threads);
+         });
+         keep(out[num - 1]);
+      });
+      measure(group, "pool chunks", 0.0, [&]
+      {
+         custom::parallel::for_chunks<uint32_t>(pool, num, range);
+         keep(out[num - 1]);
+      });
+      measure(group, "work stealing", 0.0, [&]
+      {
+         scheduler.for_range(0, num, 64, range);
+         keep(out[num - 1]);
+      });
+   }
+
+   /***************************************
+    * SPIN
+    * Work that takes steps times as long,
+    * each step waiting on the one before
+    ***************************************/
+   static float spin(uint32_t steps, float x)
+   {
+      for (uint32_t i = 0; i < steps; i++)
+         x = x * 0.999f + 0.5f;
+      return x;
+   }
+};
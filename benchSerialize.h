@@ -0,0 +1,112 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SERIALIZE
+ * Summary:
+ *    save() and load() of a 1 GB vector against what the file system
+ *    gives a plain write() and read() of the same bytes. The file stays
+ *    in the page cache, so this is the cost of the copies and of the
+ *    checksum, and not of the disk. load() also allocates its buffer
+ *    fresh every time, where read() goes into one already there.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "serialize.h"  // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <cstdint>
+#include <cstdio>       // for std::remove
+
+#include <fcntl.h>      // for open
+#include <unistd.h>     // for read, write, close
+
+/***********************************************
+ * BENCH SERIALIZE
+ * Save and load against write and read
+ ***********************************************/
+class BenchSerialize : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 27;
+      const size_t numBytes = num * sizeof(uint64_t);
+      const double bytes = double(numBytes);
+      custom::vector<uint64_t> v(num, uint64_t(0));
+      for (size_t i = 0; i < num; i++)
+         v[i] = i * 0x9e3779b97f4a7c15ull;
+
+      // Save
+      measure("save 1G", "write()", bytes, [&]
+      {
+         int fd = open(RAW_NAME, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+         writeRaw(fd, &v[0], numBytes);
+         close(fd);
+      });
+      measure("save 1G", "save()", bytes, [&]
+      {
+         custom::save(FILE_NAME, v);
+      });
+
+      // Load: the raw read goes back into v's own buffer
+      measure("load 1G", "read()", bytes, [&]
+      {
+         int fd = open(RAW_NAME, O_RDONLY);
+         readRaw(fd, &v[0], numBytes);
+         close(fd);
+         keep(v[num - 1]);
+      });
+      measure("load 1G", "load()", bytes, [&]
+      {
+         custom::vector<uint64_t> loaded;
+         custom::load(FILE_NAME, loaded);
+         keep(loaded[num - 1]);
+      });
+
+      std::remove(RAW_NAME);
+      std::remove(FILE_NAME);
+      report("Serialize");
+   }
+
+   /***************************************
+    * WRITE RAW / READ RAW
+    * The bytes and nothing else, a plain
+    * write() or read() at a time
+    ***************************************/
+   static void writeRaw(int fd, const void * p, size_t numBytes)
+   {
+      const char * pByte = static_cast<const char *>(p);
+      while (numBytes > 0)
+      {
+         ssize_t num = write(fd, pByte, numBytes);
+         if (num <= 0)
+            return;
+         pByte += num;
+         numBytes -= size_t(num);
+      }
+   }
+   static void readRaw(int fd, void * p, size_t numBytes)
+   {
+      char * pByte = static_cast<char *>(p);
+      while (numBytes > 0)
+      {
+         ssize_t num = read(fd, pByte, numBytes);
+         if (num <= 0)
+            return;
+         pByte += num;
+         numBytes -= size_t(num);
+      }
+   }
+
+   static constexpr const char * RAW_NAME  = "benchSerialize.raw";
+   static constexpr const char * FILE_NAME = "benchSerialize.bin";
+};
+
+#endif // !_WIN32
@@ -0,0 +1,97 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SIMD
+ * Summary:
+ *    GB/s of every kernel in simd.h at every level this CPU has, on
+ *    arrays that fit in the cache, where the instruction set decides
+ *    the speed, and on one far bigger than the cache, where memory
+ *    does.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "simd.h"       // class under test
+#include "benchmark.h"  // benchmark baseclass
+
+#include <cstdint>
+#include <string>
+
+/***********************************************
+ * BENCH SIMD
+ * Each kernel, each level, each element type
+ ***********************************************/
+class BenchSimd : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // In the cache
+      kernels<float>  ("float",  8192);
+      kernels<double> ("double", 8192);
+      kernels<int32_t>("int32",  8192);
+
+      // In memory
+      kernels<float>  ("float",  size_t(1) << 24);
+
+      report("Simd");
+   }
+
+   /***************************************
+    * KERNELS
+    * Every kernel on num elements of T
+    ***************************************/
+   template <typename T>
+   void kernels(const std::string & type, size_t num)
+   {
+      custom::vector<T> x(num, T());
+      custom::vector<T> y(num, T());
+      for (size_t i = 0; i < num; i++)
+      {
+         x[i] = T(int(i % 1000) - 500);
+         y[i] = T(int(i % 7));
+      }
+      x[num - 1] = T(-1000);   // argmin has to go all the way
+      T * px = &x[0];
+      T * py = &y[0];
+
+      std::string suffix = "<" + type + "> " + size(num * sizeof(T));
+      double bytes = double(num * sizeof(T));
+      typedef custom::simd::kernels<T> table;
+
+      // the kernel at every level, one after the other
+      auto atEveryLevel = [&](const std::string & kernel, double moved, auto f)
+      {
+         for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+         {
+            table k = table::at(custom::simd::level(l));
+            measure(kernel + suffix, custom::simd::level_name(custom::simd::level(l)),
+                    moved, [&] { f(k); });
+         }
+      };
+
+      atEveryLevel("sum", bytes, [&](table & k) { keep(k.sum(px, num)); });
+      atEveryLevel("min", bytes, [&](table & k) { keep(k.min(px, num)); });
+      atEveryLevel("max", bytes, [&](table & k) { keep(k.max(px, num)); });
+      atEveryLevel("argmin", 2.0 * bytes, [&](table & k) { keep(k.find(px, num, k.min(px, num))); });
+      atEveryLevel("dot", 2.0 * bytes, [&](table & k) { keep(k.dot(px, py, num)); });
+      atEveryLevel("axpy", 3.0 * bytes, [&](table & k) { k.axpy(T(0), px, py, num); });
+      atEveryLevel("scale", 2.0 * bytes, [&](table & k) { k.scale(T(1), py, num); });
+      atEveryLevel("clamp", 2.0 * bytes, [&](table & k) { k.clamp(py, num, T(-100), T(100)); });
+      atEveryLevel("count_equal", bytes, [&](table & k) { keep(k.count_equal(px, num, T(3))); });
+   }
+
+   /***************************************
+    * SIZE
+    * 32K or 64M
+    ***************************************/
+   static std::string size(size_t bytes)
+   {
+      if (bytes >= (size_t(1) << 20))
+         return std::to_string(bytes >> 20) + "M";
+      return std::to_string(bytes >> 10) + "K";
+   }
+};
@@ -0,0 +1,97 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SOA VECTOR
+ * Summary:
+ *    A loop over one or two fields of a 32-byte record, kept as a
+ *    vector of structs and as an soa_vector. GB/s counts only the bytes
+ *    of the fields the loop wants, so the gap is the cache lines the
+ *    struct layout drags in for nothing.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "soa_vector.h" // class under test
+#include "simd.h"       // for sum
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <string>
+
+/***********************************************
+ * BENCH SOA VECTOR
+ * Structs against columns
+ ***********************************************/
+class BenchSoaVector : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 22;
+      custom::vector<Particle> aos;
+      custom::soa_vector<float, float, float, float, float, float, float, float> soa;
+      aos.reserve(num);
+      soa.reserve(num);
+      for (size_t i = 0; i < num; i++)
+      {
+         float f = float(i % 100);
+         Particle p = { f, f, f, 1.0f, 1.0f, 1.0f, f, 0.0f };
+         aos.push_back(p);
+         soa.push_back(f, f, f, 1.0f, 1.0f, 1.0f, f, 0.0f);
+      }
+      std::string megabytes = std::to_string(num * sizeof(Particle) >> 20) + " MB of records";
+
+      // One field
+      measure("sum of mass", "structs", num * sizeof(float), [&]
+      {
+         float total = 0.0f;
+         for (size_t i = 0; i < num; i++)
+            total += aos[i].mass;
+         keep(total);
+      }, megabytes);
+      measure("sum of mass", "columns", num * sizeof(float), [&]
+      {
+         custom::span<float> mass = soa.column<6>();
+         float total = 0.0f;
+         for (size_t i = 0; i < num; i++)
+            total += mass[i];
+         keep(total);
+      });
+      measure("sum of mass", "columns+simd", num * sizeof(float), [&]
+      {
+         keep(custom::simd::sum(soa.column<6>()));
+      });
+
+      // Two fields, one of them written
+      measure("x += vx", "structs", 3.0 * num * sizeof(float), [&]
+      {
+         for (size_t i = 0; i < num; i++)
+            aos[i].x += aos[i].vx;
+      }, megabytes);
+      measure("x += vx", "columns", 3.0 * num * sizeof(float), [&]
+      {
+         custom::span<float> x = soa.column<0>();
+         custom::span<float> vx = soa.column<3>();
+         for (size_t i = 0; i < num; i++)
+            x[i] += vx[i];
+      });
+      measure("x += vx", "columns+simd", 3.0 * num * sizeof(float), [&]
+      {
+         custom::simd::axpy(1.0f, soa.column<3>(), soa.column<0>());
+      });
+
+      report("SoaVector");
+   }
+
+   // a record of eight floats, like the particles it was written for
+   struct Particle
+   {
+      float x, y, z;
+      float vx, vy, vz;
+      float mass;
+      float charge;
+   };
+};
@@ -0,0 +1,97 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SORT
+ * Summary:
+ *    parallel_sort() and parallel_stable_sort() against std::sort() and
+ *    std::stable_sort() on 4M keys laid out four ways: at random,
+ *    already sorted, reversed, and only 16 distinct values. Every run
+ *    sorts a fresh copy of the input; the time of that copy is taken
+ *    out of each row. The parallel sorts run on a scheduler of at least
+ *    four threads, so they take their parallel paths on any machine.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "sort.h"       // class under test
+#include "vector.h"
+#include "benchmark.h"  // benchmark baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/***********************************************
+ * BENCH SORT
+ * Each sort on each distribution
+ ***********************************************/
+class BenchSort : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 22;
+      custom::vector<uint64_t> random;
+      uint64_t x = 1;
+      for (size_t i = 0; i < num; i++)
+      {
+         x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+         random.push_back(x >> 11);
+      }
+      sorts("random 4M", random);
+
+      custom::vector<uint64_t> sorted(random);
+      std::sort(&sorted[0], &sorted[0] + num);
+      sorts("sorted 4M", sorted);
+
+      custom::vector<uint64_t> reversed(sorted);
+      std::reverse(&reversed[0], &reversed[0] + num);
+      sorts("reversed 4M", reversed);
+
+      custom::vector<uint64_t> few(random);
+      for (size_t i = 0; i < num; i++)
+         few[i] %= 16;
+      sorts("16 unique 4M", few);
+
+      report("Sort");
+   }
+
+   /***************************************
+    * SORTS
+    * The four sorts on copies of input
+    ***************************************/
+   void sorts(const std::string & group, const custom::vector<uint64_t> & input)
+   {
+      const size_t num = input.size();
+      const double bytes = double(num * sizeof(uint64_t));
+      const size_t threads = std::max(size_t(4), size_t(std::thread::hardware_concurrency()));
+      custom::task_scheduler scheduler(threads);
+      custom::vector<uint64_t> v(input);
+
+      // what it costs to start every run from the input
+      double copy = best([&]
+      {
+         v = input;
+         keep(v[0]);
+      });
+      auto sort = [&](const std::string & variant, auto f)
+      {
+         double seconds = best([&]
+         {
+            v = input;
+            f();
+            keep(v[0]);
+         });
+         record(group, variant, std::max(seconds - copy, 0.0), bytes);
+      };
+
+      sort("std::sort", [&] { std::sort(&v[0], &v[0] + num); });
+      sort("parallel_sort", [&] { custom::parallel_sort(v, std::less<uint64_t>(), scheduler); });
+      sort("std::stable_sort", [&] { std::stable_sort(&v[0], &v[0] + num); });
+      sort("parallel_stable", [&] { custom::parallel_stable_sort(v, std::less<uint64_t>(), scheduler); });
+   }
+};
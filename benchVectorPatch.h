@@ -0,0 +1,122 @@
+/***********************************************************************
+ * Header:
+ *    BENCH VECTOR PATCH
+ * Summary:
+ *    Patch size and speed for the edits a standby copy of a 16 MB vector
+ *    usually sees: a few scattered changes, a run set to one value, and
+ *    elements inserted or deleted at the front. Each is timed as a plain
+ *    copy of the new vector, the way it was sent before, against diff()
+ *    and apply(), with the size of the patch noted. Last, the byte
+ *    comparison diff() is built on, a word, 16 and 32 bytes at a time.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include "vector_patch.h" // class under test
+#include "vector.h"
+#include "benchmark.h"    // benchmark baseclass
+
+#include <cstdint>
+#include <string>
+
+/***********************************************
+ * BENCH VECTOR PATCH
+ * Edits, then the comparison
+ ***********************************************/
+class BenchVectorPatch : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t num = size_t(1) << 22;
+      custom::vector<int32_t> a;
+      for (size_t i = 0; i < num; i++)
+         a.push_back(int32_t(i * 2654435761u));
+
+      // Edits
+      custom::vector<int32_t> scattered(a);
+      for (size_t i = 0; i < num; i += 1000)
+         scattered[i] += 1;
+      edit("0.1% changed", a, scattered);
+
+      custom::vector<int32_t> filled(a);
+      for (size_t i = num / 2; i < num / 2 + 10000; i++)
+         filled[i] = 0;
+      edit("10K set to 0", a, filled);
+
+      custom::vector<int32_t> inserted;
+      for (int32_t i = 0; i < 100; i++)
+         inserted.push_back(-i);
+      for (size_t i = 0; i < num; i++)
+         inserted.push_back(a[i]);
+      edit("100 inserted at front", a, inserted);
+
+      custom::vector<int32_t> deleted;
+      for (size_t i = 100; i < num; i++)
+         deleted.push_back(a[i]);
+      edit("100 deleted at front", a, deleted);
+
+      // Comparison
+      comparison("matching bytes 16K", size_t(1) << 14);
+      comparison("matching bytes 16M", size_t(1) << 24);
+
+      report("VectorPatch");
+   }
+
+   /***************************************
+    * COMPARISON
+    * Two equal buffers of num bytes, so every
+    * byte is compared
+    ***************************************/
+   void comparison(const std::string & group, size_t num)
+   {
+      custom::vector<unsigned char> a(num, 7);
+      custom::vector<unsigned char> b(num, 7);
+      const unsigned char * p = &a[0];
+      const unsigned char * q = &b[0];
+      measure(group, "words", 2.0 * num,
+              [&] { keep(custom::patch_detail::matchingWords(p, q, 0, num)); });
+      measure(group, "sse2", 2.0 * num,
+              [&] { keep(custom::patch_detail::matchingSse2(p, q, num)); });
+#ifdef CUSTOM_SIMD_X86
+      if (custom::simd::detected_level() >= custom::simd::AVX2)
+         measure(group, "avx2", 2.0 * num,
+                 [&] { keep(custom::patch_detail::matchingAvx2(p, q, num)); });
+#endif
+   }
+
+   /***************************************
+    * EDIT
+    * Sending b whole against sending the
+    * patch from a to b
+    ***************************************/
+   void edit(const std::string & group, const custom::vector<int32_t> & a,
+             const custom::vector<int32_t> & b)
+   {
+      double bytes = double(b.size() * sizeof(int32_t));
+      custom::patch<int32_t> p = custom::diff(a, b);
+      measure(group, "copy whole", bytes, [&]
+      {
+         custom::vector<int32_t> c(b);
+         keep(c.size());
+      }, std::to_string(b.size() * sizeof(int32_t)) + " bytes to send");
+      measure(group, "diff", double(a.size() * sizeof(int32_t)) + bytes, [&]
+      {
+         custom::patch<int32_t> d = custom::diff(a, b);
+         keep(d.ops.size());
+      }, std::to_string(p.size_bytes()) + " bytes to send, " +
+         std::to_string(p.ops.size()) + " ops");
+      // a to b and back again, so every run starts from a
+      custom::patch<int32_t> back = custom::diff(b, a);
+      custom::vector<int32_t> c(a);
+      measure(group, "apply+undo", 0.0, [&]
+      {
+         custom::apply(c, p);
+         custom::apply(c, back);
+      }, "two applies");
+   }
+};
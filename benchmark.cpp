@@ -0,0 +1,101 @@
+/***********************************************************************
+ * Header:
+ *    Benchmark
+ * Summary:
+ *    Driver for the benchmarks. It is a program of its own, apart from
+ *    the unit tests, and wants to be built with the optimizer on and
+ *    the asserts off:
+ *
+ *       g++ -std=c++14 -O2 -DNDEBUG -pthread -o benchmark benchmark.cpp
+ *
+ *    In Visual Studio it is the Benchmark project of the solution, best
+ *    built as Release.
+ *
+ *    With no arguments every benchmark runs. Naming some, as in
+ *    "benchmark simd scan", runs only those. Setting CUSTOM_SIMD_LEVEL
+ *    changes the level the dispatched kernels run at, but the tables
+ *    that time each level by name ignore it.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#include "benchSoaVector.h" // for the soa_vector benchmarks
+#include "benchHugePage.h"  // for the huge_page benchmarks
+#include "benchSerialize.h" // for the serialize benchmarks
+#include "benchMmapVector.h" // for the mmap_vector benchmarks
+#include "benchExternalVector.h" // for the external_vector benchmarks
+#include "benchLogVector.h" // for the log_vector benchmarks
+#include "benchCheckpoint.h" // for the checkpoint benchmarks
+#include "benchVectorPatch.h" // for the vector_patch benchmarks
+#include "benchParallel.h"  // for the parallel benchmarks
+#include "benchScheduler.h" // for the scheduler benchmarks
+#include "benchSort.h"      // for the sort benchmarks
+#include "benchSimd.h"      // for the simd benchmarks
+#include "benchDispatch.h"  // for the dispatch benchmarks
+#include "benchExpr.h"      // for the expression template benchmarks
+#include "benchCompact.h"   // for the compaction benchmarks
+#include "benchScan.h"      // for the scan benchmarks
+
+#include <cstring>          // for strcmp
+
+/**********************************************************************
+ * WANTED
+ * Whether the benchmark called name was asked for
+ ***********************************************************************/
+static bool wanted(int argc, char ** argv, const char * name)
+{
+   if (argc < 2)
+      return true;
+   for (int i = 1; i < argc; i++)
+      if (strcmp(argv[i], name) == 0)
+         return true;
+   return false;
+}
+
+/**********************************************************************
+ * MAIN
+ * Run the benchmarks that were asked for
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   printf("SIMD level: detected %s, active %s\n\n",
+          custom::simd::level_name(custom::simd::detected_level()),
+          custom::simd::level_name(custom::simd::active_level()));
+
+   if (wanted(argc, argv, "soa"))
+      BenchSoaVector().run();
+   if (wanted(argc, argv, "hugepage"))
+      BenchHugePage().run();
+#ifndef _WIN32
+   if (wanted(argc, argv, "serialize"))
+      BenchSerialize().run();
+   if (wanted(argc, argv, "mmap"))
+      BenchMmapVector().run();
+   if (wanted(argc, argv, "external"))
+      BenchExternalVector().run();
+   if (wanted(argc, argv, "log"))
+      BenchLogVector().run();
+   if (wanted(argc, argv, "checkpoint"))
+      BenchCheckpoint().run();
+#endif
+   if (wanted(argc, argv, "patch"))
+      BenchVectorPatch().run();
+   if (wanted(argc, argv, "parallel"))
+      BenchParallel().run();
+   if (wanted(argc, argv, "scheduler"))
+      BenchScheduler().run();
+   if (wanted(argc, argv, "sort"))
+      BenchSort().run();
+   if (wanted(argc, argv, "simd"))
+      BenchSimd().run();
+   if (wanted(argc, argv, "dispatch"))
+      BenchDispatch().run();
+   if (wanted(argc, argv, "expr"))
+      BenchExpr().run();
+   if (wanted(argc, argv, "scan"))
+      BenchScan().run();
+   if (wanted(argc, argv, "compact"))
+      BenchCompact().run();
+
+   return 0;
+}
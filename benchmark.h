@@ -0,0 +1,156 @@
+/***********************************************************************
+ * Header:
+ *    BENCHMARK
+ * Summary:
+ *    The base class to all the benchmark classes. A benchmark times a
+ *    few variants of the same work, such as one kernel at every SIMD
+ *    level, and reports each one as a row: the best time of several
+ *    runs, the bytes it moved per second, and how much faster it ran
+ *    than the first row of its group.
+ *
+ *    Each run is repeated until it has taken about a fifth of a second
+ *    in all, and the fastest one is kept, since anything slower than
+ *    that was the machine doing something else.
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <chrono>    // for std::chrono::steady_clock
+#include <cstdio>    // for printf
+#include <string>    // for std::string
+#include <vector>    // for std::vector
+
+class Benchmark
+{
+public:
+   Benchmark() : minSeconds(0.2) { reset(); }
+
+private:
+   // a row is one variant of one piece of work
+   struct Row
+   {
+      std::string group;
+      std::string variant;
+      double      seconds;
+      double      bytes;
+      std::string note;
+   };
+
+   std::vector<Row> rows;
+
+protected:
+   double minSeconds;    // how long to keep repeating each run
+
+   /*************************************************************
+    * RESET
+    * Forget the rows
+    *************************************************************/
+   void reset()
+   {
+      rows.clear();
+   }
+
+   /*************************************************************
+    * BEST
+    * The fewest seconds one call of f took. f runs once to warm
+    * the caches, then at least three more times.
+    *************************************************************/
+   template <class F>
+   double best(F f)
+   {
+      typedef std::chrono::steady_clock clock;
+      f();
+      double fastest = 0.0;
+      double total = 0.0;
+      for (int num = 0; num < 3 || total < minSeconds; num++)
+      {
+         clock::time_point begin = clock::now();
+         f();
+         double seconds = std::chrono::duration<double>(clock::now() - begin).count();
+         total += seconds;
+         if (num == 0 || seconds < fastest)
+            fastest = seconds;
+      }
+      return fastest;
+   }
+
+   /*************************************************************
+    * RECORD
+    * Add a row. bytes is what one run read and wrote.
+    *************************************************************/
+   void record(const std::string & group, const std::string & variant,
+               double seconds, double bytes, const std::string & note = "")
+   {
+      Row row = { group, variant, seconds, bytes, note };
+      rows.push_back(row);
+   }
+
+   /*************************************************************
+    * MEASURE
+    * Time f and add it as a row
+    *************************************************************/
+   template <class F>
+   double measure(const std::string & group, const std::string & variant,
+                  double bytes, F f, const std::string & note = "")
+   {
+      double seconds = best(f);
+      record(group, variant, seconds, bytes, note);
+      return seconds;
+   }
+
+   /*************************************************************
+    * REPORT
+    * Print the rows, each with its speedup over the first row
+    * of its group
+    *************************************************************/
+   void report(const char * name)
+   {
+      printf("%s\n", name);
+      printf("   %-28s %-18s %15s %10s %8s\n", "", "", "time", "GB/s", "speedup");
+      double first = 0.0;
+      for (size_t i = 0; i < rows.size(); i++)
+      {
+         const Row & row = rows[i];
+         bool starts = i == 0 || rows[i - 1].group != row.group;
+         if (starts)
+            first = row.seconds;
+         printf("   %-28s %-18s %12.3f us",
+                starts ? row.group.c_str() : "", row.variant.c_str(), row.seconds * 1e6);
+         if (row.bytes > 0.0 && row.seconds > 0.0)
+            printf(" %10.2f", row.bytes / row.seconds / 1e9);
+         else
+            printf(" %10s", "-");
+         if (row.seconds > 0.0)
+            printf(" %7.2fx", first / row.seconds);
+         else
+            printf(" %8s", "-");
+         if (!row.note.empty())
+            printf("   %s", row.note.c_str());
+         printf("\n");
+      }
+      printf("\n");
+      fflush(stdout);
+   }
+
+   /*************************************************************
+    * KEEP
+    * Make the compiler believe value is used, so the work that
+    * made it is not thrown away
+    *************************************************************/
+   template <typename T>
+   static void keep(const T & value)
+   {
+      const volatile char * p = reinterpret_cast<const volatile char *>(&value);
+      for (size_t i = 0; i < sizeof(T); i++)
+         sink() = p[i];
+   }
+
+private:
+   static volatile char & sink()
+   {
+      static volatile char s;
+      return s;
+   }
+};
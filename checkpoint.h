@@ -0,0 +1,495 @@
+/***********************************************************************
+ * Header:
+ *    CHECKPOINT
+ * Summary:
+ *    Incremental checkpoints of a large vector. A tracked_vector behaves
+ *    like our vector, except that every mutating access marks the page
+ *    holding that element as dirty. A checkpoint is then a full base file
+ *    once, followed by delta files holding only the pages that changed
+ *    since the last checkpoint. apply_delta() replays a delta onto a base.
+ *
+ *    Both files start with the same header:
+ *       +-------+---------+-------+--------+-------------+
+ *       | magic | version | flags | endian | elementSize |
+ *       +-------+---------+-------+--------+-------------+
+ *       | pageElements | count | numPages |
+ *       +--------------+-------+----------+
+ *    A base file follows it with count raw elements. A delta file follows
+ *    it with numPages records of
+ *       +------+-------------+---------+----------+-------------+
+ *       | page | numElements | padding | checksum | element ... |
+ *       +------+-------------+---------+----------+-------------+
+ *
+ *    This will contain:
+ *        tracked_vector         : A vector that records which pages changed
+ *        save_base              : Write every element
+ *        save_delta             : Write just the dirty pages
+ *        apply_delta            : Bring a base file up to date
+ *        load_base              : Read a base file back into a vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32   // this needs POSIX pwrite() and ftruncate()
+
+#include <cassert>     // because I am paranoid
+#include <cstdint>     // for uint32_t, uint64_t, and INT64_MAX
+#include <stdexcept>   // for std::runtime_error
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable
+#include <utility>     // for std::swap
+#include <vector>      // the dirty page bitmap
+
+#include <fcntl.h>     // for open
+#include <unistd.h>    // for pwrite, ftruncate, close
+
+#include "serialize.h" // for checksum, readAll, and writeAll
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * CHECKPOINT HEADER
+ * The first 40 bytes of a base or a delta
+ ****************************************/
+struct checkpoint_header
+{
+   enum { MAGIC_BASE  = 0x42435643,   // "CVCB"
+          MAGIC_DELTA = 0x44435643,   // "CVCD"
+          VERSION     = 1 };
+
+   uint32_t magic;
+   uint16_t version;
+   uint16_t flags;
+   uint32_t endian;
+   uint32_t elementSize;
+   uint64_t pageElements;   // elements in one page
+   uint64_t count;          // elements in the vector
+   uint64_t numPages;       // page records that follow (delta only)
+};
+static_assert(sizeof(checkpoint_header) == 40, "the header must be 40 bytes");
+
+/*****************************************
+ * PAGE RECORD
+ * In front of every page in a delta
+ ****************************************/
+struct page_record
+{
+   uint64_t page;
+   uint32_t numElements;
+   uint32_t padding;
+   uint64_t checksum;
+};
+
+/*****************************************
+ * DIRTY BITMAP
+ * One bit per page of elements
+ ****************************************/
+class dirty_bitmap
+{
+public:
+   dirty_bitmap() : numDirty(0) { }
+
+   void mark(size_t page)
+   {
+      if (page / 64 >= bits.size())
+         bits.resize(page / 64 + 1, 0);
+      uint64_t mask = uint64_t(1) << (page % 64);
+      if (!(bits[page / 64] & mask))
+      {
+         bits[page / 64] |= mask;
+         numDirty++;
+      }
+   }
+   void mark(size_t firstPage, size_t lastPage)
+   {
+      for (size_t page = firstPage; page <= lastPage; page++)
+         mark(page);
+   }
+   bool test(size_t page) const
+   {
+      return page / 64 < bits.size() && (bits[page / 64] >> (page % 64)) & 1;
+   }
+   void   clear()       { bits.clear(); numDirty = 0; }
+   size_t count() const { return numDirty;            }
+   size_t end()   const { return bits.size() * 64;    }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   std::vector<uint64_t> bits;
+   size_t                numDirty;
+};
+
+/*****************************************
+ * TRACKED VECTOR
+ * Our vector, plus a record of the pages that
+ * were handed out for writing. Reading through
+ * a const tracked_vector marks nothing.
+ ****************************************/
+template <typename T>
+class tracked_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "tracked_vector needs a trivially copyable T");
+
+public:
+   static const size_t DEFAULT_PAGE_BYTES = 4096;
+
+   //
+   // Construct
+   //
+
+   tracked_vector(size_t pageBytes = DEFAULT_PAGE_BYTES) : sizeChanged(false)
+   {
+      pageElements = pageBytes / sizeof(T) ? pageBytes / sizeof(T) : 1;
+   }
+
+   //
+   // Assign
+   //
+
+   void swap(tracked_vector & rhs)
+   {
+      elements.swap(rhs.elements);
+      std::swap(pageElements, rhs.pageElements);
+      std::swap(dirty,        rhs.dirty);
+      std::swap(sizeChanged,  rhs.sizeChanged);
+   }
+
+   //
+   // Iterator
+   //
+
+   class iterator;
+   iterator begin() { return iterator(this, 0);                }
+   iterator end()   { return iterator(this, elements.size());  }
+
+   //
+   // Access
+   //
+
+   T & operator [] (size_t index)
+   {
+      touch(index);
+      return elements[index];
+   }
+   const T & operator [] (size_t index) const { return elements[index];  }
+   T &       front()                          { return (*this)[0];       }
+   const T & front()                    const { return elements.front(); }
+   T &       back()                           { return (*this)[size() - 1]; }
+   const T & back()                     const { return elements.back();  }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t)
+   {
+      elements.push_back(t);
+      touch(elements.size() - 1);
+      sizeChanged = true;
+   }
+   void reserve(size_t newCapacity) { elements.reserve(newCapacity); }
+   void resize(size_t newElements, const T & t = T())
+   {
+      if (newElements > elements.size())
+         dirty.mark(elements.size() / pageElements, (newElements - 1) / pageElements);
+      if (newElements != elements.size())
+         sizeChanged = true;
+      elements.resize(newElements, t);
+   }
+
+   //
+   // Remove
+   //
+
+   void pop_back()
+   {
+      if (elements.size())
+         sizeChanged = true;
+      elements.pop_back();
+   }
+
+   //
+   // Status
+   //
+
+   size_t size()         const { return elements.size();      }
+   size_t capacity()     const { return elements.capacity();  }
+   bool   empty()        const { return elements.size() == 0; }
+   size_t page_elements() const { return pageElements;        }
+   size_t dirty_pages()  const { return dirty.count();        }
+   bool   is_dirty(size_t page) const { return dirty.test(page); }
+
+   // forget what has changed: the last checkpoint has it all
+   void mark_clean()
+   {
+      dirty.clear();
+      sizeChanged = false;
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   void touch(size_t index) { dirty.mark(index / pageElements); }
+
+   vector<T>    elements;       // the vector itself
+   size_t       pageElements;   // the number of elements in a page
+   dirty_bitmap dirty;          // pages changed since the last checkpoint
+   bool         sizeChanged;    // the size changed since the last checkpoint
+};
+
+/**************************************************
+ * TRACKED VECTOR ITERATOR
+ * Dereferencing marks the element's page, since
+ * we cannot tell a read from a write
+ *************************************************/
+template <typename T>
+class tracked_vector <T> :: iterator
+{
+public:
+   // constructors, destructors, and assignment operator
+   iterator()                                  : pv(nullptr), index(0)     { }
+   iterator(tracked_vector * pv, size_t index) : pv(pv),      index(index) { }
+
+   // equals, not equals operator
+   bool operator != (const iterator & rhs) const { return index != rhs.index; }
+   bool operator == (const iterator & rhs) const { return index == rhs.index; }
+
+   // dereference operator
+   T & operator * () { return (*pv)[index]; }
+
+   // prefix and postfix increment
+   iterator & operator ++ ()    { index++; return *this; }
+   iterator   operator ++ (int) { iterator i = *this; index++; return i; }
+
+   // prefix and postfix decrement
+   iterator & operator -- ()    { index--; return *this; }
+   iterator   operator -- (int) { iterator i = *this; index--; return i; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   tracked_vector * pv;
+   size_t           index;
+};
+
+/*****************************************
+ * CHECKPOINT FILE
+ * Open a file for a checkpoint function,
+ * closing it again when we are done
+ ****************************************/
+class checkpoint_file
+{
+public:
+   checkpoint_file(const std::string & fileName, int flags) :
+      fd(open(fileName.c_str(), flags, 0644))
+   {
+      if (fd == -1)
+         throw std::runtime_error("checkpoint: unable to open " + fileName);
+   }
+   ~checkpoint_file() { ::close(fd); }
+   int fd;
+};
+
+/*****************************************
+ * SAVE BASE
+ * Write every element, then start tracking
+ * changes from here
+ ****************************************/
+template <typename T>
+void save_base(const std::string & fileName, tracked_vector<T> & v)
+{
+   checkpoint_file file(fileName, O_WRONLY | O_CREAT | O_TRUNC);
+   const tracked_vector<T> & cv = v;
+
+   checkpoint_header header = {};
+   header.magic        = checkpoint_header::MAGIC_BASE;
+   header.version      = checkpoint_header::VERSION;
+   header.endian       = serial_header::ENDIAN;
+   header.elementSize  = uint32_t(sizeof(T));
+   header.pageElements = cv.page_elements();
+   header.count        = cv.size();
+   writeAll(file.fd, &header, sizeof(header),
+            cv.size() ? &cv[0] : nullptr, cv.size() * sizeof(T));
+   v.mark_clean();
+}
+
+/*****************************************
+ * SAVE DELTA
+ * Write only the pages that changed since the
+ * last checkpoint, then start over. A delta
+ * with no pages still records the new size.
+ ****************************************/
+template <typename T>
+void save_delta(const std::string & fileName, tracked_vector<T> & v)
+{
+   checkpoint_file file(fileName, O_WRONLY | O_CREAT | O_TRUNC);
+   const tracked_vector<T> & cv = v;
+   const size_t pageElements = cv.page_elements();
+   const size_t numPages = (cv.size() + pageElements - 1) / pageElements;
+
+   // pages past the end were dropped by pop_back() or resize()
+   checkpoint_header header = {};
+   header.magic        = checkpoint_header::MAGIC_DELTA;
+   header.version      = checkpoint_header::VERSION;
+   header.endian       = serial_header::ENDIAN;
+   header.elementSize  = uint32_t(sizeof(T));
+   header.pageElements = pageElements;
+   header.count        = cv.size();
+   for (size_t page = 0; page < numPages; page++)
+      if (cv.is_dirty(page))
+         header.numPages++;
+   writeAll(file.fd, &header, sizeof(header), nullptr, 0);
+
+   for (size_t page = 0; page < numPages; page++)
+   {
+      if (!cv.is_dirty(page))
+         continue;
+
+      size_t first = page * pageElements;
+      size_t num   = cv.size() - first < pageElements ? cv.size() - first : pageElements;
+      page_record record = {};
+      record.page        = page;
+      record.numElements = uint32_t(num);
+      record.checksum    = checksum(&cv[first], num * sizeof(T));
+      writeAll(file.fd, &record, sizeof(record), &cv[first], num * sizeof(T));
+   }
+   v.mark_clean();
+}
+
+/*****************************************
+ * APPLY DELTA
+ * The replay tool: write each page of the
+ * delta into the base file and set its new
+ * size. The whole delta is checked before
+ * the base is touched. Nothing is allocated
+ * for a page until the delta is known to be
+ * long enough to hold it.
+ ****************************************/
+inline void apply_delta(const std::string & baseName, const std::string & deltaName)
+{
+   checkpoint_file base(baseName, O_RDWR);
+   checkpoint_file delta(deltaName, O_RDONLY);
+
+   checkpoint_header baseHeader;
+   checkpoint_header deltaHeader;
+   readAll(base.fd,  &baseHeader,  sizeof(baseHeader));
+   readAll(delta.fd, &deltaHeader, sizeof(deltaHeader));
+   if (baseHeader.magic != checkpoint_header::MAGIC_BASE ||
+       deltaHeader.magic != checkpoint_header::MAGIC_DELTA)
+      throw std::runtime_error("checkpoint: not a base and a delta");
+   if (baseHeader.version != checkpoint_header::VERSION ||
+       deltaHeader.version != checkpoint_header::VERSION ||
+       baseHeader.endian != serial_header::ENDIAN ||
+       deltaHeader.endian != serial_header::ENDIAN)
+      throw std::runtime_error("checkpoint: unknown version or endianness");
+   if (baseHeader.elementSize != deltaHeader.elementSize ||
+       baseHeader.pageElements != deltaHeader.pageElements ||
+       baseHeader.pageElements == 0 || baseHeader.elementSize == 0)
+      throw std::runtime_error("checkpoint: the delta does not fit the base");
+
+   const uint64_t elementSize  = baseHeader.elementSize;
+   const uint64_t pageElements = baseHeader.pageElements;
+   const uint64_t count        = deltaHeader.count;
+   const uint64_t countPages   = count / pageElements + (count % pageElements ? 1 : 0);
+   if (count > uint64_t(INT64_MAX - sizeof(checkpoint_header)) / elementSize)
+      throw std::runtime_error("checkpoint: the delta is too big");
+   if (deltaHeader.numPages > countPages)
+      throw std::runtime_error("checkpoint: the delta has too many pages");
+
+   // every page takes at least its record: more than that is a damaged header
+   uint64_t numLeft;
+   if (!bytesLeft(delta.fd, numLeft))
+      throw std::runtime_error("checkpoint: unable to size " + deltaName);
+   if (deltaHeader.numPages > numLeft / sizeof(page_record))
+      throw std::runtime_error("checkpoint: the delta is truncated");
+
+   // read and check every page first
+   std::vector<page_record> records(size_t(deltaHeader.numPages));
+   std::vector<size_t>      offsets(records.size());
+   std::string payload;
+   for (size_t i = 0; i < records.size(); i++)
+   {
+      readAll(delta.fd, &records[i], sizeof(page_record));
+      numLeft -= sizeof(page_record);
+      uint64_t numBytes = uint64_t(records[i].numElements) * elementSize;
+      if (records[i].numElements > pageElements || records[i].page >= countPages ||
+          records[i].page * pageElements + records[i].numElements > count)
+         throw std::runtime_error("checkpoint: a page in the delta is out of range");
+      if (numBytes > numLeft)
+         throw std::runtime_error("checkpoint: the delta is truncated");
+      numLeft -= numBytes;
+
+      offsets[i] = payload.size();
+      payload.resize(payload.size() + size_t(numBytes));
+      if (numBytes)
+         readAll(delta.fd, &payload[offsets[i]], size_t(numBytes));
+      if (checksum(payload.data() + offsets[i], size_t(numBytes)) != records[i].checksum)
+         throw std::runtime_error("checkpoint: checksum mismatch in the delta");
+   }
+
+   // now bring the base up to date
+   if (ftruncate(base.fd, off_t(sizeof(checkpoint_header) + count * elementSize)) != 0)
+      throw std::runtime_error("checkpoint: unable to resize " + baseName);
+   for (size_t i = 0; i < records.size(); i++)
+   {
+      const char * p = payload.data() + offsets[i];
+      size_t numBytes = size_t(records[i].numElements * elementSize);
+      off_t offset = off_t(sizeof(checkpoint_header) + records[i].page * pageElements * elementSize);
+      for (size_t done = 0; done < numBytes; )
+      {
+         ssize_t num = pwrite(base.fd, p + done, numBytes - done, offset + done);
+         if (num <= 0)
+            throw std::runtime_error("checkpoint: unable to write " + baseName);
+         done += num;
+      }
+   }
+
+   baseHeader.count = count;
+   if (pwrite(base.fd, &baseHeader, sizeof(baseHeader), 0) != ssize_t(sizeof(baseHeader)))
+      throw std::runtime_error("checkpoint: unable to write " + baseName);
+}
+
+/*****************************************
+ * LOAD BASE
+ * Read a base file back into a vector,
+ * with nothing marked dirty
+ ****************************************/
+template <typename T>
+void load_base(const std::string & fileName, tracked_vector<T> & v)
+{
+   checkpoint_file file(fileName, O_RDONLY);
+
+   checkpoint_header header;
+   readAll(file.fd, &header, sizeof(header));
+   if (header.magic != checkpoint_header::MAGIC_BASE ||
+       header.version != checkpoint_header::VERSION ||
+       header.endian != serial_header::ENDIAN ||
+       header.elementSize != sizeof(T))
+      throw std::runtime_error("checkpoint: " + fileName + " is not a base of this type");
+   uint64_t numLeft;
+   if (bytesLeft(file.fd, numLeft) && header.count > numLeft / sizeof(T))
+      throw std::runtime_error("checkpoint: " + fileName + " is truncated");
+
+   tracked_vector<T> vNew(size_t(header.pageElements) * sizeof(T));
+   vNew.resize(size_t(header.count));
+   if (header.count)
+      readAll(file.fd, &vNew[0], size_t(header.count) * sizeof(T));
+   vNew.mark_clean();
+   v.swap(vNew);
+}
+
+} // namespace custom
+
+#endif // !_WIN32
@@ -0,0 +1,687 @@
+/***********************************************************************
+ * Header:
+ *    COMPACT
+ * Summary:
+ *    Stream compaction: copy_if, remove_if and a stable partition over
+ *    vectors, without a branch on the predicate.
+ *
+ *    Every element is written to the next free place in the output
+ *    whether it is kept or not, and the next free place only moves on
+ *    when it is, so there is nothing for the CPU to mispredict. When
+ *    the predicate is one of the where:: comparisons and the elements
+ *    are four or eight bytes wide, a whole register is compared at once
+ *    and its kept elements are packed together in one instruction:
+ *    vpcompress on AVX-512, or on AVX2 a permute whose lane order comes
+ *    from a table indexed by the compare mask. Any other predicate gets
+ *    the branch-free loop.
+ *
+ *    The output is written in place and has to be big enough for what
+ *    is kept; writing as much as the input always is. The parallel
+ *    versions count what each block keeps, turn the counts into offsets
+ *    with an exclusive scan, then compact every block at once straight
+ *    into its place.
+ *
+ *    This will contain the class definition of:
+ *        where::less .. between : Predicates the kernels can vectorize
+ *        copy_if                : Copy the elements pred() is true of
+ *        remove_if              : Drop them in place
+ *        partition              : Those elements, then the rest, in order
+ *        parallel::...          : The same on every thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int32_t
+#include <cstring>      // for memcpy
+#include <type_traits>  // for std::is_base_of
+#include <vector>       // for the block counts
+
+#include "parallel.h"   // for thread_pool and chunk_size
+#include "scan.h"       // for exclusive_scan
+#include "simd.h"       // for active_level and lanes::reg
+#include "span.h"
+#include "vector.h"
+
+#ifdef CUSTOM_SIMD_X86
+#include <immintrin.h>  // for _mm512_mask_compressstoreu_epi32 and friends
+#endif
+
+namespace custom
+{
+namespace where
+{
+
+/*****************************************
+ * LANES PREDICATE
+ * The base of a predicate that can also test
+ * a whole register x, setting every lane of
+ * m that it is true of
+ ****************************************/
+struct lanes_predicate { };
+
+template <typename T>
+struct less_than : lanes_predicate
+{
+   typedef T value_type;
+   explicit less_than(T value) : value(value) { }
+   bool operator () (const T & x) const { return x < value; }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { m = x < (V() + value); }
+   T value;
+};
+
+template <typename T>
+struct greater_than : lanes_predicate
+{
+   typedef T value_type;
+   explicit greater_than(T value) : value(value) { }
+   bool operator () (const T & x) const { return x > value; }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { m = x > (V() + value); }
+   T value;
+};
+
+template <typename T>
+struct equal_to : lanes_predicate
+{
+   typedef T value_type;
+   explicit equal_to(T value) : value(value) { }
+   bool operator () (const T & x) const { return x == value; }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { m = x == (V() + value); }
+   T value;
+};
+
+template <typename T>
+struct not_equal_to : lanes_predicate
+{
+   typedef T value_type;
+   explicit not_equal_to(T value) : value(value) { }
+   bool operator () (const T & x) const { return x != value; }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { m = x != (V() + value); }
+   T value;
+};
+
+// lo <= x <= hi
+template <typename T>
+struct in_range : lanes_predicate
+{
+   typedef T value_type;
+   in_range(T lo, T hi) : lo(lo), hi(hi) { }
+   bool operator () (const T & x) const { return lo <= x && x <= hi; }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { m = (x >= (V() + lo)) & (x <= (V() + hi)); }
+   T lo;
+   T hi;
+};
+
+template <typename T> less_than<T>    less(T value)      { return less_than<T>(value);    }
+template <typename T> greater_than<T> greater(T value)   { return greater_than<T>(value); }
+template <typename T> equal_to<T>     equal(T value)     { return equal_to<T>(value);     }
+template <typename T> not_equal_to<T> not_equal(T value) { return not_equal_to<T>(value); }
+template <typename T> in_range<T>     between(T lo, T hi) { return in_range<T>(lo, hi);  }
+
+/*****************************************
+ * NEGATION
+ * True where P is false. Vectorizes when P
+ * does.
+ ****************************************/
+template <class P, bool = std::is_base_of<lanes_predicate, P>::value>
+struct negation_base { };
+
+template <class P>
+struct negation_base <P, true> : lanes_predicate
+{
+   typedef typename P::value_type value_type;
+};
+
+template <class P>
+struct negation : negation_base<P>
+{
+   negation(const P & p) : p(p) { }
+   template <class X>
+   bool operator () (const X & x) const { return !p(x); }
+   template <class V, class M>
+   void mask(const V & x, M & m) const { p.mask(x, m); m = ~m; }
+   P p;
+};
+
+} // namespace where
+
+namespace compact_detail
+{
+
+/*****************************************
+ * VECTORIZABLE
+ * Whether the kernels can test Pred a whole
+ * register of T at a time
+ ****************************************/
+template <typename T, class Pred, class Enable = void>
+struct vectorizable : std::false_type { };
+
+template <typename T, class Pred>
+struct vectorizable <T, Pred,
+                     typename std::enable_if<std::is_base_of<where::lanes_predicate, Pred>::value>::type>
+   : std::integral_constant<bool, std::is_same<typename Pred::value_type, T>::value &&
+                                  std::is_arithmetic<T>::value && !std::is_same<T, bool>::value> { };
+
+/*****************************************
+ * SCALAR COMPRESS
+ * Every element is written, and only a kept
+ * one moves j on. Nothing is written past
+ * room. Returns how many were kept.
+ ****************************************/
+template <typename T, class Pred>
+size_t scalarCompress(const T * in, size_t n, T * out, size_t room, const Pred & p, std::true_type)
+{
+   size_t j = 0;
+   for (size_t i = 0; i < n; i++)
+   {
+      T x = in[i];
+      size_t keep = p(x) ? 1 : 0;
+      if (j < room)
+         out[j] = x;
+      j += keep;
+   }
+   return j;
+}
+
+// an element that is not cheap to copy is only copied when it is kept
+template <typename T, class Pred>
+size_t scalarCompress(const T * in, size_t n, T * out, size_t room, const Pred & p, std::false_type)
+{
+   size_t j = 0;
+   for (size_t i = 0; i < n; i++)
+      if (p(in[i]))
+      {
+         assert(j < room);
+         if (out + j != in + i)
+            out[j] = in[i];
+         j++;
+      }
+   return j;
+}
+
+template <typename T, class Pred>
+size_t scalarCompress(const T * in, size_t n, T * out, size_t room, const Pred & p)
+{
+   return scalarCompress(in, n, out, room, p,
+                         std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+}
+
+template <typename T, class Pred>
+size_t scalarCount(const T * in, size_t n, const Pred & p)
+{
+   size_t num = 0;
+   for (size_t i = 0; i < n; i++)
+      num += p(in[i]) ? 1 : 0;
+   return num;
+}
+
+#ifdef CUSTOM_SIMD_X86
+/*****************************************
+ * LANES COUNT
+ * How many pred() is true of, a register at
+ * a time, as simd::count_equal counts
+ ****************************************/
+template <typename T, size_t B, class Pred>
+size_t lanesCount(const T * in, size_t n, const Pred & p)
+{
+   typedef typename simd::lanes::reg<T, B>::type V;
+   typedef decltype(V() == V()) M;
+   const size_t W = simd::lanes::reg<T, B>::width;
+   const size_t most = sizeof(T) >= 4 ? size_t(1) << 30
+                                      : (size_t(1) << (8 * sizeof(T) - 1)) - 1;
+   size_t num = 0;
+   size_t i = 0;
+   while (i + W <= n)
+   {
+      M counts = { };
+      for (size_t run = 0; run < most && i + W <= n; run++, i += W)
+      {
+         V x;
+         M m;
+         memcpy(&x, in + i, sizeof(V));
+         p.mask(x, m);
+         counts -= m;
+      }
+      for (size_t k = 0; k < W; k++)
+         num += size_t(counts[k]);
+   }
+   return num + scalarCount(in + i, n - i, p);
+}
+
+template <typename T, class Pred> __attribute__((target("sse4.2"), flatten))
+size_t sse42Count(const T * in, size_t n, const Pred & p) { return lanesCount<T, 16>(in, n, p); }
+template <typename T, class Pred> __attribute__((target("avx2"), flatten))
+size_t avx2Count(const T * in, size_t n, const Pred & p) { return lanesCount<T, 32>(in, n, p); }
+template <typename T, class Pred> __attribute__((target("avx512f"), flatten))
+size_t avx512Count(const T * in, size_t n, const Pred & p) { return lanesCount<T, 64>(in, n, p); }
+
+/*****************************************
+ * COMPRESS TABLE
+ * For each AVX2 compare mask, the lanes to
+ * take in order: the kept ones first. A 64-bit
+ * lane is two 32-bit lanes side by side.
+ ****************************************/
+struct compress_table
+{
+   compress_table()
+   {
+      for (int bits = 0; bits < 256; bits++)
+      {
+         int next = 0;
+         for (int lane = 0; lane < 8; lane++)
+            if (bits & (1 << lane))
+               lanes32[bits][next++] = lane;
+         while (next < 8)
+            lanes32[bits][next++] = 0;
+      }
+      for (int bits = 0; bits < 16; bits++)
+      {
+         int next = 0;
+         for (int lane = 0; lane < 4; lane++)
+            if (bits & (1 << lane))
+            {
+               lanes64[bits][next++] = 2 * lane;
+               lanes64[bits][next++] = 2 * lane + 1;
+            }
+         while (next < 8)
+            lanes64[bits][next++] = 0;
+      }
+   }
+
+   static const compress_table & get()
+   {
+      static const compress_table table;
+      return table;
+   }
+
+   int32_t lanes32[256][8];
+   int32_t lanes64[16][8];
+};
+
+/*****************************************
+ * AVX2 COMPRESS
+ * Compare a register, look up the permute
+ * for its mask, and store the whole register
+ * at j. Only the first popcount(mask) lanes
+ * matter, and the next store writes over the
+ * rest. Near the end of room, only those
+ * lanes are stored.
+ ****************************************/
+template <typename T, class Pred> __attribute__((target("avx2,popcnt"), flatten))
+size_t avx2Compress(const T * in, size_t n, T * out, size_t room, const Pred & p)
+{
+   typedef typename simd::lanes::reg<T, 32>::type V;
+   typedef decltype(V() == V()) M;
+   const size_t W = simd::lanes::reg<T, 32>::width;
+   const compress_table & table = compress_table::get();
+   size_t i = 0;
+   size_t j = 0;
+   for (; i + W <= n; i += W)
+   {
+      V x;
+      M m;
+      memcpy(&x, in + i, sizeof(V));
+      p.mask(x, m);
+      unsigned bits = sizeof(T) == 4 ? unsigned(_mm256_movemask_ps((__m256)m))
+                                     : unsigned(_mm256_movemask_pd((__m256d)m));
+      const int32_t * lanes = sizeof(T) == 4 ? table.lanes32[bits] : table.lanes64[bits];
+      __m256i order = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lanes));
+      __m256i packed = _mm256_permutevar8x32_epi32((__m256i)x, order);
+      size_t count = size_t(__builtin_popcount(bits));
+      if (j + W <= room)
+         _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + j), packed);
+      else
+         memcpy(out + j, &packed, count * sizeof(T));
+      j += count;
+   }
+   return j + scalarCompress(in + i, n - i, out + j, room - std::min(room, j), p);
+}
+
+/*****************************************
+ * AVX512 COMPRESS
+ * vpcompress stores only the kept lanes, so
+ * it never writes past what it keeps
+ ****************************************/
+template <typename T, class Pred> __attribute__((target("avx512f,popcnt"), flatten))
+size_t avx512Compress(const T * in, size_t n, T * out, size_t room, const Pred & p)
+{
+   typedef typename simd::lanes::reg<T, 64>::type V;
+   typedef decltype(V() == V()) M;
+   const size_t W = simd::lanes::reg<T, 64>::width;
+   size_t i = 0;
+   size_t j = 0;
+   for (; i + W <= n; i += W)
+   {
+      V x;
+      M m;
+      memcpy(&x, in + i, sizeof(V));
+      p.mask(x, m);
+      __m512i xi = (__m512i)x;
+      __m512i mi = (__m512i)m;
+      unsigned bits;
+      if (sizeof(T) == 4)
+      {
+         __mmask16 k = _mm512_test_epi32_mask(mi, mi);
+         _mm512_mask_compressstoreu_epi32(out + j, k, xi);
+         bits = k;
+      }
+      else
+      {
+         __mmask8 k = _mm512_test_epi64_mask(mi, mi);
+         _mm512_mask_compressstoreu_epi64(out + j, k, xi);
+         bits = k;
+      }
+      j += size_t(__builtin_popcount(bits));
+   }
+   return j + scalarCompress(in + i, n - i, out + j, room - std::min(room, j), p);
+}
+#endif // CUSTOM_SIMD_X86
+
+/*****************************************
+ * KERNELS
+ * compress() and count() for one T and one
+ * predicate, bound the first time they are
+ * used together
+ ****************************************/
+template <typename T, class Pred>
+struct kernels
+{
+   typedef size_t (*compress_fn)(const T *, size_t, T *, size_t, const Pred &);
+   typedef size_t (*count_fn)(const T *, size_t, const Pred &);
+
+   compress_fn compress;
+   count_fn    count;
+
+   static kernels at(simd::level l)
+   {
+      return bind(l, std::integral_constant<bool, vectorizable<T, Pred>::value>());
+   }
+
+   static const kernels & active()
+   {
+      static const kernels bound = at(simd::active_level());
+      return bound;
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // a predicate only the scalar loop can run
+   static kernels bind(simd::level, std::false_type)
+   {
+      kernels k;
+      k.compress = &scalarCompress<T, Pred>;
+      k.count    = &scalarCount<T, Pred>;
+      return k;
+   }
+
+   static kernels bind(simd::level l, std::true_type)
+   {
+      kernels k = bind(l, std::false_type());
+#ifdef CUSTOM_SIMD_X86
+      const bool wide = sizeof(T) == 4 || sizeof(T) == 8;
+      switch (l)
+      {
+         case simd::AVX512:
+            k.count = &avx512Count<T, Pred>;
+            if (wide)
+               k.compress = &avx512Compress<T, Pred>;
+            break;
+         case simd::AVX2:
+            k.count = &avx2Count<T, Pred>;
+            if (wide)
+               k.compress = &avx2Compress<T, Pred>;
+            break;
+         case simd::SSE42:
+            k.count = &sse42Count<T, Pred>;
+            break;
+         default:
+            break;
+      }
+#endif
+      return k;
+   }
+};
+
+template <typename T, class Pred>
+size_t compress(const T * in, size_t n, T * out, size_t room, const Pred & p)
+{
+   return kernels<T, Pred>::active().compress(in, n, out, room, p);
+}
+
+template <typename T, class Pred>
+size_t count(const T * in, size_t n, const Pred & p)
+{
+   return kernels<T, Pred>::active().count(in, n, p);
+}
+
+} // namespace compact_detail
+
+/*****************************************
+ * COPY IF
+ * The elements pred() is true of, in order,
+ * to the front of out. Gives back how many.
+ * out may be in.
+ ****************************************/
+template <typename T, typename U, class Pred>
+size_t copy_if(span<T> in, span<U> out, Pred pred)
+{
+   assert(out.size() >= in.size());
+   return compact_detail::compress<U>(in.data(), in.size(), out.data(), out.size(), pred);
+}
+
+// out is sized to what was kept
+template <typename T, class Pred>
+size_t copy_if(const vector<T> & in, vector<T> & out, Pred pred)
+{
+   if (out.size() < in.size())
+      out.resize(in.size(), T());
+   size_t num = copy_if(in.slice(0, in.size()), out.slice(0, out.size()), pred);
+   out.resize(num, T());
+   return num;
+}
+
+/*****************************************
+ * REMOVE IF
+ * Keep only what pred() is false of, at the
+ * front and in order. Gives back how many.
+ ****************************************/
+template <typename T, class Pred>
+size_t remove_if(span<T> s, Pred pred)
+{
+   return copy_if(s, s, where::negation<Pred>(pred));
+}
+
+// v shrinks to what was kept
+template <typename T, class Pred>
+size_t remove_if(vector<T> & v, Pred pred)
+{
+   size_t num = remove_if(v.slice(0, v.size()), pred);
+   v.resize(num, T());
+   return num;
+}
+
+/*****************************************
+ * PARTITION
+ * Every element pred() is true of, then every
+ * one it is false of, each in order. Gives
+ * back how many are true.
+ ****************************************/
+template <typename T, typename U, class Pred>
+size_t partition(span<T> in, span<U> out, Pred pred)
+{
+   assert(out.size() >= in.size());
+   assert(static_cast<const void *>(in.data()) != static_cast<const void *>(out.data()) ||
+          in.size() == 0);
+   size_t num = compact_detail::compress<U>(in.data(), in.size(), out.data(), in.size(), pred);
+   compact_detail::compress<U>(in.data(), in.size(), out.data() + num, in.size() - num,
+                               where::negation<Pred>(pred));
+   return num;
+}
+
+// out is resized to fit
+template <typename T, class Pred>
+size_t partition(const vector<T> & in, vector<T> & out, Pred pred)
+{
+   out.resize(in.size(), T());
+   return partition(in.slice(0, in.size()), out.slice(0, out.size()), pred);
+}
+
+namespace compact_detail
+{
+
+/*****************************************
+ * COUNTED BLOCKS
+ * The blocks of [0, num), how many elements
+ * of each pred() is true of, and where each
+ * block's go
+ ****************************************/
+template <typename T, class Pred, class Executor>
+struct counted_blocks
+{
+   counted_blocks(const T * in, size_t num, const Pred & p, Executor & ex) :
+      num(num), size(parallel::chunk_size<T>(num, ex.size())),
+      count((num + size - 1) / size), kept(count), offset(count)
+   {
+      ex.run(count, [&](size_t b)
+      {
+         kept[b] = compact_detail::count(in + begin(b), end(b) - begin(b), p);
+      });
+      total = exclusive_scan(span<size_t>(kept), span<size_t>(offset), size_t(0));
+   }
+
+   size_t begin(size_t b) const { return b * size; }
+   size_t end(size_t b)   const { return std::min((b + 1) * size, num); }
+
+   size_t num;
+   size_t size;
+   size_t count;
+   std::vector<size_t> kept;     // how many each block keeps
+   std::vector<size_t> offset;   // where they go
+   size_t total;                 // how many are kept in all
+};
+
+} // namespace compact_detail
+
+namespace parallel
+{
+
+/*****************************************
+ * COPY IF
+ *   1. count what every block keeps
+ *   2. an exclusive scan of the counts gives
+ *      where each block's go
+ *   3. every block compacts straight there
+ ****************************************/
+template <typename T, typename U, class Pred, class Executor = thread_pool>
+size_t copy_if(span<T> in, span<U> out, Pred pred, Executor & ex = Executor::instance())
+{
+   assert(out.size() >= in.size());
+   assert(static_cast<const void *>(in.data()) != static_cast<const void *>(out.data()) ||
+          in.size() == 0);
+   compact_detail::counted_blocks<U, Pred, Executor> b(in.data(), in.size(), pred, ex);
+   ex.run(b.count, [&](size_t block)
+   {
+      compact_detail::compress<U>(in.data() + b.begin(block), b.end(block) - b.begin(block),
+                                  out.data() + b.offset[block], b.kept[block], pred);
+   });
+   return b.total;
+}
+
+// out is sized to what was kept
+template <typename T, class Pred, class Executor = thread_pool>
+size_t copy_if(const vector<T> & in, vector<T> & out, Pred pred,
+               Executor & ex = Executor::instance())
+{
+   if (out.size() < in.size())
+      out.resize(in.size(), T());
+   size_t num = copy_if(in.slice(0, in.size()), out.slice(0, out.size()), pred, ex);
+   out.resize(num, T());
+   return num;
+}
+
+/*****************************************
+ * REMOVE IF
+ * The blocks cannot compact in place at the
+ * same time, as each one's output lands on
+ * the blocks before it. What is kept goes to
+ * a buffer and is copied back.
+ ****************************************/
+template <typename T, class Pred, class Executor = thread_pool>
+size_t remove_if(span<T> s, Pred pred, Executor & ex = Executor::instance())
+{
+   typedef typename std::remove_const<T>::type U;
+   where::negation<Pred> keep(pred);
+   compact_detail::counted_blocks<U, where::negation<Pred>, Executor> b(s.data(), s.size(), keep, ex);
+   if (b.total == s.size())
+      return b.total;
+
+   vector<U> buffer(b.total, U());
+   U * out = buffer.slice(0, b.total).data();
+   ex.run(b.count, [&](size_t block)
+   {
+      compact_detail::compress<U>(s.data() + b.begin(block), b.end(block) - b.begin(block),
+                                  out + b.offset[block], b.kept[block], keep);
+   });
+   copy(buffer.slice(0, b.total), s.subspan(0, b.total), ex);
+   return b.total;
+}
+
+// v shrinks to what was kept
+template <typename T, class Pred, class Executor = thread_pool>
+size_t remove_if(vector<T> & v, Pred pred, Executor & ex = Executor::instance())
+{
+   size_t num = remove_if(v.slice(0, v.size()), pred, ex);
+   v.resize(num, T());
+   return num;
+}
+
+/*****************************************
+ * PARTITION
+ * The trues go where copy_if would put them.
+ * The falses of a block go after every true,
+ * and after the falses of the blocks before.
+ ****************************************/
+template <typename T, typename U, class Pred, class Executor = thread_pool>
+size_t partition(span<T> in, span<U> out, Pred pred, Executor & ex = Executor::instance())
+{
+   assert(out.size() >= in.size());
+   assert(static_cast<const void *>(in.data()) != static_cast<const void *>(out.data()) ||
+          in.size() == 0);
+   compact_detail::counted_blocks<U, Pred, Executor> b(in.data(), in.size(), pred, ex);
+   where::negation<Pred> rest(pred);
+   ex.run(b.count, [&](size_t block)
+   {
+      size_t begin = b.begin(block);
+      size_t num   = b.end(block) - begin;
+      size_t falsesBefore = begin - b.offset[block];
+      compact_detail::compress<U>(in.data() + begin, num, out.data() + b.offset[block],
+                                  b.kept[block], pred);
+      compact_detail::compress<U>(in.data() + begin, num, out.data() + b.total + falsesBefore,
+                                  num - b.kept[block], rest);
+   });
+   return b.total;
+}
+
+// out is resized to fit
+template <typename T, class Pred, class Executor = thread_pool>
+size_t partition(const vector<T> & in, vector<T> & out, Pred pred,
+                 Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), T());
+   return partition(in.slice(0, in.size()), out.slice(0, out.size()), pred, ex);
+}
+
+} // namespace parallel
+} // namespace custom
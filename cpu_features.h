@@ -0,0 +1,261 @@
+/***********************************************************************
+ * Header:
+ *    CPU FEATURES
+ * Summary:
+ *    What the CPU we are running on can do, asked of the CPU itself with
+ *    the cpuid instruction, and which level of SIMD code that lets us run.
+ *
+ *    A CPU can have AVX and still not let us use it: the operating system
+ *    has to save the wider registers when it switches threads, and says
+ *    so in the XCR0 register. Both are checked before AVX, AVX2 or
+ *    AVX-512 counts as there.
+ *
+ *    The features are found once, the first time they are asked for.
+ *    Setting CUSTOM_SIMD_LEVEL in the environment to scalar, sse42, avx2
+ *    or avx512 before the program starts makes it run at that level
+ *    instead, for comparing one level against another. It can lower the
+ *    level but never raise it past what the CPU has, and a name it does
+ *    not know is ignored.
+ *
+ *    This will contain the class definition of:
+ *        cpu_features           : The features of one CPU
+ *        simd::level            : An instruction set a kernel can run on
+ *        simd::detected_level   : The best one this CPU has
+ *        simd::active_level     : The one the kernels will use
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>      // for uint32_t and uint64_t
+#include <cstdlib>      // for getenv
+#include <cstring>      // for strcmp
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CUSTOM_SIMD_X86
+#include <cpuid.h>      // for __get_cpuid_count
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>     // for __cpuidex and _xgetbv
+#endif
+
+namespace custom
+{
+
+/*****************************************
+ * CPU FEATURES
+ * One flag per feature we have code for
+ ****************************************/
+struct cpu_features
+{
+   cpu_features() : sse2(false), sse42(false), avx(false), avx2(false), fma(false),
+                    avx512f(false), avx512bw(false) { }
+
+   // this CPU, found the first time it is asked
+   static const cpu_features & host()
+   {
+      static const cpu_features found = detect();
+      return found;
+   }
+
+   static cpu_features detect();
+
+   bool sse2;
+   bool sse42;
+   bool avx;
+   bool avx2;
+   bool fma;
+   bool avx512f;
+   bool avx512bw;
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // leaf (and subleaf) of cpuid into r, or false if there is no such leaf
+   static bool cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4]);
+
+   // which register states the operating system saves for us
+   static uint64_t xcr0();
+};
+
+/*****************************************
+ * CPU FEATURES :: CPUID
+ * eax, ebx, ecx and edx, in that order
+ ****************************************/
+inline bool cpu_features::cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4])
+{
+   r[0] = r[1] = r[2] = r[3] = 0;
+#if defined(CUSTOM_SIMD_X86)
+   unsigned int a, b, c, d;
+   if (!__get_cpuid_count(leaf, subleaf, &a, &b, &c, &d))
+      return false;
+   r[0] = a;
+   r[1] = b;
+   r[2] = c;
+   r[3] = d;
+   return true;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   int top[4];
+   __cpuid(top, int(leaf & 0x80000000u));
+   if (uint32_t(top[0]) < leaf)
+      return false;
+   int regs[4];
+   __cpuidex(regs, int(leaf), int(subleaf));
+   for (int i = 0; i < 4; i++)
+      r[i] = uint32_t(regs[i]);
+   return true;
+#else
+   (void)leaf;
+   (void)subleaf;
+   return false;
+#endif
+}
+
+/*****************************************
+ * CPU FEATURES :: XCR0
+ * Only to be asked when cpuid says OSXSAVE
+ ****************************************/
+inline uint64_t cpu_features::xcr0()
+{
+#if defined(CUSTOM_SIMD_X86)
+   uint32_t lo;
+   uint32_t hi;
+   __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+   return (uint64_t(hi) << 32) | lo;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   return _xgetbv(0);
+#else
+   return 0;
+#endif
+}
+
+/*****************************************
+ * CPU FEATURES :: DETECT
+ * Ask the CPU, then the operating system
+ ****************************************/
+inline cpu_features cpu_features::detect()
+{
+   cpu_features f;
+   uint32_t r[4];
+   if (!cpuid(1, 0, r))
+      return f;
+   f.sse2  = (r[3] >> 26) & 1;
+   f.sse42 = (r[2] >> 20) & 1;
+
+   // the SSE, AVX and AVX-512 registers all saved by the operating system?
+   const bool osxsave = (r[2] >> 27) & 1;
+   const uint64_t state = osxsave ? xcr0() : 0;
+   const bool ymm = (state & 0x06) == 0x06;
+   const bool zmm = (state & 0xe6) == 0xe6;
+
+   f.avx = ymm && ((r[2] >> 28) & 1);
+   f.fma = f.avx && ((r[2] >> 12) & 1);
+   if (f.avx && cpuid(7, 0, r))
+   {
+      f.avx2     = (r[1] >> 5) & 1;
+      f.avx512f  = zmm && ((r[1] >> 16) & 1);
+      f.avx512bw = f.avx512f && ((r[1] >> 30) & 1);
+   }
+   return f;
+}
+
+namespace simd
+{
+
+/*****************************************
+ * LEVEL
+ * In order, each a superset of the last
+ ****************************************/
+enum level
+{
+   SCALAR = 0,
+   SSE42  = 1,
+   AVX2   = 2,
+   AVX512 = 3
+};
+
+/*****************************************
+ * LEVEL NAME
+ * What CUSTOM_SIMD_LEVEL calls each level
+ ****************************************/
+inline const char * level_name(level l)
+{
+   switch (l)
+   {
+      case AVX512: return "avx512";
+      case AVX2:   return "avx2";
+      case SSE42:  return "sse42";
+      default:     return "scalar";
+   }
+}
+
+/*****************************************
+ * PARSE LEVEL
+ * The level with this name, or fallback if
+ * there is none
+ ****************************************/
+inline level parse_level(const char * name, level fallback)
+{
+   if (name == nullptr)
+      return fallback;
+   for (int l = SCALAR; l <= AVX512; l++)
+      if (strcmp(name, level_name(level(l))) == 0)
+         return level(l);
+   return fallback;
+}
+
+/*****************************************
+ * LEVEL OF
+ * The best level the kernels can use with
+ * these features
+ ****************************************/
+inline level level_of(const cpu_features & f)
+{
+#ifdef CUSTOM_SIMD_X86
+   if (f.avx512f)
+      return AVX512;
+   if (f.avx2)
+      return AVX2;
+   if (f.sse42)
+      return SSE42;
+#else
+   (void)f;
+#endif
+   return SCALAR;
+}
+
+/*****************************************
+ * DETECTED LEVEL
+ * The best level this CPU has
+ ****************************************/
+inline level detected_level()
+{
+   return level_of(cpu_features::host());
+}
+
+/*****************************************
+ * CHOOSE LEVEL
+ * The level asked for by name, but never
+ * above the one detected
+ ****************************************/
+inline level choose_level(level detected, const char * name)
+{
+   level asked = parse_level(name, detected);
+   return asked < detected ? asked : detected;
+}
+
+/*****************************************
+ * ACTIVE LEVEL
+ * The level the kernels run at: the detected
+ * one, unless CUSTOM_SIMD_LEVEL lowers it
+ ****************************************/
+inline level active_level()
+{
+   static const level found = choose_level(detected_level(), getenv("CUSTOM_SIMD_LEVEL"));
+   return found;
+}
+
+} // namespace simd
+} // namespace custom
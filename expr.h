@@ -0,0 +1,421 @@
+/***********************************************************************
+ * Header:
+ *    EXPR
+ * Summary:
+ *    Element-wise arithmetic on vectors of numbers that does no work
+ *    until it is assigned. a + b * c does not build b * c and then add
+ *    a to it: it builds a small tree that remembers what to do, and
+ *    assigning the tree to a vector runs one loop that reads a, b and c
+ *    once each and writes the answer once. No vector in between is ever
+ *    allocated.
+ *
+ *    The loop works a register at a time. Every node of the tree loads
+ *    or computes a whole register of elements, so the loop is compiled
+ *    like the kernels in simd.h: once for each level, with the copy for
+ *    this CPU bound the first time a tree of that shape is assigned.
+ *
+ *    The operands are vectors, spans and single values of an arithmetic
+ *    type, all of the same type, with +, -, * and / and unary minus. The
+ *    vectors and spans have to be the same size. A tree only points at
+ *    its vectors, so it has to be assigned before they change; assigning
+ *    it to one of its own operands is fine, as every element is read
+ *    before it is written.
+ *
+ *    This will contain the class definition of:
+ *        expr::expression       : What every node of a tree derives from
+ *        expr::leaf             : The elements of a vector or a span
+ *        expr::broadcast        : One value as every element
+ *        expr::unary            : An operation on one node
+ *        expr::binary           : An operation on two nodes
+ *        expr::evaluate         : Run a tree into a span
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <cstring>      // for memcpy
+#include <stdexcept>    // for std::runtime_error
+#include <type_traits>  // for std::enable_if
+
+#include "simd.h"       // for active_level and lanes::reg
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+namespace expr
+{
+
+// the size of a node that fits any size, such as a broadcast
+const size_t anySize = size_t(-1);
+
+/*****************************************
+ * EXPRESSION
+ * The base of every node. E is the node
+ * itself, so nothing is virtual.
+ ****************************************/
+template <class E>
+struct expression
+{
+   const E & self() const { return static_cast<const E &>(*this); }
+};
+
+/*****************************************
+ * LEAF
+ * The elements of a vector or a span
+ ****************************************/
+template <typename T>
+struct leaf : expression<leaf<T>>
+{
+   typedef T value_type;
+
+   leaf(const T * p, size_t num) : p(p), num(num) { }
+
+   size_t size() const { return num; }
+   T operator [] (size_t i) const { return p[i]; }
+
+#ifdef CUSTOM_SIMD_X86
+   template <size_t B>
+   void packet(size_t i, typename simd::lanes::reg<T, B>::type & v) const
+   {
+      memcpy(&v, p + i, sizeof(v));
+   }
+#endif
+
+   const T * p;
+   size_t    num;
+};
+
+/*****************************************
+ * BROADCAST
+ * One value, as many times as it is needed
+ ****************************************/
+template <typename T>
+struct broadcast : expression<broadcast<T>>
+{
+   typedef T value_type;
+
+   broadcast(T value) : value(value) { }
+
+   size_t size() const { return anySize; }
+   T operator [] (size_t) const { return value; }
+
+#ifdef CUSTOM_SIMD_X86
+   template <size_t B>
+   void packet(size_t, typename simd::lanes::reg<T, B>::type & v) const
+   {
+      v = typename simd::lanes::reg<T, B>::type() + value;
+   }
+#endif
+
+   T value;
+};
+
+/*****************************************
+ * OPERATIONS
+ * Each works in place, on one element or on a
+ * whole register of them. Registers are never
+ * passed or returned by value, as a function
+ * without a target would pass them differently
+ * from one with.
+ ****************************************/
+struct plus       { template <class A> static void apply(A & a, const A & b) { a = a + b; } };
+struct minus      { template <class A> static void apply(A & a, const A & b) { a = a - b; } };
+struct multiplies { template <class A> static void apply(A & a, const A & b) { a = a * b; } };
+struct divides    { template <class A> static void apply(A & a, const A & b) { a = a / b; } };
+struct negate     { template <class A> static void apply(A & a)             { a = -a;    } };
+
+/*****************************************
+ * UNARY
+ * Op on every element of a node
+ ****************************************/
+template <class Op, class A>
+struct unary : expression<unary<Op, A>>
+{
+   typedef typename A::value_type value_type;
+
+   unary(const A & a) : a(a) { }
+
+   size_t size() const { return a.size(); }
+   value_type operator [] (size_t i) const
+   {
+      value_type x = a[i];
+      Op::apply(x);
+      return x;
+   }
+
+#ifdef CUSTOM_SIMD_X86
+   template <size_t B>
+   void packet(size_t i, typename simd::lanes::reg<value_type, B>::type & v) const
+   {
+      a.template packet<B>(i, v);
+      Op::apply(v);
+   }
+#endif
+
+   A a;
+};
+
+/*****************************************
+ * BINARY
+ * Op on the elements of two nodes, pair by
+ * pair. The nodes are kept by value, as they
+ * are small and may be temporaries.
+ ****************************************/
+template <class Op, class L, class R>
+struct binary : expression<binary<Op, L, R>>
+{
+   typedef typename L::value_type value_type;
+   static_assert(std::is_same<value_type, typename R::value_type>::value,
+                 "expr: both sides need the same element type");
+
+   binary(const L & l, const R & r) : l(l), r(r)
+   {
+      if (l.size() != anySize && r.size() != anySize && l.size() != r.size())
+         throw std::runtime_error("expr: the vectors are different sizes");
+   }
+
+   size_t size() const { return l.size() != anySize ? l.size() : r.size(); }
+   value_type operator [] (size_t i) const
+   {
+      value_type x = l[i];
+      Op::apply(x, r[i]);
+      return x;
+   }
+
+#ifdef CUSTOM_SIMD_X86
+   template <size_t B>
+   void packet(size_t i, typename simd::lanes::reg<value_type, B>::type & v) const
+   {
+      typename simd::lanes::reg<value_type, B>::type w;
+      l.template packet<B>(i, v);
+      r.template packet<B>(i, w);
+      Op::apply(v, w);
+   }
+#endif
+
+   L l;
+   R r;
+};
+
+/*****************************************
+ * OPERAND
+ * What may take part in a tree, and the node
+ * it becomes
+ ****************************************/
+
+// numbers a register can hold
+template <typename T>
+struct is_element
+{
+   static const bool value = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+};
+
+template <class X, class Enable = void>
+struct operand
+{
+   static const bool value = false;
+};
+
+template <typename T>
+struct operand <vector<T>, typename std::enable_if<is_element<T>::value>::type>
+{
+   static const bool value = true;
+   typedef T       value_type;
+   typedef leaf<T> type;
+   static type node(const vector<T> & v) { return type(v.slice(0, v.size()).data(), v.size()); }
+};
+
+template <typename T>
+struct operand <span<T>, typename std::enable_if<is_element<typename std::remove_const<T>::type>::value>::type>
+{
+   static const bool value = true;
+   typedef typename std::remove_const<T>::type value_type;
+   typedef leaf<value_type>                    type;
+   static type node(span<T> s) { return type(s.data(), s.size()); }
+};
+
+template <class E>
+struct operand <E, typename std::enable_if<std::is_base_of<expression<E>, E>::value>::type>
+{
+   static const bool value = true;
+   typedef typename E::value_type value_type;
+   typedef E                      type;
+   static const type & node(const E & e) { return e; }
+};
+
+/*****************************************
+ * THE OPERATORS
+ * Two operands, or an operand and a value of
+ * its element type on either side
+ ****************************************/
+#define CUSTOM_EXPR_BINARY(SYMBOL, OP)                                                  \
+template <class L, class R>                                                              \
+typename std::enable_if<operand<L>::value && operand<R>::value,                          \
+   binary<OP, typename operand<L>::type, typename operand<R>::type>>::type               \
+operator SYMBOL (const L & l, const R & r)                                               \
+{                                                                                        \
+   return binary<OP, typename operand<L>::type, typename operand<R>::type>(              \
+      operand<L>::node(l), operand<R>::node(r));                                         \
+}                                                                                        \
+template <class L>                                                                       \
+typename std::enable_if<operand<L>::value,                                               \
+   binary<OP, typename operand<L>::type, broadcast<typename operand<L>::value_type>>>::type \
+operator SYMBOL (const L & l, typename operand<L>::value_type r)                         \
+{                                                                                        \
+   return binary<OP, typename operand<L>::type, broadcast<typename operand<L>::value_type>>( \
+      operand<L>::node(l), broadcast<typename operand<L>::value_type>(r));               \
+}                                                                                        \
+template <class R>                                                                       \
+typename std::enable_if<operand<R>::value,                                               \
+   binary<OP, broadcast<typename operand<R>::value_type>, typename operand<R>::type>>::type \
+operator SYMBOL (typename operand<R>::value_type l, const R & r)                         \
+{                                                                                        \
+   return binary<OP, broadcast<typename operand<R>::value_type>, typename operand<R>::type>( \
+      broadcast<typename operand<R>::value_type>(l), operand<R>::node(r));               \
+}
+
+CUSTOM_EXPR_BINARY(+, plus)
+CUSTOM_EXPR_BINARY(-, minus)
+CUSTOM_EXPR_BINARY(*, multiplies)
+CUSTOM_EXPR_BINARY(/, divides)
+
+#undef CUSTOM_EXPR_BINARY
+
+template <class A>
+typename std::enable_if<operand<A>::value, unary<negate, typename operand<A>::type>>::type
+operator - (const A & a)
+{
+   return unary<negate, typename operand<A>::type>(operand<A>::node(a));
+}
+
+/*****************************************
+ * EVALUATE DETAIL
+ * The one loop, a register at a time and
+ * then an element at a time
+ ****************************************/
+namespace evaluate_detail
+{
+
+template <class E>
+void scalarLoop(typename E::value_type * out, const E & e, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      out[i] = e[i];
+}
+
+#ifdef CUSTOM_SIMD_X86
+template <size_t B, class E>
+void lanesLoop(typename E::value_type * out, const E & e, size_t n)
+{
+   typedef typename simd::lanes::reg<typename E::value_type, B> reg;
+   typedef typename reg::type V;
+   size_t i = 0;
+   for (; i + reg::width <= n; i += reg::width)
+   {
+      V v;
+      e.template packet<B>(i, v);
+      memcpy(out + i, &v, sizeof(V));
+   }
+   for (; i < n; i++)
+      out[i] = e[i];
+}
+
+template <class E> __attribute__((target("sse4.2"), flatten))
+void sse42Loop(typename E::value_type * out, const E & e, size_t n) { lanesLoop<16>(out, e, n); }
+template <class E> __attribute__((target("avx2"), flatten))
+void avx2Loop(typename E::value_type * out, const E & e, size_t n) { lanesLoop<32>(out, e, n); }
+template <class E> __attribute__((target("avx512f"), flatten))
+void avx512Loop(typename E::value_type * out, const E & e, size_t n) { lanesLoop<64>(out, e, n); }
+#endif // CUSTOM_SIMD_X86
+
+/*****************************************
+ * LOOP
+ * The loop for one shape of tree, bound the
+ * first time that shape is evaluated
+ ****************************************/
+template <class E>
+struct loop
+{
+   typedef void (*fn)(typename E::value_type *, const E &, size_t);
+
+   static fn at(simd::level l)
+   {
+      switch (l)
+      {
+#ifdef CUSTOM_SIMD_X86
+         case simd::AVX512: return &avx512Loop<E>;
+         case simd::AVX2:   return &avx2Loop<E>;
+         case simd::SSE42:  return &sse42Loop<E>;
+#endif
+         default:           return &scalarLoop<E>;
+      }
+   }
+
+   static fn active()
+   {
+      static const fn bound = at(simd::active_level());
+      return bound;
+   }
+};
+
+} // namespace evaluate_detail
+
+/*****************************************
+ * EVALUATE
+ * Every element of e into out, which has to
+ * be the same size
+ ****************************************/
+template <class E>
+void evaluate(span<typename E::value_type> out, const expression<E> & e)
+{
+   const E & tree = e.self();
+   if (tree.size() != anySize && tree.size() != out.size())
+      throw std::runtime_error("expr: the destination is the wrong size");
+   evaluate_detail::loop<E>::active()(out.data(), tree, out.size());
+}
+
+} // namespace expr
+
+// a + b on two vectors looks for operator + in custom, where vector is
+using expr::operator +;
+using expr::operator -;
+using expr::operator *;
+using expr::operator /;
+
+/*****************************************
+ * VECTOR :: EXPRESSION constructor
+ * As many elements as the tree has, each
+ * computed straight into place
+ ****************************************/
+template <typename T>
+template <class E>
+vector <T> :: vector(const expr::expression<E> & e) : vector()
+{
+   *this = e;
+}
+
+/*****************************************
+ * VECTOR :: EXPRESSION assignment
+ * Resize to fit the tree, then run it. The
+ * tree may read this vector as it goes.
+ ****************************************/
+template <typename T>
+template <class E>
+vector <T> & vector <T> :: operator = (const expr::expression<E> & e)
+{
+   static_assert(std::is_same<T, typename E::value_type>::value,
+                 "expr: assign to a vector of the same element type");
+   size_t num = e.self().size();
+   if (num == expr::anySize)
+      throw std::runtime_error("expr: a tree of single values has no size");
+   if (num != size())
+      resize(num, T());
+   expr::evaluate(slice(0, num), e);
+   return *this;
+}
+
+} // namespace custom
@@ -0,0 +1,486 @@
+/***********************************************************************
+ * Header:
+ *    EXTERNAL VECTOR
+ * Summary:
+ *    A vector that can hold more elements than there is memory. The
+ *    elements are split into fixed-size pages. A bounded number of pages
+ *    are kept in memory, each one a custom::vector, and the least
+ *    recently used page is written to a temporary file to make room for
+ *    the next one. When the vector notices a sequential scan it asks the
+ *    kernel to start reading the pages ahead of it.
+ *
+ *    A reference from operator[] is good until the next access to a
+ *    different page, since that access may evict the page it points into.
+ *
+ *    This will contain the class definition of:
+ *        external_vector        : A vector that spills pages to disk
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32   // this needs POSIX pread() and pwrite()
+
+#include <cassert>       // because I am paranoid
+#include <cstddef>       // for size_t
+#include <cstdlib>       // for mkstemp and getenv
+#include <stdexcept>     // for std::runtime_error
+#include <string>
+#include <type_traits>   // for std::is_trivially_copyable
+#include <unordered_map> // the page table
+#include <vector>        // which pages are on the disk
+
+#include <fcntl.h>       // for posix_fadvise
+#include <unistd.h>      // for pread, pwrite, ftruncate, close, unlink
+
+#include "vector.h"      // each page is a vector
+
+namespace custom
+{
+
+/*****************************************
+ * EXTERNAL VECTOR
+ * A vector of trivially copyable T whose pages
+ * live in a bounded LRU cache backed by a file
+ ****************************************/
+template <typename T>
+class external_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "external_vector needs a trivially copyable T");
+
+public:
+   static const size_t DEFAULT_BUDGET     = 64 * 1024 * 1024;  // bytes of pages in memory
+   static const size_t DEFAULT_PAGE_BYTES = 64 * 1024;         // bytes in one page
+   static const size_t PREFETCH_PAGES     = 8;                 // how far to read ahead
+
+   // what the cache has been doing
+   struct statistics
+   {
+      size_t hits;        // the page was already in memory
+      size_t misses;      // the page had to be brought in
+      size_t evictions;   // a page was pushed out to make room
+      size_t writes;      // a dirty page was written to the file
+      size_t prefetches;  // pages we asked the kernel to read ahead
+   };
+
+   //
+   // Construct
+   //
+
+   external_vector(size_t memoryBudget = DEFAULT_BUDGET,
+                   size_t pageBytes    = DEFAULT_PAGE_BYTES,
+                   const std::string & directory = "");
+   external_vector(const external_vector & rhs) = delete;
+   external_vector & operator = (const external_vector & rhs) = delete;
+   ~external_vector();
+
+   //
+   // Access
+   //
+
+         T & operator [] (size_t index)       { return element(index, true);  }
+   const T & operator [] (size_t index) const { return element(index, false); }
+         T & front()                          { return element(0, true);      }
+   const T & front()                    const { return element(0, false);     }
+         T & back()                           { return element(numElements - 1, true);  }
+   const T & back()                     const { return element(numElements - 1, false); }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t);
+
+   //
+   // Remove
+   //
+
+   void pop_back()
+   {
+      if (numElements > 0)
+         numElements--;
+   }
+   void clear();
+
+   //
+   // Status
+   //
+
+   size_t size()          const { return numElements;      }
+   bool   empty()         const { return numElements == 0; }
+   size_t page_size()     const { return pageElements;     }
+   size_t max_pages()     const { return numFrames;        }
+   size_t memory_budget() const { return numFrames * pageElements * sizeof(T); }
+   const statistics & stats() const { return stats_; }
+
+   // write every dirty page to the file
+   void flush();
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   // one page worth of memory, linked into the LRU list
+   struct Frame
+   {
+      Frame() : page(NO_PAGE), dirty(false), prev(NO_FRAME), next(NO_FRAME) { }
+      vector<T> elements;     // the page itself
+      size_t    page;         // which page is here, or NO_PAGE
+      bool      dirty;        // changed since it was last written
+      size_t    prev;         // more recently used frame
+      size_t    next;         // less recently used frame
+   };
+   static const size_t NO_PAGE  = size_t(-1);
+   static const size_t NO_FRAME = size_t(-1);
+
+   T &    element(size_t index, bool willWrite) const;
+   size_t load(size_t page, bool willWrite) const;
+   size_t victim() const;
+   void   writePage(Frame & frame) const;
+   void   readPage(Frame & frame) const;
+   void   readAhead(size_t page) const;
+   void   unlink(size_t iFrame) const;
+   void   pushFront(size_t iFrame) const;
+   void   pushBack(size_t iFrame) const;
+
+   int    fd;                 // the spill file, already unlinked
+   size_t pageElements;       // the number of elements in a page
+   size_t numFrames;          // the most pages we will keep in memory
+   size_t numElements;        // the number of elements in the vector
+
+   // the page cache. Reading a const vector still moves pages around.
+   mutable Frame *                            frames;
+   mutable std::unordered_map<size_t, size_t> pageTable;   // page -> frame
+   mutable std::vector<bool>                  onDisk;      // page has been written
+   mutable size_t                             mostRecent;  // head of the LRU list
+   mutable size_t                             leastRecent; // tail of the LRU list
+   mutable size_t                             numUsed;     // frames holding a page
+   mutable size_t                             lastPage;    // the page we touched last
+   mutable size_t                             runLength;   // sequential pages in a row
+   mutable statistics                         stats_;
+};
+
+/*****************************************
+ * EXTERNAL VECTOR :: CONSTRUCTOR
+ * Create the spill file. A frame's page is
+ * only allocated when the frame is first used,
+ * so a small vector with a big budget only
+ * holds the memory it needs.
+ ****************************************/
+template <typename T>
+external_vector <T> :: external_vector(size_t memoryBudget, size_t pageBytes,
+                                       const std::string & directory) :
+   fd(-1), numElements(0), frames(nullptr), mostRecent(NO_FRAME),
+   leastRecent(NO_FRAME), numUsed(0), lastPage(NO_PAGE), runLength(0), stats_()
+{
+   pageElements = pageBytes / sizeof(T);
+   if (pageElements == 0)
+      pageElements = 1;
+   numFrames = memoryBudget / (pageElements * sizeof(T));
+   if (numFrames < 2)
+      numFrames = 2;
+
+   // the spill file disappears as soon as we close it
+   std::string dir = directory;
+   if (dir.empty())
+      dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+   std::string name = dir + "/external_vector.XXXXXX";
+   fd = mkstemp(&name[0]);
+   if (fd == -1)
+      throw std::runtime_error("external_vector: unable to create a file in " + dir);
+   ::unlink(name.c_str());
+
+   frames = new Frame[numFrames];
+}
+
+/*****************************************
+ * EXTERNAL VECTOR :: DESTRUCTOR
+ * Nothing needs saving: the file goes too
+ ****************************************/
+template <typename T>
+external_vector <T> :: ~external_vector()
+{
+   delete [] frames;
+   ::close(fd);
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: PUSH BACK
+ * The size only grows once the slot is in
+ * memory, so a failed page load leaves it alone
+ **************************************/
+template <typename T>
+void external_vector <T> :: push_back(const T & t)
+{
+   size_t iFrame = load(numElements / pageElements, true);
+   frames[iFrame].elements[numElements % pageElements] = t;
+   numElements++;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: CLEAR
+ * Forget every page, in memory and on disk
+ **************************************/
+template <typename T>
+void external_vector <T> :: clear()
+{
+   for (size_t i = 0; i < numFrames; i++)
+   {
+      frames[i].page  = NO_PAGE;
+      frames[i].dirty = false;
+      frames[i].prev  = frames[i].next = NO_FRAME;
+   }
+   pageTable.clear();
+   onDisk.clear();
+   mostRecent = leastRecent = NO_FRAME;
+   numUsed = 0;
+   lastPage = NO_PAGE;
+   runLength = 0;
+   numElements = 0;
+   if (ftruncate(fd, 0) != 0)
+      throw std::runtime_error("external_vector: unable to truncate the file");
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: FLUSH
+ **************************************/
+template <typename T>
+void external_vector <T> :: flush()
+{
+   for (size_t i = 0; i < numFrames; i++)
+      if (frames[i].page != NO_PAGE && frames[i].dirty)
+         writePage(frames[i]);
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: ELEMENT
+ * Find the page holding index, bringing it
+ * into memory if need be
+ **************************************/
+template <typename T>
+T & external_vector <T> :: element(size_t index, bool willWrite) const
+{
+   assert(index < numElements);
+   size_t iFrame = load(index / pageElements, willWrite);
+   return frames[iFrame].elements[index % pageElements];
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: LOAD
+ * Return the frame holding the page, making
+ * it the most recently used
+ **************************************/
+template <typename T>
+size_t external_vector <T> :: load(size_t page, bool willWrite) const
+{
+   // watch for a sequential scan so we can read ahead of it
+   if (page != lastPage)
+   {
+      runLength = (lastPage != NO_PAGE && page == lastPage + 1) ? runLength + 1 : 0;
+      lastPage = page;
+      if (runLength >= 2)
+         readAhead(page + 1);
+   }
+
+   size_t iFrame;
+   auto it = pageTable.find(page);
+   if (it != pageTable.end())
+   {
+      stats_.hits++;
+      iFrame = it->second;
+      if (iFrame != mostRecent)
+      {
+         unlink(iFrame);
+         pushFront(iFrame);
+      }
+   }
+   else
+   {
+      stats_.misses++;
+      iFrame = victim();
+      Frame & frame = frames[iFrame];
+      frame.page = page;
+      try
+      {
+         readPage(frame);
+      }
+      catch (...)
+      {
+         // hand the frame back so the next miss takes it first
+         frame.page = NO_PAGE;
+         pushBack(iFrame);
+         throw;
+      }
+      pageTable[page] = iFrame;
+      pushFront(iFrame);
+   }
+
+   if (willWrite)
+      frames[iFrame].dirty = true;
+   return iFrame;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: VICTIM
+ * An unused frame, or else the least recently
+ * used one after its page is saved
+ **************************************/
+template <typename T>
+size_t external_vector <T> :: victim() const
+{
+   // a frame used before clear() still has its page
+   if (numUsed < numFrames)
+   {
+      frames[numUsed].elements.resize(pageElements, T());
+      return numUsed++;
+   }
+
+   size_t iFrame = leastRecent;
+   Frame & frame = frames[iFrame];
+   if (frame.page != NO_PAGE)
+   {
+      stats_.evictions++;
+      if (frame.dirty)
+         writePage(frame);
+      pageTable.erase(frame.page);
+   }
+   unlink(iFrame);
+   frame.page = NO_PAGE;
+   return iFrame;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: WRITE PAGE
+ **************************************/
+template <typename T>
+void external_vector <T> :: writePage(Frame & frame) const
+{
+   const size_t numBytes = pageElements * sizeof(T);
+   const char * p = reinterpret_cast<const char *>(&frame.elements[0]);
+   off_t offset = off_t(frame.page) * off_t(numBytes);
+
+   for (size_t done = 0; done < numBytes; )
+   {
+      ssize_t num = pwrite(fd, p + done, numBytes - done, offset + done);
+      if (num <= 0)
+         throw std::runtime_error("external_vector: unable to write a page");
+      done += num;
+   }
+
+   if (onDisk.size() <= frame.page)
+      onDisk.resize(frame.page + 1, false);
+   onDisk[frame.page] = true;
+   frame.dirty = false;
+   stats_.writes++;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: READ PAGE
+ * A page that was never written is all T()
+ **************************************/
+template <typename T>
+void external_vector <T> :: readPage(Frame & frame) const
+{
+   frame.dirty = false;
+   if (frame.page >= onDisk.size() || !onDisk[frame.page])
+   {
+      for (size_t i = 0; i < pageElements; i++)
+         frame.elements[i] = T();
+      return;
+   }
+
+   const size_t numBytes = pageElements * sizeof(T);
+   char * p = reinterpret_cast<char *>(&frame.elements[0]);
+   off_t offset = off_t(frame.page) * off_t(numBytes);
+
+   for (size_t done = 0; done < numBytes; )
+   {
+      ssize_t num = pread(fd, p + done, numBytes - done, offset + done);
+      if (num <= 0)
+         throw std::runtime_error("external_vector: unable to read a page");
+      done += num;
+   }
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: READ AHEAD
+ * Ask the kernel to start reading the next few
+ * pages that are on the disk but not in memory.
+ * The read happens in the background, so the
+ * miss that follows finds them in the page cache.
+ **************************************/
+template <typename T>
+void external_vector <T> :: readAhead(size_t page) const
+{
+   const size_t numBytes = pageElements * sizeof(T);
+   for (size_t p = page; p < page + PREFETCH_PAGES && p < onDisk.size(); p++)
+      if (onDisk[p] && pageTable.find(p) == pageTable.end())
+      {
+#ifdef POSIX_FADV_WILLNEED
+         posix_fadvise(fd, off_t(p) * off_t(numBytes), off_t(numBytes),
+                       POSIX_FADV_WILLNEED);
+#endif
+         stats_.prefetches++;
+      }
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: UNLINK
+ * Take a frame out of the LRU list
+ **************************************/
+template <typename T>
+void external_vector <T> :: unlink(size_t iFrame) const
+{
+   Frame & frame = frames[iFrame];
+   if (frame.prev != NO_FRAME)
+      frames[frame.prev].next = frame.next;
+   else
+      mostRecent = frame.next;
+   if (frame.next != NO_FRAME)
+      frames[frame.next].prev = frame.prev;
+   else
+      leastRecent = frame.prev;
+   frame.prev = frame.next = NO_FRAME;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: PUSH FRONT
+ * Make a frame the most recently used
+ **************************************/
+template <typename T>
+void external_vector <T> :: pushFront(size_t iFrame) const
+{
+   Frame & frame = frames[iFrame];
+   frame.prev = NO_FRAME;
+   frame.next = mostRecent;
+   if (mostRecent != NO_FRAME)
+      frames[mostRecent].prev = iFrame;
+   mostRecent = iFrame;
+   if (leastRecent == NO_FRAME)
+      leastRecent = iFrame;
+}
+
+/***************************************
+ * EXTERNAL VECTOR :: PUSH BACK (LRU)
+ * Make a frame the least recently used
+ **************************************/
+template <typename T>
+void external_vector <T> :: pushBack(size_t iFrame) const
+{
+   Frame & frame = frames[iFrame];
+   frame.prev = leastRecent;
+   frame.next = NO_FRAME;
+   if (leastRecent != NO_FRAME)
+      frames[leastRecent].next = iFrame;
+   leastRecent = iFrame;
+   if (mostRecent == NO_FRAME)
+      mostRecent = iFrame;
+}
+
+} // namespace custom
+
+#endif // !_WIN32
@@ -0,0 +1,409 @@
+/***********************************************************************
+ * Header:
+ *    HUGE PAGE
+ * Summary:
+ *    Storage for very large vectors. Small buffers come from malloc like
+ *    always. Once a buffer passes the huge page size it is moved into an
+ *    anonymous mmap() region that is advised for transparent huge pages,
+ *    and from then on it grows with mremap() so the kernel moves page
+ *    table entries instead of us copying the elements.
+ *
+ *    Where mmap() or transparent huge pages are not available, everything
+ *    falls back to malloc and realloc.
+ *
+ *    This will contain the class definition of:
+ *        huge_page_allocator     : Allocate, grow, and free large buffers
+ *        huge_vector             : A vector of trivially copyable T on top
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // because I am paranoid
+#include <cstddef>     // for size_t
+#include <cstdlib>     // for malloc, realloc, and free
+#include <cstring>     // for memcpy
+#include <fstream>     // for reading the THP setting
+#include <new>         // std::bad_alloc
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable
+#include <utility>     // for std::swap
+
+#ifdef __linux__
+#include <sys/mman.h>  // for mmap, mremap, madvise, munmap
+#endif
+
+#include "vector.h"    // for vector::iterator
+
+namespace custom
+{
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR
+ * Every call takes the size of the buffer in
+ * bytes so we know which way it was allocated.
+ ****************************************/
+class huge_page_allocator
+{
+public:
+   // buffers of at least this many bytes are mapped rather than malloc'ed
+   static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+   static void * allocate  (size_t numBytes);
+   static void * reallocate(void * p, size_t oldBytes, size_t newBytes);
+   static void   deallocate(void * p, size_t numBytes);
+
+   // is the kernel willing to give us huge pages when we ask?
+   static bool huge_pages_available();
+
+   // will a buffer of this size be mapped?
+   static bool is_mapped(size_t numBytes)
+   {
+#ifdef __linux__
+      return numBytes >= HUGE_PAGE_SIZE;
+#else
+      return false;
+#endif
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   static size_t roundUp(size_t numBytes)
+   {
+      return (numBytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+   }
+   static void * map(size_t numBytes);
+};
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR :: ALLOCATE
+ ****************************************/
+inline void * huge_page_allocator :: allocate(size_t numBytes)
+{
+   if (numBytes == 0)
+      return nullptr;
+
+   if (is_mapped(numBytes))
+      return map(numBytes);
+
+   void * p = malloc(numBytes);
+   if (p == nullptr)
+      throw std::bad_alloc();
+   return p;
+}
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR :: REALLOCATE
+ * Grow or shrink a buffer, keeping the first
+ * min(oldBytes, newBytes) bytes
+ ****************************************/
+inline void * huge_page_allocator :: reallocate(void * p, size_t oldBytes, size_t newBytes)
+{
+   if (p == nullptr)
+      return allocate(newBytes);
+   if (newBytes == 0)
+   {
+      deallocate(p, oldBytes);
+      return nullptr;
+   }
+
+#ifdef __linux__
+   // already mapped: let the kernel move the pages for us
+   if (is_mapped(oldBytes) && is_mapped(newBytes))
+   {
+      void * pNew = mremap(p, roundUp(oldBytes), roundUp(newBytes), MREMAP_MAYMOVE);
+      if (pNew == MAP_FAILED)
+         throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+      madvise(pNew, roundUp(newBytes), MADV_HUGEPAGE);
+#endif
+      return pNew;
+   }
+#endif
+
+   // both small: realloc does the right thing
+   if (!is_mapped(oldBytes) && !is_mapped(newBytes))
+   {
+      void * pNew = realloc(p, newBytes);
+      if (pNew == nullptr)
+         throw std::bad_alloc();
+      return pNew;
+   }
+
+   // crossing the threshold one way or the other: copy
+   void * pNew = allocate(newBytes);
+   memcpy(pNew, p, oldBytes < newBytes ? oldBytes : newBytes);
+   deallocate(p, oldBytes);
+   return pNew;
+}
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR :: DEALLOCATE
+ ****************************************/
+inline void huge_page_allocator :: deallocate(void * p, size_t numBytes)
+{
+   if (p == nullptr)
+      return;
+
+#ifdef __linux__
+   if (is_mapped(numBytes))
+   {
+      munmap(p, roundUp(numBytes));
+      return;
+   }
+#endif
+   free(p);
+}
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR :: HUGE PAGES AVAILABLE
+ * Transparent huge pages are off when the
+ * sysfs setting reads "[never]"
+ ****************************************/
+inline bool huge_page_allocator :: huge_pages_available()
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   std::ifstream fin("/sys/kernel/mm/transparent_hugepage/enabled");
+   std::string setting;
+   if (!std::getline(fin, setting))
+      return false;
+   return setting.find("[never]") == std::string::npos;
+#else
+   return false;
+#endif
+}
+
+/*****************************************
+ * HUGE PAGE ALLOCATOR :: MAP
+ * An anonymous mapping, rounded up to a whole
+ * huge page and advised for THP. The advice
+ * is only a hint: if THP is off we still get
+ * ordinary pages.
+ ****************************************/
+inline void * huge_page_allocator :: map(size_t numBytes)
+{
+#ifdef __linux__
+   void * p = mmap(nullptr, roundUp(numBytes), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED)
+      throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+   madvise(p, roundUp(numBytes), MADV_HUGEPAGE);
+#endif
+   return p;
+#else
+   void * p = malloc(numBytes);
+   if (p == nullptr)
+      throw std::bad_alloc();
+   return p;
+#endif
+}
+
+/*****************************************
+ * HUGE VECTOR
+ * Just like our vector, but the buffer comes
+ * from the huge_page_allocator. T must be
+ * trivially copyable since the buffer is
+ * moved around with mremap and memcpy.
+ ****************************************/
+template <typename T>
+class huge_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "huge_vector needs a trivially copyable T");
+
+public:
+
+   //
+   // Construct
+   //
+
+   huge_vector() : data(nullptr), numCapacity(0), numElements(0) { }
+   huge_vector(size_t numElements, const T & t = T());
+   huge_vector(const huge_vector &  rhs);
+   huge_vector(      huge_vector && rhs);
+   ~huge_vector()
+   {
+      huge_page_allocator::deallocate(data, numCapacity * sizeof(T));
+   }
+
+   //
+   // Assign
+   //
+
+   void swap(huge_vector & rhs)
+   {
+      std::swap(data,        rhs.data);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numCapacity, rhs.numCapacity);
+   }
+   huge_vector & operator = (const huge_vector & rhs)
+   {
+      huge_vector copy(rhs);
+      swap(copy);
+      return *this;
+   }
+   huge_vector & operator = (huge_vector && rhs)
+   {
+      huge_vector empty;
+      swap(rhs);
+      rhs.swap(empty);
+      return *this;
+   }
+
+   //
+   // Iterator
+   //
+
+   typedef typename vector<T>::iterator iterator;
+   iterator begin() { return iterator(data);               }
+   iterator end()   { return iterator(data + numElements); }
+
+   //
+   // Access
+   //
+
+         T & operator [] (size_t index)       { return data[index]; }
+   const T & operator [] (size_t index) const { return data[index]; }
+         T & front()                          { return data[0];     }
+   const T & front()                    const { return data[0];     }
+         T & back()                           { return data[numElements - 1]; }
+   const T & back()                     const { return data[numElements - 1]; }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t)
+   {
+      if (numElements == numCapacity)
+         reserve(numCapacity == 0 ? 1 : numCapacity * 2);
+      data[numElements++] = t;
+   }
+   void reserve(size_t newCapacity);
+   void resize(size_t newElements, const T & t = T());
+
+   //
+   // Remove
+   //
+
+   void clear()    { numElements = 0; }
+   void pop_back()
+   {
+      if (numElements > 0)
+         numElements--;
+   }
+   void shrink_to_fit();
+
+   //
+   // Status
+   //
+
+   size_t size()     const { return numElements;      }
+   size_t capacity() const { return numCapacity;      }
+   bool   empty()    const { return numElements == 0; }
+
+   // is the buffer in a huge-page mapping right now?
+   bool   is_mapped() const
+   {
+      return huge_page_allocator::is_mapped(numCapacity * sizeof(T));
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   void reallocate(size_t newCapacity);
+
+   T *     data;              // user data, from the huge_page_allocator
+   size_t  numCapacity;       // the capacity of the array
+   size_t  numElements;       // the number of items currently used
+};
+
+/*****************************************
+ * HUGE VECTOR :: NON-DEFAULT constructor
+ ****************************************/
+template <typename T>
+huge_vector <T> :: huge_vector(size_t num, const T & t) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   resize(num, t);
+}
+
+/*****************************************
+ * HUGE VECTOR :: COPY CONSTRUCTOR
+ * A single memcpy of the used elements
+ ****************************************/
+template <typename T>
+huge_vector <T> :: huge_vector(const huge_vector & rhs) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   reserve(rhs.numElements);
+   if (rhs.numElements)
+      memcpy(data, rhs.data, rhs.numElements * sizeof(T));
+   numElements = rhs.numElements;
+}
+
+/*****************************************
+ * HUGE VECTOR :: MOVE CONSTRUCTOR
+ ****************************************/
+template <typename T>
+huge_vector <T> :: huge_vector(huge_vector && rhs) :
+   data(nullptr), numCapacity(0), numElements(0)
+{
+   swap(rhs);
+}
+
+/***************************************
+ * HUGE VECTOR :: RESERVE
+ **************************************/
+template <typename T>
+void huge_vector <T> :: reserve(size_t newCapacity)
+{
+   if (newCapacity <= numCapacity)
+      return;
+   reallocate(newCapacity);
+}
+
+/***************************************
+ * HUGE VECTOR :: RESIZE
+ **************************************/
+template <typename T>
+void huge_vector <T> :: resize(size_t newElements, const T & t)
+{
+   reserve(newElements);
+   for (size_t i = numElements; i < newElements; i++)
+      data[i] = t;
+   numElements = newElements;
+}
+
+/***************************************
+ * HUGE VECTOR :: SHRINK TO FIT
+ **************************************/
+template <typename T>
+void huge_vector <T> :: shrink_to_fit()
+{
+   if (numElements != numCapacity)
+      reallocate(numElements);
+}
+
+/***************************************
+ * HUGE VECTOR :: REALLOCATE
+ * No element-by-element copy: the allocator
+ * remaps or reallocs the whole buffer
+ **************************************/
+template <typename T>
+void huge_vector <T> :: reallocate(size_t newCapacity)
+{
+   data = static_cast<T *>(huge_page_allocator::reallocate(data,
+                                                           numCapacity * sizeof(T),
+                                                           newCapacity * sizeof(T)));
+   numCapacity = newCapacity;
+}
+
+} // namespace custom
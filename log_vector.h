@@ -0,0 +1,454 @@
+/***********************************************************************
+ * Header:
+ *    LOG VECTOR
+ * Summary:
+ *    A vector that survives a crash. Every push_back() is also appended
+ *    to a log file on the disk. Appends are grouped: they are written and
+ *    synced together once commitInterval of them are waiting, or whenever
+ *    commit() is called, so a crash loses at most the appends since the
+ *    last commit. On startup the vector is rebuilt from the last snapshot
+ *    plus the log, and compact() folds the log into a new snapshot.
+ *
+ *    Files:
+ *       <name>.snap   the vector as of the last compact(), see serialize.h
+ *       <name>.log    a header, then records of
+ *          +------------+-------+---------+----------+-------------------+
+ *          | firstIndex | count | padding | checksum | element ...       |
+ *          +------------+-------+---------+----------+-------------------+
+ *
+ *    This will contain the class definition of:
+ *        log_vector             : An append-only, crash consistent vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32   // this needs POSIX fsync() and rename()
+
+#include <algorithm>   // for std::min
+#include <cassert>     // because I am paranoid
+#include <cstdint>     // for uint32_t and uint64_t
+#include <cstdio>      // for rename and remove
+#include <stdexcept>   // for std::runtime_error
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable
+
+#include <fcntl.h>     // for open
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for fsync, fdatasync, ftruncate, lseek
+
+#include "serialize.h" // for save, load, checksum_builder, and the I/O helpers
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * LOG VECTOR
+ * An append-only vector of trivially copyable
+ * T, kept durable by a write-ahead log
+ ****************************************/
+template <typename T>
+class log_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "log_vector needs a trivially copyable T");
+
+public:
+   enum { MAGIC = 0x474c5643,   // "CVLG"
+          VERSION = 1 };
+   static const size_t MAX_RECORD_BYTES = 64 * 1024 * 1024;   // a bigger commit is split
+
+   //
+   // Construct
+   //
+
+   log_vector(const std::string & baseName, size_t commitInterval = 64);
+   log_vector(const log_vector & rhs) = delete;
+   log_vector & operator = (const log_vector & rhs) = delete;
+   ~log_vector();
+
+   //
+   // Access
+   //
+
+   const T & operator [] (size_t index) const { return elements[index]; }
+   const T & front()                    const { return elements.front(); }
+   const T & back()                     const { return elements.back();  }
+   const vector<T> & contents()         const { return elements;         }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t)
+   {
+      elements.push_back(t);
+      if (elements.size() - numCommitted >= commitInterval)
+         commit();
+   }
+
+   //
+   // Persist
+   //
+
+   // write and sync everything appended since the last commit
+   void commit();
+
+   // write a snapshot of everything and start an empty log
+   void compact();
+
+   //
+   // Status
+   //
+
+   size_t size()            const { return elements.size();      }
+   bool   empty()           const { return elements.size() == 0; }
+   size_t durable_size()    const { return numCommitted;         }
+   size_t commit_interval() const { return commitInterval;       }
+   void   set_commit_interval(size_t interval)
+   {
+      commitInterval = interval ? interval : 1;
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   // the first 16 bytes of the log
+   struct LogHeader
+   {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t endian;
+      uint32_t elementSize;
+   };
+
+   // in front of every group of elements
+   struct RecordHeader
+   {
+      uint64_t firstIndex;    // where the first element goes in the vector
+      uint32_t count;         // how many elements follow
+      uint32_t padding;
+      uint64_t checksum;      // over firstIndex, count, and the elements
+   };
+
+   static uint64_t recordChecksum(const RecordHeader & header, const void * p);
+   static void syncDirectory(const std::string & fileName);
+   void openLog();
+   void replay();
+   void startLog();
+   static void syncData(int fd)
+   {
+#ifdef __linux__
+      if (fdatasync(fd) != 0)
+#else
+      if (fsync(fd) != 0)
+#endif
+         throw std::runtime_error("log_vector: unable to sync");
+   }
+
+   std::string logName;          // <name>.log
+   std::string snapName;         // <name>.snap
+   int         fd;               // the log, open for appending
+   size_t      commitInterval;   // how many appends to group into one sync
+   size_t      recordElements;   // the most elements in one record
+   size_t      numCommitted;     // elements that are safely on the disk
+   vector<T>   elements;         // the whole vector, in memory
+};
+
+/*****************************************
+ * LOG VECTOR :: CONSTRUCTOR
+ * Load the snapshot, then replay the log
+ ****************************************/
+template <typename T>
+log_vector <T> :: log_vector(const std::string & baseName, size_t commitInterval) :
+   logName(baseName + ".log"), snapName(baseName + ".snap"), fd(-1),
+   commitInterval(commitInterval ? commitInterval : 1),
+   recordElements(MAX_RECORD_BYTES / sizeof(T) ? MAX_RECORD_BYTES / sizeof(T) : 1),
+   numCommitted(0)
+{
+   // no snapshot just means we have never compacted
+   int fdSnap = open(snapName.c_str(), O_RDONLY);
+   if (fdSnap != -1)
+   {
+      try
+      {
+         load(fdSnap, elements);
+      }
+      catch (...)
+      {
+         ::close(fdSnap);
+         throw;
+      }
+      ::close(fdSnap);
+   }
+
+   // the destructor will not run to close a log we fail to open
+   try
+   {
+      openLog();
+   }
+   catch (...)
+   {
+      if (fd != -1)
+         ::close(fd);
+      fd = -1;
+      throw;
+   }
+   numCommitted = elements.size();
+}
+
+/*****************************************
+ * LOG VECTOR :: DESTRUCTOR
+ * A clean shutdown commits what is waiting
+ ****************************************/
+template <typename T>
+log_vector <T> :: ~log_vector()
+{
+   try
+   {
+      commit();
+   }
+   catch (...)
+   {
+      // nowhere to report it from a destructor
+   }
+   ::close(fd);
+}
+
+/***************************************
+ * LOG VECTOR :: COMMIT
+ * One sync for the whole group. A group too
+ * big for one record is written as several,
+ * each of which replays on its own. A failed
+ * write can leave a torn record behind, and
+ * replay() would cut off every later commit
+ * with it, so on failure the log is cut back
+ * to where this commit started.
+ **************************************/
+template <typename T>
+void log_vector <T> :: commit()
+{
+   if (numCommitted == elements.size())
+      return;
+
+   off_t start = lseek(fd, 0, SEEK_CUR);
+   if (start < 0)
+      throw std::runtime_error("log_vector: unable to find the end of " + logName);
+
+   try
+   {
+      for (size_t first = numCommitted; first < elements.size(); )
+      {
+         const T * p = &elements[first];
+         RecordHeader header = {};
+         header.firstIndex = first;
+         header.count      = uint32_t(std::min(elements.size() - first, recordElements));
+         header.checksum   = recordChecksum(header, p);
+
+         writeAll(fd, &header, sizeof(header), p, header.count * sizeof(T));
+         first += header.count;
+      }
+      syncData(fd);
+   }
+   catch (...)
+   {
+      if (ftruncate(fd, start) != 0 || lseek(fd, start, SEEK_SET) != start)
+         throw std::runtime_error("log_vector: unable to roll back " + logName);
+      throw;
+   }
+   numCommitted = elements.size();
+}
+
+/***************************************
+ * LOG VECTOR :: COMPACT
+ * Write the snapshot to a new file and rename
+ * it into place, then empty the log. A crash
+ * before the rename leaves the old snapshot
+ * and the full log; a crash after it leaves
+ * log records the snapshot already holds,
+ * which replay() skips by their firstIndex.
+ * The rename is only durable once the
+ * directory is synced, so that comes before
+ * the log is emptied.
+ **************************************/
+template <typename T>
+void log_vector <T> :: compact()
+{
+   commit();
+
+   std::string tempName = snapName + ".tmp";
+   int fdSnap = open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fdSnap == -1)
+      throw std::runtime_error("log_vector: unable to create " + tempName);
+   try
+   {
+      save(fdSnap, elements);
+      if (fsync(fdSnap) != 0)
+         throw std::runtime_error("log_vector: unable to sync the snapshot");
+   }
+   catch (...)
+   {
+      ::close(fdSnap);
+      std::remove(tempName.c_str());
+      throw;
+   }
+   ::close(fdSnap);
+
+   if (std::rename(tempName.c_str(), snapName.c_str()) != 0)
+      throw std::runtime_error("log_vector: unable to replace " + snapName);
+   syncDirectory(snapName);
+
+   // the snapshot has it all: start the log over
+   if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0)
+      throw std::runtime_error("log_vector: unable to truncate " + logName);
+   startLog();
+}
+
+/***************************************
+ * LOG VECTOR :: RECORD CHECKSUM
+ **************************************/
+template <typename T>
+uint64_t log_vector <T> :: recordChecksum(const RecordHeader & header, const void * p)
+{
+   checksum_builder builder;
+   builder.update(&header.firstIndex, sizeof(header.firstIndex));
+   builder.update(&header.count,      sizeof(header.count));
+   builder.update(p, header.count * sizeof(T));
+   return builder.finish();
+}
+
+/***************************************
+ * LOG VECTOR :: SYNC DIRECTORY
+ * Make the entries of the directory holding
+ * fileName durable
+ **************************************/
+template <typename T>
+void log_vector <T> :: syncDirectory(const std::string & fileName)
+{
+   size_t slash = fileName.find_last_of('/');
+   std::string dir = slash == std::string::npos ? std::string(".")
+                   : slash == 0                 ? std::string("/")
+                                                : fileName.substr(0, slash);
+   int fdDir = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+   if (fdDir == -1)
+      throw std::runtime_error("log_vector: unable to open " + dir);
+   int result = fsync(fdDir);
+   ::close(fdDir);
+   if (result != 0)
+      throw std::runtime_error("log_vector: unable to sync " + dir);
+}
+
+/***************************************
+ * LOG VECTOR :: OPEN LOG
+ * Create the log, or check its header and
+ * replay it onto the snapshot
+ **************************************/
+template <typename T>
+void log_vector <T> :: openLog()
+{
+   fd = open(logName.c_str(), O_RDWR | O_CREAT, 0644);
+   if (fd == -1)
+      throw std::runtime_error("log_vector: unable to open " + logName);
+
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(LogHeader)))
+   {
+      // empty, or the crash came before the header made it out
+      if (ftruncate(fd, 0) != 0)
+         throw std::runtime_error("log_vector: unable to truncate " + logName);
+      startLog();
+      return;
+   }
+
+   LogHeader header;
+   readAll(fd, &header, sizeof(header));
+   if (header.magic != MAGIC || header.version != VERSION ||
+       header.endian != serial_header::ENDIAN || header.elementSize != sizeof(T))
+      throw std::runtime_error("log_vector: " + logName + " is not a log of this type");
+
+   replay();
+}
+
+/***************************************
+ * LOG VECTOR :: REPLAY
+ * Append every good record to the vector.
+ * The first torn or damaged record marks
+ * where the crash hit: it and anything after
+ * it were never committed, so cut them off.
+ * A count longer than the rest of the file
+ * is torn too, and is never allocated.
+ **************************************/
+template <typename T>
+void log_vector <T> :: replay()
+{
+   off_t good = lseek(fd, 0, SEEK_CUR);
+   std::string payload;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0)
+      throw std::runtime_error("log_vector: unable to read " + logName);
+
+   for (;;)
+   {
+      RecordHeader header;
+      try
+      {
+         if (!readUpTo(fd, &header, sizeof(header)))
+            break;
+         off_t position = lseek(fd, 0, SEEK_CUR);
+         if (position < 0 || header.count > uint64_t(st.st_size - position) / sizeof(T))
+            break;
+         payload.resize(header.count * sizeof(T));
+         if (!payload.empty())
+            readAll(fd, &payload[0], payload.size());
+      }
+      catch (const std::runtime_error &)
+      {
+         break;   // a torn record at the end of the log
+      }
+
+      if (recordChecksum(header, payload.data()) != header.checksum ||
+          header.firstIndex > elements.size())
+         break;
+
+      // skip anything the snapshot already holds
+      const T * p = reinterpret_cast<const T *>(payload.data());
+      for (size_t i = 0; i < header.count; i++)
+         if (header.firstIndex + i >= elements.size())
+         {
+            T t;
+            memcpy(&t, p + i, sizeof(T));
+            elements.push_back(t);
+         }
+      good = lseek(fd, 0, SEEK_CUR);
+   }
+
+   // new records go right after the last good one
+   if (ftruncate(fd, good) != 0 || lseek(fd, good, SEEK_SET) != good)
+      throw std::runtime_error("log_vector: unable to truncate " + logName);
+}
+
+/***************************************
+ * LOG VECTOR :: START LOG
+ * Write the header of an empty log
+ **************************************/
+template <typename T>
+void log_vector <T> :: startLog()
+{
+   LogHeader header;
+   header.magic       = MAGIC;
+   header.version     = VERSION;
+   header.endian      = serial_header::ENDIAN;
+   header.elementSize = uint32_t(sizeof(T));
+   writeAll(fd, &header, sizeof(header), nullptr, 0);
+   syncData(fd);
+}
+
+} // namespace custom
+
+#endif // !_WIN32
@@ -0,0 +1,431 @@
+/***********************************************************************
+ * Header:
+ *    MMAP VECTOR
+ * Summary:
+ *    A vector that lives in a memory-mapped file. The file holds a small
+ *    header followed by the elements exactly as they sit in memory, so
+ *    opening an existing file is just an mmap() with no parsing and no
+ *    copying. Only trivially copyable types can be stored this way.
+ *
+ *    File layout:
+ *       +--------+---------+-------------+-------+----------+---------+
+ *       | magic  | version | elementSize | count | capacity | padding |
+ *       +--------+---------+-------------+-------+----------+---------+
+ *       | element 0 | element 1 | ... | element capacity-1            |
+ *       +-------------------------------------------------------------+
+ *
+ *    This will contain the class definition of:
+ *        mmap_vector            : A vector backed by a mapped file
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32   // this needs POSIX mmap()
+
+#include <cassert>     // because I am paranoid
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint32_t and uint64_t
+#include <stdexcept>   // for std::runtime_error
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable
+#include <utility>     // for std::swap
+
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap, mremap, msync, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for ftruncate, close, sysconf
+
+#include "vector.h"    // for vector::iterator
+
+namespace custom
+{
+
+/*****************************************
+ * MMAP VECTOR
+ * Just like our vector, but the buffer is a
+ * file on the disk. The header in the file is
+ * kept up to date on every change, so whatever
+ * is in memory is what the file holds.
+ ****************************************/
+template <typename T>
+class mmap_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "mmap_vector needs a trivially copyable T");
+
+public:
+   enum Mode { CREATE,       // start a new, empty file (truncate any old one)
+               READ_WRITE,   // open an existing file, or create it
+               READ_ONLY };  // open an existing file; element writes stay in memory
+
+   static const uint32_t MAGIC   = 0x564d4d43;  // "CMMV"
+   static const uint32_t VERSION = 1;
+
+   //
+   // Construct
+   //
+
+   mmap_vector() : fd(-1), mode(READ_ONLY), mapSize(0), pHeader(nullptr), data(nullptr) { }
+   mmap_vector(const std::string & fileName, Mode mode = READ_WRITE);
+   mmap_vector(const mmap_vector &  rhs) = delete;
+   mmap_vector(      mmap_vector && rhs);
+   ~mmap_vector() { close(); }
+
+   void open(const std::string & fileName, Mode mode = READ_WRITE);
+   void close();
+   bool is_open()   const { return fd != -1;         }
+   bool read_only() const { return mode == READ_ONLY; }
+
+   //
+   // Assign
+   //
+
+   void swap(mmap_vector & rhs)
+   {
+      std::swap(fd,      rhs.fd);
+      std::swap(mode,    rhs.mode);
+      std::swap(mapSize, rhs.mapSize);
+      std::swap(pHeader, rhs.pHeader);
+      std::swap(data,    rhs.data);
+   }
+   mmap_vector & operator = (const mmap_vector &  rhs) = delete;
+   mmap_vector & operator = (      mmap_vector && rhs)
+   {
+      mmap_vector empty;
+      swap(rhs);
+      rhs.swap(empty);   // our old file is closed with "empty"
+      return *this;
+   }
+
+   //
+   // Iterator
+   //
+
+   typedef typename vector<T>::iterator iterator;
+   iterator begin() { return iterator(data);          }
+   iterator end()   { return iterator(data + size()); }
+
+   //
+   // Access
+   //
+
+         T & operator [] (size_t index)       { return data[index]; }
+   const T & operator [] (size_t index) const { return data[index]; }
+         T & front()                          { return data[0];     }
+   const T & front()                    const { return data[0];     }
+         T & back()                           { return data[size() - 1]; }
+   const T & back()                     const { return data[size() - 1]; }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t);
+   void reserve(size_t newCapacity);
+   void resize(size_t newElements, const T & t = T());
+
+   //
+   // Remove
+   //
+
+   void clear()
+   {
+      checkWritable();
+      pHeader->count = 0;
+   }
+   void pop_back()
+   {
+      checkWritable();
+      if (pHeader->count > 0)
+         pHeader->count--;
+   }
+   void shrink_to_fit();
+
+   //
+   // Status
+   //
+
+   size_t size()     const { return pHeader ? size_t(pHeader->count)    : 0; }
+   size_t capacity() const { return pHeader ? size_t(pHeader->capacity) : 0; }
+   bool   empty()    const { return size() == 0; }
+
+   //
+   // Persist
+   //
+
+   void sync();
+   void sync(size_t first, size_t num);
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   // the start of the file. It is padded to 64 bytes so the elements are aligned.
+   struct Header
+   {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t elementSize;
+      uint64_t count;
+      uint64_t capacity;
+      uint8_t  padding[32];
+   };
+   static_assert(sizeof(Header) == 64, "the header must be 64 bytes");
+
+   static size_t fileSize(size_t capacity) { return sizeof(Header) + capacity * sizeof(T); }
+   void remap(size_t newCapacity);
+   void checkWritable() const
+   {
+      if (mode == READ_ONLY)
+         throw std::runtime_error("mmap_vector: the file was opened read-only");
+   }
+   void fail(const std::string & what)
+   {
+      close();
+      throw std::runtime_error("mmap_vector: " + what);
+   }
+
+   int      fd;               // the open file, or -1
+   Mode     mode;             // how the file was opened
+   size_t   mapSize;          // bytes mapped, which may be more than the header needs
+   Header * pHeader;          // the start of the mapping
+   T *      data;             // the elements, just past the header
+};
+
+/*****************************************
+ * MMAP VECTOR :: NON-DEFAULT constructor
+ ****************************************/
+template <typename T>
+mmap_vector <T> :: mmap_vector(const std::string & fileName, Mode mode) :
+   fd(-1), mode(READ_ONLY), mapSize(0), pHeader(nullptr), data(nullptr)
+{
+   open(fileName, mode);
+}
+
+/*****************************************
+ * MMAP VECTOR :: MOVE CONSTRUCTOR
+ ****************************************/
+template <typename T>
+mmap_vector <T> :: mmap_vector(mmap_vector && rhs) :
+   fd(-1), mode(READ_ONLY), mapSize(0), pHeader(nullptr), data(nullptr)
+{
+   swap(rhs);
+}
+
+/*****************************************
+ * MMAP VECTOR :: OPEN
+ * Map the file, writing a fresh header if it
+ * is new and checking the header if it is not
+ ****************************************/
+template <typename T>
+void mmap_vector <T> :: open(const std::string & fileName, Mode mode)
+{
+   close();
+   this->mode = mode;
+
+   int flags = (mode == READ_ONLY ? O_RDONLY : O_RDWR | O_CREAT);
+   if (mode == CREATE)
+      flags |= O_TRUNC;
+   fd = ::open(fileName.c_str(), flags, 0644);
+   if (fd == -1)
+      fail("unable to open " + fileName);
+
+   struct stat st;
+   if (fstat(fd, &st) != 0)
+      fail("unable to stat " + fileName);
+
+   // a brand new file gets an empty header
+   bool fresh = (st.st_size == 0);
+   if (fresh)
+   {
+      if (mode == READ_ONLY)
+         fail(fileName + " is empty");
+      if (ftruncate(fd, fileSize(0)) != 0)
+         fail("unable to grow " + fileName);
+   }
+   else if (size_t(st.st_size) < sizeof(Header))
+      fail(fileName + " is too small to be an mmap_vector");
+
+   // map the whole file, even past the capacity its header gives. A
+   // read-only file is mapped private, so writing an element through
+   // operator [] changes our copy of the page and never the file.
+   int share = (mode == READ_ONLY ? MAP_PRIVATE : MAP_SHARED);
+   size_t numBytes = fresh ? fileSize(0) : size_t(st.st_size);
+   void * p = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, share, fd, 0);
+   if (p == MAP_FAILED)
+      fail("unable to map " + fileName);
+   mapSize = numBytes;
+   pHeader = static_cast<Header *>(p);
+   data    = reinterpret_cast<T *>(pHeader + 1);
+
+   if (fresh)
+   {
+      pHeader->magic       = MAGIC;
+      pHeader->version     = VERSION;
+      pHeader->elementSize = sizeof(T);
+      pHeader->count       = 0;
+      pHeader->capacity    = 0;
+      return;
+   }
+
+   // an existing file must be one of ours, with the same sized elements
+   std::string problem;
+   if (pHeader->magic != MAGIC || pHeader->version != VERSION)
+      problem = " is not an mmap_vector file";
+   else if (pHeader->elementSize != sizeof(T))
+      problem = " holds elements of a different size";
+   else if (pHeader->count > pHeader->capacity ||
+            fileSize(size_t(pHeader->capacity)) > mapSize)
+      problem = " is truncated";
+
+   if (!problem.empty())
+      fail(fileName + problem);
+}
+
+/*****************************************
+ * MMAP VECTOR :: CLOSE
+ * Unmap and close. Writes reach the file
+ * through the page cache; call sync() first
+ * if they need to be on the disk.
+ ****************************************/
+template <typename T>
+void mmap_vector <T> :: close()
+{
+   if (pHeader != nullptr)
+      munmap(pHeader, mapSize);
+   if (fd != -1)
+      ::close(fd);
+   fd = -1;
+   mapSize = 0;
+   pHeader = nullptr;
+   data = nullptr;
+}
+
+/***************************************
+ * MMAP VECTOR :: PUSH BACK
+ * Doubles the capacity like vector does
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: push_back(const T & t)
+{
+   checkWritable();
+   if (size() == capacity())
+      reserve(capacity() == 0 ? 1 : capacity() * 2);
+   data[pHeader->count++] = t;
+}
+
+/***************************************
+ * MMAP VECTOR :: RESERVE
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: reserve(size_t newCapacity)
+{
+   checkWritable();
+   if (newCapacity <= capacity())
+      return;
+   remap(newCapacity);
+}
+
+/***************************************
+ * MMAP VECTOR :: RESIZE
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: resize(size_t newElements, const T & t)
+{
+   checkWritable();
+   reserve(newElements);
+   for (size_t i = size(); i < newElements; i++)
+      data[i] = t;
+   pHeader->count = newElements;
+}
+
+/***************************************
+ * MMAP VECTOR :: SHRINK TO FIT
+ * Truncate the file down to the elements in use
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: shrink_to_fit()
+{
+   checkWritable();
+   if (size() != capacity())
+      remap(size());
+}
+
+/***************************************
+ * MMAP VECTOR :: SYNC
+ * Flush the whole mapping, or just the pages
+ * that hold elements [first, first + num),
+ * to the disk
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: sync()
+{
+   if (pHeader == nullptr || mode == READ_ONLY)
+      return;
+   if (msync(pHeader, mapSize, MS_SYNC) != 0)
+      throw std::runtime_error("mmap_vector: msync failed");
+}
+
+template <typename T>
+void mmap_vector <T> :: sync(size_t first, size_t num)
+{
+   if (pHeader == nullptr || mode == READ_ONLY || num == 0)
+      return;
+   assert(first + num <= capacity());
+
+   // msync() wants a page-aligned start
+   size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+   size_t begin = sizeof(Header) + first * sizeof(T);
+   size_t end   = begin + num * sizeof(T);
+   begin -= begin % pageSize;
+
+   char * p = reinterpret_cast<char *>(pHeader);
+   if (msync(p + begin, end - begin, MS_SYNC) != 0 ||
+       msync(pHeader, sizeof(Header), MS_SYNC) != 0)
+      throw std::runtime_error("mmap_vector: msync failed");
+}
+
+/***************************************
+ * MMAP VECTOR :: REMAP
+ * Change the size of the file and of the
+ * mapping. On Linux mremap() grows the
+ * mapping in place or moves the page tables;
+ * elsewhere we unmap and map again.
+ **************************************/
+template <typename T>
+void mmap_vector <T> :: remap(size_t newCapacity)
+{
+   size_t oldSize = mapSize;
+   size_t newSize = fileSize(newCapacity);
+
+   if (newSize > oldSize && ftruncate(fd, newSize) != 0)
+      throw std::runtime_error("mmap_vector: unable to grow the file");
+
+#ifdef __linux__
+   void * p = mremap(pHeader, oldSize, newSize, MREMAP_MAYMOVE);
+   if (p == MAP_FAILED)
+      throw std::runtime_error("mmap_vector: unable to remap the file");
+#else
+   munmap(pHeader, oldSize);
+   pHeader = nullptr;
+   void * p = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (p == MAP_FAILED)
+      fail("unable to remap the file");
+#endif
+
+   mapSize = newSize;
+   pHeader = static_cast<Header *>(p);
+   data    = reinterpret_cast<T *>(pHeader + 1);
+   pHeader->capacity = newCapacity;
+
+   if (newSize < oldSize && ftruncate(fd, newSize) != 0)
+      throw std::runtime_error("mmap_vector: unable to shrink the file");
+}
+
+} // namespace custom
+
+#endif // !_WIN32
@@ -0,0 +1,345 @@
+/***********************************************************************
+ * Header:
+ *    NULLABLE VECTOR
+ * Summary:
+ *    A vector where any element may be null, stored the way Arrow
+ *    stores it: the values densely, one T each, and beside them a
+ *    bitmap with one bit per element saying whether it is there. That
+ *    costs one bit per element instead of the padded flag an optional
+ *    adds, and keeps the values in a plain array the compiler can
+ *    vectorize over.
+ *
+ *    A null element's value is always T(), so sum() can add every slot
+ *    without looking at the bitmap. min() and max() take 64 elements at a
+ *    time: all present, all null, or mixed.
+ *
+ *    This will contain the class definition of:
+ *        nullopt_t, nullopt     : What to push for "no value"
+ *        nullable_vector        : A vector plus a validity bitmap
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // because I am paranoid
+#include <cstdint>     // for uint64_t
+#include <utility>     // for std::swap
+#include <vector>      // for the validity bitmap
+
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * NULLOPT
+ * Stands in for std::nullopt until we are
+ * on C++17
+ ****************************************/
+struct nullopt_t
+{
+   explicit constexpr nullopt_t(int) { }
+};
+constexpr nullopt_t nullopt(0);
+
+/*****************************************
+ * NULLABLE VECTOR
+ * Dense values plus a packed validity bitmap
+ ****************************************/
+template <typename T>
+class nullable_vector
+{
+public:
+   //
+   // Construct
+   //
+
+   nullable_vector() : numNulls(0) { }
+   nullable_vector(const nullable_vector & rhs) : numNulls(0) { *this = rhs; }
+   nullable_vector(nullable_vector && rhs) : numNulls(0) { swap(rhs); }
+
+   //
+   // Assign
+   //
+
+   nullable_vector & operator = (const nullable_vector & rhs);
+   nullable_vector & operator = (nullable_vector && rhs)
+   {
+      nullable_vector empty;
+      swap(rhs);
+      rhs.swap(empty);
+      return *this;
+   }
+   void swap(nullable_vector & rhs)
+   {
+      values.swap(rhs.values);
+      validity.swap(rhs.validity);
+      std::swap(numNulls, rhs.numNulls);
+   }
+
+   //
+   // Access
+   //
+
+   // the value, which is T() for a null element
+   const T & operator [] (size_t index) const { return values[index]; }
+   bool is_valid(size_t index) const
+   {
+      assert(index < size());
+      return (validity[index / 64] >> (index % 64)) & 1;
+   }
+   bool is_null(size_t index) const { return !is_valid(index); }
+
+   // the values and the bitmap, as Arrow would want them
+   const T *        value_data()    const { return size() ? &values[0] : nullptr; }
+   const uint64_t * validity_data() const { return validity.empty() ? nullptr : &validity[0]; }
+
+   //
+   // Insert
+   //
+
+   void push_back(const T & t)
+   {
+      values.push_back(t);
+      growBitmap();
+      validity[(size() - 1) / 64] |= uint64_t(1) << ((size() - 1) % 64);
+   }
+   void push_back(nullopt_t)
+   {
+      values.push_back(T());
+      growBitmap();   // a new word starts all null
+      numNulls++;
+   }
+   void set(size_t index, const T & t);
+   void set_null(size_t index);
+   void reserve(size_t newCapacity)
+   {
+      values.reserve(newCapacity);
+      validity.reserve((newCapacity + 63) / 64);
+   }
+   void resize(size_t newElements);   // new elements are null
+
+   //
+   // Remove
+   //
+
+   void pop_back()
+   {
+      if (size())
+         resize(size() - 1);
+   }
+   void clear() { resize(0); }
+
+   //
+   // Status
+   //
+
+   size_t size()       const { return values.size();          }
+   bool   empty()      const { return values.size() == 0;     }
+   size_t null_count() const { return numNulls;               }
+   size_t count()      const { return values.size() - numNulls; }
+
+   //
+   // Reduce, skipping the nulls
+   //
+
+   T    sum() const;
+   bool min(T & t) const;   // false if every element is null
+   bool max(T & t) const;
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // make room in the bitmap for the element just pushed
+   void growBitmap()
+   {
+      if (validity.size() * 64 < size())
+         validity.push_back(0);
+   }
+
+   // the position of the lowest set bit
+   static size_t lowestBit(uint64_t bits)
+   {
+#ifdef __GNUC__
+      return size_t(__builtin_ctzll(bits));
+#else
+      size_t i = 0;
+      while (!((bits >> i) & 1))
+         i++;
+      return i;
+#endif
+   }
+
+   // the best of the valid elements, by min or by max
+   template <class Better>
+   bool reduce(T & t, Better better) const;
+
+   vector<T>             values;     // T() where the element is null
+   std::vector<uint64_t> validity;   // bit i is set if element i is there
+   size_t                numNulls;   // elements whose bit is clear
+};
+
+/*****************************************
+ * NULLABLE VECTOR :: ASSIGNMENT
+ ****************************************/
+template <typename T>
+nullable_vector <T> & nullable_vector <T> :: operator = (const nullable_vector & rhs)
+{
+   if (this == &rhs)
+      return *this;
+   vector<T> valuesNew;
+   valuesNew.reserve(rhs.size());
+   for (size_t i = 0; i < rhs.size(); i++)
+      valuesNew.push_back(rhs.values[i]);
+   values.swap(valuesNew);
+   validity = rhs.validity;
+   numNulls = rhs.numNulls;
+   return *this;
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: SET
+ ****************************************/
+template <typename T>
+void nullable_vector <T> :: set(size_t index, const T & t)
+{
+   assert(index < size());
+   if (is_null(index))
+   {
+      validity[index / 64] |= uint64_t(1) << (index % 64);
+      numNulls--;
+   }
+   values[index] = t;
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: SET NULL
+ * Clear the bit, and the value with it, so
+ * sum() can still add every slot
+ ****************************************/
+template <typename T>
+void nullable_vector <T> :: set_null(size_t index)
+{
+   assert(index < size());
+   if (is_valid(index))
+   {
+      validity[index / 64] &= ~(uint64_t(1) << (index % 64));
+      numNulls++;
+   }
+   values[index] = T();
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: RESIZE
+ * Growing adds nulls. Shrinking forgets the
+ * dropped elements' bits, so the bitmap past
+ * size() is always clear.
+ ****************************************/
+template <typename T>
+void nullable_vector <T> :: resize(size_t newElements)
+{
+   if (newElements > size())
+   {
+      numNulls += newElements - size();
+      values.resize(newElements, T());
+      validity.resize((newElements + 63) / 64, 0);
+      return;
+   }
+
+   for (size_t i = newElements; i < size(); i++)
+      if (is_null(i))
+         numNulls--;
+   values.resize(newElements, T());
+   validity.resize((newElements + 63) / 64);
+   if (newElements % 64)
+      validity.back() &= (uint64_t(1) << (newElements % 64)) - 1;
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: SUM
+ * Nulls hold T(), so this is a plain sum over
+ * every slot. Eight separate running totals
+ * let the compiler use SIMD registers and keep
+ * the adds from waiting on each other.
+ ****************************************/
+template <typename T>
+T nullable_vector <T> :: sum() const
+{
+   const T * p = value_data();
+   const size_t num = size();
+   T partial[8] = { T(), T(), T(), T(), T(), T(), T(), T() };
+
+   size_t i = 0;
+   for (; i + 8 <= num; i += 8)
+      for (size_t lane = 0; lane < 8; lane++)
+         partial[lane] += p[i + lane];
+   for (; i < num; i++)
+      partial[0] += p[i];
+
+   T total = T();
+   for (size_t lane = 0; lane < 8; lane++)
+      total += partial[lane];
+   return total;
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: MIN / MAX
+ ****************************************/
+template <typename T>
+bool nullable_vector <T> :: min(T & t) const
+{
+   return reduce(t, [](const T & a, const T & b) { return a < b ? a : b; });
+}
+
+template <typename T>
+bool nullable_vector <T> :: max(T & t) const
+{
+   return reduce(t, [](const T & a, const T & b) { return a > b ? a : b; });
+}
+
+/*****************************************
+ * NULLABLE VECTOR :: REDUCE
+ * A word of the bitmap at a time: a full word
+ * is a branch-free loop over 64 values, an
+ * empty word is skipped, and only a mixed
+ * word looks at the bits one by one
+ ****************************************/
+template <typename T>
+template <class Better>
+bool nullable_vector <T> :: reduce(T & t, Better better) const
+{
+   if (count() == 0)
+      return false;
+
+   const T * p = value_data();
+   bool found = false;
+   T best = T();
+   for (size_t word = 0; word < validity.size(); word++)
+   {
+      uint64_t bits = validity[word];
+      const T * q = p + word * 64;
+      if (bits == ~uint64_t(0))
+      {
+         // start from the first of the 64 if this is the first we have seen
+         T wordBest = found ? best : q[0];
+         for (size_t i = 0; i < 64; i++)
+            wordBest = better(wordBest, q[i]);
+         best = wordBest;
+         found = true;
+      }
+      else
+         for (; bits; bits &= bits - 1)
+         {
+            size_t i = lowestBit(bits);
+            best = found ? better(best, q[i]) : q[i];
+            found = true;
+         }
+   }
+   t = best;
+   return true;
+}
+
+} // namespace custom
@@ -0,0 +1,454 @@
+/***********************************************************************
+ * Header:
+ *    PARALLEL
+ * Summary:
+ *    Parallel versions of the loops we run over a whole vector. Each
+ *    algorithm cuts the index range into chunks and a pool of threads,
+ *    started once and kept for the life of the program, takes the
+ *    chunks in turn off a shared counter. A thread that finishes early
+ *    simply takes the next chunk, so uneven chunks even out.
+ *
+ *    A chunk is sized so its elements fit in a core's private cache,
+ *    but never so large that there are fewer than a few chunks per
+ *    thread. A range of one chunk or less runs on the calling thread,
+ *    and so does any call made from inside a chunk, so nesting one
+ *    algorithm inside another is safe, if not any faster.
+ *
+ *    reduce() and transform_reduce() combine the chunks' results in
+ *    index order, so the answer does not depend on which thread ran
+ *    which chunk. The operator still has to be associative.
+ *
+ *    Every algorithm runs on the shared thread_pool unless it is given
+ *    another executor as its last parameter, such as a task_scheduler.
+ *
+ *    This will contain the class definition of:
+ *        thread_pool            : A fixed set of threads that share a job
+ *        parallel::for_each     : f(element) for every element
+ *        parallel::transform    : out[i] = f(in[i])
+ *        parallel::reduce       : Combine every element with op
+ *        parallel::transform_reduce : reduce() of transform()
+ *        parallel::fill         : Every element = value
+ *        parallel::copy         : out[i] = in[i]
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>           // for std::copy, std::fill, std::min
+#include <atomic>              // for std::atomic
+#include <cassert>             // because I am paranoid
+#include <condition_variable>  // for std::condition_variable
+#include <cstddef>             // for size_t
+#include <exception>           // for std::exception_ptr
+#include <functional>          // for std::plus
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <vector>              // for the workers and the partial results
+
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * THREAD POOL
+ * The caller and size() - 1 workers run
+ * task 0 .. num - 1 of one job, each
+ * exactly once, and run() returns when all
+ * are done. One job runs at a time.
+ ****************************************/
+class thread_pool
+{
+public:
+   //
+   // Construct
+   //
+
+   // numThreads counts the thread that calls run()
+   explicit thread_pool(size_t numThreads = default_threads());
+   ~thread_pool();
+   thread_pool(const thread_pool &) = delete;
+   thread_pool & operator = (const thread_pool &) = delete;
+
+   // the pool the parallel algorithms share
+   static thread_pool & instance()
+   {
+      static thread_pool pool;
+      return pool;
+   }
+
+   static size_t default_threads()
+   {
+      size_t num = std::thread::hardware_concurrency();
+      return num ? num : 1;
+   }
+
+   //
+   // Run
+   //
+
+   // f(task) for every task, rethrowing the first exception any threw
+   template <class F>
+   void run(size_t num, F f);
+
+   //
+   // Status
+   //
+
+   size_t size() const { return workers.size() + 1; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // per thread, so a nested run() knows not to wait on itself
+   static bool & insideTask()
+   {
+      static thread_local bool inside = false;
+      return inside;
+   }
+
+   template <class F>
+   static void invoke(void * fn, size_t task) { (*static_cast<F *>(fn))(task); }
+
+   void workerLoop();
+   void work();
+
+   std::vector<std::thread> workers;
+   std::mutex               jobLock;      // one run() at a time
+   std::mutex               lock;         // guards everything below
+   std::condition_variable  wake;         // a new job, or time to stop
+   std::condition_variable  finished;     // the last worker is done
+   size_t                   generation;   // which job the workers are on
+   size_t                   numBusy;      // workers not yet done with it
+   bool                     stopping;
+
+   // the current job
+   void  (* job)(void * fn, size_t task);
+   void *                   jobFn;
+   size_t                   numTasks;
+   std::atomic<size_t>      nextTask;
+   std::exception_ptr       error;        // the first a task threw
+};
+
+/*****************************************
+ * THREAD POOL :: CONSTRUCTOR
+ * Start the workers, who wait for a job
+ ****************************************/
+inline thread_pool :: thread_pool(size_t numThreads) :
+   generation(0), numBusy(0), stopping(false),
+   job(nullptr), jobFn(nullptr), numTasks(0), nextTask(0)
+{
+   for (size_t i = 1; i < numThreads; i++)
+      workers.push_back(std::thread(&thread_pool::workerLoop, this));
+}
+
+/*****************************************
+ * THREAD POOL :: DESTRUCTOR
+ ****************************************/
+inline thread_pool :: ~thread_pool()
+{
+   {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+   }
+   wake.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+}
+
+/*****************************************
+ * THREAD POOL :: RUN
+ * Post the job, help with it, then wait
+ * for every worker to have seen it through.
+ * Waiting for all of them, not just for the
+ * tasks, means no worker is left holding a
+ * pointer to this job when the next starts.
+ ****************************************/
+template <class F>
+void thread_pool :: run(size_t num, F f)
+{
+   if (num == 0)
+      return;
+   if (num == 1 || workers.empty() || insideTask())
+   {
+      for (size_t task = 0; task < num; task++)
+         f(task);
+      return;
+   }
+
+   std::lock_guard<std::mutex> one(jobLock);
+   {
+      std::lock_guard<std::mutex> guard(lock);
+      job            = &invoke<F>;
+      jobFn          = &f;
+      numTasks       = num;
+      nextTask       = 0;
+      error          = nullptr;
+      numBusy        = workers.size();
+      generation++;
+   }
+   wake.notify_all();
+
+   work();
+
+   std::exception_ptr thrown;
+   {
+      std::unique_lock<std::mutex> guard(lock);
+      finished.wait(guard, [this] { return numBusy == 0; });
+      thrown = error;
+      error  = nullptr;
+   }
+   if (thrown)
+      std::rethrow_exception(thrown);
+}
+
+/*****************************************
+ * THREAD POOL :: WORK
+ * Take tasks until there are none left. A
+ * task that throws stops the rest of the job.
+ ****************************************/
+inline void thread_pool :: work()
+{
+   insideTask() = true;
+   for (size_t task = nextTask++; task < numTasks; task = nextTask++)
+   {
+      try
+      {
+         job(jobFn, task);
+      }
+      catch (...)
+      {
+         std::lock_guard<std::mutex> guard(lock);
+         if (!error)
+            error = std::current_exception();
+         nextTask = numTasks;
+      }
+   }
+   insideTask() = false;
+}
+
+/*****************************************
+ * THREAD POOL :: WORKER LOOP
+ * Sleep until there is a job this worker
+ * has not seen, work on it, and report back
+ ****************************************/
+inline void thread_pool :: workerLoop()
+{
+   size_t seen = 0;
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> guard(lock);
+         wake.wait(guard, [&] { return stopping || generation != seen; });
+         if (stopping)
+            return;
+         seen = generation;
+      }
+
+      work();
+
+      std::lock_guard<std::mutex> guard(lock);
+      if (--numBusy == 0)
+         finished.notify_one();
+   }
+}
+
+namespace parallel
+{
+
+/*****************************************
+ * CHUNK SIZE
+ * Enough elements to fill about a core's L2,
+ * cut down to give every thread four chunks
+ * to balance with, but not so small that
+ * taking a chunk costs more than doing it
+ ****************************************/
+template <typename T>
+size_t chunk_size(size_t num, size_t numThreads)
+{
+   const size_t cacheBytes = 256 * 1024;
+   const size_t minBytes   = 16 * 1024;
+   size_t most  = cacheBytes / sizeof(T) ? cacheBytes / sizeof(T) : 1;
+   size_t least = minBytes   / sizeof(T) ? minBytes   / sizeof(T) : 1;
+   size_t chunk = num / (numThreads * 4);
+   if (chunk > most)
+      chunk = most;
+   if (chunk < least)
+      chunk = least;
+   return chunk;
+}
+
+/*****************************************
+ * FOR CHUNKS
+ * f(begin, end) over [0, num) one chunk at
+ * a time. The algorithms below are all built
+ * on this. An Executor is anything with
+ * run(numTasks, f) and size().
+ ****************************************/
+template <typename T, class Executor, class F>
+void for_chunks(Executor & ex, size_t num, F f)
+{
+   size_t chunk = chunk_size<T>(num, ex.size());
+   size_t numChunks = (num + chunk - 1) / chunk;
+   ex.run(numChunks, [&](size_t c)
+   {
+      size_t begin = c * chunk;
+      f(begin, std::min(begin + chunk, num));
+   });
+}
+
+/*****************************************
+ * FOR EACH
+ ****************************************/
+template <typename T, class F, class Executor = thread_pool>
+void for_each(span<T> s, F f, Executor & ex = Executor::instance())
+{
+   for_chunks<T>(ex, s.size(), [&](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; i++)
+         f(s[i]);
+   });
+}
+
+template <typename T, class F, class Executor = thread_pool>
+void for_each(vector<T> & v, F f, Executor & ex = Executor::instance())
+{
+   for_each(v.slice(0, v.size()), f, ex);
+}
+
+/*****************************************
+ * TRANSFORM
+ * out has to be as big as in. out may be in.
+ ****************************************/
+template <typename T, typename U, class F, class Executor = thread_pool>
+void transform(span<T> in, span<U> out, F f, Executor & ex = Executor::instance())
+{
+   assert(out.size() >= in.size());
+   for_chunks<T>(ex, in.size(), [&](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; i++)
+         out[i] = f(in[i]);
+   });
+}
+
+// out is resized to fit
+template <typename T, typename U, class F, class Executor = thread_pool>
+void transform(const vector<T> & in, vector<U> & out, F f,
+               Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), U());
+   transform(in.slice(0, in.size()), out.slice(0, out.size()), f, ex);
+}
+
+/*****************************************
+ * TRANSFORM REDUCE
+ * init op t(s[0]) op t(s[1]) op ..., with
+ * each chunk summed on its own first
+ ****************************************/
+template <typename T, typename U, class Op, class Transform, class Executor = thread_pool>
+U transform_reduce(span<T> s, U init, Op op, Transform t,
+                   Executor & ex = Executor::instance())
+{
+   size_t chunk = chunk_size<T>(s.size(), ex.size());
+   size_t numChunks = (s.size() + chunk - 1) / chunk;
+
+   std::vector<U> partial(numChunks, init);
+   ex.run(numChunks, [&](size_t c)
+   {
+      size_t begin = c * chunk;
+      size_t end   = std::min(begin + chunk, s.size());
+      U total = t(s[begin]);
+      for (size_t i = begin + 1; i < end; i++)
+         total = op(total, t(s[i]));
+      partial[c] = total;
+   });
+
+   U total = init;
+   for (size_t c = 0; c < numChunks; c++)
+      total = op(total, partial[c]);
+   return total;
+}
+
+template <typename T, typename U, class Op, class Transform, class Executor = thread_pool>
+U transform_reduce(const vector<T> & v, U init, Op op, Transform t,
+                   Executor & ex = Executor::instance())
+{
+   return transform_reduce(v.slice(0, v.size()), init, op, t, ex);
+}
+
+/*****************************************
+ * REDUCE
+ ****************************************/
+template <typename T, typename U, class Op, class Executor = thread_pool>
+U reduce(span<T> s, U init, Op op, Executor & ex = Executor::instance())
+{
+   return transform_reduce(s, init, op, [](const T & t) -> const T & { return t; }, ex);
+}
+
+template <typename T, typename U>
+U reduce(span<T> s, U init)
+{
+   return reduce(s, init, std::plus<U>());
+}
+
+template <typename T, typename U, class Op, class Executor = thread_pool>
+U reduce(const vector<T> & v, U init, Op op, Executor & ex = Executor::instance())
+{
+   return reduce(v.slice(0, v.size()), init, op, ex);
+}
+
+template <typename T, typename U>
+U reduce(const vector<T> & v, U init)
+{
+   return reduce(v.slice(0, v.size()), init, std::plus<U>());
+}
+
+/*****************************************
+ * FILL
+ ****************************************/
+template <typename T, class Executor = thread_pool>
+void fill(span<T> s, const T & value, Executor & ex = Executor::instance())
+{
+   for_chunks<T>(ex, s.size(), [&](size_t begin, size_t end)
+   {
+      std::fill(s.data() + begin, s.data() + end, value);
+   });
+}
+
+template <typename T, class Executor = thread_pool>
+void fill(vector<T> & v, const T & value, Executor & ex = Executor::instance())
+{
+   fill(v.slice(0, v.size()), value, ex);
+}
+
+/*****************************************
+ * COPY
+ * std::copy turns each chunk into a memmove
+ * when T is trivially copyable
+ ****************************************/
+template <typename T, typename U, class Executor = thread_pool>
+void copy(span<T> in, span<U> out, Executor & ex = Executor::instance())
+{
+   assert(out.size() >= in.size());
+   for_chunks<T>(ex, in.size(), [&](size_t begin, size_t end)
+   {
+      std::copy(in.data() + begin, in.data() + end, out.data() + begin);
+   });
+}
+
+// out is resized to fit
+template <typename T, class Executor = thread_pool>
+void copy(const vector<T> & in, vector<T> & out, Executor & ex = Executor::instance())
+{
+   if (&in == &out)
+      return;
+   out.resize(in.size(), T());
+   copy(in.slice(0, in.size()), out.slice(0, out.size()), ex);
+}
+
+} // namespace parallel
+} // namespace custom
@@ -0,0 +1,560 @@
+/***********************************************************************
+ * Header:
+ *    PIPELINE
+ * Summary:
+ *    Lazy chains of filter, transform, take, drop, chunk and zip over a
+ *    vector or a span, written left to right with |:
+ *
+ *       custom::vector<int> big = from(v) | filter(isBig)
+ *                                         | transform(twice)
+ *                                         | take(10)
+ *                                         | to_vector();
+ *
+ *    Nothing runs until the sink at the end. Each stage only describes
+ *    what it does, and the sink walks the source once, handing every
+ *    element down the chain to the next stage as it goes, so no stage
+ *    ever builds a vector of its own. The sink reserves room for as many
+ *    elements as the chain can give before it starts.
+ *
+ *    parallel_to_vector() cuts the source into blocks and runs the chain
+ *    on every block at once on the thread_pool, then puts the blocks'
+ *    results together in order. That is only possible when each element
+ *    is kept or dropped without knowing where it is, so a chain with
+ *    take, drop, chunk or a zip stage runs on one thread instead.
+ *
+ *    A chain only points at its vectors, so they have to outlive it.
+ *    The span a chunk hands on is good until the next chunk.
+ *
+ *    This will contain the class definition of:
+ *        pipeline::from         : The start of a chain over one vector
+ *        pipeline::zip          : Over two side by side, or as a stage
+ *        pipeline::filter       : Only the elements pred() is true of
+ *        pipeline::transform    : f() of every element
+ *        pipeline::take         : The first n elements
+ *        pipeline::drop         : All but the first n elements
+ *        pipeline::chunk        : The elements n at a time, as spans
+ *        pipeline::to_vector    : A sink that makes a vector
+ *        pipeline::into         : A sink that appends to a vector
+ *        pipeline::parallel_to_vector : to_vector() on every thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <cstddef>      // for size_t
+#include <type_traits>  // for std::decay
+#include <utility>      // for std::pair
+#include <vector>       // for the chunks and the blocks
+
+#include "parallel.h"   // for thread_pool and chunk_size
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+namespace pipeline
+{
+
+/*****************************************
+ * RANGE
+ * The base of every chain. R is the chain
+ * itself. Each one has:
+ *    value_type     what it hands on
+ *    each(sink)     sink(element) for every
+ *                   element until sink says
+ *                   false. False if it did.
+ *    size_hint()    the most it can hand on
+ *    splittable     whether split(begin, end)
+ *                   gives the same chain over
+ *                   part of the source
+ ****************************************/
+template <class R>
+struct range
+{
+   const R & self() const { return static_cast<const R &>(*this); }
+};
+
+/*****************************************
+ * STAGE
+ * The base of whatever may follow a |. S
+ * makes a new range, or a sink's answer, from
+ * the range before it with apply().
+ ****************************************/
+template <class S>
+struct stage
+{
+   const S & self() const { return static_cast<const S &>(*this); }
+};
+
+/*****************************************
+ * SOURCE
+ * Every element of a span, in order
+ ****************************************/
+template <typename T>
+struct source : range<source<T>>
+{
+   typedef typename std::remove_const<T>::type value_type;
+   static const bool splittable = true;
+
+   source(span<T> s) : s(s) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      for (size_t i = 0; i < s.size(); i++)
+         if (!sink(s[i]))
+            return false;
+      return true;
+   }
+
+   size_t size_hint()   const { return s.size(); }
+   size_t source_size() const { return s.size(); }
+   source split(size_t begin, size_t end) const { return source(s.subspan(begin, end - begin)); }
+
+   span<T> s;
+};
+
+/*****************************************
+ * ZIP SOURCE
+ * Pairs of elements with the same index in
+ * two spans, as far as the shorter goes
+ ****************************************/
+template <typename T, typename U>
+struct zip_source : range<zip_source<T, U>>
+{
+   typedef std::pair<typename std::remove_const<T>::type,
+                     typename std::remove_const<U>::type> value_type;
+   static const bool splittable = true;
+
+   zip_source(span<T> a, span<U> b) : a(a), b(b) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      for (size_t i = 0; i < source_size(); i++)
+         if (!sink(value_type(a[i], b[i])))
+            return false;
+      return true;
+   }
+
+   size_t size_hint()   const { return source_size(); }
+   size_t source_size() const { return std::min(a.size(), b.size()); }
+   zip_source split(size_t begin, size_t end) const
+   {
+      return zip_source(a.subspan(begin, end - begin), b.subspan(begin, end - begin));
+   }
+
+   span<T> a;
+   span<U> b;
+};
+
+/*****************************************
+ * FILTER RANGE
+ ****************************************/
+template <class R, class Pred>
+struct filter_range : range<filter_range<R, Pred>>
+{
+   typedef typename R::value_type value_type;
+   static const bool splittable = R::splittable;
+
+   filter_range(const R & r, Pred pred) : r(r), pred(pred) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      Pred p = pred;
+      auto keep = [&](auto && x) { return !p(x) || sink(x); };
+      return r.each(keep);
+   }
+
+   size_t size_hint()   const { return r.size_hint(); }
+   size_t source_size() const { return r.source_size(); }
+   filter_range split(size_t begin, size_t end) const
+   {
+      return filter_range(r.split(begin, end), pred);
+   }
+
+   R    r;
+   Pred pred;
+};
+
+/*****************************************
+ * TRANSFORM RANGE
+ * f() is called exactly once per element
+ ****************************************/
+template <class R, class F>
+struct transform_range : range<transform_range<R, F>>
+{
+   typedef typename std::decay<decltype(std::declval<F &>()(
+      std::declval<const typename R::value_type &>()))>::type value_type;
+   static const bool splittable = R::splittable;
+
+   transform_range(const R & r, F f) : r(r), f(f) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      F fn = f;
+      auto apply = [&](auto && x) { return sink(fn(x)); };
+      return r.each(apply);
+   }
+
+   size_t size_hint()   const { return r.size_hint(); }
+   size_t source_size() const { return r.source_size(); }
+   transform_range split(size_t begin, size_t end) const
+   {
+      return transform_range(r.split(begin, end), f);
+   }
+
+   R r;
+   F f;
+};
+
+/*****************************************
+ * TAKE RANGE
+ * Stops the source once n are through
+ ****************************************/
+template <class R>
+struct take_range : range<take_range<R>>
+{
+   typedef typename R::value_type value_type;
+   static const bool splittable = false;
+
+   take_range(const R & r, size_t num) : r(r), num(num) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      size_t left = num;
+      if (left == 0)
+         return true;
+      bool stopped = false;
+      auto first = [&](auto && x)
+      {
+         stopped = !sink(x);
+         return !stopped && --left > 0;
+      };
+      r.each(first);
+      return !stopped;
+   }
+
+   size_t size_hint() const { return std::min(num, r.size_hint()); }
+
+   R      r;
+   size_t num;
+};
+
+/*****************************************
+ * DROP RANGE
+ ****************************************/
+template <class R>
+struct drop_range : range<drop_range<R>>
+{
+   typedef typename R::value_type value_type;
+   static const bool splittable = false;
+
+   drop_range(const R & r, size_t num) : r(r), num(num) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      size_t skip = num;
+      auto rest = [&](auto && x)
+      {
+         if (skip == 0)
+            return sink(x);
+         skip--;
+         return true;
+      };
+      return r.each(rest);
+   }
+
+   size_t size_hint() const { size_t n = r.size_hint(); return n > num ? n - num : 0; }
+
+   R      r;
+   size_t num;
+};
+
+/*****************************************
+ * CHUNK RANGE
+ * n elements at a time, and what is left at
+ * the end. The elements are copied into one
+ * buffer that every chunk reuses.
+ ****************************************/
+template <class R>
+struct chunk_range : range<chunk_range<R>>
+{
+   typedef typename R::value_type  element_type;
+   typedef span<const element_type> value_type;
+   static const bool splittable = false;
+
+   chunk_range(const R & r, size_t num) : r(r), num(num ? num : 1) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      std::vector<element_type> buffer;
+      buffer.reserve(std::min(num, r.size_hint()));
+      bool stopped = false;
+      auto gather = [&](auto && x)
+      {
+         buffer.push_back(x);
+         if (buffer.size() < num)
+            return true;
+         stopped = !sink(value_type(buffer.data(), buffer.size()));
+         buffer.clear();
+         return !stopped;
+      };
+      r.each(gather);
+      if (!stopped && !buffer.empty())
+         stopped = !sink(value_type(buffer.data(), buffer.size()));
+      return !stopped;
+   }
+
+   size_t size_hint() const { return (r.size_hint() + num - 1) / num; }
+
+   R      r;
+   size_t num;
+};
+
+/*****************************************
+ * ZIP RANGE
+ * The k-th element of the chain paired with
+ * other[k], until other runs out
+ ****************************************/
+template <class R, typename U>
+struct zip_range : range<zip_range<R, U>>
+{
+   typedef std::pair<typename R::value_type, typename std::remove_const<U>::type> value_type;
+   static const bool splittable = false;
+
+   zip_range(const R & r, span<U> other) : r(r), other(other) { }
+
+   template <class Sink>
+   bool each(Sink & sink) const
+   {
+      size_t k = 0;
+      bool stopped = false;
+      auto match = [&](auto && x)
+      {
+         if (k == other.size())
+            return false;
+         stopped = !sink(value_type(x, other[k++]));
+         return !stopped;
+      };
+      r.each(match);
+      return !stopped;
+   }
+
+   size_t size_hint() const { return std::min(r.size_hint(), other.size()); }
+
+   R       r;
+   span<U> other;
+};
+
+/*****************************************
+ * FROM, ZIP
+ * The start of a chain
+ ****************************************/
+template <typename T>
+source<T> from(span<T> s) { return source<T>(s); }
+template <typename T>
+source<const T> from(const vector<T> & v) { return source<const T>(v.slice(0, v.size())); }
+
+template <typename T, typename U>
+zip_source<T, U> zip(span<T> a, span<U> b) { return zip_source<T, U>(a, b); }
+template <typename T, typename U>
+zip_source<const T, const U> zip(const vector<T> & a, const vector<U> & b)
+{
+   return zip_source<const T, const U>(a.slice(0, a.size()), b.slice(0, b.size()));
+}
+
+/*****************************************
+ * THE STAGES
+ ****************************************/
+template <class Pred>
+struct filter_stage : stage<filter_stage<Pred>>
+{
+   filter_stage(Pred pred) : pred(pred) { }
+   template <class R>
+   filter_range<R, Pred> apply(const R & r) const { return filter_range<R, Pred>(r, pred); }
+   Pred pred;
+};
+
+template <class F>
+struct transform_stage : stage<transform_stage<F>>
+{
+   transform_stage(F f) : f(f) { }
+   template <class R>
+   transform_range<R, F> apply(const R & r) const { return transform_range<R, F>(r, f); }
+   F f;
+};
+
+// take, drop and chunk differ only in the range they make
+template <template <class> class Range>
+struct count_stage : stage<count_stage<Range>>
+{
+   count_stage(size_t num) : num(num) { }
+   template <class R>
+   Range<R> apply(const R & r) const { return Range<R>(r, num); }
+   size_t num;
+};
+
+template <typename U>
+struct zip_stage : stage<zip_stage<U>>
+{
+   zip_stage(span<U> other) : other(other) { }
+   template <class R>
+   zip_range<R, U> apply(const R & r) const { return zip_range<R, U>(r, other); }
+   span<U> other;
+};
+
+template <class Pred>
+filter_stage<Pred> filter(Pred pred) { return filter_stage<Pred>(pred); }
+
+template <class F>
+transform_stage<F> transform(F f) { return transform_stage<F>(f); }
+
+inline count_stage<take_range>  take(size_t num)  { return count_stage<take_range>(num);  }
+inline count_stage<drop_range>  drop(size_t num)  { return count_stage<drop_range>(num);  }
+inline count_stage<chunk_range> chunk(size_t num) { return count_stage<chunk_range>(num); }
+
+template <typename U>
+zip_stage<U> zip(span<U> other) { return zip_stage<U>(other); }
+template <typename U>
+zip_stage<const U> zip(const vector<U> & other) { return zip_stage<const U>(other.slice(0, other.size())); }
+
+/*****************************************
+ * THE SINKS
+ ****************************************/
+struct to_vector_stage : stage<to_vector_stage>
+{
+   template <class R>
+   vector<typename R::value_type> apply(const R & r) const
+   {
+      vector<typename R::value_type> out;
+      out.reserve(r.size_hint());
+      auto push = [&](auto && x) { out.push_back(x); return true; };
+      r.each(push);
+      return out;
+   }
+};
+
+template <typename T>
+struct into_stage : stage<into_stage<T>>
+{
+   into_stage(vector<T> & out) : out(&out) { }
+   template <class R>
+   vector<T> & apply(const R & r) const
+   {
+      vector<T> & v = *out;
+      v.reserve(v.size() + r.size_hint());
+      auto push = [&](auto && x) { v.push_back(x); return true; };
+      r.each(push);
+      return v;
+   }
+   vector<T> * out;
+};
+
+inline to_vector_stage to_vector() { return to_vector_stage(); }
+
+// appends to out and gives it back
+template <typename T>
+into_stage<T> into(vector<T> & out) { return into_stage<T>(out); }
+
+/*****************************************
+ * PARALLEL TO VECTOR
+ *   1. every block of the source runs the
+ *      chain into a buffer of its own
+ *   2. from the buffers' sizes, where each
+ *      block's elements go
+ *   3. every block moves its buffer there
+ ****************************************/
+template <class Executor>
+struct parallel_to_vector_stage : stage<parallel_to_vector_stage<Executor>>
+{
+   parallel_to_vector_stage(Executor & ex) : ex(&ex) { }
+
+   template <class R>
+   vector<typename R::value_type> apply(const R & r) const
+   {
+      return run(r, std::integral_constant<bool, R::splittable>());
+   }
+
+   // a chain that cannot be split
+   template <class R>
+   vector<typename R::value_type> run(const R & r, std::false_type) const
+   {
+      return to_vector_stage().apply(r);
+   }
+
+   template <class R>
+   vector<typename R::value_type> run(const R & r, std::true_type) const
+   {
+      typedef typename R::value_type V;
+      const size_t num   = r.source_size();
+      const size_t block = parallel::chunk_size<V>(num, ex->size());
+      const size_t numBlocks = (num + block - 1) / block;
+      if (numBlocks <= 1)
+         return to_vector_stage().apply(r);
+
+      // 1. each block on its own
+      std::vector<std::vector<V>> results(numBlocks);
+      ex->run(numBlocks, [&](size_t b)
+      {
+         R part = r.split(b * block, std::min((b + 1) * block, num));
+         std::vector<V> & result = results[b];
+         result.reserve(part.size_hint());
+         auto push = [&](auto && x) { result.push_back(x); return true; };
+         part.each(push);
+      });
+
+      // 2. where each block starts
+      std::vector<size_t> start(numBlocks + 1, 0);
+      for (size_t b = 0; b < numBlocks; b++)
+         start[b + 1] = start[b] + results[b].size();
+
+      // 3. every block into place
+      vector<V> out(start[numBlocks], V());
+      V * p = out.slice(0, out.size()).data();
+      ex->run(numBlocks, [&](size_t b)
+      {
+         std::move(results[b].begin(), results[b].end(), p + start[b]);
+      });
+      return out;
+   }
+
+   Executor * ex;
+};
+
+template <class Executor = thread_pool>
+parallel_to_vector_stage<Executor> parallel_to_vector(Executor & ex = Executor::instance())
+{
+   return parallel_to_vector_stage<Executor>(ex);
+}
+
+/*****************************************
+ * PIPE
+ * range | stage, or vector | stage to start
+ * a chain from a vector
+ ****************************************/
+template <class R, class S>
+auto operator | (const range<R> & r, const stage<S> & s) -> decltype(s.self().apply(r.self()))
+{
+   return s.self().apply(r.self());
+}
+
+template <typename T, class S>
+auto operator | (const vector<T> & v, const stage<S> & s) -> decltype(s.self().apply(from(v)))
+{
+   return s.self().apply(from(v));
+}
+
+} // namespace pipeline
+
+// v | filter(pred) looks for operator | in custom, where vector is
+using pipeline::operator |;
+
+} // namespace custom
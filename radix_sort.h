@@ -0,0 +1,344 @@
+/***********************************************************************
+ * Header:
+ *    RADIX SORT
+ * Summary:
+ *    Sorts that never compare two elements. Each key is turned into an
+ *    unsigned integer that orders the same way, and the elements are
+ *    dealt into 256 buckets a byte at a time.
+ *
+ *    radix_sort() is a least-significant-digit sort. It counts every
+ *    byte of every key in one pass up front, and a byte that is the
+ *    same in every key, such as the top bytes of small IDs, is skipped
+ *    without moving anything. Each pass that remains is stable and
+ *    moves every element once between the vector and a buffer. The
+ *    count and the move are split into one block per thread, each with
+ *    its own histogram, so no two threads ever write the same counter.
+ *
+ *    radix_sort_in_place() is an American flag sort: a most-significant-
+ *    digit sort that swaps each element into its bucket within the
+ *    vector, then sorts each bucket on the next byte. It needs no buffer
+ *    but is not stable, and it runs on one thread.
+ *
+ *    Keys are integers, floats or doubles. A float key sorts -0 before
+ *    +0 and puts NaNs at the ends, by their sign.
+ *
+ *    This will contain the class definition of:
+ *        radix_key              : A key as an unsigned integer, in order
+ *        radix_sort             : A stable LSD radix sort on every thread
+ *        radix_sort_in_place    : An in-place MSD radix sort
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t and uint64_t
+#include <cstring>      // for memcpy
+#include <type_traits>  // for std::make_unsigned
+#include <utility>      // for std::move and std::swap
+#include <vector>       // for the histograms
+
+#include "parallel.h"   // for thread_pool
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * RADIX KEY
+ * encode(k) is an unsigned integer that is
+ * less than encode(j) exactly when k < j
+ ****************************************/
+template <typename K, class Enable = void>
+struct radix_key;
+
+// an unsigned integer is its own key, and a signed one flips its sign bit
+template <typename K>
+struct radix_key <K, typename std::enable_if<std::is_integral<K>::value>::type>
+{
+   typedef typename std::make_unsigned<K>::type type;
+   static type encode(K k)
+   {
+      const type sign = std::is_signed<K>::value ? type(type(1) << (sizeof(K) * 8 - 1)) : type(0);
+      return type(type(k) ^ sign);
+   }
+};
+
+// a positive float flips its sign bit, and a negative one flips every bit
+template <>
+struct radix_key <float>
+{
+   typedef uint32_t type;
+   static type encode(float k)
+   {
+      uint32_t bits;
+      memcpy(&bits, &k, sizeof(bits));
+      return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+   }
+};
+
+template <>
+struct radix_key <double>
+{
+   typedef uint64_t type;
+   static type encode(double k)
+   {
+      uint64_t bits;
+      memcpy(&bits, &k, sizeof(bits));
+      return (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+   }
+};
+
+namespace radix_detail
+{
+
+// sort on the element itself
+struct identity
+{
+   template <typename T>
+   const T & operator () (const T & t) const { return t; }
+};
+
+// below this many elements one thread does the whole sort
+const size_t parallelCutoff = 1 << 16;
+
+// below this many elements the in-place sort uses an insertion sort
+const size_t insertionCutoff = 32;
+
+/*****************************************
+ * KEY OF
+ * The encoded key of an element
+ ****************************************/
+template <typename T, class KeyFn>
+struct key_of
+{
+   typedef typename std::decay<decltype(std::declval<KeyFn &>()(std::declval<const T &>()))>::type key_type;
+   typedef radix_key<key_type>     traits;
+   typedef typename traits::type   type;
+
+   static type get(const T & t, KeyFn & key) { return traits::encode(key(t)); }
+   static size_t digit(const T & t, KeyFn & key, size_t d)
+   {
+      return size_t((get(t, key) >> (8 * d)) & 0xFF);
+   }
+};
+
+/*****************************************
+ * LSD SORT
+ *   1. every block counts every digit of
+ *      its keys
+ *   2. a digit with all its keys in one
+ *      bucket is skipped
+ *   3. otherwise, each bucket's share of each
+ *      block gives where that block writes,
+ *      and the blocks move their elements
+ *   4. after an odd number of passes the
+ *      elements are in the buffer, so they
+ *      move back
+ * Returns the number of passes made.
+ ****************************************/
+template <typename T, class KeyFn, class Executor>
+size_t lsdSort(T * p, size_t n, KeyFn & key, Executor & ex)
+{
+   typedef key_of<T, KeyFn> k;
+   const size_t numDigits = sizeof(typename k::type);
+   if (n < 2)
+      return 0;
+
+   const size_t numBlocks = n < parallelCutoff ? 1 : ex.size();
+   const size_t blockSize = (n + numBlocks - 1) / numBlocks;
+   auto blockBegin = [&](size_t block) { return std::min(block * blockSize, n);       };
+   auto blockEnd   = [&](size_t block) { return std::min((block + 1) * blockSize, n); };
+
+   // 1. histograms of every digit, per block, in one pass
+   std::vector<size_t> counts(numBlocks * numDigits * 256, 0);
+   ex.run(numBlocks, [&](size_t block)
+   {
+      size_t * count = &counts[block * numDigits * 256];
+      for (size_t i = blockBegin(block); i < blockEnd(block); i++)
+      {
+         typename k::type bits = k::get(p[i], key);
+         for (size_t d = 0; d < numDigits; d++)
+            count[d * 256 + ((bits >> (8 * d)) & 0xFF)]++;
+      }
+   });
+
+   vector<T> buffer;
+   T * from = p;
+   T * to   = nullptr;
+   size_t numPasses = 0;
+   std::vector<size_t> next(numBlocks * 256);
+   for (size_t d = 0; d < numDigits; d++)
+   {
+      // 2. is this digit the same in every key?
+      size_t first = k::digit(from[0], key, d);
+      size_t total = 0;
+      for (size_t block = 0; block < numBlocks; block++)
+         total += counts[(block * numDigits + d) * 256 + first];
+      if (total == n)
+         continue;
+
+      if (to == nullptr)
+      {
+         buffer.resize(n, T());
+         to = buffer.slice(0, n).data();
+      }
+
+      // once the elements have moved, the blocks hold different ones
+      if (numPasses > 0 && numBlocks > 1)
+         ex.run(numBlocks, [&](size_t block)
+         {
+            size_t * count = &counts[(block * numDigits + d) * 256];
+            for (size_t bucket = 0; bucket < 256; bucket++)
+               count[bucket] = 0;
+            for (size_t i = blockBegin(block); i < blockEnd(block); i++)
+               count[k::digit(from[i], key, d)]++;
+         });
+
+      // 3. bucket by bucket, and block by block within a bucket
+      size_t offset = 0;
+      for (size_t bucket = 0; bucket < 256; bucket++)
+         for (size_t block = 0; block < numBlocks; block++)
+         {
+            next[block * 256 + bucket] = offset;
+            offset += counts[(block * numDigits + d) * 256 + bucket];
+         }
+      assert(offset == n);
+
+      ex.run(numBlocks, [&](size_t block)
+      {
+         size_t * nextBlock = &next[block * 256];
+         for (size_t i = blockBegin(block); i < blockEnd(block); i++)
+            to[nextBlock[k::digit(from[i], key, d)]++] = std::move(from[i]);
+      });
+      std::swap(from, to);
+      numPasses++;
+   }
+
+   // 4. back where they belong
+   if (from != p)
+      ex.run(numBlocks, [&](size_t block)
+      {
+         for (size_t i = blockBegin(block); i < blockEnd(block); i++)
+            p[i] = std::move(from[i]);
+      });
+   return numPasses;
+}
+
+/*****************************************
+ * INSERTION SORT
+ * For the small buckets of the in-place sort
+ ****************************************/
+template <typename T, class KeyFn>
+void insertionSort(T * p, size_t n, KeyFn & key)
+{
+   typedef key_of<T, KeyFn> k;
+   for (size_t i = 1; i < n; i++)
+   {
+      T t = std::move(p[i]);
+      typename k::type bits = k::get(t, key);
+      size_t j = i;
+      for (; j > 0 && bits < k::get(p[j - 1], key); j--)
+         p[j] = std::move(p[j - 1]);
+      p[j] = std::move(t);
+   }
+}
+
+/*****************************************
+ * AMERICAN FLAG SORT
+ * Count the buckets of digit d, then walk
+ * each bucket, swapping whatever is there
+ * to the next free place in its own bucket
+ * until what is there belongs. Then each
+ * bucket is sorted on the digit below.
+ ****************************************/
+template <typename T, class KeyFn>
+void americanFlag(T * p, size_t n, size_t d, KeyFn & key)
+{
+   typedef key_of<T, KeyFn> k;
+   if (n <= insertionCutoff)
+   {
+      insertionSort(p, n, key);
+      return;
+   }
+
+   size_t count[256] = { 0 };
+   for (size_t i = 0; i < n; i++)
+      count[k::digit(p[i], key, d)]++;
+
+   size_t next[256];
+   size_t end[256];
+   size_t offset = 0;
+   bool   constant = false;
+   for (size_t bucket = 0; bucket < 256; bucket++)
+   {
+      constant = constant || count[bucket] == n;
+      next[bucket] = offset;
+      offset += count[bucket];
+      end[bucket] = offset;
+   }
+
+   if (!constant)
+      for (size_t bucket = 0; bucket < 256; bucket++)
+         while (next[bucket] < end[bucket])
+         {
+            size_t home = k::digit(p[next[bucket]], key, d);
+            if (home == bucket)
+               next[bucket]++;
+            else
+               std::swap(p[next[bucket]], p[next[home]++]);
+         }
+
+   if (d == 0)
+      return;
+   size_t begin = 0;
+   for (size_t bucket = 0; bucket < 256; bucket++)
+   {
+      if (count[bucket] > 1)
+         americanFlag(p + begin, count[bucket], d - 1, key);
+      begin += count[bucket];
+   }
+}
+
+} // namespace radix_detail
+
+/*****************************************
+ * RADIX SORT
+ * Stable. key(element) gives the key to sort
+ * on, or the element itself if there is none.
+ ****************************************/
+template <typename T, class KeyFn = radix_detail::identity, class Executor = thread_pool>
+void radix_sort(span<T> s, KeyFn key = KeyFn(), Executor & ex = Executor::instance())
+{
+   radix_detail::lsdSort(s.data(), s.size(), key, ex);
+}
+
+template <typename T, class KeyFn = radix_detail::identity, class Executor = thread_pool>
+void radix_sort(vector<T> & v, KeyFn key = KeyFn(), Executor & ex = Executor::instance())
+{
+   radix_sort(v.slice(0, v.size()), key, ex);
+}
+
+/*****************************************
+ * RADIX SORT IN PLACE
+ * No buffer, but not stable either
+ ****************************************/
+template <typename T, class KeyFn = radix_detail::identity>
+void radix_sort_in_place(span<T> s, KeyFn key = KeyFn())
+{
+   typedef radix_detail::key_of<T, KeyFn> k;
+   if (s.size() > 1)
+      radix_detail::americanFlag(s.data(), s.size(), sizeof(typename k::type) - 1, key);
+}
+
+template <typename T, class KeyFn = radix_detail::identity>
+void radix_sort_in_place(vector<T> & v, KeyFn key = KeyFn())
+{
+   radix_sort_in_place(v.slice(0, v.size()), key);
+}
+
+} // namespace custom
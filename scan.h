@@ -0,0 +1,338 @@
+/***********************************************************************
+ * Header:
+ *    SCAN
+ * Summary:
+ *    Prefix sums over vectors of numbers, the way offsets are built from
+ *    counts: out[i] is the sum of every element before i (an exclusive
+ *    scan), or up to and including i (an inclusive scan).
+ *
+ *    On one thread, a scan is the simd kernel for this CPU. The parallel
+ *    scans make two passes over blocks of the vector. The first sums
+ *    every block at once; a scan of those sums, one per block, gives
+ *    what comes before each block; and the second pass scans every
+ *    block at once, starting from that. Each element is read twice and
+ *    written once, which is why a parallel scan only pays on more than
+ *    one core.
+ *
+ *    A segmented scan starts over wherever flags[i] is set, so one call
+ *    scans every row of a ragged array. Its first pass keeps, for each
+ *    block, the sum since its last flag and whether it has one, so a
+ *    block only carries what came before it up to its first flag.
+ *
+ *    Every scan may write over its own input, and gives back the sum of
+ *    everything plus init (for a segmented scan, of the last segment).
+ *
+ *    This will contain the class definition of:
+ *        inclusive_scan             : out[i] = in[0] + ... + in[i]
+ *        exclusive_scan             : out[i] = in[0] + ... + in[i - 1]
+ *        segmented_inclusive_scan   : inclusive_scan, restarting at flags
+ *        segmented_exclusive_scan   : exclusive_scan, restarting at flags
+ *        parallel::...              : The same on every thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <type_traits>  // for std::is_same
+#include <vector>       // for the block sums
+
+#include "parallel.h"   // for thread_pool and chunk_size
+#include "simd.h"       // for the scan kernels
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+
+// the kernels read and write the same type
+#define CUSTOM_SCAN_SAME_TYPE(T, U)                                                  \
+   static_assert(std::is_same<typename std::remove_const<T>::type, U>::value,      \
+                 "scan: in and out need the same element type");
+
+/*****************************************
+ * INCLUSIVE SCAN, EXCLUSIVE SCAN
+ * out has to be as big as in. out may be in.
+ ****************************************/
+template <typename T, typename U>
+U inclusive_scan(span<T> in, span<U> out, U init = U())
+{
+   CUSTOM_SCAN_SAME_TYPE(T, U)
+   assert(out.size() >= in.size());
+   return simd::inclusive_scan<U>(in.data(), out.data(), in.size(), init);
+}
+
+template <typename T, typename U>
+U exclusive_scan(span<T> in, span<U> out, U init = U())
+{
+   CUSTOM_SCAN_SAME_TYPE(T, U)
+   assert(out.size() >= in.size());
+   return simd::exclusive_scan<U>(in.data(), out.data(), in.size(), init);
+}
+
+// out is resized to fit
+template <typename T>
+T inclusive_scan(const vector<T> & in, vector<T> & out, T init = T())
+{
+   out.resize(in.size(), T());
+   return inclusive_scan(in.slice(0, in.size()), out.slice(0, out.size()), init);
+}
+
+template <typename T>
+T exclusive_scan(const vector<T> & in, vector<T> & out, T init = T())
+{
+   out.resize(in.size(), T());
+   return exclusive_scan(in.slice(0, in.size()), out.slice(0, out.size()), init);
+}
+
+namespace scan_detail
+{
+
+/*****************************************
+ * SEGMENTED
+ * One scan over [begin, end), starting from
+ * carry until the first flag. Exclusive or
+ * inclusive, as the tag says.
+ ****************************************/
+template <bool Exclusive, typename T, typename U, typename F>
+U segmented(const T * in, U * out, const F * flags, size_t begin, size_t end, U carry, U init)
+{
+   for (size_t i = begin; i < end; i++)
+   {
+      if (flags[i])
+         carry = init;
+      U t = in[i];
+      if (Exclusive)
+         out[i] = carry;
+      carry += t;
+      if (!Exclusive)
+         out[i] = carry;
+   }
+   return carry;
+}
+
+/*****************************************
+ * BLOCKS
+ * How the parallel scans cut [0, num)
+ ****************************************/
+template <typename T, class Executor>
+struct blocks
+{
+   blocks(size_t num, Executor & ex) : num(num), size(parallel::chunk_size<T>(num, ex.size())),
+                                       count((num + size - 1) / size) { }
+
+   size_t begin(size_t b) const { return b * size; }
+   size_t end(size_t b)   const { return std::min((b + 1) * size, num); }
+
+   size_t num;
+   size_t size;
+   size_t count;
+};
+
+/*****************************************
+ * PARALLEL SCAN
+ *   1. sum every block
+ *   2. scan the sums, for what comes before
+ *      each block
+ *   3. scan every block from there
+ ****************************************/
+template <bool Exclusive, typename T, typename U, class Executor>
+U parallelScan(span<T> in, span<U> out, U init, Executor & ex)
+{
+   CUSTOM_SCAN_SAME_TYPE(T, U)
+   assert(out.size() >= in.size());
+   blocks<U, Executor> b(in.size(), ex);
+   if (b.count <= 1)
+      return Exclusive ? exclusive_scan(in, out, init) : inclusive_scan(in, out, init);
+
+   // 1. the sum of every block
+   std::vector<U> before(b.count + 1);
+   ex.run(b.count, [&](size_t block)
+   {
+      before[block + 1] = simd::sum<U>(in.data() + b.begin(block), b.end(block) - b.begin(block));
+   });
+
+   // 2. what comes before each block
+   before[0] = init;
+   for (size_t block = 1; block <= b.count; block++)
+      before[block] += before[block - 1];
+
+   // 3. every block from where the one before it left off
+   ex.run(b.count, [&](size_t block)
+   {
+      size_t begin = b.begin(block);
+      size_t num   = b.end(block) - begin;
+      if (Exclusive)
+         simd::exclusive_scan<U>(in.data() + begin, out.data() + begin, num, before[block]);
+      else
+         simd::inclusive_scan<U>(in.data() + begin, out.data() + begin, num, before[block]);
+   });
+   return before[b.count];
+}
+
+/*****************************************
+ * PARALLEL SEGMENTED SCAN
+ *   1. every block finds the sum since its
+ *      last flag, and whether it has one
+ *   2. what each block carries in: the one
+ *      before's sum, plus what it carried in
+ *      itself unless it had a flag
+ *   3. scan every block from there
+ ****************************************/
+template <bool Exclusive, typename T, typename U, typename F, class Executor>
+U parallelSegmented(span<T> in, span<F> flags, span<U> out, U init, Executor & ex)
+{
+   assert(out.size() >= in.size());
+   assert(flags.size() >= in.size());
+   blocks<U, Executor> b(in.size(), ex);
+
+   // 1. the tail of every block, which starts from init after a flag
+   std::vector<U>    tail(b.count, U());
+   std::vector<char> flagged(b.count, 0);
+   ex.run(b.count, [&](size_t block)
+   {
+      U total = U();
+      for (size_t i = b.begin(block); i < b.end(block); i++)
+      {
+         if (flags[i])
+         {
+            total = init;
+            flagged[block] = 1;
+         }
+         total += in[i];
+      }
+      tail[block] = total;
+   });
+
+   // 2. what comes before each block
+   std::vector<U> carry(b.count + 1, init);
+   for (size_t block = 0; block < b.count; block++)
+      carry[block + 1] = flagged[block] ? tail[block] : U(carry[block] + tail[block]);
+
+   // 3. every block from where the one before it left off
+   ex.run(b.count, [&](size_t block)
+   {
+      segmented<Exclusive>(in.data(), out.data(), flags.data(),
+                           b.begin(block), b.end(block), carry[block], init);
+   });
+   return carry[b.count];
+}
+
+} // namespace scan_detail
+
+/*****************************************
+ * SEGMENTED INCLUSIVE SCAN, EXCLUSIVE SCAN
+ * A new segment starts, from init, wherever
+ * flags[i] is set
+ ****************************************/
+template <typename T, typename F, typename U>
+U segmented_inclusive_scan(span<T> in, span<F> flags, span<U> out, U init = U())
+{
+   assert(out.size() >= in.size());
+   assert(flags.size() >= in.size());
+   return scan_detail::segmented<false>(in.data(), out.data(), flags.data(), 0, in.size(), init, init);
+}
+
+template <typename T, typename F, typename U>
+U segmented_exclusive_scan(span<T> in, span<F> flags, span<U> out, U init = U())
+{
+   assert(out.size() >= in.size());
+   assert(flags.size() >= in.size());
+   return scan_detail::segmented<true>(in.data(), out.data(), flags.data(), 0, in.size(), init, init);
+}
+
+template <typename T, typename F>
+T segmented_inclusive_scan(const vector<T> & in, const vector<F> & flags, vector<T> & out,
+                           T init = T())
+{
+   out.resize(in.size(), T());
+   return segmented_inclusive_scan(in.slice(0, in.size()), flags.slice(0, flags.size()),
+                                   out.slice(0, out.size()), init);
+}
+
+template <typename T, typename F>
+T segmented_exclusive_scan(const vector<T> & in, const vector<F> & flags, vector<T> & out,
+                           T init = T())
+{
+   out.resize(in.size(), T());
+   return segmented_exclusive_scan(in.slice(0, in.size()), flags.slice(0, flags.size()),
+                                   out.slice(0, out.size()), init);
+}
+
+namespace parallel
+{
+
+/*****************************************
+ * INCLUSIVE SCAN, EXCLUSIVE SCAN
+ ****************************************/
+template <typename T, typename U, class Executor = thread_pool>
+U inclusive_scan(span<T> in, span<U> out, U init = U(), Executor & ex = Executor::instance())
+{
+   return scan_detail::parallelScan<false>(in, out, init, ex);
+}
+
+template <typename T, typename U, class Executor = thread_pool>
+U exclusive_scan(span<T> in, span<U> out, U init = U(), Executor & ex = Executor::instance())
+{
+   return scan_detail::parallelScan<true>(in, out, init, ex);
+}
+
+template <typename T, class Executor = thread_pool>
+T inclusive_scan(const vector<T> & in, vector<T> & out, T init = T(),
+                 Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), T());
+   return inclusive_scan(in.slice(0, in.size()), out.slice(0, out.size()), init, ex);
+}
+
+template <typename T, class Executor = thread_pool>
+T exclusive_scan(const vector<T> & in, vector<T> & out, T init = T(),
+                 Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), T());
+   return exclusive_scan(in.slice(0, in.size()), out.slice(0, out.size()), init, ex);
+}
+
+/*****************************************
+ * SEGMENTED INCLUSIVE SCAN, EXCLUSIVE SCAN
+ ****************************************/
+template <typename T, typename F, typename U, class Executor = thread_pool>
+U segmented_inclusive_scan(span<T> in, span<F> flags, span<U> out, U init = U(),
+                           Executor & ex = Executor::instance())
+{
+   return scan_detail::parallelSegmented<false>(in, flags, out, init, ex);
+}
+
+template <typename T, typename F, typename U, class Executor = thread_pool>
+U segmented_exclusive_scan(span<T> in, span<F> flags, span<U> out, U init = U(),
+                           Executor & ex = Executor::instance())
+{
+   return scan_detail::parallelSegmented<true>(in, flags, out, init, ex);
+}
+
+template <typename T, typename F, class Executor = thread_pool>
+T segmented_inclusive_scan(const vector<T> & in, const vector<F> & flags, vector<T> & out,
+                           T init = T(), Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), T());
+   return segmented_inclusive_scan(in.slice(0, in.size()), flags.slice(0, flags.size()),
+                                   out.slice(0, out.size()), init, ex);
+}
+
+template <typename T, typename F, class Executor = thread_pool>
+T segmented_exclusive_scan(const vector<T> & in, const vector<F> & flags, vector<T> & out,
+                           T init = T(), Executor & ex = Executor::instance())
+{
+   out.resize(in.size(), T());
+   return segmented_exclusive_scan(in.slice(0, in.size()), flags.slice(0, flags.size()),
+                                   out.slice(0, out.size()), init, ex);
+}
+
+} // namespace parallel
+
+#undef CUSTOM_SCAN_SAME_TYPE
+
+} // namespace custom
@@ -0,0 +1,551 @@
+/***********************************************************************
+ * Header:
+ *    SCHEDULER
+ * Summary:
+ *    A work-stealing task scheduler for fork/join parallelism. Every
+ *    thread has its own double-ended queue of tasks. A thread pushes
+ *    and pops its own tasks at the bottom, like a stack, so it works
+ *    on what is still hot in its cache, and a thread with nothing to
+ *    do steals from the top of someone else's, where the oldest and
+ *    so usually the biggest pieces of work are.
+ *
+ *    parallel_invoke(f, g) offers g to the thieves and runs f itself.
+ *    If no one took g in the meantime it runs g too, at the cost of a
+ *    push and a pop. parallel_for() splits a range in half, and in
+ *    half again, down to the grain, so an idle thread steals half of
+ *    whatever is left rather than one fixed chunk. That keeps every
+ *    thread busy when some elements cost far more than others, where
+ *    the chunks of thread_pool can leave one thread with all the slow
+ *    ones.
+ *
+ *    A task_scheduler can be handed to any of the parallel algorithms
+ *    in parallel.h in place of the thread_pool. Unlike the pool, a
+ *    parallel call from inside a task runs in parallel too.
+ *
+ *    This will contain the class definition of:
+ *        chase_lev_deque        : The lock-free deque each thread owns
+ *        task_scheduler         : The threads, their deques, and stealing
+ *        parallel_invoke        : Run f and g in parallel
+ *        parallel_for           : Run f on the pieces of a range
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>              // for std::atomic
+#include <cassert>             // because I am paranoid
+#include <condition_variable>  // for std::condition_variable
+#include <cstddef>             // for size_t
+#include <cstdint>             // for int64_t
+#include <exception>           // for std::exception_ptr
+#include <memory>              // for std::unique_ptr
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <vector>              // for the workers and the old rings
+
+#include "parallel.h"          // for thread_pool::default_threads
+
+namespace custom
+{
+
+/*****************************************
+ * CHASE LEV DEQUE
+ * Chase and Lev's deque, with the memory
+ * orders of Le, Pop, Cohen and Zappa Nardelli.
+ * Only the owner calls push() and pop(); any
+ * thread may call steal(). T is a pointer.
+ *
+ * The ring doubles when full. Thieves may
+ * still be reading an old ring, so the old
+ * ones are kept until the deque goes away.
+ ****************************************/
+template <typename T>
+class chase_lev_deque
+{
+public:
+   explicit chase_lev_deque(size_t capacity = 64) : top(0), bottom(0)
+   {
+      size_t cap = 1;
+      while (cap < capacity)
+         cap *= 2;
+      rings.push_back(std::unique_ptr<ring>(new ring(cap)));
+      array = rings.back().get();
+   }
+
+   // the owner adds to the bottom
+   void push(T x)
+   {
+      int64_t b = bottom.load(std::memory_order_relaxed);
+      int64_t t = top.load(std::memory_order_acquire);
+      ring * a = array.load(std::memory_order_relaxed);
+      if (b - t > int64_t(a->mask))
+         a = grow(a, t, b);
+      a->put(b, x);
+      bottom.store(b + 1, std::memory_order_release);
+   }
+
+   // the owner takes from the bottom, nullptr if empty or lost to a thief
+   T pop()
+   {
+      int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+      ring * a = array.load(std::memory_order_relaxed);
+      bottom.store(b, std::memory_order_seq_cst);
+      int64_t t = top.load(std::memory_order_seq_cst);
+
+      T x = nullptr;
+      if (t <= b)
+      {
+         x = a->get(b);
+         if (t == b)
+         {
+            // the last one: a thief may be after it too
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed))
+               x = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+         }
+      }
+      else
+         bottom.store(b + 1, std::memory_order_relaxed);
+      return x;
+   }
+
+   // anyone takes from the top, nullptr if empty or lost a race
+   T steal()
+   {
+      int64_t t = top.load(std::memory_order_seq_cst);
+      int64_t b = bottom.load(std::memory_order_seq_cst);
+      if (t >= b)
+         return nullptr;
+
+      ring * a = array.load(std::memory_order_acquire);
+      T x = a->get(t);
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+         return nullptr;
+      return x;
+   }
+
+   // a guess, as it may change as soon as it is read
+   size_t size() const
+   {
+      int64_t b = bottom.load(std::memory_order_relaxed);
+      int64_t t = top.load(std::memory_order_relaxed);
+      return b > t ? size_t(b - t) : 0;
+   }
+   size_t capacity() const { return array.load(std::memory_order_relaxed)->mask + 1; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // a power of two slots, indexed by position mod the size
+   struct ring
+   {
+      explicit ring(size_t cap) : mask(cap - 1), slots(new std::atomic<T>[cap]) { }
+      T    get(int64_t i) const { return slots[size_t(i) & mask].load(std::memory_order_relaxed); }
+      void put(int64_t i, T x)  { slots[size_t(i) & mask].store(x, std::memory_order_relaxed); }
+
+      size_t                            mask;
+      std::unique_ptr<std::atomic<T>[]> slots;
+   };
+
+   ring * grow(ring * a, int64_t t, int64_t b)
+   {
+      ring * aNew = new ring(2 * (a->mask + 1));
+      rings.push_back(std::unique_ptr<ring>(aNew));
+      for (int64_t i = t; i < b; i++)
+         aNew->put(i, a->get(i));
+      array.store(aNew, std::memory_order_release);
+      return aNew;
+   }
+
+   std::atomic<int64_t>               top;      // the next to steal
+   std::atomic<int64_t>               bottom;   // one past the next to pop
+   std::atomic<ring *>                array;    // the current ring
+   std::vector<std::unique_ptr<ring>> rings;    // every ring, old and current
+};
+
+/*****************************************
+ * TASK SCHEDULER
+ * size() - 1 workers, plus slot 0 for the
+ * thread that calls from outside. Outside
+ * callers take turns with slot 0.
+ ****************************************/
+class task_scheduler
+{
+public:
+   //
+   // Construct
+   //
+
+   // numThreads counts the thread that calls in
+   explicit task_scheduler(size_t numThreads = thread_pool::default_threads());
+   ~task_scheduler();
+   task_scheduler(const task_scheduler &) = delete;
+   task_scheduler & operator = (const task_scheduler &) = delete;
+
+   static task_scheduler & instance()
+   {
+      static task_scheduler scheduler;
+      return scheduler;
+   }
+
+   //
+   // Fork and join
+   //
+
+   // f() and g() in parallel, rethrowing f's exception, else g's
+   template <class F, class G>
+   void invoke(F f, G g);
+
+   // f(begin, end) on pieces of [begin, end) no bigger than grain
+   template <class F>
+   void for_range(size_t begin, size_t end, size_t grain, F f);
+
+   // f(task) for every task: what the parallel algorithms call
+   template <class F>
+   void run(size_t num, F f)
+   {
+      for_range(0, num, 1, [&](size_t begin, size_t end)
+      {
+         for (size_t task = begin; task < end; task++)
+            f(task);
+      });
+   }
+
+   //
+   // Status
+   //
+
+   size_t size() const { return slots.size(); }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   // a piece of work on a deque, which lives on the stack of invoke()
+   struct task
+   {
+      task() : done(false) { }
+      virtual ~task() { }
+      virtual void execute() = 0;
+      void run()
+      {
+         try
+         {
+            execute();
+         }
+         catch (...)
+         {
+            error = std::current_exception();
+         }
+         done.store(true, std::memory_order_release);
+      }
+
+      std::atomic<bool>  done;
+      std::exception_ptr error;
+   };
+
+   template <class F>
+   struct function_task : public task
+   {
+      explicit function_task(F & f) : f(f) { }
+      void execute() { f(); }
+      F & f;
+   };
+
+   // which scheduler and slot this thread is working for
+   struct context
+   {
+      task_scheduler * scheduler;
+      size_t           slot;
+   };
+   static context & current()
+   {
+      static thread_local context c = { nullptr, 0 };
+      return c;
+   }
+
+   struct worker
+   {
+      chase_lev_deque<task *> tasks;
+      uint32_t                seed;   // for picking a victim
+   };
+
+   template <class F, class G>
+   void invokeHere(size_t slot, F & f, G & g);
+   void   workerLoop(size_t slot);
+   task * find(size_t slot);
+   bool   anyWork() const;
+   void   wakeOne();
+
+   std::vector<std::unique_ptr<worker>> slots;
+   std::vector<std::thread>             threads;
+   std::mutex                           outside;      // slot 0, one caller at a time
+   std::atomic<bool>                    stopping;
+   std::atomic<size_t>                  numSleeping;
+   std::mutex                           sleepLock;
+   std::condition_variable              sleepWake;
+};
+
+/*****************************************
+ * TASK SCHEDULER :: CONSTRUCTOR
+ ****************************************/
+inline task_scheduler :: task_scheduler(size_t numThreads) :
+   stopping(false), numSleeping(0)
+{
+   if (numThreads == 0)
+      numThreads = 1;
+   for (size_t slot = 0; slot < numThreads; slot++)
+   {
+      slots.push_back(std::unique_ptr<worker>(new worker));
+      slots.back()->seed = uint32_t(slot * 2654435761u + 1);
+   }
+   for (size_t slot = 1; slot < numThreads; slot++)
+      threads.push_back(std::thread(&task_scheduler::workerLoop, this, slot));
+}
+
+/*****************************************
+ * TASK SCHEDULER :: DESTRUCTOR
+ ****************************************/
+inline task_scheduler :: ~task_scheduler()
+{
+   stopping = true;
+   {
+      std::lock_guard<std::mutex> guard(sleepLock);
+      sleepWake.notify_all();
+   }
+   for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+}
+
+/*****************************************
+ * TASK SCHEDULER :: INVOKE
+ * A thread already working for us uses its
+ * own slot. Anyone else waits for slot 0.
+ ****************************************/
+template <class F, class G>
+void task_scheduler :: invoke(F f, G g)
+{
+   if (size() == 1)
+   {
+      f();
+      g();
+      return;
+   }
+
+   context & c = current();
+   if (c.scheduler == this)
+   {
+      invokeHere(c.slot, f, g);
+      return;
+   }
+
+   std::lock_guard<std::mutex> guard(outside);
+   context saved = c;
+   c.scheduler = this;
+   c.slot = 0;
+   try
+   {
+      invokeHere(0, f, g);
+   }
+   catch (...)
+   {
+      c = saved;
+      throw;
+   }
+   c = saved;
+}
+
+/*****************************************
+ * TASK SCHEDULER :: INVOKE HERE
+ * Offer g, run f, then take g back. If a
+ * thief has g, steal other work until it is
+ * done: our own deque is empty by then, as
+ * thieves take the oldest tasks first.
+ ****************************************/
+template <class F, class G>
+void task_scheduler :: invokeHere(size_t slot, F & f, G & g)
+{
+   function_task<G> taskG(g);
+   chase_lev_deque<task *> & tasks = slots[slot]->tasks;
+   tasks.push(&taskG);
+   wakeOne();
+
+   std::exception_ptr errorF;
+   try
+   {
+      f();
+   }
+   catch (...)
+   {
+      errorF = std::current_exception();
+   }
+
+   task * t = tasks.pop();
+   if (t != nullptr)
+   {
+      assert(t == &taskG);
+      taskG.run();
+   }
+   else
+      while (!taskG.done.load(std::memory_order_acquire))
+      {
+         task * other = find(slot);
+         if (other != nullptr)
+            other->run();
+         else
+            std::this_thread::yield();
+      }
+
+   if (errorF)
+      std::rethrow_exception(errorF);
+   if (taskG.error)
+      std::rethrow_exception(taskG.error);
+}
+
+/*****************************************
+ * TASK SCHEDULER :: FOR RANGE
+ * Halve the range until it is no bigger
+ * than grain
+ ****************************************/
+template <class F>
+void task_scheduler :: for_range(size_t begin, size_t end, size_t grain, F f)
+{
+   if (begin >= end)
+      return;
+   if (end - begin <= (grain ? grain : 1))
+   {
+      f(begin, end);
+      return;
+   }
+   size_t middle = begin + (end - begin) / 2;
+   invoke([&] { for_range(begin, middle, grain, f); },
+          [&] { for_range(middle, end,   grain, f); });
+}
+
+/*****************************************
+ * TASK SCHEDULER :: FIND
+ * Our own newest task, else the oldest task
+ * of someone else, starting from a random
+ * victim so the thieves spread out
+ ****************************************/
+inline task_scheduler::task * task_scheduler :: find(size_t slot)
+{
+   task * t = slots[slot]->tasks.pop();
+   if (t != nullptr)
+      return t;
+
+   uint32_t & seed = slots[slot]->seed;
+   seed ^= seed << 13;
+   seed ^= seed >> 17;
+   seed ^= seed << 5;
+   size_t start = seed % slots.size();
+   for (size_t i = 0; i < slots.size(); i++)
+   {
+      size_t victim = (start + i) % slots.size();
+      if (victim == slot)
+         continue;
+      t = slots[victim]->tasks.steal();
+      if (t != nullptr)
+         return t;
+   }
+   return nullptr;
+}
+
+/*****************************************
+ * TASK SCHEDULER :: ANY WORK
+ * Is there a task in any deque? The fence
+ * pairs with the one in wakeOne().
+ ****************************************/
+inline bool task_scheduler :: anyWork() const
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   for (size_t slot = 0; slot < slots.size(); slot++)
+      if (slots[slot]->tasks.size() > 0)
+         return true;
+   return false;
+}
+
+/*****************************************
+ * TASK SCHEDULER :: WAKE ONE
+ * There is a new task. Wake a sleeper to
+ * steal it, if there is one. The task was
+ * pushed before the fence and a sleeper
+ * counts itself before its own, so either we
+ * see the sleeper or it sees the task.
+ ****************************************/
+inline void task_scheduler :: wakeOne()
+{
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (numSleeping.load(std::memory_order_relaxed) > 0)
+   {
+      std::lock_guard<std::mutex> guard(sleepLock);
+      sleepWake.notify_one();
+   }
+}
+
+/*****************************************
+ * TASK SCHEDULER :: WORKER LOOP
+ * Look for work, yield when there is none,
+ * and after a while sleep. Before sleeping,
+ * look once more with sleepLock held: a task
+ * pushed after that look finds us counted in
+ * numSleeping, and its notify waits for the
+ * lock until we are in wait().
+ ****************************************/
+inline void task_scheduler :: workerLoop(size_t slot)
+{
+   current().scheduler = this;
+   current().slot = slot;
+
+   size_t numMisses = 0;
+   while (!stopping.load(std::memory_order_relaxed))
+   {
+      task * t = find(slot);
+      if (t != nullptr)
+      {
+         t->run();
+         numMisses = 0;
+      }
+      else if (++numMisses < 64)
+         std::this_thread::yield();
+      else
+      {
+         std::unique_lock<std::mutex> guard(sleepLock);
+         numSleeping++;
+         if (!stopping && !anyWork())
+            sleepWake.wait(guard);
+         numSleeping--;
+         numMisses = 0;
+      }
+   }
+}
+
+/*****************************************
+ * PARALLEL INVOKE
+ * f() and g() in parallel on the shared
+ * scheduler
+ ****************************************/
+template <class F, class G>
+void parallel_invoke(F f, G g)
+{
+   task_scheduler::instance().invoke(f, g);
+}
+
+/*****************************************
+ * PARALLEL FOR
+ * f(begin, end) on pieces of the range,
+ * split down to grain elements
+ ****************************************/
+template <class F>
+void parallel_for(size_t begin, size_t end, size_t grain, F f)
+{
+   task_scheduler::instance().for_range(begin, end, grain, f);
+}
+
+} // namespace custom
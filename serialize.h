@@ -0,0 +1,490 @@
+/***********************************************************************
+ * Header:
+ *    SERIALIZE
+ * Summary:
+ *    Save a custom::vector to a binary file and load it back again.
+ *
+ *    File layout:
+ *       +-------+---------+-------+--------+-------------+-------+
+ *       | magic | version | flags | endian | elementSize | count |
+ *       +-------+---------+-------+--------+-------------+-------+
+ *       | payloadBytes | checksum | payload ...                   |
+ *       +--------------+----------+-------------------------------+
+ *
+ *    A trivially copyable T is written as its raw bytes: the header and
+ *    the whole buffer go out in one writev(), and loading reads straight
+ *    into the vector's buffer. Any other T goes through codec<T>, which
+ *    can be specialized for your own types.
+ *
+ *    This will contain:
+ *        codec                  : How to encode and decode one element
+ *        save                   : Write a vector to a file
+ *        load                   : Read a vector from a file
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // because I am paranoid
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint32_t and uint64_t
+#include <cstring>     // for memcpy
+#include <stdexcept>   // for std::runtime_error
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable
+
+#include <fcntl.h>     // for open
+#include <sys/stat.h>  // for fstat
+#ifdef _WIN32
+#include <io.h>        // for _read and _write
+#else
+#include <sys/uio.h>   // for writev
+#include <unistd.h>    // for read, write, close
+#endif
+
+#include "vector.h"    // for vector
+
+namespace custom
+{
+
+/*****************************************
+ * CODEC
+ * Turn one element into bytes and back. The
+ * general version handles any trivially
+ * copyable T; specialize it for anything else.
+ *    MIN_BYTES the fewest bytes one element
+ *              can be encoded in
+ *    encode() appends to out
+ *    decode() reads from p and moves p along,
+ *             returning false if it runs past end
+ ****************************************/
+template <typename T, typename Enable = void>
+struct codec;
+
+template <typename T>
+struct codec <T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+   enum { MIN_BYTES = sizeof(T) };
+
+   static void encode(const T & t, std::string & out)
+   {
+      out.append(reinterpret_cast<const char *>(&t), sizeof(T));
+   }
+   static bool decode(const char * & p, const char * end, T & t)
+   {
+      if (size_t(end - p) < sizeof(T))
+         return false;
+      memcpy(&t, p, sizeof(T));
+      p += sizeof(T);
+      return true;
+   }
+};
+
+template <>
+struct codec <std::string>
+{
+   enum { MIN_BYTES = sizeof(uint64_t) };   // the length
+
+   static void encode(const std::string & s, std::string & out)
+   {
+      codec<uint64_t>::encode(uint64_t(s.size()), out);
+      out.append(s);
+   }
+   static bool decode(const char * & p, const char * end, std::string & s)
+   {
+      uint64_t length;
+      if (!codec<uint64_t>::decode(p, end, length) || uint64_t(end - p) < length)
+         return false;
+      s.assign(p, size_t(length));
+      p += length;
+      return true;
+   }
+};
+
+/*****************************************
+ * SERIAL HEADER
+ * The first 40 bytes of every file
+ ****************************************/
+struct serial_header
+{
+   enum { MAGIC = 0x43564543,   // "CVEC"
+          VERSION = 1,
+          ENDIAN = 0x01020304,  // reads as 0x04030201 on the other endianness
+          FLAG_CODEC = 0x0001   // the payload went through codec<T>
+   };
+
+   uint32_t magic;
+   uint16_t version;
+   uint16_t flags;
+   uint32_t endian;
+   uint32_t elementSize;
+   uint64_t count;
+   uint64_t payloadBytes;
+   uint64_t checksum;
+};
+static_assert(sizeof(serial_header) == 40, "the header must be 40 bytes");
+
+/*****************************************
+ * CHECKSUM
+ * FNV-1a, but eight bytes at a time so it
+ * keeps up with the disk
+ ****************************************/
+inline uint64_t checksum(const void * pBuffer, size_t numBytes, uint64_t hash = 0xcbf29ce484222325ull)
+{
+   const uint64_t PRIME = 0x100000001b3ull;
+   const char * p = static_cast<const char *>(pBuffer);
+
+   for (; numBytes >= 8; numBytes -= 8, p += 8)
+   {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      hash = (hash ^ word) * PRIME;
+      hash ^= hash >> 29;
+   }
+   for (; numBytes > 0; numBytes--, p++)
+      hash = (hash ^ uint8_t(*p)) * PRIME;
+   return hash;
+}
+
+/*****************************************
+ * CHECKSUM BUILDER
+ * The same checksum, fed a piece at a time.
+ * The pieces need not line up with the
+ * eight-byte words: finish() gives the same
+ * answer as checksum() over all of them.
+ ****************************************/
+class checksum_builder
+{
+public:
+   checksum_builder() : hash(0xcbf29ce484222325ull), numPending(0) { }
+
+   void update(const void * pBuffer, size_t numBytes)
+   {
+      const char * p = static_cast<const char *>(pBuffer);
+
+      // top up a partial word left from last time
+      while (numPending > 0 && numPending < 8 && numBytes > 0)
+      {
+         pending[numPending++] = *p++;
+         numBytes--;
+      }
+      if (numPending == 8)
+      {
+         hash = checksumWords(pending, 8, hash);
+         numPending = 0;
+      }
+
+      // whole words, then keep what is left over
+      size_t numWords = numBytes / 8 * 8;
+      hash = checksumWords(p, numWords, hash);
+      for (p += numWords, numBytes -= numWords; numBytes > 0; numBytes--)
+         pending[numPending++] = *p++;
+   }
+
+   uint64_t finish() const
+   {
+      return checksum(pending, numPending, hash);
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   static uint64_t checksumWords(const void * p, size_t numBytes, uint64_t hash)
+   {
+      assert(numBytes % 8 == 0);
+      return checksum(p, numBytes, hash);
+   }
+
+   uint64_t hash;             // the hash of every whole word so far
+   char     pending[8];       // bytes that do not yet make a whole word
+   size_t   numPending;       // how many of them there are
+};
+
+/*****************************************
+ * WRITE ALL
+ * Write the header and the payload with a
+ * single writev(), picking up where the
+ * kernel left off after a short write
+ ****************************************/
+inline void writeAll(int fd, const void * pHeader, size_t headerBytes,
+                     const void * pPayload, size_t payloadBytes)
+{
+#ifdef _WIN32
+   const char * parts[2] = { static_cast<const char *>(pHeader),
+                             static_cast<const char *>(pPayload) };
+   size_t sizes[2] = { headerBytes, payloadBytes };
+   for (int i = 0; i < 2; i++)
+      while (sizes[i] > 0)
+      {
+         int num = _write(fd, parts[i], unsigned(sizes[i] > 0x40000000 ? 0x40000000 : sizes[i]));
+         if (num <= 0)
+            throw std::runtime_error("serialize: write failed");
+         parts[i] += num;
+         sizes[i] -= num;
+      }
+#else
+   struct iovec iov[2];
+   iov[0].iov_base = const_cast<void *>(pHeader);
+   iov[0].iov_len  = headerBytes;
+   iov[1].iov_base = const_cast<void *>(pPayload);
+   iov[1].iov_len  = payloadBytes;
+
+   struct iovec * pIov = iov;
+   int numIov = (payloadBytes ? 2 : 1);
+   while (numIov > 0)
+   {
+      ssize_t num = writev(fd, pIov, numIov);
+      if (num < 0)
+         throw std::runtime_error("serialize: write failed");
+
+      // skip over whatever made it out
+      while (numIov > 0 && size_t(num) >= pIov->iov_len)
+      {
+         num -= pIov->iov_len;
+         pIov++;
+         numIov--;
+      }
+      if (numIov > 0)
+      {
+         pIov->iov_base = static_cast<char *>(pIov->iov_base) + num;
+         pIov->iov_len -= num;
+      }
+   }
+#endif
+}
+
+/*****************************************
+ * READ ALL
+ * Read exactly numBytes or throw
+ ****************************************/
+inline void readAll(int fd, void * pBuffer, size_t numBytes)
+{
+   char * p = static_cast<char *>(pBuffer);
+   while (numBytes > 0)
+   {
+      size_t chunk = numBytes > 0x40000000 ? 0x40000000 : numBytes;
+#ifdef _WIN32
+      int num = _read(fd, p, unsigned(chunk));
+#else
+      ssize_t num = read(fd, p, chunk);
+#endif
+      if (num <= 0)
+         throw std::runtime_error("serialize: the file is truncated");
+      p += num;
+      numBytes -= num;
+   }
+}
+
+/*****************************************
+ * READ UP TO
+ * Like readAll(), but running out of file
+ * before the first byte is not an error.
+ * Returns false at a clean end of file.
+ ****************************************/
+inline bool readUpTo(int fd, void * pBuffer, size_t numBytes)
+{
+   char * p = static_cast<char *>(pBuffer);
+#ifdef _WIN32
+   int num = _read(fd, p, unsigned(numBytes));
+#else
+   ssize_t num = read(fd, p, numBytes);
+#endif
+   if (num == 0)
+      return false;
+   if (num < 0)
+      throw std::runtime_error("serialize: read failed");
+   if (size_t(num) < numBytes)
+      readAll(fd, p + num, numBytes - num);
+   return true;
+}
+
+/*****************************************
+ * BYTES LEFT
+ * How much of a regular file is left after
+ * the read position. False for a pipe or
+ * anything else that does not know.
+ ****************************************/
+inline bool bytesLeft(int fd, uint64_t & numBytes)
+{
+#ifdef _WIN32
+   struct _stat64 st;
+   if (_fstat64(fd, &st) != 0 || !(st.st_mode & _S_IFREG))
+      return false;
+   __int64 position = _lseeki64(fd, 0, SEEK_CUR);
+#else
+   struct stat st;
+   if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+      return false;
+   off_t position = lseek(fd, 0, SEEK_CUR);
+#endif
+   if (position < 0 || position > st.st_size)
+      return false;
+   numBytes = uint64_t(st.st_size - position);
+   return true;
+}
+
+/*****************************************
+ * CHECK HEADER
+ * Make sure the file is one of ours and that
+ * it holds what the caller expects. Nothing
+ * is allocated from the header until this
+ * says the count fits in the payload.
+ ****************************************/
+inline void checkHeader(const serial_header & header, size_t elementSize, bool usesCodec,
+                        size_t minBytes)
+{
+   if (header.magic != serial_header::MAGIC)
+      throw std::runtime_error("serialize: not a vector file");
+   if (header.endian != serial_header::ENDIAN)
+      throw std::runtime_error("serialize: written on a machine of the other endianness");
+   if (header.version != serial_header::VERSION)
+      throw std::runtime_error("serialize: unknown version");
+   if (((header.flags & serial_header::FLAG_CODEC) != 0) != usesCodec)
+      throw std::runtime_error("serialize: element encoding does not match");
+   if (!usesCodec && header.elementSize != elementSize)
+      throw std::runtime_error("serialize: element size does not match");
+   if (header.payloadBytes > uint64_t(SIZE_MAX) ||
+       header.count > header.payloadBytes / minBytes)
+      throw std::runtime_error("serialize: the count does not fit in the payload");
+
+   // count * elementSize is no more than payloadBytes now, so it cannot wrap
+   if (!usesCodec && header.payloadBytes != header.count * elementSize)
+      throw std::runtime_error("serialize: element size does not match");
+}
+
+/*****************************************
+ * SAVE
+ * Write v to an open file descriptor
+ ****************************************/
+template <typename T>
+void save(int fd, const vector<T> & v)
+{
+   const bool usesCodec = !std::is_trivially_copyable<T>::value;
+
+   serial_header header = {};
+   header.magic       = serial_header::MAGIC;
+   header.version     = serial_header::VERSION;
+   header.flags       = usesCodec ? serial_header::FLAG_CODEC : 0;
+   header.endian      = serial_header::ENDIAN;
+   header.elementSize = uint32_t(sizeof(T));
+   header.count       = v.size();
+
+   // raw bytes go out straight from the vector's buffer
+   if (!usesCodec)
+   {
+      const void * pPayload = v.size() ? &v[0] : nullptr;
+      header.payloadBytes = v.size() * sizeof(T);
+      header.checksum     = checksum(pPayload, size_t(header.payloadBytes));
+      writeAll(fd, &header, sizeof(header), pPayload, size_t(header.payloadBytes));
+      return;
+   }
+
+   // everything else is encoded one element at a time
+   std::string payload;
+   for (size_t i = 0; i < v.size(); i++)
+      codec<T>::encode(v[i], payload);
+   header.payloadBytes = payload.size();
+   header.checksum     = checksum(payload.data(), payload.size());
+   writeAll(fd, &header, sizeof(header), payload.data(), payload.size());
+}
+
+/*****************************************
+ * LOAD
+ * Read v from an open file descriptor. On
+ * any error v is left as it was.
+ ****************************************/
+template <typename T>
+void load(int fd, vector<T> & v)
+{
+   const bool usesCodec = !std::is_trivially_copyable<T>::value;
+
+   serial_header header;
+   readAll(fd, &header, sizeof(header));
+   checkHeader(header, sizeof(T), usesCodec, size_t(codec<T>::MIN_BYTES));
+   uint64_t numLeft;
+   if (bytesLeft(fd, numLeft) && header.payloadBytes > numLeft)
+      throw std::runtime_error("serialize: the file is truncated");
+
+   // raw bytes come straight into the new buffer. new T[] leaves a
+   // trivially constructible T uninitialized, so the read is the
+   // first and only time each page is touched.
+   vector<T> vNew;
+   if (!usesCodec)
+   {
+      if (header.count)
+         vNew.adopt(new T[size_t(header.count)], size_t(header.count), size_t(header.count));
+      void * pPayload = header.count ? &vNew[0] : nullptr;
+      readAll(fd, pPayload, size_t(header.payloadBytes));
+      if (checksum(pPayload, size_t(header.payloadBytes)) != header.checksum)
+         throw std::runtime_error("serialize: checksum mismatch");
+      v.swap(vNew);
+      return;
+   }
+
+   if (header.count)
+      vNew.resize(size_t(header.count), T());
+   std::string payload(size_t(header.payloadBytes), '\0');
+   if (!payload.empty())
+      readAll(fd, &payload[0], payload.size());
+   if (checksum(payload.data(), payload.size()) != header.checksum)
+      throw std::runtime_error("serialize: checksum mismatch");
+
+   const char * p   = payload.data();
+   const char * end = p + payload.size();
+   for (size_t i = 0; i < vNew.size(); i++)
+      if (!codec<T>::decode(p, end, vNew[i]))
+         throw std::runtime_error("serialize: the payload is truncated");
+   v.swap(vNew);
+}
+
+/*****************************************
+ * SAVE / LOAD by file name
+ ****************************************/
+template <typename T>
+void save(const std::string & fileName, const vector<T> & v)
+{
+#ifdef _WIN32
+   int fd = _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+   int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("serialize: unable to create " + fileName);
+   try
+   {
+      save(fd, v);
+   }
+   catch (...)
+   {
+      close(fd);
+      throw;
+   }
+   close(fd);
+}
+
+template <typename T>
+void load(const std::string & fileName, vector<T> & v)
+{
+#ifdef _WIN32
+   int fd = _open(fileName.c_str(), _O_RDONLY | _O_BINARY);
+#else
+   int fd = open(fileName.c_str(), O_RDONLY);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("serialize: unable to open " + fileName);
+   try
+   {
+      load(fd, v);
+   }
+   catch (...)
+   {
+      close(fd);
+      throw;
+   }
+   close(fd);
+}
+
+} // namespace custom
@@ -0,0 +1,568 @@
+/***********************************************************************
+ * Header:
+ *    SHM VECTOR
+ * Summary:
+ *    A vector in POSIX shared memory, so several processes on one box
+ *    can read the same elements without each making its own copy. The
+ *    segment holds a header and then the elements; nothing in it is a
+ *    pointer, only offsets from the start of the segment, so every
+ *    process can map it wherever it likes.
+ *
+ *    Writers take a process-shared mutex and bump a sequence number
+ *    before and after each change (a seqlock). Readers take no lock:
+ *    they copy what they want and try again if the sequence number was
+ *    odd or moved while they were copying.
+ *
+ *    The header is mapped on its own and never moves, so the writer
+ *    lock stays where it was locked. The elements are in a second
+ *    mapping of the whole segment. The segment only ever grows: when a
+ *    reader needs more, or a writer finds the capacity past its mapping
+ *    because another process grew it, a bigger mapping is made. The old
+ *    ones are kept until the shm_vector goes away, so a thread still
+ *    copying out of one is never left pointing at nothing, and one
+ *    shm_vector can be shared by the threads of a process.
+ *
+ *    Segment layout:
+ *       +-------+---------+-------------+------------+----------+-------+
+ *       | magic | version | elementSize | dataOffset | sequence | count |
+ *       +-------+---------+-------------+------------+----------+-------+
+ *       | capacity | writer lock | padding up to dataOffset             |
+ *       +----------+-------------+--------------------------------------+
+ *       | element 0 | element 1 | ... | element capacity-1              |
+ *       +---------------------------------------------------------------+
+ *
+ *    Some older C libraries need -lrt for shm_open().
+ *
+ *    This will contain the class definition of:
+ *        shm_vector             : A vector shared between processes
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32   // this needs POSIX shm_open() and process-shared mutexes
+
+#include <atomic>      // for the sequence number
+#include <cassert>     // because I am paranoid
+#include <cerrno>      // for EOWNERDEAD
+#include <cstdint>     // for uint32_t and uint64_t
+#include <cstring>     // for memcpy
+#include <mutex>       // for std::mutex
+#include <new>         // for placement new
+#include <stdexcept>   // for std::runtime_error and std::out_of_range
+#include <string>
+#include <thread>      // for std::this_thread::yield
+#include <type_traits> // for std::is_trivially_copyable
+
+#include <fcntl.h>     // for O_CREAT and O_RDWR
+#include <pthread.h>   // for the process-shared mutex
+#include <sys/mman.h>  // for shm_open, mmap, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for ftruncate, close
+
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * SHM VECTOR
+ * A vector of trivially copyable T in shared
+ * memory: one writer at a time, any number
+ * of lock-free readers, in any process
+ ****************************************/
+template <typename T>
+class shm_vector
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "shm_vector needs a trivially copyable T");
+
+public:
+   enum Mode { CREATE,   // make a new segment (replacing any old one)
+               OPEN };   // attach to a segment another process made
+
+   static const uint32_t MAGIC   = 0x4d485343;  // "CSHM"
+   static const uint32_t VERSION = 1;
+
+   //
+   // Construct
+   //
+
+   shm_vector(const std::string & name, Mode mode = OPEN, size_t capacity = 0);
+   shm_vector(const shm_vector & rhs) = delete;
+   shm_vector & operator = (const shm_vector & rhs) = delete;
+   ~shm_vector();
+
+   // take the segment out of the namespace; mappings stay good
+   static void remove(const std::string & name) { shm_unlink(name.c_str()); }
+
+   //
+   // Read: no lock, from any process
+   //
+
+   T        get(size_t index)            const;
+   void     snapshot(vector<T> & v)      const;
+   size_t   size()                       const;
+   bool     empty()                      const { return size() == 0; }
+   size_t   capacity()                   const { return size_t(pHeader->capacity.load()); }
+   uint64_t version()                    const { return pHeader->sequence.load() / 2; }
+
+   //
+   // Write: one process at a time
+   //
+
+   void set(size_t index, const T & t);
+   void push_back(const T & t);
+   void pop_back();
+   void resize(size_t newElements, const T & t = T());
+   void reserve(size_t newCapacity);
+   void assign(const vector<T> & v);
+   void clear() { resize(0); }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   // the start of the segment
+   struct Header
+   {
+      uint32_t              magic;        // written last: MAGIC means ready
+      uint32_t              version;
+      uint32_t              elementSize;
+      uint32_t              padding;
+      uint64_t              dataOffset;   // where element 0 is
+      std::atomic<uint64_t> sequence;     // odd while a writer is busy
+      std::atomic<uint64_t> count;        // elements in use
+      std::atomic<uint64_t> capacity;     // elements the segment holds
+      pthread_mutex_t       writeLock;    // one writer at a time
+   };
+
+   // one mapping of the whole segment, and the smaller one before it
+   struct Mapping
+   {
+      char *    base;
+      size_t    size;
+      Mapping * older;
+   };
+
+   /*****************************************
+    * WRITE GUARD
+    * Hold the writer lock and keep the sequence
+    * number odd while a change is made. Another
+    * process may have grown the segment since we
+    * last looked, so the mapping is brought up
+    * to the capacity before anything is written.
+    ****************************************/
+   class WriteGuard
+   {
+   public:
+      WriteGuard(shm_vector * pv) : pv(pv)
+      {
+         pv->lock();
+         try
+         {
+            size_t needed = segmentSize(pv->capacity());
+            if (pv->mapping()->size < needed)
+               pv->map(needed);
+         }
+         catch (...)
+         {
+            pthread_mutex_unlock(&pv->pHeader->writeLock);
+            throw;
+         }
+         pv->pHeader->sequence.fetch_add(1, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_release);
+      }
+      ~WriteGuard()
+      {
+         pv->pHeader->sequence.fetch_add(1, std::memory_order_release);
+         pthread_mutex_unlock(&pv->pHeader->writeLock);
+      }
+   private:
+      shm_vector * pv;
+   };
+
+   static size_t dataOffset()
+   {
+      return (sizeof(Header) + 63) / 64 * 64;
+   }
+   static size_t segmentSize(size_t capacity)
+   {
+      return dataOffset() + capacity * sizeof(T);
+   }
+
+   T *       data()       { return reinterpret_cast<T *>(base() + pHeader->dataOffset); }
+   char *    base() const { return mapping()->base; }
+   Mapping * mapping() const { return pMapping.load(std::memory_order_acquire); }
+   void      lock();
+   void      grow(size_t newCapacity);
+   bool      mapped(size_t numElements) const;
+   void      mapHeader();
+   void      map(size_t newSize) const;
+   void      unmap();
+   void      fail(const std::string & message);
+
+   std::string                    name;       // the name passed to shm_open()
+   int                            fd;         // the segment
+   Header *                       pHeader;    // the header alone; it never moves
+   mutable std::atomic<Mapping *> pMapping;   // the newest mapping of the whole segment
+   mutable std::mutex             mapLock;    // one thread of ours maps at a time
+};
+
+/*****************************************
+ * SHM VECTOR :: CONSTRUCTOR
+ * Make a new segment, or attach to one
+ ****************************************/
+template <typename T>
+shm_vector <T> :: shm_vector(const std::string & name, Mode mode, size_t capacity) :
+   name(name), fd(-1), pHeader(nullptr), pMapping(nullptr)
+{
+   if (mode == CREATE)
+   {
+      shm_unlink(name.c_str());
+      fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      if (fd == -1)
+         throw std::runtime_error("shm_vector: unable to create " + name);
+      if (ftruncate(fd, segmentSize(capacity)) != 0)
+         fail("unable to size " + name);
+      mapHeader();
+      map(segmentSize(capacity));
+
+      // the header, with a mutex every process can use
+      Header * p = new (pHeader) Header;
+      p->version     = VERSION;
+      p->elementSize = uint32_t(sizeof(T));
+      p->padding     = 0;
+      p->dataOffset  = dataOffset();
+      p->sequence.store(0);
+      p->count.store(0);
+      p->capacity.store(capacity);
+      pthread_mutexattr_t attr;
+      pthread_mutexattr_init(&attr);
+      pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+      // a writer that dies holding the lock does not hang everyone else
+      pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+      int error = pthread_mutex_init(&p->writeLock, &attr);
+      pthread_mutexattr_destroy(&attr);
+      if (error != 0)
+         fail("unable to make the writer lock");
+
+      std::atomic_thread_fence(std::memory_order_release);
+      p->magic = MAGIC;
+   }
+   else
+   {
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+      if (fd == -1)
+         throw std::runtime_error("shm_vector: unable to open " + name);
+      struct stat st;
+      if (fstat(fd, &st) != 0 || size_t(st.st_size) < dataOffset())
+         fail(name + " is not ready");
+      mapHeader();
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (pHeader->magic != MAGIC || pHeader->version != VERSION ||
+          pHeader->elementSize != sizeof(T))
+         fail(name + " is not a shm_vector of this type");
+      map(size_t(st.st_size));
+   }
+}
+
+/*****************************************
+ * SHM VECTOR :: DESTRUCTOR
+ * Let go of our mappings. The segment lives
+ * on until remove() and the last munmap().
+ ****************************************/
+template <typename T>
+shm_vector <T> :: ~shm_vector()
+{
+   unmap();
+   if (fd != -1)
+      ::close(fd);
+}
+
+/***************************************
+ * SHM VECTOR :: GET
+ * One element, as it was between two writes
+ **************************************/
+template <typename T>
+T shm_vector <T> :: get(size_t index) const
+{
+   for (;;)
+   {
+      uint64_t before = pHeader->sequence.load(std::memory_order_acquire);
+      if (before & 1)
+      {
+         std::this_thread::yield();
+         continue;
+      }
+
+      bool inRange = index < pHeader->count.load(std::memory_order_relaxed);
+      T t;
+      if (inRange && !mapped(index + 1))
+         continue;   // map() found more of the segment; look again
+      if (inRange)
+         memcpy(&t, base() + pHeader->dataOffset + index * sizeof(T), sizeof(T));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (pHeader->sequence.load(std::memory_order_relaxed) != before)
+         continue;   // a writer got in: what we copied may be torn
+      if (!inRange)
+         throw std::out_of_range("shm_vector: index out of range");
+      return t;
+   }
+}
+
+/***************************************
+ * SHM VECTOR :: SNAPSHOT
+ * Every element, as they were between two writes
+ **************************************/
+template <typename T>
+void shm_vector <T> :: snapshot(vector<T> & v) const
+{
+   for (;;)
+   {
+      uint64_t before = pHeader->sequence.load(std::memory_order_acquire);
+      if (before & 1)
+      {
+         std::this_thread::yield();
+         continue;
+      }
+
+      size_t num = size_t(pHeader->count.load(std::memory_order_relaxed));
+      if (!mapped(num))
+         continue;
+      v.resize(num, T());
+      if (num)
+         memcpy(&v[0], base() + pHeader->dataOffset, num * sizeof(T));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (pHeader->sequence.load(std::memory_order_relaxed) == before)
+         return;
+   }
+}
+
+/***************************************
+ * SHM VECTOR :: SIZE
+ **************************************/
+template <typename T>
+size_t shm_vector <T> :: size() const
+{
+   return size_t(pHeader->count.load(std::memory_order_acquire));
+}
+
+/***************************************
+ * SHM VECTOR :: SET
+ **************************************/
+template <typename T>
+void shm_vector <T> :: set(size_t index, const T & t)
+{
+   WriteGuard guard(this);
+   if (index >= pHeader->count.load(std::memory_order_relaxed))
+      throw std::out_of_range("shm_vector: index out of range");
+   memcpy(data() + index, &t, sizeof(T));
+}
+
+/***************************************
+ * SHM VECTOR :: PUSH BACK
+ * Double the segment when it is full
+ **************************************/
+template <typename T>
+void shm_vector <T> :: push_back(const T & t)
+{
+   WriteGuard guard(this);
+   size_t num = size_t(pHeader->count.load(std::memory_order_relaxed));
+   if (num == capacity())
+      grow(num ? num * 2 : 1);
+   memcpy(data() + num, &t, sizeof(T));
+   pHeader->count.store(num + 1, std::memory_order_relaxed);
+}
+
+/***************************************
+ * SHM VECTOR :: POP BACK
+ **************************************/
+template <typename T>
+void shm_vector <T> :: pop_back()
+{
+   WriteGuard guard(this);
+   uint64_t num = pHeader->count.load(std::memory_order_relaxed);
+   if (num > 0)
+      pHeader->count.store(num - 1, std::memory_order_relaxed);
+}
+
+/***************************************
+ * SHM VECTOR :: RESIZE
+ **************************************/
+template <typename T>
+void shm_vector <T> :: resize(size_t newElements, const T & t)
+{
+   WriteGuard guard(this);
+   if (newElements > capacity())
+      grow(newElements);
+   for (size_t i = size_t(pHeader->count.load(std::memory_order_relaxed)); i < newElements; i++)
+      memcpy(data() + i, &t, sizeof(T));
+   pHeader->count.store(newElements, std::memory_order_relaxed);
+}
+
+/***************************************
+ * SHM VECTOR :: RESERVE
+ **************************************/
+template <typename T>
+void shm_vector <T> :: reserve(size_t newCapacity)
+{
+   WriteGuard guard(this);
+   if (newCapacity > capacity())
+      grow(newCapacity);
+}
+
+/***************************************
+ * SHM VECTOR :: ASSIGN
+ * Hand off a whole vector in one write
+ **************************************/
+template <typename T>
+void shm_vector <T> :: assign(const vector<T> & v)
+{
+   WriteGuard guard(this);
+   if (v.size() > capacity())
+      grow(v.size());
+   if (v.size())
+      memcpy(data(), &v[0], v.size() * sizeof(T));
+   pHeader->count.store(v.size(), std::memory_order_relaxed);
+}
+
+/***************************************
+ * SHM VECTOR :: LOCK
+ * Take the writer lock. If the last writer
+ * died holding it, its half-finished change
+ * is kept and its odd sequence number closed.
+ **************************************/
+template <typename T>
+void shm_vector <T> :: lock()
+{
+   int error = pthread_mutex_lock(&pHeader->writeLock);
+#ifdef __linux__
+   if (error == EOWNERDEAD)
+   {
+      if (pHeader->sequence.load(std::memory_order_relaxed) & 1)
+         pHeader->sequence.fetch_add(1, std::memory_order_release);
+      pthread_mutex_consistent(&pHeader->writeLock);
+      error = 0;
+   }
+#endif
+   if (error != 0)
+      throw std::runtime_error("shm_vector: unable to take the writer lock");
+}
+
+/***************************************
+ * SHM VECTOR :: GROW
+ * Make the segment bigger. The file grows
+ * before capacity says so, so a reader that
+ * sees the new capacity can map all of it.
+ **************************************/
+template <typename T>
+void shm_vector <T> :: grow(size_t newCapacity)
+{
+   if (ftruncate(fd, segmentSize(newCapacity)) != 0)
+      throw std::runtime_error("shm_vector: unable to grow " + name);
+   map(segmentSize(newCapacity));
+   pHeader->capacity.store(newCapacity, std::memory_order_release);
+}
+
+/***************************************
+ * SHM VECTOR :: MAPPED
+ * Is there room for numElements in our
+ * mapping? If not, map what the segment has
+ * now and say no, so the caller looks again.
+ **************************************/
+template <typename T>
+bool shm_vector <T> :: mapped(size_t numElements) const
+{
+   size_t mapSize = mapping()->size;
+   if (segmentSize(numElements) <= mapSize)
+      return true;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0)
+      throw std::runtime_error("shm_vector: unable to check " + name);
+   if (size_t(st.st_size) > mapSize)
+      map(size_t(st.st_size));
+   return false;
+}
+
+/***************************************
+ * SHM VECTOR :: MAP HEADER
+ * Map the header on its own, for good
+ **************************************/
+template <typename T>
+void shm_vector <T> :: mapHeader()
+{
+   void * p = mmap(nullptr, dataOffset(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (p == MAP_FAILED)
+      fail("unable to map " + name);
+   pHeader = static_cast<Header *>(p);
+}
+
+/***************************************
+ * SHM VECTOR :: MAP
+ * Map at least newSize bytes of the segment.
+ * Only offsets live in the segment, so it
+ * does not matter where it lands.
+ **************************************/
+template <typename T>
+void shm_vector <T> :: map(size_t newSize) const
+{
+   std::lock_guard<std::mutex> guard(mapLock);
+   Mapping * pOlder = pMapping.load(std::memory_order_relaxed);
+   if (pOlder != nullptr && pOlder->size >= newSize)
+      return;   // another thread got here first
+
+   void * p = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (p == MAP_FAILED)
+      throw std::runtime_error("shm_vector: unable to map " + name);
+   Mapping * pNewer = new Mapping;
+   pNewer->base  = static_cast<char *>(p);
+   pNewer->size  = newSize;
+   pNewer->older = pOlder;
+   pMapping.store(pNewer, std::memory_order_release);
+}
+
+/***************************************
+ * SHM VECTOR :: UNMAP
+ * Let go of every mapping, old and new
+ **************************************/
+template <typename T>
+void shm_vector <T> :: unmap()
+{
+   Mapping * p = pMapping.exchange(nullptr);
+   while (p != nullptr)
+   {
+      Mapping * pOlder = p->older;
+      munmap(p->base, p->size);
+      delete p;
+      p = pOlder;
+   }
+   if (pHeader != nullptr)
+      munmap(pHeader, dataOffset());
+   pHeader = nullptr;
+}
+
+/***************************************
+ * SHM VECTOR :: FAIL
+ * Clean up a half-built segment and throw
+ **************************************/
+template <typename T>
+void shm_vector <T> :: fail(const std::string & message)
+{
+   unmap();
+   ::close(fd);
+   fd = -1;
+   throw std::runtime_error("shm_vector: " + message);
+}
+
+} // namespace custom
+
+#endif // !_WIN32
@@ -0,0 +1,679 @@
+/***********************************************************************
+ * Header:
+ *    SIMD
+ * Summary:
+ *    Kernels for the loops we keep writing over vectors of numbers:
+ *    sum, min, max, argmin, dot, axpy, scale, clamp, count_equal and
+ *    the prefix sums inclusive_scan and exclusive_scan.
+ *
+ *    Each kernel is written once, against a vector register of B bytes,
+ *    using the compiler's vector extensions rather than one set of
+ *    intrinsics per instruction set. It is then compiled three more
+ *    times, for SSE4.2 (16 bytes), AVX2 (32) and AVX-512 (64), by
+ *    wrappers that carry their own target, so the program itself can be
+ *    built for the oldest machine we run on. Which copy runs is decided
+ *    once, from what cpuid says the CPU can do (see cpu_features.h), and
+ *    each kernel is then called through a pointer bound to that copy.
+ *
+ *    Compilers without vector extensions, such as MSVC, and CPUs other
+ *    than x86, get the scalar copy.
+ *
+ *    A sum, a dot product or a scan adds in a different order from a
+ *    plain loop, so a float answer may differ in the last bits. With
+ *    NaNs in the input, the answers of min, max and argmin are
+ *    unspecified.
+ *
+ *    This will contain the class definition of:
+ *        simd::kernels          : Pointers to the kernels for one level
+ *        simd::sum .. exclusive_scan : The kernels
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <cstring>      // for memcpy
+#include <type_traits>  // for std::remove_const
+#include <utility>      // for std::index_sequence
+
+#include "cpu_features.h" // for active_level
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+namespace simd
+{
+
+/*****************************************
+ * SCALAR
+ * The plain loops, for any T and any CPU
+ ****************************************/
+namespace scalar
+{
+
+template <typename T>
+T sum(const T * p, size_t n)
+{
+   T total = T();
+   for (size_t i = 0; i < n; i++)
+      total += p[i];
+   return total;
+}
+
+template <typename T>
+T min(const T * p, size_t n)
+{
+   assert(n > 0);
+   T best = p[0];
+   for (size_t i = 1; i < n; i++)
+      best = p[i] < best ? p[i] : best;
+   return best;
+}
+
+template <typename T>
+T max(const T * p, size_t n)
+{
+   assert(n > 0);
+   T best = p[0];
+   for (size_t i = 1; i < n; i++)
+      best = p[i] > best ? p[i] : best;
+   return best;
+}
+
+template <typename T>
+size_t find(const T * p, size_t n, T value)
+{
+   for (size_t i = 0; i < n; i++)
+      if (p[i] == value)
+         return i;
+   return n;
+}
+
+template <typename T>
+T dot(const T * a, const T * b, size_t n)
+{
+   T total = T();
+   for (size_t i = 0; i < n; i++)
+      total += a[i] * b[i];
+   return total;
+}
+
+template <typename T>
+void axpy(T alpha, const T * x, T * y, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      y[i] += alpha * x[i];
+}
+
+template <typename T>
+void scale(T alpha, T * x, size_t n)
+{
+   for (size_t i = 0; i < n; i++)
+      x[i] *= alpha;
+}
+
+template <typename T>
+void clamp(T * x, size_t n, T lo, T hi)
+{
+   for (size_t i = 0; i < n; i++)
+      x[i] = x[i] < lo ? lo : (x[i] > hi ? hi : x[i]);
+}
+
+template <typename T>
+size_t count_equal(const T * x, size_t n, T value)
+{
+   size_t num = 0;
+   for (size_t i = 0; i < n; i++)
+      num += (x[i] == value);
+   return num;
+}
+
+// out[i] = init + in[0] + ... + in[i], and the sum of everything
+template <typename T>
+T inclusive_scan(const T * in, T * out, size_t n, T init)
+{
+   for (size_t i = 0; i < n; i++)
+   {
+      init += in[i];
+      out[i] = init;
+   }
+   return init;
+}
+
+// out[i] = init + in[0] + ... + in[i - 1], and the sum of everything
+template <typename T>
+T exclusive_scan(const T * in, T * out, size_t n, T init)
+{
+   for (size_t i = 0; i < n; i++)
+   {
+      T t = in[i];
+      out[i] = init;
+      init += t;
+   }
+   return init;
+}
+
+} // namespace scalar
+
+#ifdef CUSTOM_SIMD_X86
+/*****************************************
+ * LANES
+ * The kernels, for a register of B bytes.
+ * Only the wrappers below give them a target,
+ * and they are flattened into the wrappers,
+ * so none is ever called on its own.
+ ****************************************/
+namespace lanes
+{
+
+template <typename T, size_t B>
+struct reg
+{
+   typedef T type __attribute__((vector_size(B)));
+   static const size_t width = B / sizeof(T);
+};
+
+#define CUSTOM_SIMD_REG                              \
+   typedef typename reg<T, B>::type V;               \
+   const size_t W = reg<T, B>::width;
+
+template <typename T, size_t B>
+T sum(const T * p, size_t n)
+{
+   CUSTOM_SIMD_REG
+   // four sums, so each add need not wait for the one before
+   V s0 = { }, s1 = { }, s2 = { }, s3 = { };
+   size_t i = 0;
+   for (; i + 4 * W <= n; i += 4 * W)
+   {
+      V a, b, c, d;
+      memcpy(&a, p + i,         sizeof(V));
+      memcpy(&b, p + i + W,     sizeof(V));
+      memcpy(&c, p + i + 2 * W, sizeof(V));
+      memcpy(&d, p + i + 3 * W, sizeof(V));
+      s0 += a;
+      s1 += b;
+      s2 += c;
+      s3 += d;
+   }
+   for (; i + W <= n; i += W)
+   {
+      V a;
+      memcpy(&a, p + i, sizeof(V));
+      s0 += a;
+   }
+   s0 += s1 + s2 + s3;
+   T total = T();
+   for (size_t k = 0; k < W; k++)
+      total += s0[k];
+   for (; i < n; i++)
+      total += p[i];
+   return total;
+}
+
+template <typename T, size_t B>
+T min(const T * p, size_t n)
+{
+   CUSTOM_SIMD_REG
+   assert(n > 0);
+   if (n < W)
+      return scalar::min(p, n);
+   V best;
+   memcpy(&best, p, sizeof(V));
+   size_t i = W;
+   for (; i + W <= n; i += W)
+   {
+      V a;
+      memcpy(&a, p + i, sizeof(V));
+      best = a < best ? a : best;
+   }
+   T t = best[0];
+   for (size_t k = 1; k < W; k++)
+      t = best[k] < t ? best[k] : t;
+   for (; i < n; i++)
+      t = p[i] < t ? p[i] : t;
+   return t;
+}
+
+template <typename T, size_t B>
+T max(const T * p, size_t n)
+{
+   CUSTOM_SIMD_REG
+   assert(n > 0);
+   if (n < W)
+      return scalar::max(p, n);
+   V best;
+   memcpy(&best, p, sizeof(V));
+   size_t i = W;
+   for (; i + W <= n; i += W)
+   {
+      V a;
+      memcpy(&a, p + i, sizeof(V));
+      best = a > best ? a : best;
+   }
+   T t = best[0];
+   for (size_t k = 1; k < W; k++)
+      t = best[k] > t ? best[k] : t;
+   for (; i < n; i++)
+      t = p[i] > t ? p[i] : t;
+   return t;
+}
+
+// the first index holding value, or n
+template <typename T, size_t B>
+size_t find(const T * p, size_t n, T value)
+{
+   CUSTOM_SIMD_REG
+   V target = V() + value;
+   size_t i = 0;
+   for (; i + W <= n; i += W)
+   {
+      V a;
+      memcpy(&a, p + i, sizeof(V));
+      auto same = (a == target);
+      decltype(same) none = { };
+      if (memcmp(&same, &none, sizeof(same)) != 0)
+         for (size_t k = 0; k < W; k++)
+            if (same[k])
+               return i + k;
+   }
+   return i + scalar::find(p + i, n - i, value);
+}
+
+template <typename T, size_t B>
+T dot(const T * a, const T * b, size_t n)
+{
+   CUSTOM_SIMD_REG
+   V s0 = { }, s1 = { };
+   size_t i = 0;
+   for (; i + 2 * W <= n; i += 2 * W)
+   {
+      V a0, a1, b0, b1;
+      memcpy(&a0, a + i,     sizeof(V));
+      memcpy(&a1, a + i + W, sizeof(V));
+      memcpy(&b0, b + i,     sizeof(V));
+      memcpy(&b1, b + i + W, sizeof(V));
+      s0 += a0 * b0;
+      s1 += a1 * b1;
+   }
+   s0 += s1;
+   T total = T();
+   for (size_t k = 0; k < W; k++)
+      total += s0[k];
+   return total + scalar::dot(a + i, b + i, n - i);
+}
+
+template <typename T, size_t B>
+void axpy(T alpha, const T * x, T * y, size_t n)
+{
+   CUSTOM_SIMD_REG
+   V a = V() + alpha;
+   size_t i = 0;
+   for (; i + W <= n; i += W)
+   {
+      V vx, vy;
+      memcpy(&vx, x + i, sizeof(V));
+      memcpy(&vy, y + i, sizeof(V));
+      vy += a * vx;
+      memcpy(y + i, &vy, sizeof(V));
+   }
+   scalar::axpy(alpha, x + i, y + i, n - i);
+}
+
+template <typename T, size_t B>
+void scale(T alpha, T * x, size_t n)
+{
+   CUSTOM_SIMD_REG
+   V a = V() + alpha;
+   size_t i = 0;
+   for (; i + W <= n; i += W)
+   {
+      V vx;
+      memcpy(&vx, x + i, sizeof(V));
+      vx *= a;
+      memcpy(x + i, &vx, sizeof(V));
+   }
+   scalar::scale(alpha, x + i, n - i);
+}
+
+template <typename T, size_t B>
+void clamp(T * x, size_t n, T lo, T hi)
+{
+   CUSTOM_SIMD_REG
+   V vlo = V() + lo;
+   V vhi = V() + hi;
+   size_t i = 0;
+   for (; i + W <= n; i += W)
+   {
+      V vx;
+      memcpy(&vx, x + i, sizeof(V));
+      vx = vx < vlo ? vlo : vx;
+      vx = vx > vhi ? vhi : vx;
+      memcpy(x + i, &vx, sizeof(V));
+   }
+   scalar::clamp(x + i, n - i, lo, hi);
+}
+
+// a match is -1 in its lane, so subtracting counts it. The lane
+// counters are as narrow as T, so they are emptied before they overflow.
+template <typename T, size_t B>
+size_t count_equal(const T * x, size_t n, T value)
+{
+   CUSTOM_SIMD_REG
+   typedef decltype(V() == V()) M;
+   const size_t most = sizeof(T) >= 4 ? size_t(1) << 30
+                                      : (size_t(1) << (8 * sizeof(T) - 1)) - 1;
+   V target = V() + value;
+   size_t num = 0;
+   size_t i = 0;
+   while (i + W <= n)
+   {
+      M counts = { };
+      for (size_t run = 0; run < most && i + W <= n; run++, i += W)
+      {
+         V a;
+         memcpy(&a, x + i, sizeof(V));
+         counts -= (a == target);
+      }
+      for (size_t k = 0; k < W; k++)
+         num += size_t(counts[k]);
+   }
+   return num + scalar::count_equal(x + i, n - i, value);
+}
+
+// x moved up K lanes, with zeros in the K lanes at the bottom. The mask
+// is built from the lane numbers at compile time, so it is a constant.
+template <size_t K, typename V, typename M, size_t... I>
+void shiftUp(V & x, std::index_sequence<I...>)
+{
+   const V zero = { };
+   const M mask = { (I >= K ? I - K : sizeof...(I))... };
+   x = __builtin_shuffle(x, zero, mask);
+}
+
+// x[i] = x[0] + ... + x[i], by adding x to itself moved up K = 1, 2, 4 ..
+template <size_t K, size_t W, typename V, typename M>
+void prefix(V &, std::false_type) { }
+template <size_t K, size_t W, typename V, typename M>
+void prefix(V & x, std::true_type)
+{
+   V y = x;
+   shiftUp<K, V, M>(y, std::make_index_sequence<W>());
+   x += y;
+   prefix<2 * K, W, V, M>(x, std::integral_constant<bool, (2 * K < W)>());
+}
+
+// every lane of last set to the last lane of x
+template <typename V, typename M, size_t... I>
+void broadcastLast(const V & x, V & last, std::index_sequence<I...>)
+{
+   const M mask = { (I * 0 + sizeof...(I) - 1)... };
+   last = __builtin_shuffle(x, mask);
+}
+
+// Within a register the sums take log2(W) shifted adds. The carry from
+// one register to the next stays in a register too, in every lane, so
+// the only thing one step waits on from the last is a single add.
+template <typename T, size_t B, bool Exclusive>
+T scan(const T * in, T * out, size_t n, T carry)
+{
+   CUSTOM_SIMD_REG
+   typedef decltype(V() == V()) M;
+   size_t i = 0;
+   V carries = V() + carry;
+   for (; i + W <= n; i += W)
+   {
+      V x;
+      memcpy(&x, in + i, sizeof(V));
+      prefix<1, W, V, M>(x, std::integral_constant<bool, (1 < W)>());
+      V total;
+      broadcastLast<V, M>(x, total, std::make_index_sequence<W>());
+      if (Exclusive)
+         shiftUp<1, V, M>(x, std::make_index_sequence<W>());
+      x += carries;
+      memcpy(out + i, &x, sizeof(V));
+      carries += total;
+   }
+   carry = carries[0];
+   return Exclusive ? scalar::exclusive_scan(in + i, out + i, n - i, carry)
+                    : scalar::inclusive_scan(in + i, out + i, n - i, carry);
+}
+
+#undef CUSTOM_SIMD_REG
+
+} // namespace lanes
+
+/*****************************************
+ * SSE42, AVX2, AVX512
+ * The lanes kernels compiled for each
+ * instruction set
+ ****************************************/
+#define CUSTOM_SIMD_LEVEL(NAME, TARGET, BYTES)                                       \
+namespace NAME                                                                       \
+{                                                                                    \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T sum(const T * p, size_t n) { return lanes::sum<T, BYTES>(p, n); }               \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T min(const T * p, size_t n) { return lanes::min<T, BYTES>(p, n); }               \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T max(const T * p, size_t n) { return lanes::max<T, BYTES>(p, n); }               \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   size_t find(const T * p, size_t n, T value)                                       \
+   { return lanes::find<T, BYTES>(p, n, value); }                                    \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T dot(const T * a, const T * b, size_t n) { return lanes::dot<T, BYTES>(a, b, n); } \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   void axpy(T alpha, const T * x, T * y, size_t n)                                  \
+   { lanes::axpy<T, BYTES>(alpha, x, y, n); }                                        \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   void scale(T alpha, T * x, size_t n) { lanes::scale<T, BYTES>(alpha, x, n); }     \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   void clamp(T * x, size_t n, T lo, T hi) { lanes::clamp<T, BYTES>(x, n, lo, hi); } \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   size_t count_equal(const T * x, size_t n, T value)                                \
+   { return lanes::count_equal<T, BYTES>(x, n, value); }                             \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T inclusive_scan(const T * in, T * out, size_t n, T init)                         \
+   { return lanes::scan<T, BYTES, false>(in, out, n, init); }                        \
+   template <typename T> __attribute__((target(TARGET), flatten))                    \
+   T exclusive_scan(const T * in, T * out, size_t n, T init)                         \
+   { return lanes::scan<T, BYTES, true>(in, out, n, init); }                         \
+}
+
+CUSTOM_SIMD_LEVEL(sse42,  "sse4.2",  16)
+CUSTOM_SIMD_LEVEL(avx2,   "avx2",    32)
+CUSTOM_SIMD_LEVEL(avx512, "avx512f", 64)
+
+#undef CUSTOM_SIMD_LEVEL
+
+#endif // CUSTOM_SIMD_X86
+
+/*****************************************
+ * KERNELS
+ * A pointer to every kernel, all compiled
+ * for the same level
+ ****************************************/
+template <typename T>
+struct kernels
+{
+   T      (*sum)(const T *, size_t);
+   T      (*min)(const T *, size_t);
+   T      (*max)(const T *, size_t);
+   size_t (*find)(const T *, size_t, T);
+   T      (*dot)(const T *, const T *, size_t);
+   void   (*axpy)(T, const T *, T *, size_t);
+   void   (*scale)(T, T *, size_t);
+   void   (*clamp)(T *, size_t, T, T);
+   size_t (*count_equal)(const T *, size_t, T);
+   T      (*inclusive_scan)(const T *, T *, size_t, T);
+   T      (*exclusive_scan)(const T *, T *, size_t, T);
+
+   static kernels at(level l);
+
+   // the ones for active_level(), bound the first time T is used
+   static const kernels & active()
+   {
+      static const kernels bound = at(active_level());
+      return bound;
+   }
+};
+
+/*****************************************
+ * KERNELS :: AT
+ * The kernels for level l, which the CPU
+ * had better support
+ ****************************************/
+template <typename T>
+kernels<T> kernels<T>::at(level l)
+{
+#define CUSTOM_SIMD_BIND(NAME)                              \
+   k.sum            = &NAME::sum<T>;                        \
+   k.min            = &NAME::min<T>;                        \
+   k.max            = &NAME::max<T>;                        \
+   k.find           = &NAME::find<T>;                       \
+   k.dot            = &NAME::dot<T>;                        \
+   k.axpy           = &NAME::axpy<T>;                       \
+   k.scale          = &NAME::scale<T>;                      \
+   k.clamp          = &NAME::clamp<T>;                      \
+   k.count_equal    = &NAME::count_equal<T>;                \
+   k.inclusive_scan = &NAME::inclusive_scan<T>;             \
+   k.exclusive_scan = &NAME::exclusive_scan<T>;
+
+   kernels k;
+   switch (l)
+   {
+#ifdef CUSTOM_SIMD_X86
+      case AVX512: CUSTOM_SIMD_BIND(avx512) break;
+      case AVX2:   CUSTOM_SIMD_BIND(avx2)   break;
+      case SSE42:  CUSTOM_SIMD_BIND(sse42)  break;
+#endif
+      default:     CUSTOM_SIMD_BIND(scalar) break;
+   }
+   return k;
+
+#undef CUSTOM_SIMD_BIND
+}
+
+/*****************************************
+ * THE KERNELS
+ * On a pointer and a count, a span, or a
+ * whole vector
+ ****************************************/
+
+// the total of the elements
+template <typename T>
+T sum(const T * p, size_t n) { return kernels<T>::active().sum(p, n); }
+
+// the smallest and the largest: n has to be at least 1
+template <typename T>
+T min(const T * p, size_t n) { return kernels<T>::active().min(p, n); }
+template <typename T>
+T max(const T * p, size_t n) { return kernels<T>::active().max(p, n); }
+
+// the first index of value, or n if it is not there
+template <typename T>
+size_t find(const T * p, size_t n, T value) { return kernels<T>::active().find(p, n, value); }
+
+// the index of the first smallest element: n has to be at least 1
+template <typename T>
+size_t argmin(const T * p, size_t n) { return find(p, n, min(p, n)); }
+
+// a[0] * b[0] + a[1] * b[1] + ...
+template <typename T>
+T dot(const T * a, const T * b, size_t n) { return kernels<T>::active().dot(a, b, n); }
+
+// y[i] += alpha * x[i]
+template <typename T>
+void axpy(T alpha, const T * x, T * y, size_t n) { kernels<T>::active().axpy(alpha, x, y, n); }
+
+// x[i] *= alpha
+template <typename T>
+void scale(T alpha, T * x, size_t n) { kernels<T>::active().scale(alpha, x, n); }
+
+// lo <= x[i] <= hi
+template <typename T>
+void clamp(T * x, size_t n, T lo, T hi) { kernels<T>::active().clamp(x, n, lo, hi); }
+
+// how many x[i] == value
+template <typename T>
+size_t count_equal(const T * x, size_t n, T value)
+{
+   return kernels<T>::active().count_equal(x, n, value);
+}
+
+// out[i] = init + in[0] + ... + in[i]. Gives back the sum of everything.
+// out may be in.
+template <typename T>
+T inclusive_scan(const T * in, T * out, size_t n, T init)
+{
+   return kernels<T>::active().inclusive_scan(in, out, n, init);
+}
+
+// out[i] = init + in[0] + ... + in[i - 1]
+template <typename T>
+T exclusive_scan(const T * in, T * out, size_t n, T init)
+{
+   return kernels<T>::active().exclusive_scan(in, out, n, init);
+}
+
+template <typename T>
+typename std::remove_const<T>::type sum(span<T> s) { return sum(s.data(), s.size()); }
+template <typename T>
+T sum(const vector<T> & v) { return sum(v.slice(0, v.size())); }
+
+template <typename T>
+typename std::remove_const<T>::type min(span<T> s) { return min(s.data(), s.size()); }
+template <typename T>
+T min(const vector<T> & v) { return min(v.slice(0, v.size())); }
+
+template <typename T>
+typename std::remove_const<T>::type max(span<T> s) { return max(s.data(), s.size()); }
+template <typename T>
+T max(const vector<T> & v) { return max(v.slice(0, v.size())); }
+
+template <typename T>
+size_t argmin(span<T> s) { return argmin(s.data(), s.size()); }
+template <typename T>
+size_t argmin(const vector<T> & v) { return argmin(v.slice(0, v.size())); }
+
+template <typename T, typename U>
+typename std::remove_const<T>::type dot(span<T> a, span<U> b)
+{
+   assert(a.size() == b.size());
+   return dot(a.data(), b.data(), a.size());
+}
+template <typename T>
+T dot(const vector<T> & a, const vector<T> & b) { return dot(a.slice(0, a.size()), b.slice(0, b.size())); }
+
+template <typename T, typename U>
+void axpy(typename std::remove_const<T>::type alpha, span<T> x, span<U> y)
+{
+   assert(x.size() == y.size());
+   axpy(alpha, x.data(), y.data(), x.size());
+}
+template <typename T>
+void axpy(T alpha, const vector<T> & x, vector<T> & y) { axpy(alpha, x.slice(0, x.size()), y.slice(0, y.size())); }
+
+template <typename T>
+void scale(T alpha, span<T> x) { scale(alpha, x.data(), x.size()); }
+template <typename T>
+void scale(T alpha, vector<T> & x) { scale(alpha, x.slice(0, x.size())); }
+
+template <typename T>
+void clamp(span<T> x, T lo, T hi) { clamp(x.data(), x.size(), lo, hi); }
+template <typename T>
+void clamp(vector<T> & x, T lo, T hi) { clamp(x.slice(0, x.size()), lo, hi); }
+
+template <typename T>
+size_t count_equal(span<T> x, typename std::remove_const<T>::type value)
+{
+   return count_equal(x.data(), x.size(), value);
+}
+template <typename T>
+size_t count_equal(const vector<T> & x, T value) { return count_equal(x.slice(0, x.size()), value); }
+
+} // namespace simd
+} // namespace custom
@@ -0,0 +1,401 @@
+/***********************************************************************
+ * Header:
+ *    SOA VECTOR
+ * Summary:
+ *    A struct-of-arrays cousin of our custom vector. Rather than storing
+ *    a contiguous array of structures, each field lives in its own
+ *    contiguous array so a loop over one field only touches that field.
+ *
+ *    This will contain the class definition of:
+ *        soa_vector              : A vector of records stored by column
+ *        soa_vector::row         : A proxy to one record across the columns
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>  // because I am paranoid
+#include <cstddef>  // for size_t
+#include <memory>   // for std::unique_ptr
+#include <tuple>    // for std::tuple
+#include <type_traits> // for std::conditional
+#include <utility>  // for std::index_sequence
+
+#include "span.h"   // for column
+
+namespace custom
+{
+
+/*****************************************
+ * SOA VECTOR
+ * Like vector <std::tuple <Ts...>>, but each
+ * field is kept in its own array. All the
+ * columns share one size and one capacity.
+ ****************************************/
+template <typename ... Ts>
+class soa_vector
+{
+   static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one field");
+
+public:
+   typedef std::tuple<Ts...> value_type;
+
+   // the type of the Ith field
+   template <size_t I>
+   using field_type = typename std::tuple_element<I, value_type>::type;
+
+   //
+   // Construct
+   //
+
+   soa_vector();
+   soa_vector(const soa_vector &  rhs);
+   soa_vector(      soa_vector && rhs);
+   ~soa_vector();
+
+   //
+   // Assign
+   //
+
+   soa_vector & operator = (const soa_vector &  rhs);
+   soa_vector & operator = (      soa_vector && rhs);
+   void swap(soa_vector & rhs)
+   {
+      std::swap(data,        rhs.data);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numCapacity, rhs.numCapacity);
+   }
+
+   //
+   // Access
+   //
+
+   class row;
+
+   row operator [] (size_t index)        { return row(this, index);  }
+   row front()                           { return row(this, 0);      }
+   row back()                            { return row(this, numElements - 1); }
+   value_type get(size_t index) const;
+
+   // contiguous access to one field
+   template <size_t I>
+   span<field_type<I>> column()
+   {
+      return span<field_type<I>>(std::get<I>(data), numElements);
+   }
+   template <size_t I>
+   span<const field_type<I>> column() const
+   {
+      return span<const field_type<I>>(std::get<I>(data), numElements);
+   }
+
+   //
+   // Insert
+   //
+
+   void push_back(const value_type & t);
+   void push_back(const Ts & ... fields) { push_back(value_type(fields...)); }
+   void reserve(size_t newCapacity);
+   void resize(size_t newElements);
+
+   //
+   // Remove
+   //
+
+   void clear()     { numElements = 0; }
+   void pop_back()
+   {
+      if (numElements > 0)
+         numElements--;
+   }
+   void shrink_to_fit();
+
+   //
+   // Status
+   //
+
+   size_t size()     const { return numElements;      }
+   size_t capacity() const { return numCapacity;      }
+   bool   empty()    const { return numElements == 0; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+
+   // move numElements items of every column into buffers of newCapacity
+   template <size_t ... Is>
+   void reallocate(size_t newCapacity, std::index_sequence<Is...>);
+   template <size_t I>
+   void moveColumn(field_type<I> * columnNew);
+   template <size_t ... Is>
+   void release(std::index_sequence<Is...>);
+   template <size_t ... Is>
+   void assign(size_t index, const value_type & t, std::index_sequence<Is...>);
+   template <size_t ... Is>
+   value_type gather(size_t index, std::index_sequence<Is...>) const;
+
+   std::tuple<Ts * ...> data;    // one dynamically-allocated array per field
+   size_t numCapacity;           // the capacity of every column
+   size_t numElements;           // the number of records currently used
+};
+
+/**************************************************
+ * SOA VECTOR :: ROW
+ * A proxy to one record. Reading a field through the
+ * proxy only touches that field's column.
+ *************************************************/
+template <typename ... Ts>
+class soa_vector <Ts...> :: row
+{
+public:
+   row(soa_vector * pSoa, size_t index) : pSoa(pSoa), index(index) { }
+
+   // access a single field of the record
+   template <size_t I>
+   field_type<I> & get() const { return std::get<I>(pSoa->data)[index]; }
+
+   // read or write the whole record
+   operator value_type () const { return pSoa->get(index); }
+   row & operator = (const value_type & t)
+   {
+      pSoa->assign(index, t, std::index_sequence_for<Ts...>());
+      return *this;
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   soa_vector * pSoa;
+   size_t index;
+};
+
+/*****************************************
+ * SOA VECTOR :: DEFAULT constructor
+ * No allocations, every column is NULL
+ ****************************************/
+template <typename ... Ts>
+soa_vector <Ts...> :: soa_vector() : data(), numCapacity(0), numElements(0)
+{
+   // std::tuple value-initializes each pointer to nullptr
+}
+
+/*****************************************
+ * SOA VECTOR :: COPY CONSTRUCTOR
+ * Allocate exactly numElements in each column
+ ****************************************/
+template <typename ... Ts>
+soa_vector <Ts...> :: soa_vector(const soa_vector & rhs) :
+   data(), numCapacity(0), numElements(0)
+{
+   *this = rhs;
+}
+
+/*****************************************
+ * SOA VECTOR :: MOVE CONSTRUCTOR
+ * Steal the columns from the RHS
+ ****************************************/
+template <typename ... Ts>
+soa_vector <Ts...> :: soa_vector(soa_vector && rhs) :
+   data(), numCapacity(0), numElements(0)
+{
+   swap(rhs);
+}
+
+/*****************************************
+ * SOA VECTOR :: DESTRUCTOR
+ * Free every column
+ ****************************************/
+template <typename ... Ts>
+soa_vector <Ts...> :: ~soa_vector()
+{
+   release(std::index_sequence_for<Ts...>());
+}
+
+/***************************************
+ * SOA VECTOR :: ASSIGNMENT
+ * Copy each column of the rhs onto *this,
+ * growing the buffers as needed
+ **************************************/
+template <typename ... Ts>
+soa_vector <Ts...> & soa_vector <Ts...> :: operator = (const soa_vector & rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   numElements = 0;
+   reserve(rhs.numElements);
+   for (size_t i = 0; i < rhs.numElements; i++)
+      assign(i, rhs.get(i), std::index_sequence_for<Ts...>());
+   numElements = rhs.numElements;
+   return *this;
+}
+
+template <typename ... Ts>
+soa_vector <Ts...> & soa_vector <Ts...> :: operator = (soa_vector && rhs)
+{
+   soa_vector empty;
+   swap(rhs);
+   rhs.swap(empty);   // our old columns are freed with "empty"
+   return *this;
+}
+
+/***************************************
+ * SOA VECTOR :: GET
+ * Gather a record from all the columns
+ **************************************/
+template <typename ... Ts>
+typename soa_vector <Ts...> :: value_type soa_vector <Ts...> :: get(size_t index) const
+{
+   assert(index < numElements);
+   return gather(index, std::index_sequence_for<Ts...>());
+}
+
+/***************************************
+ * SOA VECTOR :: PUSH BACK
+ * Scatter the record across the columns, doubling
+ * the capacity of every column as needed
+ **************************************/
+template <typename ... Ts>
+void soa_vector <Ts...> :: push_back(const value_type & t)
+{
+   if (numElements == numCapacity)
+      reserve(numCapacity == 0 ? 1 : numCapacity * 2);
+
+   assign(numElements, t, std::index_sequence_for<Ts...>());
+   numElements++;
+}
+
+/***************************************
+ * SOA VECTOR :: RESERVE
+ * Grow every column to newCapacity
+ **************************************/
+template <typename ... Ts>
+void soa_vector <Ts...> :: reserve(size_t newCapacity)
+{
+   if (newCapacity <= numCapacity)
+      return;
+
+   reallocate(newCapacity, std::index_sequence_for<Ts...>());
+}
+
+/***************************************
+ * SOA VECTOR :: RESIZE
+ * New records are value-initialized
+ **************************************/
+template <typename ... Ts>
+void soa_vector <Ts...> :: resize(size_t newElements)
+{
+   reserve(newElements);
+
+   for (size_t i = numElements; i < newElements; i++)
+      assign(i, value_type(), std::index_sequence_for<Ts...>());
+   numElements = newElements;
+}
+
+/***************************************
+ * SOA VECTOR :: SHRINK TO FIT
+ * Get rid of any extra capacity in every column
+ **************************************/
+template <typename ... Ts>
+void soa_vector <Ts...> :: shrink_to_fit()
+{
+   if (numElements == numCapacity)
+      return;
+
+   if (numElements == 0)
+   {
+      release(std::index_sequence_for<Ts...>());
+      data = std::tuple<Ts * ...>();
+      numCapacity = 0;
+      return;
+   }
+
+   reallocate(numElements, std::index_sequence_for<Ts...>());
+}
+
+/***************************************
+ * SOA VECTOR :: REALLOCATE
+ * Give every column a new buffer and move the
+ * existing records across, one column at a time.
+ * Every buffer is allocated, and every column
+ * moved, before any old buffer is freed. A
+ * column only moves if moving cannot throw, and
+ * is copied if it can, so if an allocation or a
+ * copy throws the new buffers are freed and
+ * nothing has changed.
+ **************************************/
+template <typename ... Ts>
+template <size_t ... Is>
+void soa_vector <Ts...> :: reallocate(size_t newCapacity, std::index_sequence<Is...>)
+{
+   std::tuple<std::unique_ptr<Ts[]> ...> dataNew { std::unique_ptr<Ts[]>(new Ts[newCapacity])... };
+
+   int moved[] = { 0, (moveColumn<Is>(std::get<Is>(dataNew).get()), 0)... };
+   (void)moved;
+
+   release(std::index_sequence<Is...>());
+   data = std::tuple<Ts * ...>(std::get<Is>(dataNew).release()...);
+   numCapacity = newCapacity;
+}
+
+/***************************************
+ * SOA VECTOR :: MOVE COLUMN
+ * Move the records of column I into columnNew,
+ * or copy them if a move could throw. The old
+ * buffer is left for reallocate() to free.
+ **************************************/
+template <typename ... Ts>
+template <size_t I>
+void soa_vector <Ts...> :: moveColumn(field_type<I> * columnNew)
+{
+   typedef field_type<I> F;
+   typedef typename std::conditional<std::is_nothrow_move_assignable<F>::value,
+                                     F &&, const F &>::type source;
+   F * columnOld = std::get<I>(data);
+   for (size_t i = 0; i < numElements; i++)
+      columnNew[i] = static_cast<source>(columnOld[i]);
+}
+
+/***************************************
+ * SOA VECTOR :: RELEASE
+ * Free every column
+ **************************************/
+template <typename ... Ts>
+template <size_t ... Is>
+void soa_vector <Ts...> :: release(std::index_sequence<Is...>)
+{
+   int unused[] = { 0, (delete [] std::get<Is>(data), 0)... };
+   (void)unused;
+}
+
+/***************************************
+ * SOA VECTOR :: ASSIGN
+ * Scatter one record into the columns
+ **************************************/
+template <typename ... Ts>
+template <size_t ... Is>
+void soa_vector <Ts...> :: assign(size_t index, const value_type & t,
+                                  std::index_sequence<Is...>)
+{
+   int unused[] = { 0, (std::get<Is>(data)[index] = std::get<Is>(t), 0)... };
+   (void)unused;
+}
+
+/***************************************
+ * SOA VECTOR :: GATHER
+ * Collect one record from the columns
+ **************************************/
+template <typename ... Ts>
+template <size_t ... Is>
+typename soa_vector <Ts...> :: value_type
+soa_vector <Ts...> :: gather(size_t index, std::index_sequence<Is...>) const
+{
+   return value_type(std::get<Is>(data)[index]...);
+}
+
+} // namespace custom
@@ -0,0 +1,286 @@
+/***********************************************************************
+ * Header:
+ *    SORT
+ * Summary:
+ *    Parallel sorts for our custom vector, run on the task_scheduler.
+ *
+ *    parallel_stable_sort() is a merge sort. The two halves are sorted
+ *    in parallel, and the merge itself is split as well: the middle of
+ *    the longer run is found in the other by binary search, and the two
+ *    sides merge in parallel. Elements move between the vector and one
+ *    buffer of the same size, changing places at every level, so no
+ *    level copies anything back.
+ *
+ *    parallel_sort() does not promise stability. Above a million or so
+ *    elements it is a sample sort: a sorted random sample picks a
+ *    splitter for every bucket, every element is moved once into its
+ *    bucket, and the buckets are sorted at the same time, each by one
+ *    thread. Below that, it is the merge sort with std::sort at the
+ *    leaves.
+ *
+ *    Both get their buffer the way the vector gets its own, so T needs
+ *    a default constructor and a move assignment, as the vector does.
+ *
+ *    This will contain the class definition of:
+ *        parallel_sort          : An unstable sort on every thread
+ *        parallel_stable_sort   : A stable sort on every thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>   // for std::sort, std::merge, std::upper_bound
+#include <cassert>     // because I am paranoid
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint32_t and uint64_t
+#include <functional>  // for std::less
+#include <iterator>    // for std::make_move_iterator
+#include <vector>      // for the bucket counts
+
+#include "scheduler.h" // for task_scheduler
+#include "span.h"
+#include "vector.h"
+
+namespace custom
+{
+namespace sort_detail
+{
+
+// below this, one thread and std::sort are faster than splitting
+const size_t serialCutoff = 8192;
+
+// the smallest merge worth splitting between two threads
+const size_t mergeGrain = 8192;
+
+// where parallel_sort() switches from merge sort to sample sort
+const size_t sampleCutoff = 1 << 20;
+
+// sample elements per bucket, to even out the bucket sizes
+const size_t oversample = 32;
+
+/*****************************************
+ * MERGE
+ * Move the sorted runs a and b into out, in
+ * order. On a tie a goes first, which is what
+ * keeps the sort stable.
+ ****************************************/
+template <typename T, class Compare>
+void merge(T * a, size_t na, T * b, size_t nb, T * out,
+           Compare & comp, task_scheduler & scheduler)
+{
+   if (na + nb <= mergeGrain)
+   {
+      std::merge(std::make_move_iterator(a), std::make_move_iterator(a + na),
+                 std::make_move_iterator(b), std::make_move_iterator(b + nb),
+                 out, comp);
+      return;
+   }
+
+   // split the longer run in the middle, and the other where that lands
+   size_t ma;
+   size_t mb;
+   if (na >= nb)
+   {
+      ma = na / 2;
+      mb = std::lower_bound(b, b + nb, a[ma], comp) - b;
+   }
+   else
+   {
+      mb = nb / 2;
+      ma = std::upper_bound(a, a + na, b[mb], comp) - a;
+   }
+   scheduler.invoke([&] { merge(a, ma, b, mb, out, comp, scheduler); },
+                    [&] { merge(a + ma, na - ma, b + mb, nb - mb, out + ma + mb,
+                                comp, scheduler); });
+}
+
+/*****************************************
+ * MERGE SORT
+ * Sort the n elements at a. They end up at a,
+ * or at the same place in b if toB is set.
+ * Each level puts its halves on the other
+ * side so the merge can bring them back.
+ ****************************************/
+template <typename T, class Compare>
+void mergeSort(T * a, T * b, size_t n, bool toB, bool stable, size_t leaf,
+               Compare & comp, task_scheduler & scheduler)
+{
+   if (n <= leaf)
+   {
+      if (stable)
+         std::stable_sort(a, a + n, comp);
+      else
+         std::sort(a, a + n, comp);
+      if (toB)
+         std::move(a, a + n, b);
+      return;
+   }
+
+   size_t half = n / 2;
+   scheduler.invoke([&] { mergeSort(a, b, half, !toB, stable, leaf, comp, scheduler); },
+                    [&] { mergeSort(a + half, b + half, n - half, !toB, stable, leaf,
+                                    comp, scheduler); });
+   T * from = toB ? a : b;
+   T * to   = toB ? b : a;
+   merge(from, half, from + half, n - half, to, comp, scheduler);
+}
+
+/*****************************************
+ * PARALLEL MERGE SORT
+ * Leaves small enough to give every thread
+ * several, but never below serialCutoff
+ ****************************************/
+template <typename T, class Compare>
+void parallelMergeSort(T * p, size_t n, bool stable, Compare & comp,
+                       task_scheduler & scheduler)
+{
+   vector<T> buffer(n, T());
+   size_t leaf = n / (scheduler.size() * 8);
+   if (leaf < serialCutoff)
+      leaf = serialCutoff;
+   mergeSort(p, buffer.slice(0, n).data(), n, false, stable, leaf, comp, scheduler);
+}
+
+/*****************************************
+ * SAMPLE SORT
+ *   1. sort a sample and take every
+ *      oversample-th as a splitter
+ *   2. count, block by block, how many of the
+ *      block's elements fall in each bucket
+ *   3. from the counts, where each block's
+ *      share of each bucket starts
+ *   4. move every element to its place in the
+ *      buffer
+ *   5. sort each bucket and move it back
+ * A bucket far bigger than it should be, from
+ * many equal keys, is merge sorted in parallel.
+ ****************************************/
+template <typename T, class Compare>
+void sampleSort(T * p, size_t n, Compare & comp, task_scheduler & scheduler)
+{
+   const size_t numBuckets = scheduler.size() * 4;
+   const size_t numBlocks  = scheduler.size() * 4;
+   const size_t blockSize  = (n + numBlocks - 1) / numBlocks;
+
+   // 1. the splitters, from a sample spread over the whole range
+   std::vector<T> sample;
+   sample.reserve(numBuckets * oversample);
+   uint64_t seed = 88172645463325252ull;
+   for (size_t i = 0; i < numBuckets * oversample; i++)
+   {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      sample.push_back(p[seed % n]);
+   }
+   std::sort(sample.begin(), sample.end(), comp);
+   std::vector<T> splitters;
+   for (size_t i = 1; i < numBuckets; i++)
+      splitters.push_back(sample[i * oversample]);
+
+   // 2. the bucket of every element, and how full each bucket is per block
+   std::vector<uint32_t> bucketOf(n);
+   std::vector<size_t> counts(numBlocks * numBuckets, 0);
+   scheduler.run(numBlocks, [&](size_t block)
+   {
+      size_t * count = &counts[block * numBuckets];
+      size_t end = std::min((block + 1) * blockSize, n);
+      for (size_t i = block * blockSize; i < end; i++)
+      {
+         size_t bucket = std::upper_bound(splitters.begin(), splitters.end(), p[i], comp)
+                         - splitters.begin();
+         bucketOf[i] = uint32_t(bucket);
+         count[bucket]++;
+      }
+   });
+
+   // 3. bucket by bucket, then block by block within it
+   std::vector<size_t> bucketStart(numBuckets + 1, 0);
+   size_t offset = 0;
+   for (size_t bucket = 0; bucket < numBuckets; bucket++)
+   {
+      bucketStart[bucket] = offset;
+      for (size_t block = 0; block < numBlocks; block++)
+      {
+         size_t num = counts[block * numBuckets + bucket];
+         counts[block * numBuckets + bucket] = offset;
+         offset += num;
+      }
+   }
+   bucketStart[numBuckets] = offset;
+   assert(offset == n);
+
+   // 4. every block moves its own elements, so the blocks run in parallel
+   vector<T> buffer(n, T());
+   T * out = buffer.slice(0, n).data();
+   scheduler.run(numBlocks, [&](size_t block)
+   {
+      size_t * next = &counts[block * numBuckets];
+      size_t end = std::min((block + 1) * blockSize, n);
+      for (size_t i = block * blockSize; i < end; i++)
+         out[next[bucketOf[i]]++] = std::move(p[i]);
+   });
+
+   // 5. each bucket is sorted in the buffer and moved back to the same place
+   const size_t tooBig = 4 * (n / numBuckets);
+   scheduler.run(numBuckets, [&](size_t bucket)
+   {
+      size_t begin = bucketStart[bucket];
+      size_t num = bucketStart[bucket + 1] - begin;
+      if (num > tooBig && num > serialCutoff)
+         parallelMergeSort(out + begin, num, false, comp, scheduler);
+      else
+         std::sort(out + begin, out + begin + num, comp);
+      std::move(out + begin, out + begin + num, p + begin);
+   });
+}
+
+} // namespace sort_detail
+
+/*****************************************
+ * PARALLEL SORT
+ * Sample sort when big enough, else merge
+ * sort, else std::sort
+ ****************************************/
+template <typename T, class Compare = std::less<T>>
+void parallel_sort(span<T> s, Compare comp = Compare(),
+                   task_scheduler & scheduler = task_scheduler::instance())
+{
+   if (s.size() <= sort_detail::serialCutoff || scheduler.size() == 1)
+      std::sort(s.begin(), s.end(), comp);
+   else if (s.size() < sort_detail::sampleCutoff)
+      sort_detail::parallelMergeSort(s.data(), s.size(), false, comp, scheduler);
+   else
+      sort_detail::sampleSort(s.data(), s.size(), comp, scheduler);
+}
+
+template <typename T, class Compare = std::less<T>>
+void parallel_sort(vector<T> & v, Compare comp = Compare(),
+                   task_scheduler & scheduler = task_scheduler::instance())
+{
+   parallel_sort(v.slice(0, v.size()), comp, scheduler);
+}
+
+/*****************************************
+ * PARALLEL STABLE SORT
+ * Equal elements keep their order
+ ****************************************/
+template <typename T, class Compare = std::less<T>>
+void parallel_stable_sort(span<T> s, Compare comp = Compare(),
+                          task_scheduler & scheduler = task_scheduler::instance())
+{
+   if (s.size() <= sort_detail::serialCutoff || scheduler.size() == 1)
+      std::stable_sort(s.begin(), s.end(), comp);
+   else
+      sort_detail::parallelMergeSort(s.data(), s.size(), true, comp, scheduler);
+}
+
+template <typename T, class Compare = std::less<T>>
+void parallel_stable_sort(vector<T> & v, Compare comp = Compare(),
+                          task_scheduler & scheduler = task_scheduler::instance())
+{
+   parallel_stable_sort(v.slice(0, v.size()), comp, scheduler);
+}
+
+} // namespace custom
@@ -0,0 +1,235 @@
+/***********************************************************************
+ * Header:
+ *    SPAN
+ * Summary:
+ *    Views of part of a vector that do not own or copy the elements.
+ *    A span is a pointer and a count, the same thing std::span is in
+ *    C++20, so a kernel that takes a span works on a whole vector, a
+ *    slice of one, a column of a soa_vector, or a std::vector without
+ *    caring which. A strided_view is every k-th element of a span, such
+ *    as one channel of interleaved samples.
+ *
+ *    Neither keeps the elements alive: anything that reallocates the
+ *    vector underneath, such as push_back or reserve, invalidates them.
+ *
+ *    This will contain the class definition of:
+ *        span                   : A contiguous run of elements
+ *        strided_view           : Every k-th element of a run
+ *        strided_view::iterator : An iterator through a strided view
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>      // because I am paranoid
+#include <cstddef>      // for size_t
+#include <type_traits>  // for std::enable_if
+#include <utility>      // for std::declval
+
+namespace custom
+{
+
+template <typename T>
+class strided_view;
+
+/*****************************************
+ * SPAN
+ * A pointer to the first element and the
+ * number of elements. Copying a span copies
+ * the view, never the elements.
+ ****************************************/
+template <typename T>
+class span
+{
+public:
+   typedef T                                     element_type;
+   typedef typename std::remove_const<T>::type   value_type;
+   typedef T *                                   iterator;
+
+   //
+   // Construct
+   //
+
+   span() : p(nullptr), num(0)                   { }
+   span(T * p, size_t num) : p(p), num(num)      { }
+   template <size_t N>
+   span(T (& array)[N]) : p(array), num(N)       { }
+
+   // a span of T is also a span of const T
+   template <typename U,
+             typename = typename std::enable_if<std::is_convertible<U (*)[], T (*)[]>::value>::type>
+   span(const span<U> & rhs) : p(rhs.data()), num(rhs.size()) { }
+
+   // anything contiguous with data() and size(), such as std::vector
+   template <typename Container,
+             typename = typename std::enable_if<std::is_convertible<
+                decltype(std::declval<Container &>().data()), T *>::value>::type>
+   span(Container & c) : p(c.data()), num(c.size()) { }
+
+   //
+   // Access
+   //
+
+   T & operator [] (size_t index) const
+   {
+      assert(index < num);
+      return p[index];
+   }
+   T & front() const { assert(num); return p[0];       }
+   T & back()  const { assert(num); return p[num - 1]; }
+   T * data()  const { return p;                       }
+
+   iterator begin() const { return p;       }
+   iterator end()   const { return p + num; }
+
+   //
+   // Views
+   //
+
+   span subspan(size_t offset, size_t count) const
+   {
+      assert(offset <= num && count <= num - offset);
+      return span(p + offset, count);
+   }
+   span subspan(size_t offset) const { return subspan(offset, num - offset); }
+   span first(size_t count)    const { return subspan(0, count);             }
+   span last(size_t count)     const { return subspan(num - count, count);   }
+
+   // every stride-th element, starting at offset
+   strided_view<T> strided(size_t stride, size_t offset = 0) const;
+
+   //
+   // Status
+   //
+
+   size_t size()       const { return num;             }
+   size_t size_bytes() const { return num * sizeof(T); }
+   bool   empty()      const { return num == 0;        }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   T *    p;     // the first element
+   size_t num;   // the number of elements
+};
+
+/*****************************************
+ * STRIDED VIEW
+ * Element i is p[i * stride]. A stride of 1
+ * is a span, and a kernel can check for that
+ * and take its contiguous path.
+ ****************************************/
+template <typename T>
+class strided_view
+{
+public:
+   class iterator;
+
+   //
+   // Construct
+   //
+
+   strided_view() : p(nullptr), num(0), step(1)  { }
+   strided_view(T * p, size_t num, size_t step) : p(p), num(num), step(step)
+   {
+      assert(step > 0);
+   }
+
+   //
+   // Access
+   //
+
+   T & operator [] (size_t index) const
+   {
+      assert(index < num);
+      return p[index * step];
+   }
+   T * data() const { return p; }
+
+   iterator begin() const { return iterator(p, 0,   step); }
+   iterator end()   const { return iterator(p, num, step); }
+
+   // the same elements as a span, which only works for a stride of 1
+   bool    is_contiguous() const { return step == 1 || num <= 1; }
+   span<T> contiguous()    const
+   {
+      assert(is_contiguous());
+      return span<T>(p, num);
+   }
+
+   //
+   // Status
+   //
+
+   size_t size()   const { return num;      }
+   size_t stride() const { return step;     }
+   bool   empty()  const { return num == 0; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   T *    p;      // the first element
+   size_t num;    // how many elements are in the view
+   size_t step;   // elements of T from one to the next
+};
+
+/**************************************************
+ * STRIDED VIEW ITERATOR
+ * Counts elements rather than moving a pointer, so
+ * end() never points past the end of the array
+ *************************************************/
+template <typename T>
+class strided_view <T> :: iterator
+{
+public:
+   iterator() : p(nullptr), index(0), step(1) { }
+   iterator(T * p, size_t index, size_t step) :
+      p(p), index(index), step(step)          { }
+
+   bool operator != (const iterator & rhs) const { return index != rhs.index; }
+   bool operator == (const iterator & rhs) const { return index == rhs.index; }
+
+   T & operator * () const { return p[index * step]; }
+
+   iterator & operator ++ ()
+   {
+      index++;
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator tmp(*this);
+      index++;
+      return tmp;
+   }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   T *    p;
+   size_t index;
+   size_t step;
+};
+
+/*****************************************
+ * SPAN :: STRIDED
+ * The view holds ceil((size - offset) / stride)
+ * elements, so the last one is in the span
+ ****************************************/
+template <typename T>
+strided_view<T> span <T> :: strided(size_t stride, size_t offset) const
+{
+   assert(stride > 0);
+   if (offset >= num)
+      return strided_view<T>(p, 0, stride);
+   return strided_view<T>(p + offset, (num - offset + stride - 1) / stride, stride);
+}
+
+} // namespace custom
@@ -0,0 +1,203 @@
+/***********************************************************************
+ * Header:
+ *    TEST ALIGNED VECTOR
+ * Summary:
+ *    Unit tests for aligned_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "aligned_vector.h"   // class under test
+#include "unitTest.h"         // unit test baseclass
+
+#include <cstdint>            // for uintptr_t
+
+/***********************************************
+ * TEST ALIGNED VECTOR
+ * Unit tests for the aligned_vector class
+ ***********************************************/
+class TestAlignedVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_sizeFour();
+      test_constructInit_standard();
+
+      // Insert
+      test_pushback_empty();
+      test_reserve_roundsUp();
+      test_resize_shrinkClearsTail();
+
+      // Access
+      test_assumeAligned_standard();
+      test_paddedSize_standard();
+
+      // Remove
+      test_popback_clearsSlot();
+      test_shrink_wholeBlocks();
+
+      report("AlignedVector");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {
+      // exercise
+      custom::aligned_vector<int, 64> v;
+      // verify
+      assertUnit(v.data == nullptr);
+      assertUnit(v.numElements == 0);
+      assertUnit(v.numCapacity == 0);
+   }  // teardown
+
+   // four ints take one 64-byte block of sixteen
+   void test_construct_sizeFour()
+   {
+      // exercise
+      custom::aligned_vector<int, 64> v(4);
+      // verify
+      assertUnit(isAligned(v.data, 64));
+      assertUnit(v.numElements == 4);
+      assertUnit(v.numCapacity == 16);
+      for (size_t i = 0; i < v.numCapacity; i++)
+         assertUnit(v.data[i] == 0);
+   }  // teardown
+
+   // an initializer list is copied in order
+   void test_constructInit_standard()
+   {
+      // exercise
+      custom::aligned_vector<double, 32> v{ 2.6, 4.9, 6.7, 8.9 };
+      // verify
+      assertUnit(isAligned(v.data, 32));
+      assertUnit(v.numElements == 4);
+      assertUnit(v.numCapacity == 4);
+      assertUnit(v.data[0] == 2.6);
+      assertUnit(v.data[3] == 8.9);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // the first push allocates a whole block
+   void test_pushback_empty()
+   {  // setup
+      custom::aligned_vector<int, 64> v;
+      // exercise
+      v.push_back(26);
+      // verify
+      assertUnit(isAligned(v.data, 64));
+      assertUnit(v.numElements == 1);
+      assertUnit(v.numCapacity == 16);
+      assertUnit(v.data[0] == 26);
+   }  // teardown
+
+   // reserve never leaves a partial block
+   void test_reserve_roundsUp()
+   {  // setup
+      custom::aligned_vector<int, 64> v{ 26, 49, 67, 89 };
+      // exercise
+      v.reserve(17);
+      // verify
+      assertUnit(isAligned(v.data, 64));
+      assertUnit(v.numCapacity == 32);
+      assertUnit(v.numElements == 4);
+      assertUnit(v.data[3] == 89);
+   }  // teardown
+
+   // shrinking the size puts T() back in the tail
+   void test_resize_shrinkClearsTail()
+   {  // setup
+      custom::aligned_vector<int, 64> v(4, 99);
+      // exercise
+      v.resize(2);
+      // verify
+      assertUnit(v.numElements == 2);
+      assertUnit(v.data[1] == 99);
+      assertUnit(v.data[2] == 0);
+      assertUnit(v.data[3] == 0);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // the aligned accessor is the buffer itself
+   void test_assumeAligned_standard()
+   {  // setup
+      custom::aligned_vector<float, 64> v(5, 1.0f);
+      // exercise
+      const float * p = v.assume_aligned();
+      float sum = 0.0f;
+      for (size_t i = 0; i < v.padded_size(); i++)
+         sum += p[i];
+      // verify
+      assertUnit(p == v.data);
+      assertUnit(sum == 5.0f);
+   }  // teardown
+
+   // padded size is the size rounded to a whole block
+   void test_paddedSize_standard()
+   {  // setup
+      custom::aligned_vector<double, 64> v(9);
+      // exercise
+      size_t padded = v.padded_size();
+      // verify
+      assertUnit(v.lanes() == 8);
+      assertUnit(padded == 16);
+      assertUnit(padded <= v.numCapacity);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // pop back zeros the slot it gave up
+   void test_popback_clearsSlot()
+   {  // setup
+      custom::aligned_vector<int, 64> v{ 26, 49, 67, 89 };
+      // exercise
+      v.pop_back();
+      // verify
+      assertUnit(v.numElements == 3);
+      assertUnit(v.data[3] == 0);
+   }  // teardown
+
+   // shrink only frees whole blocks
+   void test_shrink_wholeBlocks()
+   {  // setup
+      custom::aligned_vector<int, 64> v{ 26, 49, 67, 89 };
+      v.reserve(100);
+      // exercise
+      v.shrink_to_fit();
+      // verify
+      assertUnit(isAligned(v.data, 64));
+      assertUnit(v.numCapacity == 16);
+      assertUnit(v.numElements == 4);
+      assertUnit(v.data[0] == 26);
+   }  // teardown
+
+   /*************************************************************
+    * IS ALIGNED
+    *************************************************************/
+   static bool isAligned(const void * p, size_t align)
+   {
+      return p != nullptr && reinterpret_cast<uintptr_t>(p) % align == 0;
+   }
+};
+
+#endif // DEBUG
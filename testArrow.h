@@ -0,0 +1,443 @@
+/***********************************************************************
+ * Header:
+ *    TEST ARROW
+ * Summary:
+ *    Unit tests for the Arrow export, import, and IPC files
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "arrow.h"        // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <cstdio>         // for std::remove
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>      // for std::move
+
+/***********************************************
+ * TEST ARROW
+ * Unit tests for export_arrow, import_arrow, arrow_view,
+ * arrow_file_writer, and arrow_file_reader
+ ***********************************************/
+class TestArrow : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Export
+      test_export_zeroCopy();
+      test_export_release();
+
+      // Import
+      test_import_fromExport();
+      test_import_offsetAndGrow();
+      test_import_nulls();
+
+      // View
+      test_view_fromExport();
+      test_view_offsetAndNulls();
+      test_view_wrongType();
+
+      // File
+      test_file_roundTrip();
+      test_file_empty();
+      test_file_fromArrow();
+      test_file_wrongType();
+      test_file_notArrow();
+
+      report("Arrow");
+   }
+
+   /***************************************
+    * EXPORT
+    ***************************************/
+
+   // the exported array points at the vector's own buffer
+   void test_export_zeroCopy()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      const int32_t * pBuffer = &v[0];
+      ArrowArray array;
+      ArrowSchema schema;
+      // exercise
+      custom::export_arrow(v, &array, &schema);
+      // verify
+      assertUnit(v.size() == 0);
+      assertUnit(array.length == 4);
+      assertUnit(array.null_count == 0);
+      assertUnit(array.n_buffers == 2);
+      assertUnit(array.buffers[0] == nullptr);
+      assertUnit(array.buffers[1] == pBuffer);
+      assertUnit(std::string(schema.format) == "i");
+      // teardown
+      array.release(&array);
+      schema.release(&schema);
+   }
+
+   // release() marks the array released
+   void test_export_release()
+   {  // setup
+      custom::vector<double> v;
+      v.push_back(3.5);
+      ArrowArray array;
+      custom::export_arrow(v, &array);
+      // exercise
+      array.release(&array);
+      // verify
+      assertUnit(array.release == nullptr);
+   }  // teardown
+
+   /***************************************
+    * IMPORT
+    ***************************************/
+
+   // an exported vector comes back as the same buffer
+   void test_import_fromExport()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      const int32_t * pBuffer = &v[0];
+      ArrowArray array;
+      ArrowSchema schema;
+      custom::export_arrow(v, &array, &schema);
+      // exercise
+      custom::vector<int32_t> vImported = custom::import_arrow<int32_t>(std::move(array), &schema);
+      // verify
+      assertUnit(array.release == nullptr);   // the vector has it now
+      assertUnit(&vImported[0] == pBuffer);
+      assertStandardFixture(vImported);
+      // teardown
+      schema.release(&schema);
+   }
+
+   // the offset is honored, and growing the vector releases the array
+   void test_import_offsetAndGrow()
+   {  // setup
+      static int64_t values[] = { 0, 26, 49, 67, 89 };
+      static const void * buffers[] = { nullptr, values };
+      static bool released = false;
+      struct Release { static void release(ArrowArray * a) { released = true; a->release = nullptr; } };
+      ArrowArray array = { 4, 0, 1, 2, 0, buffers, nullptr, nullptr, &Release::release, nullptr };
+      released = false;
+      // exercise
+      custom::vector<int64_t> v = custom::import_arrow<int64_t>(std::move(array));
+      // verify
+      assertUnit(v.size() == 4);
+      assertUnit(&v[0] == values + 1);
+      assertUnit(v[0] == 26);
+      assertUnit(v[3] == 89);
+      assertUnit(!released);
+      v.push_back(99);
+      assertUnit(released);
+      assertUnit(v.size() == 5);
+      assertUnit(v[0] == 26);
+      assertUnit(v[4] == 99);
+      assertUnit(values[1] == 26);
+   }  // teardown
+
+   // an array with a null is refused, and released
+   void test_import_nulls()
+   {  // setup
+      static int64_t values[] = { 26, 49, 67, 89 };
+      static unsigned char validity[] = { 0x0d };   // 1101: element 1 is null
+      static const void * buffers[] = { validity, values };
+      static bool released = false;
+      struct Release { static void release(ArrowArray * a) { released = true; a->release = nullptr; } };
+      ArrowArray array = { 4, -1, 0, 2, 0, buffers, nullptr, nullptr, &Release::release, nullptr };
+      released = false;
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::import_arrow<int64_t>(std::move(array));
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertUnit(released);
+      assertUnit(array.release == nullptr);
+   }  // teardown
+
+   /***************************************
+    * VIEW
+    ***************************************/
+
+   // a view of an exported vector sees the same buffer, and owns it
+   void test_view_fromExport()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      const int32_t * pBuffer = &v[0];
+      ArrowArray array;
+      ArrowSchema schema;
+      custom::export_arrow(v, &array, &schema);
+      // exercise
+      {
+         custom::arrow_view<int32_t> view(&array, &schema);
+         // verify
+         assertUnit(array.release == nullptr);   // the view has it now
+         assertUnit(view.begin() == pBuffer);
+         assertUnit(view.null_count() == 0);
+         assertStandardFixture(view);
+      }
+      // teardown
+      schema.release(&schema);
+   }
+
+   // Arrow's offset and validity bitmap are honored
+   void test_view_offsetAndNulls()
+   {  // setup
+      static int64_t values[] = { 0, 26, 49, 67, 89 };
+      static unsigned char validity[] = { 0x1b };   // 11011: element 2 is null
+      static const void * buffers[] = { validity, values };
+      static bool released = false;
+      struct Release { static void release(ArrowArray * a) { released = true; a->release = nullptr; } };
+      ArrowArray array = { 4, -1, 1, 2, 0, buffers, nullptr, nullptr, &Release::release, nullptr };
+      released = false;
+      // exercise
+      {
+         custom::arrow_view<int64_t> view(&array);
+         // verify
+         assertUnit(view.size() == 4);
+         assertUnit(view[0] == 26);
+         assertUnit(view[3] == 89);
+         assertUnit(view.is_valid(0));
+         assertUnit(!view.is_valid(1));
+         assertUnit(view.is_valid(2));
+         assertUnit(view.null_count() == 1);
+         assertUnit(!released);
+      }
+      assertUnit(released);
+   }  // teardown
+
+   // an array of another type is refused, and released
+   void test_view_wrongType()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      ArrowArray array;
+      ArrowSchema schema;
+      custom::export_arrow(v, &array, &schema);
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::arrow_view<float> view(&array, &schema);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertUnit(array.release == nullptr);
+      // teardown
+      schema.release(&schema);
+   }
+
+   /***************************************
+    * FILE
+    ***************************************/
+
+   // what we write, we read back batch by batch
+   void test_file_roundTrip()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      custom::vector<int32_t> vOne;
+      vOne.push_back(99);
+      {
+         custom::arrow_file_writer<int32_t> writer(FILE_NAME, "numbers");
+         writer.write(v);
+         writer.write(vOne);
+      }
+      custom::vector<int32_t> vBatch;
+      custom::vector<int32_t> vAll;
+      // exercise
+      custom::arrow_file_reader<int32_t> reader(FILE_NAME);
+      reader.read(0, vBatch);
+      reader.read_all(vAll);
+      // verify
+      assertUnit(reader.num_batches() == 2);
+      assertUnit(reader.column_name() == "numbers");
+      assertStandardFixture(vBatch);
+      assertUnit(vAll.size() == 5);
+      assertUnit(vAll.size() == 5 && vAll[0] == 26 && vAll[4] == 99);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file with no batches is still a file
+   void test_file_empty()
+   {  // setup
+      {
+         custom::arrow_file_writer<double> writer(FILE_NAME);
+      }
+      custom::vector<double> v;
+      v.push_back(3.5);
+      // exercise
+      custom::arrow_file_reader<double> reader(FILE_NAME);
+      reader.read_all(v);
+      // verify
+      assertUnit(reader.num_batches() == 0);
+      assertUnit(v.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file written by Arrow itself (pyarrow: one int32 column "n")
+   void test_file_fromArrow()
+   {  // setup
+      writeArrowFixture();
+      custom::vector<int32_t> v;
+      // exercise
+      custom::arrow_file_reader<int32_t> reader(FILE_NAME);
+      reader.read_all(v);
+      // verify
+      assertUnit(reader.column_name() == "n");
+      assertStandardFixture(v);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // an int32 column is not a column of doubles
+   void test_file_wrongType()
+   {  // setup
+      writeArrowFixture();
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::arrow_file_reader<double> reader(FILE_NAME);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file in our own format is not an Arrow file
+   void test_file_notArrow()
+   {  // setup
+      custom::vector<int32_t> v;
+      setupStandardFixture(v);
+      custom::save(std::string(FILE_NAME), v);
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::arrow_file_reader<int32_t> reader(FILE_NAME);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::vector<int32_t> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   template <class V>
+   void assertStandardFixtureParameters(const V & v, int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+
+   /*************************************************************
+    * WRITE ARROW FIXTURE
+    * The standard fixture, as pyarrow writes it
+    *************************************************************/
+   static void writeArrowFixture()
+   {
+      static const unsigned char bytes[] =
+      {
+         0x41, 0x52, 0x52, 0x4f, 0x57, 0x31, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+         0x78, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00,
+         0x0c, 0x00, 0x06, 0x00, 0x05, 0x00, 0x08, 0x00, 0x0a, 0x00, 0x00, 0x00,
+         0x00, 0x01, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x08, 0x00,
+         0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+         0x01, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x10, 0x00, 0x14, 0x00,
+         0x08, 0x00, 0x06, 0x00, 0x07, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x10, 0x00,
+         0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x10, 0x00, 0x00, 0x00,
+         0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x01, 0x00, 0x00, 0x00, 0x6e, 0x00, 0x00, 0x00, 0x08, 0x00, 0x0c, 0x00,
+         0x08, 0x00, 0x07, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+         0x20, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x88, 0x00, 0x00, 0x00,
+         0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x16, 0x00,
+         0x06, 0x00, 0x05, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00,
+         0x00, 0x03, 0x04, 0x00, 0x18, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x18, 0x00, 0x0c, 0x00,
+         0x04, 0x00, 0x08, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00,
+         0x10, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+         0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00,
+         0x43, 0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+         0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x14, 0x00,
+         0x06, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x04, 0x00, 0x34, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00,
+         0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x88, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+         0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,
+         0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+         0x10, 0x00, 0x14, 0x00, 0x08, 0x00, 0x06, 0x00, 0x07, 0x00, 0x0c, 0x00,
+         0x00, 0x00, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+         0x10, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x6e, 0x00, 0x00, 0x00,
+         0x08, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x07, 0x00, 0x08, 0x00, 0x00, 0x00,
+         0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x00, 0xa0, 0x00, 0x00, 0x00,
+         0x41, 0x52, 0x52, 0x4f, 0x57, 0x31,      };
+      std::ofstream fout(FILE_NAME, std::ios::binary | std::ios::trunc);
+      fout.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+   }
+
+   static constexpr const char * FILE_NAME = "testArrow.arrow";
+};
+
+#endif // DEBUG
@@ -0,0 +1,357 @@
+/***********************************************************************
+ * Header:
+ *    TEST CHECKPOINT
+ * Summary:
+ *    Unit tests for tracked_vector and the checkpoint files
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "checkpoint.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <cstdio>         // for std::remove
+#include <fstream>
+#include <string>
+
+/***********************************************
+ * TEST CHECKPOINT
+ * Unit tests for tracked_vector, save_base,
+ * save_delta, and apply_delta
+ ***********************************************/
+class TestCheckpoint : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+#ifndef _WIN32
+      // Track
+      test_track_subscript();
+      test_track_constRead();
+      test_track_iterator();
+      test_track_pushBack();
+      test_track_resize();
+
+      // Save
+      test_saveBase_roundTrip();
+      test_saveDelta_onlyDirty();
+
+      // Apply
+      test_applyDelta_standard();
+      test_applyDelta_shrink();
+      test_applyDelta_corrupt();
+      test_applyDelta_hugeCount();
+#endif // !_WIN32
+
+      report("Checkpoint");
+   }
+
+#ifndef _WIN32
+   /***************************************
+    * TRACK
+    ***************************************/
+
+   // writing through [] marks just that page
+   void test_track_subscript()
+   {  // setup
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      v.resize(16);
+      v.mark_clean();
+      // exercise
+      v[5] = 99;
+      v[6] = 99;
+      // verify
+      assertUnit(v.dirty_pages() == 1);
+      assertUnit(v.is_dirty(1));
+      assertUnit(!v.is_dirty(0));
+      assertUnit(!v.is_dirty(2));
+   }  // teardown
+
+   // reading through a const reference marks nothing
+   void test_track_constRead()
+   {  // setup
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      v.resize(16);
+      v.mark_clean();
+      const custom::tracked_vector<int> & cv = v;
+      // exercise
+      int sum = cv[0] + cv[9] + cv.front() + cv.back();
+      // verify
+      assertUnit(sum == 0);
+      assertUnit(v.dirty_pages() == 0);
+   }  // teardown
+
+   // an iterator cannot tell a read from a write
+   void test_track_iterator()
+   {  // setup
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      v.resize(8);
+      v.mark_clean();
+      // exercise
+      custom::tracked_vector<int>::iterator it = v.begin();
+      ++it;
+      *it = 99;
+      // verify
+      assertUnit(v[1] == 99);
+      assertUnit(v.dirty_pages() == 1);
+      assertUnit(v.is_dirty(0));
+   }  // teardown
+
+   // appending marks the page at the end
+   void test_track_pushBack()
+   {  // setup
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      v.mark_clean();
+      // exercise
+      v.push_back(99);
+      // verify
+      assertUnit(v.size() == 5);
+      assertUnit(v.dirty_pages() == 1);
+      assertUnit(v.is_dirty(1));
+   }  // teardown
+
+   // growing marks every new page, shrinking marks none
+   void test_track_resize()
+   {  // setup
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      v.mark_clean();
+      // exercise
+      v.resize(13);
+      size_t dirtyGrow = v.dirty_pages();
+      v.mark_clean();
+      v.resize(2);
+      // verify
+      assertUnit(dirtyGrow == 3);
+      assertUnit(v.dirty_pages() == 0);
+      assertUnit(v.size() == 2);
+   }  // teardown
+
+   /***************************************
+    * SAVE
+    ***************************************/
+
+   // a base file reads back to the same vector
+   void test_saveBase_roundTrip()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      custom::tracked_vector<int> vLoad(4 * sizeof(int));
+      // exercise
+      custom::save_base(BASE_NAME, v);
+      custom::load_base(BASE_NAME, vLoad);
+      // verify
+      assertUnit(v.dirty_pages() == 0);
+      assertStandardFixture(vLoad);
+      assertUnit(vLoad.dirty_pages() == 0);
+      assertUnit(vLoad.page_elements() == 4);
+      assertUnit(fileSize(BASE_NAME) == 40 + 4 * sizeof(int));
+      // teardown
+      cleanup();
+   }
+
+   // a delta holds only the pages that changed
+   void test_saveDelta_onlyDirty()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      v.resize(64);
+      custom::save_base(BASE_NAME, v);
+      // exercise
+      v[10] = 99;
+      v[50] = 99;
+      custom::save_delta(DELTA_NAME, v);
+      // verify
+      assertUnit(v.dirty_pages() == 0);
+      assertUnit(fileSize(DELTA_NAME) == 40 + 2 * (24 + 4 * sizeof(int)));
+      // teardown
+      cleanup();
+   }
+
+   /***************************************
+    * APPLY
+    ***************************************/
+
+   // base plus deltas is the vector as it is now
+   void test_applyDelta_standard()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      v.resize(10);
+      custom::save_base(BASE_NAME, v);
+      v[1] = 26;
+      v[9] = 49;
+      custom::save_delta(DELTA_NAME, v);
+      custom::apply_delta(BASE_NAME, DELTA_NAME);
+      v.push_back(67);
+      v[0] = 89;
+      custom::save_delta(DELTA_NAME, v);
+      custom::tracked_vector<int> vLoad;
+      // exercise
+      custom::apply_delta(BASE_NAME, DELTA_NAME);
+      custom::load_base(BASE_NAME, vLoad);
+      // verify
+      assertUnit(vLoad.size() == 11);
+      if (vLoad.size() == 11)
+      {
+         const custom::tracked_vector<int> & cv = vLoad;
+         assertUnit(cv[0] == 89);
+         assertUnit(cv[1] == 26);
+         assertUnit(cv[2] == 0);
+         assertUnit(cv[9] == 49);
+         assertUnit(cv[10] == 67);
+      }
+      // teardown
+      cleanup();
+   }
+
+   // a shorter vector shortens the base, even with no dirty pages
+   void test_applyDelta_shrink()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      v.push_back(99);
+      custom::save_base(BASE_NAME, v);
+      v.pop_back();
+      custom::save_delta(DELTA_NAME, v);
+      custom::tracked_vector<int> vLoad;
+      // exercise
+      custom::apply_delta(BASE_NAME, DELTA_NAME);
+      custom::load_base(BASE_NAME, vLoad);
+      // verify
+      assertUnit(fileSize(DELTA_NAME) == 40);
+      assertStandardFixture(vLoad);
+      assertUnit(fileSize(BASE_NAME) == 40 + 4 * sizeof(int));
+      // teardown
+      cleanup();
+   }
+
+   // a damaged delta leaves the base alone
+   void test_applyDelta_corrupt()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      custom::save_base(BASE_NAME, v);
+      v[0] = 99;
+      custom::save_delta(DELTA_NAME, v);
+      {
+         std::fstream f(DELTA_NAME, std::ios::binary | std::ios::in | std::ios::out);
+         f.seekp(40 + 24);   // the first element of the first page
+         f.put('\x7f');
+      }
+      bool threw = false;
+      custom::tracked_vector<int> vLoad;
+      // exercise
+      try
+      {
+         custom::apply_delta(BASE_NAME, DELTA_NAME);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      custom::load_base(BASE_NAME, vLoad);
+      // verify
+      assertUnit(threw);
+      assertStandardFixture(vLoad);
+      // teardown
+      cleanup();
+   }
+
+   // a header claiming more pages than the delta holds is refused before allocating
+   void test_applyDelta_hugeCount()
+   {  // setup
+      cleanup();
+      custom::tracked_vector<int> v(4 * sizeof(int));
+      setupStandardFixture(v);
+      custom::save_base(BASE_NAME, v);
+      v[0] = 99;
+      custom::save_delta(DELTA_NAME, v);
+      {
+         uint64_t count    = uint64_t(1) << 40;
+         uint64_t numPages = uint64_t(1) << 38;
+         std::fstream f(DELTA_NAME, std::ios::binary | std::ios::in | std::ios::out);
+         f.seekp(24);   // count, then numPages
+         f.write(reinterpret_cast<const char *>(&count),    sizeof(count));
+         f.write(reinterpret_cast<const char *>(&numPages), sizeof(numPages));
+      }
+      bool threw = false;
+      custom::tracked_vector<int> vLoad;
+      // exercise
+      try
+      {
+         custom::apply_delta(BASE_NAME, DELTA_NAME);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      custom::load_base(BASE_NAME, vLoad);
+      // verify
+      assertUnit(threw);
+      assertStandardFixture(vLoad);
+      // teardown
+      cleanup();
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::tracked_vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::tracked_vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+
+   /*************************************************************
+    * FILE HELPERS
+    *************************************************************/
+   static void cleanup()
+   {
+      std::remove(BASE_NAME);
+      std::remove(DELTA_NAME);
+   }
+   static size_t fileSize(const std::string & fileName)
+   {
+      std::ifstream fin(fileName, std::ios::binary | std::ios::ate);
+      return fin ? size_t(fin.tellg()) : 0;
+   }
+
+   static constexpr const char * BASE_NAME  = "testCheckpoint.base";
+   static constexpr const char * DELTA_NAME = "testCheckpoint.delta";
+#endif // !_WIN32
+};
+
+#endif // DEBUG
@@ -0,0 +1,344 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMPACT
+ * Summary:
+ *    Unit tests for copy_if, remove_if and partition in compact.h
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "compact.h"    // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+#include <string>
+
+/***********************************************
+ * TEST COMPACT
+ * Unit tests for the compaction kernels, on one
+ * thread and on every thread
+ ***********************************************/
+class TestCompact : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Copy If
+      test_copyIf_standard();
+      test_copyIf_lambda();
+      test_copyIf_none();
+      test_copyIf_strings();
+      test_copyIf_levelsAgree();
+      test_copyIf_tightRoom();
+
+      // Remove If
+      test_removeIf_standard();
+      test_removeIf_long();
+
+      // Partition
+      test_partition_standard();
+      test_partition_stable();
+
+      // Parallel
+      test_parallel_copyIf();
+      test_parallel_removeIf();
+      test_parallel_partition();
+
+      report("Compact");
+   }
+
+   /***************************************
+    * COPY IF
+    ***************************************/
+
+   // what is over 50, in order, and out shrinks to fit
+   void test_copyIf_standard()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      size_t num = custom::copy_if(v, out, custom::where::greater(50));
+      // verify
+      assertUnit(num == 2);
+      assertUnit(out.size() == 2);
+      assertUnit(out[0] == 67);
+      assertUnit(out[1] == 89);
+   }  // teardown
+
+   // any predicate works, through the scalar loop
+   void test_copyIf_lambda()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      size_t num = custom::copy_if(v, out, [](int x) { return x % 2 == 1; });
+      // verify
+      assertUnit(num == 3);
+      assertUnit(out[0] == 49);
+      assertUnit(out[1] == 67);
+      assertUnit(out[2] == 89);
+   }  // teardown
+
+   // nothing kept, and nothing to keep
+   void test_copyIf_none()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> empty;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      size_t num = custom::copy_if(v, out, custom::where::less(0));
+      size_t none = custom::copy_if(empty, out, custom::where::less(0));
+      // verify
+      assertUnit(num == 0);
+      assertUnit(none == 0);
+      assertUnit(out.size() == 0);
+   }  // teardown
+
+   // elements that are not numbers are only copied when kept
+   void test_copyIf_strings()
+   {  // setup
+      custom::vector<std::string> v;
+      custom::vector<std::string> out;
+      v.push_back("apple");
+      v.push_back("");
+      v.push_back("cherry");
+      // exercise
+      size_t num = custom::copy_if(v, out, [](const std::string & s) { return !s.empty(); });
+      // verify
+      assertUnit(num == 2);
+      assertUnit(out[0] == "apple");
+      assertUnit(out[1] == "cherry");
+   }  // teardown
+
+   // every kernel this CPU can run, for every width, gives the scalar answer
+   void test_copyIf_levelsAgree()
+   {
+      assertUnit(levelsAgree<int8_t>());
+      assertUnit(levelsAgree<int16_t>());
+      assertUnit(levelsAgree<int32_t>());
+      assertUnit(levelsAgree<uint32_t>());
+      assertUnit(levelsAgree<int64_t>());
+      assertUnit(levelsAgree<float>());
+      assertUnit(levelsAgree<double>());
+   }
+
+   // an output just big enough for what is kept is not written past
+   void test_copyIf_tightRoom()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i % 10);
+      custom::vector<int> out(21, -1);
+      typedef custom::compact_detail::kernels<int, custom::where::equal_to<int>> kernels;
+      bool allRight = true;
+      // exercise
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         for (size_t i = 0; i < out.size(); i++)
+            out[i] = -1;
+         size_t num = kernels::at(custom::simd::level(l)).compress(v.slice(0, v.size()).data(), v.size(),
+                                                                   out.slice(0, out.size()).data(), 10,
+                                                                   custom::where::equal(7));
+         // verify
+         if (num != 10 || out[9] != 7 || out[10] != -1)
+            allRight = false;
+      }
+      assertUnit(allRight);
+   }  // teardown
+
+   /***************************************
+    * REMOVE IF
+    ***************************************/
+
+   // what is left closes up, and v shrinks
+   void test_removeIf_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      size_t num = custom::remove_if(v, custom::where::between(40, 70));
+      // verify
+      assertUnit(num == 2);
+      assertUnit(v.size() == 2);
+      assertUnit(v[0] == 26);
+      assertUnit(v[1] == 89);
+   }  // teardown
+
+   // in place over many registers
+   void test_removeIf_long()
+   {  // setup
+      custom::vector<int64_t> v;
+      for (int64_t i = 0; i < 1003; i++)
+         v.push_back(i);
+      // exercise
+      size_t num = custom::remove_if(v, custom::where::not_equal(int64_t(0)));
+      custom::vector<int64_t> w;
+      for (int64_t i = 0; i < 1003; i++)
+         w.push_back(i);
+      size_t odd = custom::remove_if(w, [](int64_t x) { return x % 2 == 0; });
+      // verify
+      assertUnit(num == 1);
+      assertUnit(v[0] == 0);
+      assertUnit(odd == 501);
+      bool allRight = w.size() == 501;
+      for (size_t i = 0; i < w.size(); i++)
+         if (w[i] != int64_t(2 * i + 1))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   /***************************************
+    * PARTITION
+    ***************************************/
+
+   // the trues, then the falses
+   void test_partition_standard()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      size_t num = custom::partition(v, out, custom::where::greater(60));
+      // verify
+      assertUnit(num == 2);
+      assertUnit(out.size() == 4);
+      assertUnit(out[0] == 67);
+      assertUnit(out[1] == 89);
+      assertUnit(out[2] == 26);
+      assertUnit(out[3] == 49);
+   }  // teardown
+
+   // both sides keep their order
+   void test_partition_stable()
+   {  // setup
+      custom::vector<float> v;
+      custom::vector<float> out;
+      for (int i = 0; i < 777; i++)
+         v.push_back(float(i));
+      // exercise
+      size_t num = custom::partition(v, out, custom::where::less(100.0f));
+      // verify
+      bool allRight = num == 100 && out.size() == 777;
+      for (size_t i = 0; i < out.size(); i++)
+         if (out[i] != float(i))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   /***************************************
+    * PARALLEL
+    ***************************************/
+
+   // every block compacts to its own offset
+   void test_parallel_copyIf()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int> v;
+      custom::vector<int> out;
+      custom::vector<int> expected;
+      for (int i = 0; i < 200003; i++)
+         v.push_back((i * 7919) % 1009);
+      custom::copy_if(v, expected, custom::where::less(300));
+      // exercise
+      size_t num = custom::parallel::copy_if(v, out, custom::where::less(300), pool);
+      // verify
+      bool allAgree = num == expected.size() && out.size() == num;
+      for (size_t i = 0; i < out.size() && allAgree; i++)
+         if (out[i] != expected[i])
+            allAgree = false;
+      assertUnit(allAgree);
+   }  // teardown
+
+   // what is kept comes back in place, in order
+   void test_parallel_removeIf()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::vector<double> v;
+      for (int i = 0; i < 100000; i++)
+         v.push_back(double(i));
+      // exercise
+      size_t num = custom::parallel::remove_if(v, [](double x) { return int(x) % 4 != 0; }, pool);
+      // verify
+      bool allRight = num == 25000 && v.size() == 25000;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != double(4 * i))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   // the same as one thread
+   void test_parallel_partition()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int64_t> v;
+      custom::vector<int64_t> expected;
+      custom::vector<int64_t> out;
+      for (int64_t i = 0; i < 150000; i++)
+         v.push_back((i * 31) % 997);
+      size_t numExpected = custom::partition(v, expected, custom::where::greater(int64_t(500)));
+      // exercise
+      size_t num = custom::parallel::partition(v, out, custom::where::greater(int64_t(500)), pool);
+      // verify
+      bool allAgree = num == numExpected && out.size() == v.size();
+      for (size_t i = 0; i < out.size() && allAgree; i++)
+         if (out[i] != expected[i])
+            allAgree = false;
+      assertUnit(allAgree);
+   }  // teardown
+
+   /***************************************
+    * LEVELS AGREE
+    * copy_if and count at every level match
+    * the scalar loop, on a length that leaves
+    * a tail
+    ***************************************/
+   template <typename T>
+   bool levelsAgree()
+   {
+      custom::vector<T> v;
+      for (int i = 0; i < 1001; i++)
+         v.push_back(T((i * 37) % 101));
+      const T * in = v.slice(0, v.size()).data();
+      custom::where::in_range<T> p(T(20), T(60));
+      custom::vector<T> expected(v.size(), T());
+      size_t numExpected = custom::compact_detail::scalarCompress(in, v.size(),
+                              expected.slice(0, expected.size()).data(), v.size(), p);
+      bool allAgree = true;
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         typedef custom::compact_detail::kernels<T, custom::where::in_range<T>> kernels;
+         kernels k = kernels::at(custom::simd::level(l));
+         custom::vector<T> out(v.size(), T());
+         size_t num = k.compress(in, v.size(), out.slice(0, out.size()).data(), v.size(), p);
+         if (num != numExpected || k.count(in, v.size(), p) != numExpected)
+            allAgree = false;
+         for (size_t i = 0; i < num && allAgree; i++)
+            if (out[i] != expected[i])
+               allAgree = false;
+      }
+      return allAgree;
+   }
+
+   /***************************************
+    * SETUP STANDARD FIXTURE
+    *   {26, 49, 67, 89}
+    ***************************************/
+   void setupStandardFixture(custom::vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,181 @@
+/***********************************************************************
+ * Header:
+ *    TEST CPU FEATURES
+ * Summary:
+ *    Unit tests for cpu_features and the choice of simd level
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "cpu_features.h" // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <cstdint>
+
+/***********************************************
+ * TEST CPU FEATURES
+ * Unit tests for cpu_features and simd::level
+ ***********************************************/
+class TestCpuFeatures : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Detect
+      test_detect_consistent();
+      test_detect_cached();
+      test_levelOf_best();
+      test_levelOf_none();
+
+      // Parse
+      test_parse_everyName();
+      test_parse_unknown();
+
+      // Choose
+      test_choose_lowers();
+      test_choose_neverRaises();
+      test_choose_none();
+      test_active_notAboveDetected();
+
+      report("CpuFeatures");
+   }
+
+   /***************************************
+    * DETECT
+    ***************************************/
+
+   // each feature needs the ones under it
+   void test_detect_consistent()
+   {  // setup
+      // exercise
+      custom::cpu_features f = custom::cpu_features::detect();
+      // verify
+      assertUnit(!f.avx2 || f.avx);
+      assertUnit(!f.fma || f.avx);
+      assertUnit(!f.avx512f || f.avx2);
+      assertUnit(!f.avx512bw || f.avx512f);
+#if defined(__x86_64__) || defined(_M_X64)
+      assertUnit(f.sse2);
+#endif
+   }  // teardown
+
+   // host() is what detect() says, asked once
+   void test_detect_cached()
+   {  // setup
+      custom::cpu_features f = custom::cpu_features::detect();
+      // exercise
+      const custom::cpu_features & host = custom::cpu_features::host();
+      // verify
+      assertUnit(&host == &custom::cpu_features::host());
+      assertUnit(host.sse42 == f.sse42);
+      assertUnit(host.avx2 == f.avx2);
+      assertUnit(host.avx512f == f.avx512f);
+   }  // teardown
+
+   // the highest feature wins
+   void test_levelOf_best()
+   {  // setup
+      custom::cpu_features f;
+      f.sse2 = f.sse42 = f.avx = f.avx2 = true;
+      // exercise
+      custom::simd::level l = custom::simd::level_of(f);
+      // verify
+#ifdef CUSTOM_SIMD_X86
+      assertUnit(l == custom::simd::AVX2);
+#else
+      assertUnit(l == custom::simd::SCALAR);
+#endif
+   }  // teardown
+
+   // nothing at all is scalar
+   void test_levelOf_none()
+   {  // setup
+      custom::cpu_features f;
+      // exercise
+      custom::simd::level l = custom::simd::level_of(f);
+      // verify
+      assertUnit(l == custom::simd::SCALAR);
+   }  // teardown
+
+   /***************************************
+    * PARSE
+    ***************************************/
+
+   // every level reads back from its own name
+   void test_parse_everyName()
+   {  // setup
+      bool allRead = true;
+      // exercise
+      for (int l = custom::simd::SCALAR; l <= custom::simd::AVX512; l++)
+      {
+         custom::simd::level level = custom::simd::level(l);
+         if (custom::simd::parse_level(custom::simd::level_name(level),
+                                       custom::simd::SCALAR) != level)
+            allRead = false;
+      }
+      // verify
+      assertUnit(allRead);
+      assertUnit(custom::simd::parse_level("avx2", custom::simd::SCALAR) == custom::simd::AVX2);
+   }  // teardown
+
+   // a name we do not know, or no name, is the fallback
+   void test_parse_unknown()
+   {  // setup
+      // exercise and verify
+      assertUnit(custom::simd::parse_level("AVX2", custom::simd::SSE42) == custom::simd::SSE42);
+      assertUnit(custom::simd::parse_level("", custom::simd::SSE42) == custom::simd::SSE42);
+      assertUnit(custom::simd::parse_level("neon", custom::simd::AVX2) == custom::simd::AVX2);
+      assertUnit(custom::simd::parse_level(nullptr, custom::simd::AVX512) == custom::simd::AVX512);
+   }  // teardown
+
+   /***************************************
+    * CHOOSE
+    ***************************************/
+
+   // asking for less than the CPU has gets it
+   void test_choose_lowers()
+   {  // setup
+      // exercise
+      custom::simd::level l = custom::simd::choose_level(custom::simd::AVX512, "sse42");
+      // verify
+      assertUnit(l == custom::simd::SSE42);
+      assertUnit(custom::simd::choose_level(custom::simd::AVX2, "scalar") == custom::simd::SCALAR);
+   }  // teardown
+
+   // asking for more than the CPU has does not
+   void test_choose_neverRaises()
+   {  // setup
+      // exercise
+      custom::simd::level l = custom::simd::choose_level(custom::simd::SSE42, "avx512");
+      // verify
+      assertUnit(l == custom::simd::SSE42);
+   }  // teardown
+
+   // no override is whatever was detected
+   void test_choose_none()
+   {  // setup
+      // exercise
+      custom::simd::level l = custom::simd::choose_level(custom::simd::AVX2, nullptr);
+      // verify
+      assertUnit(l == custom::simd::AVX2);
+      assertUnit(custom::simd::choose_level(custom::simd::AVX2, "bogus") == custom::simd::AVX2);
+   }  // teardown
+
+   // whatever the environment says, the level runs on this CPU
+   void test_active_notAboveDetected()
+   {  // setup
+      // exercise
+      custom::simd::level active = custom::simd::active_level();
+      // verify
+      assertUnit(active <= custom::simd::detected_level());
+      assertUnit(active == custom::simd::active_level());
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,275 @@
+/***********************************************************************
+ * Header:
+ *    TEST EXPR
+ * Summary:
+ *    Unit tests for the lazy element-wise arithmetic in expr.h
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "expr.h"       // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <stdexcept>
+#include <type_traits>
+
+/***********************************************
+ * TEST EXPR
+ * Unit tests for custom::expr
+ ***********************************************/
+class TestExpr : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Build
+      test_build_lazy();
+      test_build_sizeMismatch();
+
+      // Assign
+      test_assign_standard();
+      test_assign_construct();
+      test_assign_scalars();
+      test_assign_negate();
+      test_assign_intDivide();
+      test_assign_span();
+      test_assign_resizes();
+      test_assign_ownOperand();
+
+      // Levels
+      test_levels_agree();
+
+      report("Expr");
+   }
+
+   /***************************************
+    * BUILD
+    ***************************************/
+
+   // a + b * c is a tree, not a vector, until it is assigned
+   void test_build_lazy()
+   {  // setup
+      custom::vector<double> a;
+      setupStandardFixture(a);
+      // exercise
+      auto tree = a + a * a;
+      // verify
+      assertUnit((std::is_base_of<custom::expr::expression<decltype(tree)>, decltype(tree)>::value));
+      assertUnit(tree.size() == 4);
+      assertUnit(tree[0] == 26.0 + 26.0 * 26.0);
+      assertUnit(tree[3] == 89.0 + 89.0 * 89.0);
+   }  // teardown
+
+   // vectors of different sizes do not make a tree
+   void test_build_sizeMismatch()
+   {  // setup
+      custom::vector<double> a;
+      custom::vector<double> b;
+      setupStandardFixture(a);
+      b.push_back(1.0);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         auto tree = a + b;
+         (void)tree;
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   /***************************************
+    * ASSIGN
+    ***************************************/
+
+   // the standard fixture, through a three-operand tree
+   void test_assign_standard()
+   {  // setup
+      custom::vector<double> a;
+      custom::vector<double> b;
+      custom::vector<double> c;
+      custom::vector<double> r;
+      setupStandardFixture(a);
+      setupStandardFixture(b);
+      setupStandardFixture(c);
+      // exercise
+      r = a + b * c;
+      // verify
+      assertUnit(r.size() == 4);
+      assertUnit(r[0] == 26.0 + 26.0 * 26.0);
+      assertUnit(r[1] == 49.0 + 49.0 * 49.0);
+      assertUnit(r[2] == 67.0 + 67.0 * 67.0);
+      assertUnit(r[3] == 89.0 + 89.0 * 89.0);
+   }  // teardown
+
+   // a new vector straight from a tree
+   void test_assign_construct()
+   {  // setup
+      custom::vector<float> a;
+      custom::vector<float> b;
+      for (int i = 0; i < 37; i++)
+      {
+         a.push_back(float(i));
+         b.push_back(float(2 * i));
+      }
+      // exercise
+      custom::vector<float> r = b - a;
+      // verify
+      assertUnit(r.size() == 37);
+      bool allRight = true;
+      for (size_t i = 0; i < r.size(); i++)
+         if (r[i] != float(i))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   // single values on either side, and a literal of another type
+   void test_assign_scalars()
+   {  // setup
+      custom::vector<double> a;
+      setupStandardFixture(a);
+      custom::vector<double> r;
+      // exercise
+      r = 2 * a + 1.5 - a / 2.0;
+      // verify
+      assertUnit(r.size() == 4);
+      assertUnit(r[0] == 2 * 26.0 + 1.5 - 26.0 / 2.0);
+      assertUnit(r[3] == 2 * 89.0 + 1.5 - 89.0 / 2.0);
+   }  // teardown
+
+   // unary minus, of a vector and of a tree
+   void test_assign_negate()
+   {  // setup
+      custom::vector<int> a;
+      for (int i = 0; i < 50; i++)
+         a.push_back(i);
+      custom::vector<int> r;
+      // exercise
+      r = -a + -(a * 2);
+      // verify
+      bool allRight = r.size() == 50;
+      for (size_t i = 0; i < r.size(); i++)
+         if (r[i] != -3 * int(i))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   // integer division truncates, in the registers as in the tail
+   void test_assign_intDivide()
+   {  // setup
+      custom::vector<int> a;
+      for (int i = -40; i < 41; i++)
+         a.push_back(i);
+      custom::vector<int> r;
+      // exercise
+      r = a / 3;
+      // verify
+      bool allRight = r.size() == 81;
+      for (size_t i = 0; i < r.size(); i++)
+         if (r[i] != (int(i) - 40) / 3)
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   // spans work as operands and as the destination
+   void test_assign_span()
+   {  // setup
+      custom::vector<double> a;
+      setupStandardFixture(a);
+      custom::vector<double> r(4, 0.0);
+      // exercise
+      custom::expr::evaluate(r.slice(1, 2), a.slice(0, 2) + a.slice(2, 2));
+      // verify
+      assertUnit(r[0] == 0.0);
+      assertUnit(r[1] == 26.0 + 67.0);
+      assertUnit(r[2] == 49.0 + 89.0);
+      assertUnit(r[3] == 0.0);
+   }  // teardown
+
+   // the destination grows or shrinks to the tree
+   void test_assign_resizes()
+   {  // setup
+      custom::vector<double> a;
+      setupStandardFixture(a);
+      custom::vector<double> r(100, 7.0);
+      // exercise
+      r = a * 1.0;
+      // verify
+      assertUnit(r.size() == 4);
+      assertUnit(r[0] == 26.0);
+      assertUnit(r[3] == 89.0);
+   }  // teardown
+
+   // a = a * a + a reads each element before writing it
+   void test_assign_ownOperand()
+   {  // setup
+      custom::vector<long long> a;
+      for (long long i = 0; i < 101; i++)
+         a.push_back(i);
+      // exercise
+      a = a * a + a;
+      // verify
+      bool allRight = a.size() == 101;
+      for (size_t i = 0; i < a.size(); i++)
+         if (a[i] != (long long)(i * i + i))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   /***************************************
+    * LEVELS
+    ***************************************/
+
+   // every loop this CPU can run gives the scalar answer
+   void test_levels_agree()
+   {  // setup
+      custom::vector<float> a;
+      custom::vector<float> b;
+      for (int i = 0; i < 1003; i++)
+      {
+         a.push_back(float(i % 17) - 8.0f);
+         b.push_back(float(i % 5) + 1.0f);
+      }
+      auto tree = (a - b) * 3.0f + a / b;
+      typedef custom::expr::evaluate_detail::loop<decltype(tree)> loop;
+      custom::vector<float> expected(a.size(), 0.0f);
+      loop::at(custom::simd::SCALAR)(expected.slice(0, a.size()).data(), tree, a.size());
+      bool allAgree = true;
+      // exercise
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         custom::vector<float> r(a.size(), 0.0f);
+         loop::at(custom::simd::level(l))(r.slice(0, r.size()).data(), tree, r.size());
+         for (size_t i = 0; i < r.size(); i++)
+            if (r[i] != expected[i])
+               allAgree = false;
+      }
+      // verify
+      assertUnit(allAgree);
+      assertUnit(expected[0] == (-8.0f - 1.0f) * 3.0f + -8.0f / 1.0f);
+   }  // teardown
+
+   /***************************************
+    * SETUP STANDARD FIXTURE
+    *   {26, 49, 67, 89}
+    ***************************************/
+   void setupStandardFixture(custom::vector<double> & v)
+   {
+      v.push_back(26.0);
+      v.push_back(49.0);
+      v.push_back(67.0);
+      v.push_back(89.0);
+   }
+};
+
+#endif // DEBUG
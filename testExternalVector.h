@@ -0,0 +1,293 @@
+/***********************************************************************
+ * Header:
+ *    TEST EXTERNAL VECTOR
+ * Summary:
+ *    Unit tests for external_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "external_vector.h"   // class under test
+#include "unitTest.h"          // unit test baseclass
+
+/***********************************************
+ * TEST EXTERNAL VECTOR
+ * Unit tests for the external_vector class
+ ***********************************************/
+class TestExternalVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+#ifndef _WIN32
+      // Construct
+      test_construct_budget();
+      test_construct_tinyBudget();
+      test_construct_allocatesLazily();
+
+      // Insert
+      test_pushback_withinBudget();
+      test_pushback_spills();
+      test_pushback_failedLoadKeepsSize();
+
+      // Access
+      test_subscript_writeSurvivesEviction();
+      test_subscript_randomAccess();
+      test_subscript_readIsNotDirty();
+      test_scan_prefetches();
+      test_subscript_failedReadFreesFrame();
+
+      // Remove
+      test_clear_standard();
+#endif // !_WIN32
+
+      report("ExternalVector");
+   }
+
+#ifndef _WIN32
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // the budget decides how many pages fit in memory
+   void test_construct_budget()
+   {
+      // exercise
+      custom::external_vector<int> v(4 * 64, 64);
+      // verify
+      assertUnit(v.page_size() == 16);
+      assertUnit(v.max_pages() == 4);
+      assertUnit(v.memory_budget() == 4 * 64);
+      assertUnit(v.size() == 0);
+      assertUnit(v.fd != -1);
+   }  // teardown
+
+   // we always keep at least two pages
+   void test_construct_tinyBudget()
+   {
+      // exercise
+      custom::external_vector<int> v(1, 64);
+      // verify
+      assertUnit(v.max_pages() == 2);
+   }  // teardown
+
+   // a big budget costs nothing until pages are used
+   void test_construct_allocatesLazily()
+   {  // setup
+      custom::external_vector<int> v(1024 * 64, 64);
+      size_t numAllocated = 0;
+      // exercise
+      for (int i = 0; i < 20; i++)
+         v.push_back(i);
+      // verify
+      for (size_t i = 0; i < v.max_pages(); i++)
+         if (v.frames[i].elements.capacity() > 0)
+            numAllocated++;
+      assertUnit(v.max_pages() == 1024);
+      assertUnit(numAllocated == 2);
+      assertUnit(v[19] == 19);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // nothing touches the disk while it all fits
+   void test_pushback_withinBudget()
+   {  // setup
+      custom::external_vector<int> v(4 * 64, 64);
+      // exercise
+      for (int i = 0; i < 64; i++)
+         v.push_back(i);
+      // verify
+      assertUnit(v.size() == 64);
+      assertUnit(v.stats().evictions == 0);
+      assertUnit(v.stats().writes == 0);
+      assertUnit(v[0] == 0);
+      assertUnit(v[63] == 63);
+   }  // teardown
+
+   // past the budget the oldest pages go to the file
+   void test_pushback_spills()
+   {  // setup
+      custom::external_vector<int> v(4 * 64, 64);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i);
+      // verify
+      bool same = true;
+      for (int i = 0; i < 1000; i++)
+         same = same && v[i] == i;
+      assertUnit(same);
+      assertUnit(v.size() == 1000);
+      assertUnit(v.stats().evictions > 0);
+      assertUnit(v.stats().writes > 0);
+   }  // teardown
+
+   // when the page cannot be brought in, the size does not change
+   void test_pushback_failedLoadKeepsSize()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 32; i++)
+         v.push_back(i);
+      int spill = v.fd;
+      v.fd = open("/dev/null", O_RDONLY);   // the dirty page cannot be written
+      // exercise
+      bool thrown = false;
+      try
+      {
+         v.push_back(32);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      ::close(v.fd);
+      v.fd = spill;
+      // verify
+      assertUnit(thrown);
+      assertUnit(v.size() == 32);
+      v.push_back(32);
+      assertUnit(v.size() == 33);
+      assertUnit(v[0] == 0);
+      assertUnit(v[32] == 32);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // a change is kept when the page is written out and read back
+   void test_subscript_writeSurvivesEviction()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      // exercise
+      v[3] = 99;
+      int evicted = v[50] + v[70] + v[90];   // three other pages push page 0 out
+      // verify
+      assertUnit(evicted == 50 + 70 + 90);
+      assertUnit(v[3] == 99);
+      assertUnit(v[4] == 4);
+   }  // teardown
+
+   // jumping around reads the right pages back
+   void test_subscript_randomAccess()
+   {  // setup
+      custom::external_vector<int> v(3 * 64, 64);
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i * 2);
+      // exercise
+      size_t index = 7;
+      bool same = true;
+      for (int i = 0; i < 200; i++)
+      {
+         index = (index * 31 + 17) % 1000;
+         same = same && v[index] == int(index * 2);
+      }
+      // verify
+      assertUnit(same);
+      assertUnit(v.stats().misses > v.max_pages());
+   }  // teardown
+
+   // reading through a const vector does not make a page dirty
+   void test_subscript_readIsNotDirty()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 16; i++)
+         v.push_back(i);
+      v.flush();
+      size_t writes = v.stats().writes;
+      const custom::external_vector<int> & cv = v;
+      // exercise
+      int sum = 0;
+      for (int i = 0; i < 16; i++)
+         sum += cv[i];
+      v.flush();
+      // verify
+      assertUnit(sum == 120);
+      assertUnit(v.stats().writes == writes);
+   }  // teardown
+
+   // a sequential scan over spilled pages reads ahead
+   void test_scan_prefetches()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i);
+      // exercise
+      long long sum = 0;
+      for (size_t i = 0; i < v.size(); i++)
+         sum += v[i];
+      // verify
+      assertUnit(sum == 999LL * 1000LL / 2LL);
+      assertUnit(v.stats().prefetches > 0);
+   }  // teardown
+
+   // a page that cannot be read gives its frame back to the cache
+   void test_subscript_failedReadFreesFrame()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 64; i++)
+         v.push_back(i);
+      v.flush();
+      int spill = v.fd;
+      v.fd = open("/dev/null", O_WRONLY);   // page 0 cannot be read
+      // exercise
+      bool thrown = false;
+      try
+      {
+         int value = v[0];
+         (void)value;
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      ::close(v.fd);
+      v.fd = spill;
+      // verify
+      assertUnit(thrown);
+      assertUnit(v.pageTable.size() == 1);
+      assertUnit(v.frames[v.leastRecent].page == v.NO_PAGE);
+      size_t linked = 0;
+      for (size_t i = v.mostRecent; i != v.NO_FRAME; i = v.frames[i].next)
+         linked++;
+      assertUnit(linked == v.max_pages());
+      assertUnit(v[0] == 0);
+      assertUnit(v[63] == 63);
+      assertUnit(v.pageTable.size() == 2);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // clear forgets everything, even what was spilled
+   void test_clear_standard()
+   {  // setup
+      custom::external_vector<int> v(2 * 64, 64);
+      for (int i = 0; i < 100; i++)
+         v.push_back(i + 1);
+      // exercise
+      v.clear();
+      v.push_back(26);
+      for (int i = 1; i < 100; i++)
+         v.push_back(0);
+      // verify
+      assertUnit(v.size() == 100);
+      assertUnit(v[0] == 26);
+      assertUnit(v[50] == 0);
+      assertUnit(v[99] == 0);
+   }  // teardown
+#endif // !_WIN32
+};
+
+#endif // DEBUG
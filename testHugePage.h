@@ -0,0 +1,177 @@
+/***********************************************************************
+ * Header:
+ *    TEST HUGE PAGE
+ * Summary:
+ *    Unit tests for huge_page_allocator and huge_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "huge_page.h"   // class under test
+#include "unitTest.h"    // unit test baseclass
+
+/***********************************************
+ * TEST HUGE PAGE
+ * Unit tests for the huge page storage
+ ***********************************************/
+class TestHugePage : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Allocator
+      test_allocate_zero();
+      test_allocate_small();
+      test_reallocate_crossThreshold();
+      test_reallocate_mapped();
+
+      // Vector
+      test_construct_default();
+      test_pushback_growsIntoMapping();
+      test_constructCopy_standard();
+      test_shrink_leavesMapping();
+
+      report("HugePage");
+   }
+
+   /***************************************
+    * ALLOCATOR
+    ***************************************/
+
+   // nothing to allocate
+   void test_allocate_zero()
+   {
+      // exercise
+      void * p = custom::huge_page_allocator::allocate(0);
+      // verify
+      assertUnit(p == nullptr);
+   }  // teardown
+
+   // small buffers are not mapped
+   void test_allocate_small()
+   {
+      // exercise
+      int * p = static_cast<int *>(custom::huge_page_allocator::allocate(4 * sizeof(int)));
+      p[3] = 89;
+      // verify
+      assertUnit(p != nullptr);
+      assertUnit(!custom::huge_page_allocator::is_mapped(4 * sizeof(int)));
+      assertUnit(p[3] == 89);
+      // teardown
+      custom::huge_page_allocator::deallocate(p, 4 * sizeof(int));
+   }
+
+   // growing past the threshold keeps the contents
+   void test_reallocate_crossThreshold()
+   {  // setup
+      const size_t small = 1024;
+      const size_t large = custom::huge_page_allocator::HUGE_PAGE_SIZE * 2;
+      char * p = static_cast<char *>(custom::huge_page_allocator::allocate(small));
+      for (size_t i = 0; i < small; i++)
+         p[i] = char(i);
+      // exercise
+      p = static_cast<char *>(custom::huge_page_allocator::reallocate(p, small, large));
+      p[large - 1] = 99;
+      // verify
+      bool same = true;
+      for (size_t i = 0; i < small; i++)
+         same = same && p[i] == char(i);
+      assertUnit(same);
+      assertUnit(p[large - 1] == 99);
+      // teardown
+      custom::huge_page_allocator::deallocate(p, large);
+   }
+
+   // growing a mapped buffer keeps the contents
+   void test_reallocate_mapped()
+   {  // setup
+      const size_t oldBytes = custom::huge_page_allocator::HUGE_PAGE_SIZE * 2;
+      const size_t newBytes = custom::huge_page_allocator::HUGE_PAGE_SIZE * 5;
+      char * p = static_cast<char *>(custom::huge_page_allocator::allocate(oldBytes));
+      p[0] = 26;
+      p[oldBytes - 1] = 89;
+      // exercise
+      p = static_cast<char *>(custom::huge_page_allocator::reallocate(p, oldBytes, newBytes));
+      p[newBytes - 1] = 99;
+      // verify
+      assertUnit(p[0] == 26);
+      assertUnit(p[oldBytes - 1] == 89);
+      assertUnit(p[newBytes - 1] == 99);
+      // teardown
+      custom::huge_page_allocator::deallocate(p, newBytes);
+   }
+
+   /***************************************
+    * VECTOR
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {
+      // exercise
+      custom::huge_vector<int> v;
+      // verify
+      assertUnit(v.data == nullptr);
+      assertUnit(v.numElements == 0);
+      assertUnit(v.numCapacity == 0);
+      assertUnit(!v.is_mapped());
+   }  // teardown
+
+   // enough push_backs move the buffer into a mapping
+   void test_pushback_growsIntoMapping()
+   {  // setup
+      custom::huge_vector<int> v;
+      const size_t num = custom::huge_page_allocator::HUGE_PAGE_SIZE;  // 4x the threshold in bytes
+      // exercise
+      for (size_t i = 0; i < num; i++)
+         v.push_back(int(i));
+      // verify
+      bool same = true;
+      for (size_t i = 0; i < num; i++)
+         same = same && v[i] == int(i);
+      assertUnit(same);
+      assertUnit(v.numElements == num);
+      assertUnit(v.numCapacity >= num);
+#ifdef __linux__
+      assertUnit(v.is_mapped());
+#endif
+   }  // teardown
+
+   // copy constructor makes an independent buffer
+   void test_constructCopy_standard()
+   {  // setup
+      custom::huge_vector<int> vSrc(4, 99);
+      vSrc[0] = 26;
+      // exercise
+      custom::huge_vector<int> vDest(vSrc);
+      vSrc[1] = 0;
+      // verify
+      assertUnit(vDest.numElements == 4);
+      assertUnit(vDest.data != vSrc.data);
+      assertUnit(vDest[0] == 26);
+      assertUnit(vDest[1] == 99);
+   }  // teardown
+
+   // shrinking a big vector to a few elements drops back to malloc
+   void test_shrink_leavesMapping()
+   {  // setup
+      custom::huge_vector<int> v(custom::huge_page_allocator::HUGE_PAGE_SIZE, 7);
+      v[0] = 26;
+      v.resize(4);
+      // exercise
+      v.shrink_to_fit();
+      // verify
+      assertUnit(v.numCapacity == 4);
+      assertUnit(!v.is_mapped());
+      assertUnit(v[0] == 26);
+      assertUnit(v[3] == 7);
+   }  // teardown
+};
+
+#endif // DEBUG
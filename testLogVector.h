@@ -0,0 +1,435 @@
+/***********************************************************************
+ * Header:
+ *    TEST LOG VECTOR
+ * Summary:
+ *    Unit tests for log_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "log_vector.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <csignal>        // for signal and SIGXFSZ
+#include <cstdio>         // for std::remove
+#include <fstream>
+#include <iterator>       // for std::istreambuf_iterator
+#include <string>
+
+#ifndef _WIN32
+#include <sys/resource.h> // for setrlimit and RLIMIT_FSIZE
+#endif
+
+/***********************************************
+ * TEST LOG VECTOR
+ * Unit tests for the log_vector class
+ ***********************************************/
+class TestLogVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+#ifndef _WIN32
+      // Construct
+      test_construct_fresh();
+      test_construct_replay();
+      test_construct_failedOpenClosesLog();
+
+      // Commit
+      test_commit_groups();
+      test_commit_explicit();
+      test_commit_splitsRecords();
+      test_commit_failedThenGood();
+
+      // Recover
+      test_recover_tornRecord();
+      test_recover_damagedRecord();
+      test_recover_hugeCount();
+
+      // Compact
+      test_compact_standard();
+      test_compact_crashAfterRename();
+#endif // !_WIN32
+
+      report("LogVector");
+   }
+
+#ifndef _WIN32
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // a new log is just its header
+   void test_construct_fresh()
+   {  // setup
+      cleanup();
+      // exercise
+      {
+         custom::log_vector<int> v(BASE_NAME);
+         // verify
+         assertUnit(v.size() == 0);
+         assertUnit(v.durable_size() == 0);
+      }
+      assertUnit(fileSize(logName()) == 16);
+      // teardown
+      cleanup();
+   }
+
+   // what was committed is there when we open it again
+   void test_construct_replay()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 3);
+         setupStandardFixture(v);
+      }
+      // exercise
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertStandardFixture(v);
+      assertUnit(v.durable_size() == 4);
+      // teardown
+      cleanup();
+   }
+
+   // a log that cannot be started is not left open
+   void test_construct_failedOpenClosesLog()
+   {  // setup
+      cleanup();
+      int before = open("/dev/null", O_RDONLY);   // the lowest free descriptor
+      ::close(before);
+      // exercise: there is no room for the header
+      bool thrown = false;
+      {
+         struct rlimit oldLimit;
+         getrlimit(RLIMIT_FSIZE, &oldLimit);
+         struct rlimit limit = oldLimit;
+         limit.rlim_cur = 0;
+         void (*oldHandler)(int) = signal(SIGXFSZ, SIG_IGN);
+         setrlimit(RLIMIT_FSIZE, &limit);
+         try
+         {
+            custom::log_vector<int> v(BASE_NAME);
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         setrlimit(RLIMIT_FSIZE, &oldLimit);
+         signal(SIGXFSZ, oldHandler);
+      }
+      // verify
+      int after = open("/dev/null", O_RDONLY);
+      ::close(after);
+      assertUnit(thrown);
+      assertUnit(after == before);
+      // teardown
+      cleanup();
+   }
+
+   /***************************************
+    * COMMIT
+    ***************************************/
+
+   // appends go to the disk commitInterval at a time
+   void test_commit_groups()
+   {  // setup
+      cleanup();
+      custom::log_vector<int> v(BASE_NAME, 2);
+      // exercise
+      v.push_back(26);
+      size_t durableOne = v.durable_size();
+      v.push_back(49);
+      size_t durableTwo = v.durable_size();
+      v.push_back(67);
+      // verify
+      assertUnit(durableOne == 0);
+      assertUnit(durableTwo == 2);
+      assertUnit(v.durable_size() == 2);
+      assertUnit(v.size() == 3);
+      assertUnit(fileSize(logName()) == 16 + 24 + 2 * sizeof(int));
+      // teardown
+      cleanup();
+   }
+
+   // commit() does not wait for a full group
+   void test_commit_explicit()
+   {  // setup
+      cleanup();
+      custom::log_vector<int> v(BASE_NAME, 100);
+      v.push_back(26);
+      // exercise
+      v.commit();
+      v.commit();   // nothing new: no empty record
+      // verify
+      assertUnit(v.durable_size() == 1);
+      assertUnit(fileSize(logName()) == 16 + 24 + sizeof(int));
+      // teardown
+      cleanup();
+   }
+
+   // a group too big for one record goes out as several, and replays whole
+   void test_commit_splitsRecords()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 100);
+         v.recordElements = 3;
+         for (int i = 0; i < 7; i++)
+            v.push_back(i);
+         // exercise
+         v.commit();
+         assertUnit(v.durable_size() == 7);
+         assertUnit(fileSize(logName()) == 16 + 3 * 24 + 7 * sizeof(int));
+      }
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertUnit(v.size() == 7);
+      assertUnit(v[0] == 0);
+      assertUnit(v[6] == 6);
+      // teardown
+      cleanup();
+   }
+
+   // a commit that fails partway leaves no torn record for the next one to follow
+   void test_commit_failedThenGood()
+   {  // setup
+      cleanup();
+      size_t goodSize;
+      {
+         custom::log_vector<int> v(BASE_NAME, 100);
+         v.push_back(26);
+         v.push_back(49);
+         v.commit();
+         goodSize = fileSize(logName());
+         v.push_back(67);
+         // exercise: the disk fills up ten bytes into the record
+         bool thrown = false;
+         {
+            struct rlimit oldLimit;
+            getrlimit(RLIMIT_FSIZE, &oldLimit);
+            struct rlimit limit = oldLimit;
+            limit.rlim_cur = goodSize + 10;
+            void (*oldHandler)(int) = signal(SIGXFSZ, SIG_IGN);
+            setrlimit(RLIMIT_FSIZE, &limit);
+            try
+            {
+               v.commit();
+            }
+            catch (const std::runtime_error &)
+            {
+               thrown = true;
+            }
+            setrlimit(RLIMIT_FSIZE, &oldLimit);
+            signal(SIGXFSZ, oldHandler);
+         }
+         assertUnit(thrown);
+         assertUnit(v.durable_size() == 2);
+         assertUnit(fileSize(logName()) == goodSize);
+         v.push_back(89);
+         v.commit();
+         assertUnit(v.durable_size() == 4);
+      }
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertStandardFixture(v);
+      // teardown
+      cleanup();
+   }
+
+   /***************************************
+    * RECOVER
+    ***************************************/
+
+   // half a record at the end of the log is dropped
+   void test_recover_tornRecord()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 1);
+         setupStandardFixture(v);
+      }
+      size_t goodSize = fileSize(logName());
+      {
+         std::ofstream fout(logName(), std::ios::binary | std::ios::app);
+         fout.write("\x05\x00\x00\x00\x00\x00", 6);
+      }
+      // exercise
+      custom::log_vector<int> v(BASE_NAME);
+      v.push_back(99);
+      v.commit();
+      // verify
+      assertUnit(v.size() == 5);
+      assertUnit(v[3] == 89);
+      assertUnit(v[4] == 99);
+      assertUnit(fileSize(logName()) == goodSize + 24 + sizeof(int));
+      // teardown
+      cleanup();
+   }
+
+   // a record whose checksum does not match ends the replay
+   void test_recover_damagedRecord()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 2);
+         setupStandardFixture(v);   // two records of two
+      }
+      {
+         std::fstream f(logName(), std::ios::binary | std::ios::in | std::ios::out);
+         f.seekp(16 + 24 + 2 * sizeof(int) + 24);   // first element of the second record
+         f.put('\x7f');
+      }
+      // exercise
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertUnit(v.size() == 2);
+      assertUnit(v[0] == 26);
+      assertUnit(v[1] == 49);
+      // teardown
+      cleanup();
+   }
+
+   // a header claiming more than is left of the file is torn, not allocated
+   void test_recover_hugeCount()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 1);
+         setupStandardFixture(v);
+      }
+      size_t goodSize = fileSize(logName());
+      {
+         custom::log_vector<int>::RecordHeader header = {};
+         header.firstIndex = 4;
+         header.count      = 0xffffffff;
+         std::ofstream fout(logName(), std::ios::binary | std::ios::app);
+         fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+         fout.write("\x01\x02\x03\x04", 4);
+      }
+      // exercise
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertStandardFixture(v);
+      assertUnit(fileSize(logName()) == goodSize);
+      // teardown
+      cleanup();
+   }
+
+   /***************************************
+    * COMPACT
+    ***************************************/
+
+   // compaction moves the log into the snapshot
+   void test_compact_standard()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 1);
+         setupStandardFixture(v);
+         // exercise
+         v.compact();
+         assertUnit(fileSize(logName()) == 16);
+         assertUnit(fileSize(snapName()) == sizeof(custom::serial_header) + 4 * sizeof(int));
+         v.push_back(99);
+      }
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertUnit(v.size() == 5);
+      assertUnit(v[0] == 26);
+      assertUnit(v[4] == 99);
+      // teardown
+      cleanup();
+   }
+
+   // a crash between the rename and the truncate does not duplicate anything
+   void test_compact_crashAfterRename()
+   {  // setup
+      cleanup();
+      {
+         custom::log_vector<int> v(BASE_NAME, 1);
+         setupStandardFixture(v);
+      }
+      std::string oldLog = readFile(logName());
+      {
+         custom::log_vector<int> v(BASE_NAME);
+         v.compact();
+      }
+      writeFile(logName(), oldLog);   // as if the truncate never happened
+      // exercise
+      custom::log_vector<int> v(BASE_NAME);
+      // verify
+      assertStandardFixture(v);
+      // teardown
+      cleanup();
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::log_vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::log_vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+
+   /*************************************************************
+    * FILE HELPERS
+    *************************************************************/
+   static std::string logName()  { return std::string(BASE_NAME) + ".log";  }
+   static std::string snapName() { return std::string(BASE_NAME) + ".snap"; }
+
+   static void cleanup()
+   {
+      std::remove(logName().c_str());
+      std::remove(snapName().c_str());
+   }
+   static size_t fileSize(const std::string & fileName)
+   {
+      std::ifstream fin(fileName, std::ios::binary | std::ios::ate);
+      return fin ? size_t(fin.tellg()) : 0;
+   }
+   static std::string readFile(const std::string & fileName)
+   {
+      std::ifstream fin(fileName, std::ios::binary);
+      return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+   }
+   static void writeFile(const std::string & fileName, const std::string & contents)
+   {
+      std::ofstream fout(fileName, std::ios::binary | std::ios::trunc);
+      fout.write(contents.data(), contents.size());
+   }
+
+   static constexpr const char * BASE_NAME = "testLogVector";
+#endif // !_WIN32
+};
+
+#endif // DEBUG
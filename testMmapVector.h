@@ -0,0 +1,329 @@
+/***********************************************************************
+ * Header:
+ *    TEST MMAP VECTOR
+ * Summary:
+ *    Unit tests for mmap_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "mmap_vector.h"   // class under test
+#include "unitTest.h"      // unit test baseclass
+
+#include <cstdio>          // for std::remove
+#include <fstream>
+
+/***********************************************
+ * TEST MMAP VECTOR
+ * Unit tests for the mmap_vector class
+ ***********************************************/
+class TestMmapVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+#ifndef _WIN32
+      // Construct
+      test_open_create();
+      test_open_reopen();
+      test_open_readOnly();
+      test_open_wrongElementSize();
+      test_open_notOurs();
+      test_open_longerThanCapacity();
+
+      // Insert
+      test_pushback_grows();
+      test_resize_standard();
+
+      // Remove
+      test_shrink_truncatesFile();
+
+      // Persist
+      test_sync_range();
+#endif // !_WIN32
+
+      report("MmapVector");
+   }
+
+#ifndef _WIN32
+   /***************************************
+    * OPEN
+    ***************************************/
+
+   // a new file is just a header
+   void test_open_create()
+   {  // setup
+      std::remove(FILE_NAME);
+      // exercise
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+      // verify
+      assertUnit(v.is_open());
+      assertUnit(v.size() == 0);
+      assertUnit(v.capacity() == 0);
+      assertUnit(v.pHeader->magic == custom::mmap_vector<int>::MAGIC);
+      assertUnit(v.pHeader->elementSize == sizeof(int));
+      assertUnit(fileSize() == 64);
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   // what we write is there when we open the file again
+   void test_open_reopen()
+   {  // setup
+      {
+         custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+         setupStandardFixture(v);
+      }
+      // exercise
+      custom::mmap_vector<int> v(FILE_NAME);
+      // verify
+      assertStandardFixture(v);
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   // a read-only vector can be read and iterated, but the file is not changed
+   void test_open_readOnly()
+   {  // setup
+      {
+         custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+         setupStandardFixture(v);
+      }
+      // exercise
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::READ_ONLY);
+      bool thrown = false;
+      try
+      {
+         v.push_back(99);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      int sum = 0;
+      for (custom::mmap_vector<int>::iterator it = v.begin(); it != v.end(); ++it)
+         sum += *it;
+      v[0] = 99;   // only our private copy of the page
+      // verify
+      assertUnit(v.read_only());
+      assertUnit(thrown);
+      assertUnit(sum == 26 + 49 + 67 + 89);
+      assertUnit(v[0] == 99);
+      v.close();
+      v.open(FILE_NAME, custom::mmap_vector<int>::READ_ONLY);
+      assertStandardFixture(v);
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   // a file of doubles is not a file of ints
+   void test_open_wrongElementSize()
+   {  // setup
+      {
+         custom::mmap_vector<double> v(FILE_NAME, custom::mmap_vector<double>::CREATE);
+         v.push_back(2.6);
+      }
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::READ_ONLY);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file without our magic number is rejected
+   void test_open_notOurs()
+   {  // setup
+      {
+         std::ofstream fout(FILE_NAME, std::ios::binary);
+         for (int i = 0; i < 100; i++)
+            fout.put('x');
+      }
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::mmap_vector<int> v(FILE_NAME);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file longer than its capacity is mapped, and unmapped, whole
+   void test_open_longerThanCapacity()
+   {  // setup
+      {
+         custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+         setupStandardFixture(v);
+      }
+      {
+         std::ofstream fout(FILE_NAME, std::ios::binary | std::ios::app);
+         for (int i = 0; i < 4096; i++)
+            fout.put('x');
+      }
+      // exercise
+      {
+         custom::mmap_vector<int> v(FILE_NAME);
+         assertUnit(v.mapSize == 64 + 4 * sizeof(int) + 4096);
+         assertStandardFixture(v);
+         v.push_back(99);
+         // verify
+         assertUnit(v.mapSize == 64 + 8 * sizeof(int));
+         assertUnit(fileSize() == 64 + 8 * sizeof(int));
+      }
+      const custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::READ_ONLY);
+      assertUnit(v.size() == 5);
+      assertUnit(v[4] == 99);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // growing the vector grows the file
+   void test_pushback_grows()
+   {  // setup
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i);
+      // verify
+      assertUnit(v.size() == 1000);
+      assertUnit(v.capacity() == 1024);
+      assertUnit(v[0] == 0);
+      assertUnit(v[999] == 999);
+      assertUnit(fileSize() == 64 + 1024 * sizeof(int));
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   // resize fills the new elements
+   void test_resize_standard()
+   {  // setup
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+      setupStandardFixture(v);
+      // exercise
+      v.resize(6, 99);
+      // verify
+      assertUnit(v.size() == 6);
+      assertUnit(v[3] == 89);
+      assertUnit(v[5] == 99);
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // shrinking gives the space back to the file system
+   void test_shrink_truncatesFile()
+   {  // setup
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+      setupStandardFixture(v);
+      v.reserve(100);
+      // exercise
+      v.shrink_to_fit();
+      // verify
+      assertStandardFixture(v);
+      assertUnit(fileSize() == 64 + 4 * sizeof(int));
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * PERSIST
+    ***************************************/
+
+   // syncing part of the vector does not disturb it
+   void test_sync_range()
+   {  // setup
+      custom::mmap_vector<int> v(FILE_NAME, custom::mmap_vector<int>::CREATE);
+      setupStandardFixture(v);
+      // exercise
+      v[2] = 99;
+      v.sync(2, 1);
+      v.sync();
+      // verify
+      assertUnit(v[2] == 99);
+      assertUnit(v.size() == 4);
+      // teardown
+      v.close();
+      std::remove(FILE_NAME);
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::mmap_vector<int> & v)
+   {
+      v.reserve(4);
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::mmap_vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      assertIndirect(v.capacity() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+
+   /*************************************************************
+    * FILE SIZE
+    *************************************************************/
+   static size_t fileSize()
+   {
+      std::ifstream fin(FILE_NAME, std::ios::binary | std::ios::ate);
+      return fin ? size_t(fin.tellg()) : 0;
+   }
+
+   static constexpr const char * FILE_NAME = "testMmapVector.bin";
+#endif // !_WIN32
+};
+
+#endif // DEBUG
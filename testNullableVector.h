@@ -0,0 +1,234 @@
+/***********************************************************************
+ * Header:
+ *    TEST NULLABLE VECTOR
+ * Summary:
+ *    Unit tests for nullable_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "nullable_vector.h" // class under test
+#include "unitTest.h"        // unit test baseclass
+
+/***********************************************
+ * TEST NULLABLE VECTOR
+ * Unit tests for the nullable_vector class
+ ***********************************************/
+class TestNullableVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Insert
+      test_pushBack_value();
+      test_pushBack_null();
+      test_set_andSetNull();
+      test_resize_growAndShrink();
+
+      // Assign
+      test_copy_standard();
+
+      // Reduce
+      test_sum_skipsNulls();
+      test_minMax_standard();
+      test_minMax_allNull();
+      test_minMax_acrossWords();
+
+      report("NullableVector");
+   }
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a value sets its bit
+   void test_pushBack_value()
+   {  // setup
+      custom::nullable_vector<int> v;
+      // exercise
+      v.push_back(26);
+      // verify
+      assertUnit(v.size() == 1);
+      assertUnit(v.is_valid(0));
+      assertUnit(v[0] == 26);
+      assertUnit(v.null_count() == 0);
+      assertUnit(v.count() == 1);
+   }  // teardown
+
+   // nullopt only leaves a bit clear
+   void test_pushBack_null()
+   {  // setup
+      custom::nullable_vector<int> v;
+      // exercise
+      v.push_back(custom::nullopt);
+      // verify
+      assertUnit(v.size() == 1);
+      assertUnit(v.is_null(0));
+      assertUnit(v[0] == 0);
+      assertUnit(v.null_count() == 1);
+      assertUnit(v.count() == 0);
+   }  // teardown
+
+   // set() fills a null and set_null() empties a value
+   void test_set_andSetNull()
+   {  // setup
+      custom::nullable_vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      v.set(1, 99);
+      v.set_null(2);
+      // verify
+      assertUnit(v.is_valid(1));
+      assertUnit(v[1] == 99);
+      assertUnit(v.is_null(2));
+      assertUnit(v[2] == 0);
+      assertUnit(v.null_count() == 1);
+   }  // teardown
+
+   // growing adds nulls, and shrinking forgets the dropped bits
+   void test_resize_growAndShrink()
+   {  // setup
+      custom::nullable_vector<int> v;
+      for (int i = 0; i < 70; i++)
+         v.push_back(i);
+      // exercise
+      v.resize(65);
+      v.resize(130);
+      // verify
+      assertUnit(v.size() == 130);
+      assertUnit(v.null_count() == 65);
+      assertUnit(v.is_valid(64));
+      assertUnit(v.is_null(65));
+      assertUnit(v.is_null(69));
+      assertUnit(v[69] == 0);
+   }  // teardown
+
+   /***************************************
+    * ASSIGN
+    ***************************************/
+
+   // a copy has its own values and its own bitmap
+   void test_copy_standard()
+   {  // setup
+      custom::nullable_vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::nullable_vector<int> vCopy(v);
+      v.set(0, 99);
+      // verify
+      assertStandardFixture(vCopy);
+      assertUnit(v[0] == 99);
+   }  // teardown
+
+   /***************************************
+    * REDUCE
+    ***************************************/
+
+   // a sum ignores the nulls
+   void test_sum_skipsNulls()
+   {  // setup
+      custom::nullable_vector<double> v;
+      for (int i = 1; i <= 100; i++)
+         if (i % 3 == 0)
+            v.push_back(custom::nullopt);
+         else
+            v.push_back(double(i));
+      // exercise
+      double sum = v.sum();
+      // verify
+      assertUnit(sum == 5050.0 - 1683.0);   // 1683 = 3 + 6 + ... + 99
+   }  // teardown
+
+   // the smallest and the largest of the standard fixture
+   void test_minMax_standard()
+   {  // setup
+      custom::nullable_vector<int> v;
+      setupStandardFixture(v);
+      int smallest = 0;
+      int largest = 0;
+      // exercise
+      bool foundMin = v.min(smallest);
+      bool foundMax = v.max(largest);
+      // verify
+      assertUnit(foundMin && smallest == 26);
+      assertUnit(foundMax && largest == 89);
+   }  // teardown
+
+   // nothing to compare is not the same as T()
+   void test_minMax_allNull()
+   {  // setup
+      custom::nullable_vector<int> v;
+      v.push_back(custom::nullopt);
+      v.push_back(custom::nullopt);
+      int t = 99;
+      // exercise
+      bool found = v.min(t);
+      // verify
+      assertUnit(!found);
+      assertUnit(t == 99);
+   }  // teardown
+
+   // a null never wins, in a full, an empty, or a mixed word
+   void test_minMax_acrossWords()
+   {  // setup
+      custom::nullable_vector<int> v;
+      for (int i = 0; i < 64; i++)
+         v.push_back(i + 100);           // a full word
+      for (int i = 0; i < 64; i++)
+         v.push_back(custom::nullopt);   // an empty word: 0 would be the min
+      for (int i = 0; i < 10; i++)
+         if (i == 5)
+            v.push_back(-7);
+         else
+            v.push_back(custom::nullopt);   // a mixed word
+      int smallest = 0;
+      int largest = 0;
+      // exercise
+      v.min(smallest);
+      v.max(largest);
+      // verify
+      assertUnit(smallest == -7);
+      assertUnit(largest == 163);
+      assertUnit(v.count() == 65);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::nullable_vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::nullable_vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      assertIndirect(v.null_count() == 0);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+};
+
+#endif // DEBUG
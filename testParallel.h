@@ -0,0 +1,255 @@
+/***********************************************************************
+ * Header:
+ *    TEST PARALLEL
+ * Summary:
+ *    Unit tests for thread_pool and the parallel algorithms
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "parallel.h"   // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+/***********************************************
+ * TEST PARALLEL
+ * Unit tests for the thread_pool class and the
+ * algorithms in custom::parallel
+ ***********************************************/
+class TestParallel : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Thread pool
+      test_pool_everyTaskOnce();
+      test_pool_rethrows();
+      test_pool_nested();
+      test_pool_single();
+
+      // Algorithms
+      test_forEach_standard();
+      test_transform_standard();
+      test_reduce_standard();
+      test_reduce_empty();
+      test_reduce_inOrder();
+      test_transformReduce_standard();
+      test_fill_slice();
+      test_copy_standard();
+
+      report("Parallel");
+   }
+
+   /***************************************
+    * THREAD POOL
+    ***************************************/
+
+   // no task is skipped and none is run twice
+   void test_pool_everyTaskOnce()
+   {  // setup
+      custom::thread_pool pool(4);
+      std::vector<std::atomic<int>> counts(1000);
+      for (size_t i = 0; i < counts.size(); i++)
+         counts[i] = 0;
+      // exercise
+      for (int repeat = 0; repeat < 10; repeat++)
+         pool.run(counts.size(), [&](size_t task) { counts[task]++; });
+      // verify
+      bool allTen = true;
+      for (size_t i = 0; i < counts.size(); i++)
+         if (counts[i] != 10)
+            allTen = false;
+      assertUnit(pool.size() == 4);
+      assertUnit(allTen);
+   }  // teardown
+
+   // a task's exception comes out of run(), and the pool still works
+   void test_pool_rethrows()
+   {  // setup
+      custom::thread_pool pool(4);
+      bool threw = false;
+      std::atomic<int> num(0);
+      // exercise
+      try
+      {
+         pool.run(100, [](size_t task)
+         {
+            if (task == 37)
+               throw std::runtime_error("task 37");
+         });
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      pool.run(100, [&](size_t) { num++; });
+      // verify
+      assertUnit(threw);
+      assertUnit(num == 100);
+   }  // teardown
+
+   // a run() inside a task runs there rather than waiting on the pool
+   void test_pool_nested()
+   {  // setup
+      custom::thread_pool pool(4);
+      std::atomic<int> num(0);
+      // exercise
+      pool.run(8, [&](size_t)
+      {
+         pool.run(8, [&](size_t) { num++; });
+      });
+      // verify
+      assertUnit(num == 64);
+      assertUnit(!custom::thread_pool::insideTask());
+   }  // teardown
+
+   // a pool of one is the calling thread
+   void test_pool_single()
+   {  // setup
+      custom::thread_pool pool(1);
+      int num = 0;
+      // exercise
+      pool.run(10, [&](size_t) { num++; });
+      // verify
+      assertUnit(pool.size() == 1);
+      assertUnit(pool.workers.empty());
+      assertUnit(num == 10);
+   }  // teardown
+
+   /***************************************
+    * ALGORITHMS
+    ***************************************/
+
+   // every element is visited once, in place
+   void test_forEach_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      // exercise
+      custom::parallel::for_each(v, [](int & value) { value *= 2; });
+      // verify
+      assertUnit(isBig(v, 2, 0));
+   }  // teardown
+
+   // out is sized to in and holds f(in)
+   void test_transform_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      custom::vector<double> vOut;
+      // exercise
+      custom::parallel::transform(v, vOut, [](int value) { return value + 0.5; });
+      // verify
+      assertUnit(vOut.size() == v.size());
+      assertUnit(vOut[0] == 0.5);
+      assertUnit(vOut[v.size() - 1] == double(v.size() - 1) + 0.5);
+   }  // teardown
+
+   // a sum over many chunks
+   void test_reduce_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      // exercise
+      long long sum = custom::parallel::reduce(v, 0LL);
+      // verify
+      long long num = (long long)v.size();
+      assertUnit(sum == num * (num - 1) / 2);
+   }  // teardown
+
+   // nothing to reduce is init
+   void test_reduce_empty()
+   {  // setup
+      custom::vector<int> v;
+      // exercise
+      int sum = custom::parallel::reduce(v, 99);
+      // verify
+      assertUnit(sum == 99);
+   }  // teardown
+
+   // an associative but not commutative op sees the chunks in order
+   void test_reduce_inOrder()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      // exercise
+      int last = custom::parallel::reduce(v, -1, [](int, int b) { return b; });
+      // verify
+      assertUnit(last == int(v.size()) - 1);
+   }  // teardown
+
+   // a sum of squares
+   void test_transformReduce_standard()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 1; i <= 1000; i++)
+         v.push_back(i);
+      // exercise
+      long long sum = custom::parallel::transform_reduce(v, 0LL, std::plus<long long>(),
+                                                         [](int value) { return (long long)value * value; });
+      // verify
+      assertUnit(sum == 1000LL * 1001 * 2001 / 6);
+   }  // teardown
+
+   // a fill of a slice leaves the rest alone
+   void test_fill_slice()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      // exercise
+      custom::parallel::fill(v.slice(10, v.size() - 20), 7);
+      // verify
+      assertUnit(v[9] == 9);
+      assertUnit(v[10] == 7);
+      assertUnit(v[v.size() - 11] == 7);
+      assertUnit(v[v.size() - 10] == int(v.size()) - 10);
+   }  // teardown
+
+   // a copy has its own buffer with the same elements
+   void test_copy_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupBig(v);
+      custom::vector<int> vCopy;
+      // exercise
+      custom::parallel::copy(v, vCopy);
+      // verify
+      assertUnit(vCopy.data != v.data);
+      assertUnit(isBig(vCopy, 1, 0));
+   }  // teardown
+
+   /*************************************************************
+    * SETUP BIG
+    * 0, 1, 2, ... across many more chunks than there are threads
+    *************************************************************/
+   void setupBig(custom::vector<int> & v)
+   {
+      const int num = 1000000;
+      v.reserve(num);
+      for (int i = 0; i < num; i++)
+         v.push_back(i);
+   }
+
+   // is element i equal to i * scale + offset for every i?
+   bool isBig(const custom::vector<int> & v, int scale, int offset)
+   {
+      if (v.size() != 1000000)
+         return false;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != int(i) * scale + offset)
+            return false;
+      return true;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,347 @@
+/***********************************************************************
+ * Header:
+ *    TEST PIPELINE
+ * Summary:
+ *    Unit tests for the lazy pipeline stages and sinks
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "pipeline.h"   // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <utility>
+
+/***********************************************
+ * TEST PIPELINE
+ * Unit tests for custom::pipeline
+ ***********************************************/
+class TestPipeline : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Stages
+      test_filter_standard();
+      test_transform_standard();
+      test_transform_onceEach();
+      test_take_stopsSource();
+      test_take_zero();
+      test_drop_standard();
+      test_chunk_remainder();
+      test_zip_source();
+      test_zip_stage();
+
+      // Chains
+      test_chain_filterTransformTake();
+      test_chain_lazy();
+      test_chain_reusable();
+
+      // Sinks
+      test_into_appends();
+      test_toVector_reserves();
+      test_parallel_inOrder();
+      test_parallel_notSplittable();
+
+      report("Pipeline");
+   }
+
+   /***************************************
+    * STAGES
+    ***************************************/
+
+   // only the elements the predicate likes
+   void test_filter_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::vector<int> odd = v | custom::pipeline::filter([](int x) { return x % 2 == 1; })
+                                  | custom::pipeline::to_vector();
+      // verify
+      assertUnit(odd.size() == 3);
+      assertUnit(odd[0] == 49);
+      assertUnit(odd[1] == 67);
+      assertUnit(odd[2] == 89);
+   }  // teardown
+
+   // a change of type on the way
+   void test_transform_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::vector<double> half = custom::pipeline::from(v)
+                                  | custom::pipeline::transform([](int x) { return x / 2.0; })
+                                  | custom::pipeline::to_vector();
+      // verify
+      assertUnit(half.size() == 4);
+      assertUnit(half[0] == 13.0);
+      assertUnit(half[3] == 44.5);
+   }  // teardown
+
+   // a filter after a transform does not run the transform twice
+   void test_transform_onceEach()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      int calls = 0;
+      // exercise
+      custom::vector<int> big = v | custom::pipeline::transform([&](int x) { calls++; return x * 10; })
+                                  | custom::pipeline::filter([](int x) { return x > 500; })
+                                  | custom::pipeline::to_vector();
+      // verify
+      assertUnit(calls == 4);
+      assertUnit(big.size() == 2);
+      assertUnit(big[0] == 670);
+   }  // teardown
+
+   // the source is not read past what take needs
+   void test_take_stopsSource()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i);
+      int seen = 0;
+      // exercise
+      custom::vector<int> first = v | custom::pipeline::filter([&](int) { seen++; return true; })
+                                    | custom::pipeline::take(3)
+                                    | custom::pipeline::to_vector();
+      // verify
+      assertUnit(first.size() == 3);
+      assertUnit(first[2] == 2);
+      assertUnit(seen == 3);
+   }  // teardown
+
+   // take(0) reads nothing at all
+   void test_take_zero()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::vector<int> none = v | custom::pipeline::take(0) | custom::pipeline::to_vector();
+      // verify
+      assertUnit(none.size() == 0);
+   }  // teardown
+
+   // all but the first n, and nothing when n is too many
+   void test_drop_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::vector<int> rest = v | custom::pipeline::drop(1) | custom::pipeline::to_vector();
+      custom::vector<int> none = v | custom::pipeline::drop(9) | custom::pipeline::to_vector();
+      // verify
+      assertUnit(rest.size() == 3);
+      assertUnit(rest[0] == 49);
+      assertUnit(none.size() == 0);
+   }  // teardown
+
+   // full chunks, then whatever is left
+   void test_chunk_remainder()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 1; i <= 7; i++)
+         v.push_back(i);
+      // exercise
+      custom::vector<int> sums = v | custom::pipeline::chunk(3)
+                                   | custom::pipeline::transform([](custom::span<const int> c)
+                                     {
+                                        int sum = 0;
+                                        for (size_t i = 0; i < c.size(); i++)
+                                           sum += c[i];
+                                        return sum;
+                                     })
+                                   | custom::pipeline::to_vector();
+      // verify
+      assertUnit(sums.size() == 3);
+      assertUnit(sums[0] == 1 + 2 + 3);
+      assertUnit(sums[1] == 4 + 5 + 6);
+      assertUnit(sums[2] == 7);
+   }  // teardown
+
+   // two vectors side by side, as far as the shorter one goes
+   void test_zip_source()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<double> w;
+      setupStandardFixture(v);
+      w.push_back(0.5);
+      w.push_back(2.0);
+      w.push_back(3.0);
+      // exercise
+      custom::vector<double> products = custom::pipeline::zip(v, w)
+         | custom::pipeline::transform([](const std::pair<int, double> & p) { return p.first * p.second; })
+         | custom::pipeline::to_vector();
+      // verify
+      assertUnit(products.size() == 3);
+      assertUnit(products[0] == 13.0);
+      assertUnit(products[1] == 98.0);
+      assertUnit(products[2] == 201.0);
+   }  // teardown
+
+   // what survives a filter, paired with the next of another vector
+   void test_zip_stage()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<char> names;
+      setupStandardFixture(v);
+      names.push_back('a');
+      names.push_back('b');
+      // exercise
+      custom::vector<std::pair<int, char>> pairs = v
+         | custom::pipeline::filter([](int x) { return x > 40; })
+         | custom::pipeline::zip(names)
+         | custom::pipeline::to_vector();
+      // verify
+      assertUnit(pairs.size() == 2);
+      assertUnit(pairs[0].first == 49 && pairs[0].second == 'a');
+      assertUnit(pairs[1].first == 67 && pairs[1].second == 'b');
+   }  // teardown
+
+   /***************************************
+    * CHAINS
+    ***************************************/
+
+   // the example in the header
+   void test_chain_filterTransformTake()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      // exercise
+      custom::vector<int> r = custom::pipeline::from(v)
+                            | custom::pipeline::filter([](int x) { return x % 7 == 0; })
+                            | custom::pipeline::transform([](int x) { return x * 2; })
+                            | custom::pipeline::drop(1)
+                            | custom::pipeline::take(3)
+                            | custom::pipeline::to_vector();
+      // verify
+      assertUnit(r.size() == 3);
+      assertUnit(r[0] == 14);
+      assertUnit(r[1] == 28);
+      assertUnit(r[2] == 42);
+   }  // teardown
+
+   // building a chain runs nothing
+   void test_chain_lazy()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      int calls = 0;
+      // exercise
+      auto chain = v | custom::pipeline::transform([&](int x) { calls++; return x; });
+      // verify
+      assertUnit(calls == 0);
+      custom::vector<int> r = chain | custom::pipeline::to_vector();
+      assertUnit(calls == 4);
+      assertUnit(r.size() == 4);
+   }  // teardown
+
+   // a chain runs the same way twice
+   void test_chain_reusable()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      auto chain = v | custom::pipeline::take(2);
+      // exercise
+      custom::vector<int> a = chain | custom::pipeline::to_vector();
+      custom::vector<int> b = chain | custom::pipeline::to_vector();
+      // verify
+      assertUnit(a.size() == 2);
+      assertUnit(b.size() == 2);
+      assertUnit(a[1] == b[1]);
+   }  // teardown
+
+   /***************************************
+    * SINKS
+    ***************************************/
+
+   // into keeps what the vector already had
+   void test_into_appends()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      out.push_back(1);
+      // exercise
+      v | custom::pipeline::take(2) | custom::pipeline::into(out);
+      // verify
+      assertUnit(out.size() == 3);
+      assertUnit(out[0] == 1);
+      assertUnit(out[1] == 26);
+      assertUnit(out[2] == 49);
+   }  // teardown
+
+   // the sink reserves the most the chain can give, once
+   void test_toVector_reserves()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      // exercise
+      custom::vector<int> r = v | custom::pipeline::take(10) | custom::pipeline::to_vector();
+      // verify
+      assertUnit(r.size() == 10);
+      assertUnit(r.capacity() == 10);
+   }  // teardown
+
+   // blocks on every thread, put back in order
+   void test_parallel_inOrder()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int> v;
+      for (int i = 0; i < 100000; i++)
+         v.push_back(i);
+      // exercise
+      custom::vector<long long> r = v
+         | custom::pipeline::filter([](int x) { return x % 3 == 0; })
+         | custom::pipeline::transform([](int x) { return (long long)x * x; })
+         | custom::pipeline::parallel_to_vector(pool);
+      // verify
+      assertUnit(r.size() == 33334);
+      bool inOrder = true;
+      for (size_t i = 0; i < r.size(); i++)
+         if (r[i] != (long long)(3 * i) * (long long)(3 * i))
+            inOrder = false;
+      assertUnit(inOrder);
+   }  // teardown
+
+   // a chain with take runs on one thread and still gives the first ones
+   void test_parallel_notSplittable()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int> v;
+      for (int i = 0; i < 100000; i++)
+         v.push_back(i);
+      // exercise
+      custom::vector<int> r = v | custom::pipeline::filter([](int x) { return x % 2 == 0; })
+                                | custom::pipeline::take(5)
+                                | custom::pipeline::parallel_to_vector(pool);
+      // verify
+      assertUnit(r.size() == 5);
+      assertUnit(r[0] == 0);
+      assertUnit(r[4] == 8);
+   }  // teardown
+
+   /***************************************
+    * SETUP STANDARD FIXTURE
+    *   {26, 49, 67, 89}
+    ***************************************/
+   void setupStandardFixture(custom::vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+};
+
+#endif // DEBUG
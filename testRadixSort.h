@@ -0,0 +1,297 @@
+/***********************************************************************
+ * Header:
+ *    TEST RADIX SORT
+ * Summary:
+ *    Unit tests for radix_sort and radix_sort_in_place
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "radix_sort.h" // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/***********************************************
+ * TEST RADIX SORT
+ * Unit tests for the radix sorts
+ ***********************************************/
+class TestRadixSort : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Keys
+      test_key_signed();
+      test_key_float();
+
+      // LSD
+      test_sort_standard();
+      test_sort_unsigned();
+      test_sort_signed();
+      test_sort_double();
+      test_sort_skipsConstantDigits();
+      test_sort_keyStable();
+      test_sort_parallel();
+
+      // MSD
+      test_inPlace_unsigned();
+      test_inPlace_float();
+      test_inPlace_key();
+
+      report("RadixSort");
+   }
+
+   /***************************************
+    * KEYS
+    ***************************************/
+
+   // negative below zero below positive
+   void test_key_signed()
+   {  // setup
+      // exercise
+      uint32_t minusOne = custom::radix_key<int>::encode(-1);
+      uint32_t zero     = custom::radix_key<int>::encode(0);
+      uint32_t one      = custom::radix_key<int>::encode(1);
+      uint32_t lowest   = custom::radix_key<int>::encode(-2147483647 - 1);
+      // verify
+      assertUnit(lowest == 0);
+      assertUnit(minusOne < zero);
+      assertUnit(zero < one);
+   }  // teardown
+
+   // the more negative a float, the smaller its key
+   void test_key_float()
+   {  // setup
+      float values[] = { -1e30f, -2.5f, -1.0f, -0.0f, 0.0f, 1e-30f, 1.0f, 2.5f, 1e30f };
+      // exercise
+      bool ordered = true;
+      for (size_t i = 1; i < sizeof(values) / sizeof(values[0]); i++)
+         if (!(custom::radix_key<float>::encode(values[i - 1]) <
+               custom::radix_key<float>::encode(values[i])))
+            ordered = false;
+      // verify
+      assertUnit(ordered);
+   }  // teardown
+
+   /***************************************
+    * LSD
+    ***************************************/
+
+   // the standard fixture, out of order
+   void test_sort_standard()
+   {  // setup
+      custom::vector<int> v;
+      v.push_back(67);
+      v.push_back(26);
+      v.push_back(89);
+      v.push_back(49);
+      // exercise
+      custom::radix_sort(v);
+      // verify
+      assertUnit(v.size() == 4);
+      assertUnit(v[0] == 26);
+      assertUnit(v[1] == 49);
+      assertUnit(v[2] == 67);
+      assertUnit(v[3] == 89);
+   }  // teardown
+
+   // every byte in play
+   void test_sort_unsigned()
+   {  // setup
+      custom::vector<uint32_t> v;
+      setupRandom(v, 10000, 0);
+      std::vector<uint32_t> expected = sorted(v);
+      // exercise
+      custom::radix_sort(v);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // negatives before positives
+   void test_sort_signed()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 10000, 1);
+      custom::vector<int64_t> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back(int64_t(int32_t(bits[i])) * 1000);
+      std::vector<int64_t> expected = sorted(v);
+      // exercise
+      custom::radix_sort(v);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // doubles of both signs and many sizes
+   void test_sort_double()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 10000, 2);
+      custom::vector<double> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back((double(int32_t(bits[i])) / 1000.0) * ((i % 7) ? 1.0 : 1e-200));
+      std::vector<double> expected = sorted(v);
+      // exercise
+      custom::radix_sort(v);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // IDs under 65536 in a 64-bit key need two passes, not eight
+   void test_sort_skipsConstantDigits()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 5000, 3);
+      custom::vector<uint64_t> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back(bits[i] & 0xFFFF);
+      std::vector<uint64_t> expected = sorted(v);
+      custom::radix_detail::identity key;
+      // exercise
+      size_t numPasses = custom::radix_detail::lsdSort(v.data, v.size(), key,
+                                                       custom::thread_pool::instance());
+      // verify
+      assertUnit(numPasses == 2);
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // records with the same key keep their order
+   void test_sort_keyStable()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 10000, 4);
+      custom::vector<Record> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back(Record(float(int(bits[i] % 50)) - 25.0f, int(i)));
+      // exercise
+      custom::radix_sort(v, [](const Record & r) { return r.key; });
+      // verify
+      bool stable = true;
+      for (size_t i = 1; i < v.size(); i++)
+         if (v[i - 1].key > v[i].key ||
+             (v[i - 1].key == v[i].key && v[i - 1].position > v[i].position))
+            stable = false;
+      assertUnit(stable);
+   }  // teardown
+
+   // enough for a block per thread on four threads
+   void test_sort_parallel()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<uint32_t> v;
+      setupRandom(v, 300000, 5);
+      std::vector<uint32_t> expected = sorted(v);
+      // exercise
+      custom::radix_sort(v, custom::radix_detail::identity(), pool);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   /***************************************
+    * MSD
+    ***************************************/
+
+   // every byte in play, with no buffer
+   void test_inPlace_unsigned()
+   {  // setup
+      custom::vector<uint32_t> v;
+      setupRandom(v, 20000, 6);
+      std::vector<uint32_t> expected = sorted(v);
+      // exercise
+      custom::radix_sort_in_place(v);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // floats of both signs
+   void test_inPlace_float()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 20000, 7);
+      custom::vector<float> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back(float(int32_t(bits[i])) / 65536.0f);
+      std::vector<float> expected = sorted(v);
+      // exercise
+      custom::radix_sort_in_place(v);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // records by key, with few distinct keys
+   void test_inPlace_key()
+   {  // setup
+      custom::vector<uint32_t> bits;
+      setupRandom(bits, 20000, 8);
+      custom::vector<Record> v;
+      for (size_t i = 0; i < bits.size(); i++)
+         v.push_back(Record(float(int(bits[i] % 10)), int(i)));
+      // exercise
+      custom::radix_sort_in_place(v, [](const Record & r) { return r.key; });
+      // verify
+      bool ordered = true;
+      for (size_t i = 1; i < v.size(); i++)
+         if (v[i - 1].key > v[i].key)
+            ordered = false;
+      assertUnit(ordered);
+      assertUnit(v.size() == 20000);
+   }  // teardown
+
+   // a key and where the record started
+   struct Record
+   {
+      Record() : key(0.0f), position(0) { }
+      Record(float key, int position) : key(key), position(position) { }
+      float key;
+      int   position;
+   };
+
+   /*************************************************************
+    * SETUP RANDOM
+    * num pseudo-random numbers, the same ones for the same seed
+    *************************************************************/
+   void setupRandom(custom::vector<uint32_t> & v, size_t num, uint32_t seed)
+   {
+      uint32_t x = 2463534242u + seed;
+      v.reserve(num);
+      for (size_t i = 0; i < num; i++)
+      {
+         x ^= x << 13;
+         x ^= x >> 17;
+         x ^= x << 5;
+         v.push_back(x);
+      }
+   }
+
+   template <typename T>
+   std::vector<T> sorted(const custom::vector<T> & v)
+   {
+      std::vector<T> copy;
+      for (size_t i = 0; i < v.size(); i++)
+         copy.push_back(v[i]);
+      std::sort(copy.begin(), copy.end());
+      return copy;
+   }
+
+   template <typename T>
+   bool same(const custom::vector<T> & v, const std::vector<T> & expected)
+   {
+      if (v.size() != expected.size())
+         return false;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != expected[i])
+            return false;
+      return true;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,301 @@
+/***********************************************************************
+ * Header:
+ *    TEST SCAN
+ * Summary:
+ *    Unit tests for the prefix sums in scan.h
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "scan.h"       // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+
+/***********************************************
+ * TEST SCAN
+ * Unit tests for the scans, on one thread and on
+ * every thread
+ ***********************************************/
+class TestScan : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Sequential
+      test_inclusive_standard();
+      test_exclusive_standard();
+      test_exclusive_offsets();
+      test_scan_inPlace();
+      test_scan_empty();
+      test_levels_agree();
+
+      // Segmented
+      test_segmented_inclusive();
+      test_segmented_exclusive();
+
+      // Parallel
+      test_parallel_inclusive();
+      test_parallel_exclusive();
+      test_parallel_segmented();
+
+      report("Scan");
+   }
+
+   /***************************************
+    * SEQUENTIAL
+    ***************************************/
+
+   // running totals of the standard fixture
+   void test_inclusive_standard()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      int total = custom::inclusive_scan(v, out);
+      // verify
+      assertUnit(out.size() == 4);
+      assertUnit(out[0] == 26);
+      assertUnit(out[1] == 26 + 49);
+      assertUnit(out[2] == 26 + 49 + 67);
+      assertUnit(out[3] == 26 + 49 + 67 + 89);
+      assertUnit(total == 231);
+   }  // teardown
+
+   // each total leaves out its own element, and starts from init
+   void test_exclusive_standard()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      // exercise
+      int total = custom::exclusive_scan(v, out, 100);
+      // verify
+      assertUnit(out.size() == 4);
+      assertUnit(out[0] == 100);
+      assertUnit(out[1] == 100 + 26);
+      assertUnit(out[2] == 100 + 26 + 49);
+      assertUnit(out[3] == 100 + 26 + 49 + 67);
+      assertUnit(total == 331);
+   }  // teardown
+
+   // row counts to CSR row offsets, long enough for several registers
+   void test_exclusive_offsets()
+   {  // setup
+      custom::vector<uint32_t> counts;
+      custom::vector<uint32_t> offsets;
+      for (uint32_t row = 0; row < 1000; row++)
+         counts.push_back(row % 4);
+      // exercise
+      uint32_t numValues = custom::exclusive_scan(counts, offsets);
+      // verify
+      bool allRight = offsets.size() == 1000;
+      uint32_t expected = 0;
+      for (size_t row = 0; row < offsets.size(); row++)
+      {
+         if (offsets[row] != expected)
+            allRight = false;
+         expected += counts[row];
+      }
+      assertUnit(allRight);
+      assertUnit(numValues == 1500);
+   }  // teardown
+
+   // out may be in
+   void test_scan_inPlace()
+   {  // setup
+      custom::vector<double> v;
+      for (int i = 0; i < 37; i++)
+         v.push_back(1.0);
+      // exercise
+      custom::inclusive_scan(v.slice(0, v.size()), v.slice(0, v.size()));
+      // verify
+      bool allRight = true;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != double(i + 1))
+            allRight = false;
+      assertUnit(allRight);
+   }  // teardown
+
+   // nothing to scan is init
+   void test_scan_empty()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> out;
+      // exercise
+      int total = custom::exclusive_scan(v, out, 7);
+      // verify
+      assertUnit(total == 7);
+      assertUnit(out.size() == 0);
+   }  // teardown
+
+   // every kernel this CPU can run gives the scalar answer
+   void test_levels_agree()
+   {  // setup
+      custom::vector<int64_t> v;
+      for (int i = 0; i < 1001; i++)
+         v.push_back((i * 7919) % 1009 - 500);
+      custom::vector<int64_t> inclusive(v.size(), 0);
+      custom::vector<int64_t> exclusive(v.size(), 0);
+      const int64_t * p = v.slice(0, v.size()).data();
+      custom::simd::scalar::inclusive_scan(p, inclusive.slice(0, v.size()).data(), v.size(), int64_t(5));
+      custom::simd::scalar::exclusive_scan(p, exclusive.slice(0, v.size()).data(), v.size(), int64_t(5));
+      bool allAgree = true;
+      // exercise
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         custom::simd::kernels<int64_t> k = custom::simd::kernels<int64_t>::at(custom::simd::level(l));
+         custom::vector<int64_t> a(v.size(), 0);
+         custom::vector<int64_t> b(v.size(), 0);
+         k.inclusive_scan(p, a.slice(0, a.size()).data(), v.size(), int64_t(5));
+         k.exclusive_scan(p, b.slice(0, b.size()).data(), v.size(), int64_t(5));
+         for (size_t i = 0; i < v.size(); i++)
+            if (a[i] != inclusive[i] || b[i] != exclusive[i])
+               allAgree = false;
+      }
+      // verify
+      assertUnit(allAgree);
+   }  // teardown
+
+   /***************************************
+    * SEGMENTED
+    ***************************************/
+
+   // the sum starts over at every flag
+   void test_segmented_inclusive()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<char> flags;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      flags.push_back(1);
+      flags.push_back(0);
+      flags.push_back(1);
+      flags.push_back(0);
+      // exercise
+      int last = custom::segmented_inclusive_scan(v, flags, out);
+      // verify
+      assertUnit(out.size() == 4);
+      assertUnit(out[0] == 26);
+      assertUnit(out[1] == 26 + 49);
+      assertUnit(out[2] == 67);
+      assertUnit(out[3] == 67 + 89);
+      assertUnit(last == 67 + 89);
+   }  // teardown
+
+   // each segment starts from init
+   void test_segmented_exclusive()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<char> flags;
+      custom::vector<int> out;
+      setupStandardFixture(v);
+      flags.push_back(0);
+      flags.push_back(1);
+      flags.push_back(0);
+      flags.push_back(1);
+      // exercise
+      custom::segmented_exclusive_scan(v, flags, out, 1);
+      // verify
+      assertUnit(out[0] == 1);
+      assertUnit(out[1] == 1);
+      assertUnit(out[2] == 1 + 49);
+      assertUnit(out[3] == 1);
+   }  // teardown
+
+   /***************************************
+    * PARALLEL
+    ***************************************/
+
+   // enough blocks that every one carries in from the last
+   void test_parallel_inclusive()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int64_t> v;
+      custom::vector<int64_t> out;
+      for (int64_t i = 0; i < 200000; i++)
+         v.push_back(i % 10);
+      // exercise
+      int64_t total = custom::parallel::inclusive_scan(v, out, int64_t(0), pool);
+      // verify
+      bool allRight = out.size() == v.size();
+      int64_t expected = 0;
+      for (size_t i = 0; i < v.size(); i++)
+      {
+         expected += v[i];
+         if (out[i] != expected)
+            allRight = false;
+      }
+      assertUnit(allRight);
+      assertUnit(total == expected);
+   }  // teardown
+
+   // in place, starting from init
+   void test_parallel_exclusive()
+   {  // setup
+      custom::thread_pool pool(3);
+      custom::vector<int> v;
+      for (int i = 0; i < 100003; i++)
+         v.push_back(1);
+      // exercise
+      int total = custom::parallel::exclusive_scan(v.slice(0, v.size()), v.slice(0, v.size()), 10, pool);
+      // verify
+      bool allRight = true;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != int(i) + 10)
+            allRight = false;
+      assertUnit(allRight);
+      assertUnit(total == 100013);
+   }  // teardown
+
+   // the same as one thread, with flags in some blocks and none in others
+   void test_parallel_segmented()
+   {  // setup
+      custom::thread_pool pool(4);
+      custom::vector<int64_t> v;
+      custom::vector<uint8_t> flags;
+      for (int i = 0; i < 150000; i++)
+      {
+         v.push_back(i % 7);
+         flags.push_back((i % 50000) == 1234 || i == 99999);
+      }
+      custom::vector<int64_t> inclusive;
+      custom::vector<int64_t> exclusive;
+      custom::segmented_inclusive_scan(v, flags, inclusive, int64_t(3));
+      custom::segmented_exclusive_scan(v, flags, exclusive, int64_t(3));
+      custom::vector<int64_t> a;
+      custom::vector<int64_t> b;
+      // exercise
+      int64_t lastA = custom::parallel::segmented_inclusive_scan(v, flags, a, int64_t(3), pool);
+      int64_t lastB = custom::parallel::segmented_exclusive_scan(v, flags, b, int64_t(3), pool);
+      // verify
+      bool allAgree = a.size() == v.size() && b.size() == v.size();
+      for (size_t i = 0; i < v.size(); i++)
+         if (a[i] != inclusive[i] || b[i] != exclusive[i])
+            allAgree = false;
+      assertUnit(allAgree);
+      assertUnit(lastA == inclusive[v.size() - 1]);
+      assertUnit(lastB == lastA);
+   }  // teardown
+
+   /***************************************
+    * SETUP STANDARD FIXTURE
+    *   {26, 49, 67, 89}
+    ***************************************/
+   void setupStandardFixture(custom::vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+};
+
+#endif // DEBUG
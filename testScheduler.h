@@ -0,0 +1,323 @@
+/***********************************************************************
+ * Header:
+ *    TEST SCHEDULER
+ * Summary:
+ *    Unit tests for chase_lev_deque and task_scheduler
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "scheduler.h"  // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/***********************************************
+ * TEST SCHEDULER
+ * Unit tests for the chase_lev_deque and the
+ * task_scheduler classes
+ ***********************************************/
+class TestScheduler : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Deque
+      test_deque_popIsLifo();
+      test_deque_stealIsFifo();
+      test_deque_grow();
+      test_deque_thievesTakeEachOnce();
+
+      // Fork and join
+      test_invoke_both();
+      test_invoke_nested();
+      test_invoke_rethrows();
+      test_forRange_uneven();
+      test_sleep_wakesForWork();
+
+      // Algorithms
+      test_reduce_onScheduler();
+      test_forEach_nestedParallel();
+
+      report("Scheduler");
+   }
+
+   /***************************************
+    * DEQUE
+    ***************************************/
+
+   // the owner works like a stack
+   void test_deque_popIsLifo()
+   {  // setup
+      int a[3] = { 26, 49, 67 };
+      custom::chase_lev_deque<int *> d;
+      // exercise
+      d.push(&a[0]);
+      d.push(&a[1]);
+      d.push(&a[2]);
+      // verify
+      assertUnit(d.size() == 3);
+      assertUnit(d.pop() == &a[2]);
+      assertUnit(d.pop() == &a[1]);
+      assertUnit(d.pop() == &a[0]);
+      assertUnit(d.pop() == nullptr);
+      assertUnit(d.size() == 0);
+   }  // teardown
+
+   // a thief takes the oldest
+   void test_deque_stealIsFifo()
+   {  // setup
+      int a[3] = { 26, 49, 67 };
+      custom::chase_lev_deque<int *> d;
+      d.push(&a[0]);
+      d.push(&a[1]);
+      d.push(&a[2]);
+      // exercise
+      int * first  = d.steal();
+      int * second = d.pop();
+      int * third  = d.steal();
+      // verify
+      assertUnit(first  == &a[0]);
+      assertUnit(second == &a[2]);
+      assertUnit(third  == &a[1]);
+      assertUnit(d.steal() == nullptr);
+   }  // teardown
+
+   // a full ring doubles and keeps its elements
+   void test_deque_grow()
+   {  // setup
+      std::vector<int> values(100);
+      custom::chase_lev_deque<int *> d(4);
+      // exercise
+      for (size_t i = 0; i < values.size(); i++)
+         d.push(&values[i]);
+      // verify
+      assertUnit(d.capacity() == 128);
+      assertUnit(d.rings.size() == 6);
+      assertUnit(d.steal() == &values[0]);
+      assertUnit(d.pop() == &values[99]);
+      assertUnit(d.size() == 98);
+   }  // teardown
+
+   // the owner and three thieves between them take every item once
+   void test_deque_thievesTakeEachOnce()
+   {  // setup
+      const int num = 20000;
+      std::vector<int> values(num);
+      std::vector<std::atomic<int>> taken(num);
+      for (int i = 0; i < num; i++)
+      {
+         values[i] = i;
+         taken[i] = 0;
+      }
+      custom::chase_lev_deque<int *> d(8);
+      std::atomic<bool> ownerDone(false);
+      // exercise
+      std::vector<std::thread> thieves;
+      for (int k = 0; k < 3; k++)
+         thieves.push_back(std::thread([&]
+         {
+            while (!ownerDone || d.size())
+            {
+               int * p = d.steal();
+               if (p)
+                  taken[*p]++;
+            }
+         }));
+      for (int i = 0; i < num; i++)
+      {
+         d.push(&values[i]);
+         if (i % 3 == 0)
+         {
+            int * p = d.pop();
+            if (p)
+               taken[*p]++;
+         }
+      }
+      ownerDone = true;
+      for (size_t k = 0; k < thieves.size(); k++)
+         thieves[k].join();
+      for (int * p = d.pop(); p; p = d.pop())
+         taken[*p]++;
+      // verify
+      bool eachOnce = true;
+      for (int i = 0; i < num; i++)
+         if (taken[i] != 1)
+            eachOnce = false;
+      assertUnit(eachOnce);
+   }  // teardown
+
+   /***************************************
+    * FORK AND JOIN
+    ***************************************/
+
+   // both halves run
+   void test_invoke_both()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      int left = 0;
+      int right = 0;
+      // exercise
+      scheduler.invoke([&] { left = 26; }, [&] { right = 49; });
+      // verify
+      assertUnit(scheduler.size() == 4);
+      assertUnit(left == 26);
+      assertUnit(right == 49);
+   }  // teardown
+
+   // a worker asleep with no time limit still wakes for a new task
+   void test_sleep_wakesForWork()
+   {  // setup
+      custom::task_scheduler scheduler(2);
+      std::chrono::steady_clock::time_point giveUp =
+         std::chrono::steady_clock::now() + std::chrono::seconds(5);
+      while (scheduler.numSleeping.load() == 0 && std::chrono::steady_clock::now() < giveUp)
+         std::this_thread::yield();
+      bool wasAsleep = scheduler.numSleeping.load() == 1;
+      std::atomic<bool> stolen(false);
+      // exercise: f only finishes once the worker has taken g
+      scheduler.invoke([&]
+      {
+         while (!stolen.load() && std::chrono::steady_clock::now() < giveUp)
+            std::this_thread::yield();
+      },
+      [&] { stolen = true; });
+      // verify
+      assertUnit(wasAsleep);
+      assertUnit(stolen.load());
+      assertUnit(std::chrono::steady_clock::now() < giveUp);
+   }  // teardown
+
+   // recursion many levels deep: the 20th Fibonacci number the slow way
+   void test_invoke_nested()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      // exercise
+      int result = fib(scheduler, 20);
+      // verify
+      assertUnit(result == 6765);
+   }  // teardown
+
+   // an exception in either half comes out of invoke()
+   void test_invoke_rethrows()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      bool threwLeft = false;
+      bool threwRight = false;
+      int right = 0;
+      // exercise
+      try
+      {
+         scheduler.invoke([] { throw std::runtime_error("left"); }, [&] { right = 49; });
+      }
+      catch (const std::runtime_error &)
+      {
+         threwLeft = true;
+      }
+      try
+      {
+         scheduler.invoke([] { }, [] { throw std::runtime_error("right"); });
+      }
+      catch (const std::runtime_error &)
+      {
+         threwRight = true;
+      }
+      // verify
+      assertUnit(threwLeft);
+      assertUnit(right == 49);
+      assertUnit(threwRight);
+   }  // teardown
+
+   // every index once, even when a few cost a thousand times the rest
+   void test_forRange_uneven()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      const size_t num = 10000;
+      std::vector<std::atomic<int>> visits(num);
+      for (size_t i = 0; i < num; i++)
+         visits[i] = 0;
+      std::atomic<long long> work(0);
+      // exercise
+      scheduler.for_range(0, num, 16, [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; i++)
+         {
+            long long cost = (i % 1000 == 0) ? 1000 : 1;
+            long long sum = 0;
+            for (long long k = 0; k < cost; k++)
+               sum += k;
+            work += sum;
+            visits[i]++;
+         }
+      });
+      // verify
+      bool eachOnce = true;
+      for (size_t i = 0; i < num; i++)
+         if (visits[i] != 1)
+            eachOnce = false;
+      assertUnit(eachOnce);
+      assertUnit(work == 10 * 499500LL);
+   }  // teardown
+
+   /***************************************
+    * ALGORITHMS
+    ***************************************/
+
+   // a parallel algorithm handed a scheduler instead of the pool
+   void test_reduce_onScheduler()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<int> v;
+      for (int i = 0; i < 1000000; i++)
+         v.push_back(i);
+      // exercise
+      long long sum = custom::parallel::reduce(v, 0LL, std::plus<long long>(), scheduler);
+      // verify
+      assertUnit(sum == 999999LL * 1000000 / 2);
+   }  // teardown
+
+   // a parallel call inside a task is itself split up, not run serially
+   void test_forEach_nestedParallel()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<int> outer;
+      for (int i = 0; i < 8; i++)
+         outer.push_back(i);
+      std::atomic<long long> total(0);
+      // exercise
+      custom::parallel::for_each(outer, [&](int & value)
+      {
+         custom::vector<int> inner;
+         for (int i = 0; i < 100000; i++)
+            inner.push_back(value);
+         total += custom::parallel::reduce(inner, 0LL, std::plus<long long>(), scheduler);
+      }, scheduler);
+      // verify
+      assertUnit(total == 100000LL * (0 + 1 + 2 + 3 + 4 + 5 + 6 + 7));
+   }  // teardown
+
+   // fib(n) with the two calls in parallel
+   static int fib(custom::task_scheduler & scheduler, int n)
+   {
+      if (n < 2)
+         return n;
+      int a = 0;
+      int b = 0;
+      scheduler.invoke([&] { a = fib(scheduler, n - 1); },
+                       [&] { b = fib(scheduler, n - 2); });
+      return a + b;
+   }
+};
+
+#endif // DEBUG
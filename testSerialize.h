@@ -0,0 +1,356 @@
+/***********************************************************************
+ * Header:
+ *    TEST SERIALIZE
+ * Summary:
+ *    Unit tests for saving and loading a vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "serialize.h"   // functions under test
+#include "unitTest.h"    // unit test baseclass
+
+#include <cstdio>        // for std::remove
+#include <fstream>
+#include <string>
+
+/***********************************************
+ * TEST SERIALIZE
+ * Unit tests for save() and load()
+ ***********************************************/
+class TestSerialize : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Round trip
+      test_roundTrip_empty();
+      test_roundTrip_standard();
+      test_roundTrip_codec();
+
+      // Header
+      test_header_layout();
+
+      // Errors
+      test_load_corruptPayload();
+      test_load_wrongType();
+      test_load_notOurs();
+      test_load_hugeCount();
+      test_load_countWraps();
+      test_load_payloadPastEnd();
+
+      report("Serialize");
+   }
+
+   /***************************************
+    * ROUND TRIP
+    ***************************************/
+
+   // an empty vector is just a header
+   void test_roundTrip_empty()
+   {  // setup
+      custom::vector<int> vSrc;
+      custom::vector<int> vDest;
+      // exercise
+      custom::save(FILE_NAME, vSrc);
+      custom::load(FILE_NAME, vDest);
+      // verify
+      assertUnit(fileSize() == sizeof(custom::serial_header));
+      assertUnit(vDest.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // ints are written as raw bytes
+   void test_roundTrip_standard()
+   {  // setup
+      custom::vector<int> vSrc;
+      setupStandardFixture(vSrc);
+      custom::vector<int> vDest;
+      // exercise
+      custom::save(FILE_NAME, vSrc);
+      custom::load(FILE_NAME, vDest);
+      // verify
+      assertUnit(fileSize() == sizeof(custom::serial_header) + 4 * sizeof(int));
+      assertUnit(vDest.size() == 4);
+      if (vDest.size() == 4)
+      {
+         assertUnit(vDest[0] == 26);
+         assertUnit(vDest[1] == 49);
+         assertUnit(vDest[2] == 67);
+         assertUnit(vDest[3] == 89);
+      }
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // strings go through their codec
+   void test_roundTrip_codec()
+   {  // setup
+      custom::vector<std::string> vSrc;
+      vSrc.push_back(std::string("twenty six"));
+      vSrc.push_back(std::string(""));
+      vSrc.push_back(std::string("eighty nine"));
+      custom::vector<std::string> vDest;
+      // exercise
+      custom::save(FILE_NAME, vSrc);
+      custom::load(FILE_NAME, vDest);
+      // verify
+      assertUnit(vDest.size() == 3);
+      if (vDest.size() == 3)
+      {
+         assertUnit(vDest[0] == "twenty six");
+         assertUnit(vDest[1] == "");
+         assertUnit(vDest[2] == "eighty nine");
+      }
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * HEADER
+    ***************************************/
+
+   // the header says what is in the file
+   void test_header_layout()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::save(FILE_NAME, v);
+      custom::serial_header header = {};
+      {
+         std::ifstream fin(FILE_NAME, std::ios::binary);
+         fin.read(reinterpret_cast<char *>(&header), sizeof(header));
+      }
+      // verify
+      assertUnit(header.magic == custom::serial_header::MAGIC);
+      assertUnit(header.version == custom::serial_header::VERSION);
+      assertUnit(header.endian == custom::serial_header::ENDIAN);
+      assertUnit(header.flags == 0);
+      assertUnit(header.elementSize == sizeof(int));
+      assertUnit(header.count == 4);
+      assertUnit(header.payloadBytes == 4 * sizeof(int));
+      assertUnit(header.checksum == custom::checksum(&v[0], 4 * sizeof(int)));
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * ERRORS
+    ***************************************/
+
+   // a flipped bit in the payload is caught and v is untouched
+   void test_load_corruptPayload()
+   {  // setup
+      custom::vector<int> vSrc;
+      setupStandardFixture(vSrc);
+      custom::save(FILE_NAME, vSrc);
+      {
+         std::fstream f(FILE_NAME, std::ios::binary | std::ios::in | std::ios::out);
+         f.seekp(sizeof(custom::serial_header) + 1);
+         f.put('\x7f');
+      }
+      custom::vector<int> vDest;
+      vDest.push_back(99);
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::load(FILE_NAME, vDest);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(vDest.size() == 1);
+      assertUnit(vDest[0] == 99);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a file of ints cannot be read as doubles
+   void test_load_wrongType()
+   {  // setup
+      custom::vector<int> vSrc;
+      setupStandardFixture(vSrc);
+      custom::save(FILE_NAME, vSrc);
+      custom::vector<double> vDest;
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::load(FILE_NAME, vDest);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(vDest.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // random bytes are not a vector file
+   void test_load_notOurs()
+   {  // setup
+      {
+         std::ofstream fout(FILE_NAME, std::ios::binary);
+         for (int i = 0; i < 100; i++)
+            fout.put('x');
+      }
+      custom::vector<int> v;
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::load(FILE_NAME, v);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a count the payload cannot hold is refused before anything is allocated
+   void test_load_hugeCount()
+   {  // setup
+      custom::vector<std::string> vSrc;
+      vSrc.push_back(std::string("twenty six"));
+      custom::save(FILE_NAME, vSrc);
+      custom::serial_header header = readHeader();
+      header.count = 1ull << 40;
+      writeHeader(header);
+      custom::vector<std::string> vDest;
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::load(FILE_NAME, vDest);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(vDest.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // count * elementSize wrapping around to payloadBytes is still caught
+   void test_load_countWraps()
+   {  // setup
+      custom::vector<int> vSrc;
+      setupStandardFixture(vSrc);
+      custom::save(FILE_NAME, vSrc);
+      custom::serial_header header = readHeader();
+      header.count += 1ull << 62;   // times four is the same 16 bytes
+      writeHeader(header);
+      custom::vector<int> vDest;
+      // exercise
+      bool thrown = false;
+      try
+      {
+         custom::load(FILE_NAME, vDest);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(vDest.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a payload longer than the file is a truncated file
+   void test_load_payloadPastEnd()
+   {  // setup
+      custom::vector<int> vSrc;
+      setupStandardFixture(vSrc);
+      custom::save(FILE_NAME, vSrc);
+      custom::serial_header header = readHeader();
+      header.count        = 1ull << 30;
+      header.payloadBytes = header.count * sizeof(int);
+      writeHeader(header);
+      custom::vector<int> vDest;
+      // exercise
+      std::string message;
+      try
+      {
+         custom::load(FILE_NAME, vDest);
+      }
+      catch (const std::runtime_error & e)
+      {
+         message = e.what();
+      }
+      // verify
+      assertUnit(message == "serialize: the file is truncated");
+      assertUnit(vDest.size() == 0);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /*************************************************************
+    * READ HEADER / WRITE HEADER
+    * Doctor the header of FILE_NAME
+    *************************************************************/
+   custom::serial_header readHeader()
+   {
+      custom::serial_header header = {};
+      std::ifstream fin(FILE_NAME, std::ios::binary);
+      fin.read(reinterpret_cast<char *>(&header), sizeof(header));
+      return header;
+   }
+
+   void writeHeader(const custom::serial_header & header)
+   {
+      std::fstream f(FILE_NAME, std::ios::binary | std::ios::in | std::ios::out);
+      f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * FILE SIZE
+    *************************************************************/
+   static size_t fileSize()
+   {
+      std::ifstream fin(FILE_NAME, std::ios::binary | std::ios::ate);
+      return fin ? size_t(fin.tellg()) : 0;
+   }
+
+   static constexpr const char * FILE_NAME = "testSerialize.bin";
+};
+
+#endif // DEBUG
@@ -0,0 +1,346 @@
+/***********************************************************************
+ * Header:
+ *    TEST SHM VECTOR
+ * Summary:
+ *    Unit tests for shm_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "shm_vector.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>     // for waitpid
+#include <unistd.h>       // for fork, getpid, _exit
+#endif
+
+/***********************************************
+ * TEST SHM VECTOR
+ * Unit tests for the shm_vector class
+ ***********************************************/
+class TestShmVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+#ifndef _WIN32
+      // Construct
+      test_construct_create();
+      test_construct_openElsewhere();
+      test_construct_wrongType();
+
+      // Write
+      test_write_grow();
+      test_write_staleWriter();
+      test_write_version();
+      test_get_outOfRange();
+
+      // Processes
+      test_fork_childWrites();
+      test_fork_noTornReads();
+      test_threads_shareOne();
+#endif // !_WIN32
+
+      report("ShmVector");
+   }
+
+#ifndef _WIN32
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // a new segment is empty with the capacity we asked for
+   void test_construct_create()
+   {  // setup
+      // exercise
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 10);
+      // verify
+      assertUnit(v.size() == 0);
+      assertUnit(v.empty());
+      assertUnit(v.capacity() == 10);
+      assertUnit(v.version() == 0);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // a second mapping, at another address, sees the same elements
+   void test_construct_openElsewhere()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 4);
+      setupStandardFixture(v);
+      // exercise
+      custom::shm_vector<int> vOther(segmentName());
+      // verify
+      assertUnit(vOther.base() != v.base());
+      assertStandardFixture(vOther);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // a segment of ints is not a segment of doubles
+   void test_construct_wrongType()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 4);
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::shm_vector<double> vOther(segmentName());
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   /***************************************
+    * WRITE
+    ***************************************/
+
+   // a reader mapped before the segment grew maps it again
+   void test_write_grow()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE);
+      custom::shm_vector<int> vReader(segmentName());
+      size_t mapBefore = vReader.mapping()->size;
+      // exercise
+      for (int i = 0; i < 10000; i++)
+         v.push_back(i);
+      // verify
+      assertUnit(v.capacity() >= 10000);
+      assertUnit(vReader.size() == 10000);
+      assertUnit(vReader.get(9999) == 9999);
+      assertUnit(vReader.mapping()->size > mapBefore);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // a writer mapped before someone else grew the segment maps it again first
+   void test_write_staleWriter()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE);
+      custom::shm_vector<int> vStale(segmentName());
+      for (int i = 0; i < 5000; i++)
+         v.push_back(i);
+      // exercise
+      vStale.set(4999, -1);
+      vStale.push_back(5000);
+      // verify
+      assertUnit(v.get(4999) == -1);
+      assertUnit(v.get(5000) == 5000);
+      assertUnit(vStale.mapping()->size >= vStale.segmentSize(vStale.capacity()));
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // every write moves the version along by one
+   void test_write_version()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 4);
+      // exercise
+      setupStandardFixture(v);
+      v.set(1, 99);
+      v.pop_back();
+      // verify
+      assertUnit(v.version() == 6);
+      assertUnit(v.size() == 3);
+      assertUnit(v.get(1) == 99);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // reading past the end throws
+   void test_get_outOfRange()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 4);
+      setupStandardFixture(v);
+      bool threw = false;
+      // exercise
+      try
+      {
+         v.get(4);
+      }
+      catch (const std::out_of_range &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   /***************************************
+    * PROCESSES
+    ***************************************/
+
+   // what a child process writes, the parent reads
+   void test_fork_childWrites()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, 1);
+      // exercise
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+         int status = 0;
+         try
+         {
+            custom::shm_vector<int> vChild(segmentName());
+            setupStandardFixture(vChild);
+         }
+         catch (...)
+         {
+            status = 1;
+         }
+         _exit(status);
+      }
+      int status = -1;
+      waitpid(pid, &status, 0);
+      // verify
+      assertUnit(pid > 0);
+      assertUnit(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+      assertStandardFixture(v);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   // a reader never sees half of a write
+   void test_fork_noTornReads()
+   {  // setup
+      const size_t num = 4096;
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE, num);
+      v.resize(num, 0);
+      // exercise
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+         int status = 0;
+         try
+         {
+            custom::shm_vector<int> vChild(segmentName());
+            custom::vector<int> values;
+            values.resize(num, 0);
+            for (int k = 1; k <= 500; k++)
+            {
+               for (size_t i = 0; i < num; i++)
+                  values[i] = k;
+               vChild.assign(values);
+            }
+         }
+         catch (...)
+         {
+            status = 1;
+         }
+         _exit(status);
+      }
+
+      bool allWhole = true;
+      int status = -1;
+      custom::vector<int> copy;
+      while (waitpid(pid, &status, WNOHANG) == 0)
+      {
+         v.snapshot(copy);
+         for (size_t i = 1; i < copy.size(); i++)
+            if (copy[i] != copy[0])
+               allWhole = false;
+      }
+      v.snapshot(copy);
+      // verify
+      assertUnit(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+      assertUnit(allWhole);
+      assertUnit(copy.size() == num);
+      assertUnit(copy[0] == 500 && copy[num - 1] == 500);
+      assertUnit(v.version() == 501);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   /***************************************
+    * THREADS
+    ***************************************/
+
+   // one shm_vector read by one thread while another grows it
+   void test_threads_shareOne()
+   {  // setup
+      custom::shm_vector<int> v(segmentName(), custom::shm_vector<int>::CREATE);
+      bool allInOrder = true;
+      // exercise
+      std::thread writer([&v]()
+      {
+         for (int i = 0; i < 20000; i++)
+            v.push_back(i);
+      });
+      while (v.size() < 20000)
+      {
+         size_t num = v.size();
+         if (num > 0 && v.get(num - 1) != int(num - 1))
+            allInOrder = false;
+      }
+      writer.join();
+      custom::vector<int> copy;
+      v.snapshot(copy);
+      // verify
+      assertUnit(allInOrder);
+      assertUnit(copy.size() == 20000);
+      assertUnit(copy[19999] == 19999);
+      // teardown
+      custom::shm_vector<int>::remove(segmentName());
+   }
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   static void setupStandardFixture(custom::shm_vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::shm_vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v.get(0) == 26);
+         assertIndirect(v.get(1) == 49);
+         assertIndirect(v.get(2) == 67);
+         assertIndirect(v.get(3) == 89);
+      }
+   }
+
+   // one name per test run, so two runs at once do not collide.
+   // The name is made once, so a forked child gets its parent's name.
+   static std::string segmentName()
+   {
+      static const std::string name = "/testShmVector." + std::to_string(getpid());
+      return name;
+   }
+#endif // !_WIN32
+};
+
+#endif // DEBUG
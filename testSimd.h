@@ -0,0 +1,256 @@
+/***********************************************************************
+ * Header:
+ *    TEST SIMD
+ * Summary:
+ *    Unit tests for the simd kernels
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "simd.h"       // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdint>
+
+/***********************************************
+ * TEST SIMD
+ * Unit tests for the kernels in custom::simd
+ ***********************************************/
+class TestSimd : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Reduce
+      test_sum_standard();
+      test_sum_int();
+      test_minMax_standard();
+      test_argmin_firstOfTies();
+      test_dot_standard();
+      test_countEqual_narrowLanes();
+
+      // Update
+      test_axpy_standard();
+      test_scale_slice();
+      test_clamp_standard();
+
+      // Levels
+      test_levels_agree();
+      test_kernels_boundToActive();
+
+      report("Simd");
+   }
+
+   /***************************************
+    * REDUCE
+    ***************************************/
+
+   // small, so it is all remainder, and the standard fixture
+   void test_sum_standard()
+   {  // setup
+      custom::vector<double> v;
+      setupStandardFixture(v);
+      // exercise
+      double sum = custom::simd::sum(v);
+      // verify
+      assertUnit(sum == 26.0 + 49.0 + 67.0 + 89.0);
+   }  // teardown
+
+   // long enough for all four running sums and a remainder
+   void test_sum_int()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 1; i <= 1001; i++)
+         v.push_back(i);
+      // exercise
+      int sum = custom::simd::sum(v);
+      // verify
+      assertUnit(sum == 1001 * 1002 / 2);
+   }  // teardown
+
+   // the extremes sit in the remainder and mid-register
+   void test_minMax_standard()
+   {  // setup
+      custom::vector<float> v;
+      for (int i = 0; i < 103; i++)
+         v.push_back(float(i % 10));
+      v[37] = -5.5f;
+      v[102] = 99.0f;
+      // exercise
+      float smallest = custom::simd::min(v);
+      float largest  = custom::simd::max(v);
+      // verify
+      assertUnit(smallest == -5.5f);
+      assertUnit(largest == 99.0f);
+   }  // teardown
+
+   // of two equal smallest, the first
+   void test_argmin_firstOfTies()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 200; i++)
+         v.push_back(100 - i % 50);
+      v[70] = -3;
+      v[150] = -3;
+      // exercise
+      size_t index = custom::simd::argmin(v);
+      // verify
+      assertUnit(index == 70);
+   }  // teardown
+
+   // the standard fixture with itself
+   void test_dot_standard()
+   {  // setup
+      custom::vector<double> v;
+      setupStandardFixture(v);
+      // exercise
+      double dot = custom::simd::dot(v, v);
+      // verify
+      assertUnit(dot == 26.0 * 26 + 49.0 * 49 + 67.0 * 67 + 89.0 * 89);
+   }  // teardown
+
+   // more matches than a byte-wide lane counter could hold
+   void test_countEqual_narrowLanes()
+   {  // setup
+      custom::vector<int8_t> v;
+      for (int i = 0; i < 100000; i++)
+         v.push_back(int8_t(i % 4));
+      // exercise
+      size_t num = custom::simd::count_equal(v, int8_t(3));
+      // verify
+      assertUnit(num == 25000);
+   }  // teardown
+
+   /***************************************
+    * UPDATE
+    ***************************************/
+
+   // y += 2x, across registers and the remainder
+   void test_axpy_standard()
+   {  // setup
+      custom::vector<float> x;
+      custom::vector<float> y;
+      for (int i = 0; i < 37; i++)
+      {
+         x.push_back(float(i));
+         y.push_back(1.0f);
+      }
+      // exercise
+      custom::simd::axpy(2.0f, x, y);
+      // verify
+      bool right = true;
+      for (int i = 0; i < 37; i++)
+         if (y[i] != 1.0f + 2.0f * i)
+            right = false;
+      assertUnit(right);
+      assertUnit(x[36] == 36.0f);
+   }  // teardown
+
+   // only the slice is scaled
+   void test_scale_slice()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 50; i++)
+         v.push_back(i);
+      // exercise
+      custom::simd::scale(3, v.slice(10, 30));
+      // verify
+      assertUnit(v[9] == 9);
+      assertUnit(v[10] == 30);
+      assertUnit(v[39] == 117);
+      assertUnit(v[40] == 40);
+   }  // teardown
+
+   // below, inside, and above the range
+   void test_clamp_standard()
+   {  // setup
+      custom::vector<double> v;
+      setupStandardFixture(v);
+      // exercise
+      custom::simd::clamp(v, 40.0, 70.0);
+      // verify
+      assertUnit(v[0] == 40.0);
+      assertUnit(v[1] == 49.0);
+      assertUnit(v[2] == 67.0);
+      assertUnit(v[3] == 70.0);
+   }  // teardown
+
+   /***************************************
+    * LEVELS
+    ***************************************/
+
+   // every level this CPU can run gives the scalar answers
+   void test_levels_agree()
+   {  // setup
+      custom::vector<int> v;
+      custom::vector<int> w;
+      for (int i = 0; i < 1000; i++)
+      {
+         v.push_back((i * 7919) % 1009 - 500);
+         w.push_back(i % 3);
+      }
+      const int * p = v.slice(0, v.size()).data();
+      const int * q = w.slice(0, w.size()).data();
+      size_t n = v.size();
+      int sum = custom::simd::scalar::sum(p, n);
+      int dot = custom::simd::scalar::dot(p, q, n);
+      int smallest = custom::simd::scalar::min(p, n);
+      int largest = custom::simd::scalar::max(p, n);
+      size_t found = custom::simd::scalar::find(p, n, 123);
+      size_t num = custom::simd::scalar::count_equal(q, n, 2);
+      // exercise
+      bool allAgree = true;
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         custom::simd::kernels<int> k = custom::simd::kernels<int>::at(custom::simd::level(l));
+         allAgree = allAgree &&
+                    k.sum(p, n) == sum &&
+                    k.dot(p, q, n) == dot &&
+                    k.min(p, n) == smallest &&
+                    k.max(p, n) == largest &&
+                    k.find(p, n, 123) == found &&
+                    k.count_equal(q, n, 2) == num;
+      }
+      // verify
+      assertUnit(allAgree);
+      assertUnit(found < n);
+      assertUnit(num == 333);
+   }  // teardown
+
+   // the kernels called through simd:: are the ones for active_level()
+   void test_kernels_boundToActive()
+   {  // setup
+      custom::simd::kernels<float> expected =
+         custom::simd::kernels<float>::at(custom::simd::active_level());
+      // exercise
+      const custom::simd::kernels<float> & bound = custom::simd::kernels<float>::active();
+      // verify
+      assertUnit(bound.sum == expected.sum);
+      assertUnit(bound.dot == expected.dot);
+      assertUnit(bound.count_equal == expected.count_equal);
+      assertUnit(custom::simd::active_level() <= custom::simd::detected_level());
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::vector<double> & v)
+   {
+      v.push_back(26.0);
+      v.push_back(49.0);
+      v.push_back(67.0);
+      v.push_back(89.0);
+   }
+};
+
+#endif // DEBUG
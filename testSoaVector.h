@@ -0,0 +1,341 @@
+/***********************************************************************
+ * Header:
+ *    TEST SOA VECTOR
+ * Summary:
+ *    Unit tests for soa_vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "soa_vector.h"   // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <new>
+#include <tuple>
+
+/***********************************************
+ * GRUMPY
+ * A field whose buffers cannot be allocated
+ * once it is told to refuse
+ ***********************************************/
+struct Grumpy
+{
+   static bool refuse;
+   Grumpy() : value(0) { if (refuse) throw std::bad_alloc(); }
+   int value;
+};
+bool Grumpy::refuse = false;
+
+/***********************************************
+ * PICKY
+ * A field that cannot be copied once it is told
+ * to refuse, and whose move might throw
+ ***********************************************/
+struct Picky
+{
+   static bool refuse;
+   Picky() : value(0) { }
+   Picky(const Picky & rhs) : value(rhs.value) { }
+   Picky & operator = (const Picky & rhs)
+   {
+      if (refuse)
+         throw std::bad_alloc();
+      value = rhs.value;
+      return *this;
+   }
+   int value;
+};
+bool Picky::refuse = false;
+
+/***********************************************
+ * TEST SOA VECTOR
+ * Unit tests for the soa_vector class
+ ***********************************************/
+class TestSoaVector : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructCopy_standard();
+      test_constructMove_standard();
+
+      // Insert
+      test_pushback_tuple();
+      test_pushback_fields();
+      test_reserve_keepsRecords();
+      test_reserve_throwKeepsRecords();
+      test_reserve_throwMovingKeepsRecords();
+      test_resize_valueInitialized();
+
+      // Access
+      test_column_contiguous();
+      test_row_readWrite();
+
+      // Remove
+      test_shrink_standard();
+
+      report("SoaVector");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // default constructor, no allocations
+   void test_construct_default()
+   {
+      // exercise
+      custom::soa_vector<int, double> v;
+      // verify
+      assertUnit(std::get<0>(v.data) == nullptr);
+      assertUnit(std::get<1>(v.data) == nullptr);
+      assertUnit(v.numElements == 0);
+      assertUnit(v.numCapacity == 0);
+   }  // teardown
+
+   // copy constructor duplicates every column
+   void test_constructCopy_standard()
+   {  // setup
+      custom::soa_vector<int, double> vSrc;
+      setupStandardFixture(vSrc);
+      // exercise
+      custom::soa_vector<int, double> vDest(vSrc);
+      // verify
+      assertStandardFixture(vSrc);
+      assertStandardFixture(vDest);
+      assertUnit(std::get<0>(vDest.data) != std::get<0>(vSrc.data));
+      assertUnit(std::get<1>(vDest.data) != std::get<1>(vSrc.data));
+   }  // teardown
+
+   // move constructor steals every column
+   void test_constructMove_standard()
+   {  // setup
+      custom::soa_vector<int, double> vSrc;
+      setupStandardFixture(vSrc);
+      int * pInts = std::get<0>(vSrc.data);
+      // exercise
+      custom::soa_vector<int, double> vDest(std::move(vSrc));
+      // verify
+      assertStandardFixture(vDest);
+      assertUnit(std::get<0>(vDest.data) == pInts);
+      assertUnit(std::get<0>(vSrc.data) == nullptr);
+      assertUnit(vSrc.numElements == 0);
+      assertUnit(vSrc.numCapacity == 0);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // push a tuple into an empty soa_vector
+   void test_pushback_tuple()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      // exercise
+      v.push_back(std::make_tuple(26, 2.6));
+      // verify
+      assertUnit(v.numElements == 1);
+      assertUnit(v.numCapacity == 1);
+      assertUnit(std::get<0>(v.data)[0] == 26);
+      assertUnit(std::get<1>(v.data)[0] == 2.6);
+   }  // teardown
+
+   // push the fields one at a time, doubling as we go
+   void test_pushback_fields()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      // exercise
+      v.push_back(26, 2.6);
+      v.push_back(49, 4.9);
+      v.push_back(67, 6.7);
+      // verify
+      assertUnit(v.numElements == 3);
+      assertUnit(v.numCapacity == 4);
+      assertUnit(std::get<0>(v.data)[2] == 67);
+      assertUnit(std::get<1>(v.data)[2] == 6.7);
+   }  // teardown
+
+   // growing the capacity keeps the records
+   void test_reserve_keepsRecords()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      setupStandardFixture(v);
+      // exercise
+      v.reserve(10);
+      // verify
+      assertUnit(v.numCapacity == 10);
+      assertUnit(v.numElements == 4);
+      assertUnit(std::get<0>(v.data)[3] == 89);
+      assertUnit(std::get<1>(v.data)[3] == 8.9);
+   }  // teardown
+
+   // a column that cannot be allocated frees the ones before it and
+   // leaves the records where they were
+   void test_reserve_throwKeepsRecords()
+   {  // setup
+      custom::soa_vector<Grumpy, int> v;
+      v.push_back(Grumpy(), 26);
+      v.push_back(Grumpy(), 49);
+      int * ints = std::get<1>(v.data);
+      bool threw = false;
+      // exercise
+      Grumpy::refuse = true;
+      try
+      {
+         v.reserve(10);
+      }
+      catch (const std::bad_alloc &)
+      {
+         threw = true;
+      }
+      Grumpy::refuse = false;
+      // verify
+      assertUnit(threw);
+      assertUnit(v.numElements == 2);
+      assertUnit(v.numCapacity < 10);
+      assertUnit(std::get<1>(v.data) == ints);
+      assertUnit(std::get<1>(v.data)[1] == 49);
+   }  // teardown
+
+   // a column that throws while it moves leaves every column, even
+   // the ones already moved, in their old buffers
+   void test_reserve_throwMovingKeepsRecords()
+   {  // setup
+      custom::soa_vector<int, Picky> v;
+      v.push_back(26, Picky());
+      v.push_back(49, Picky());
+      int * ints = std::get<0>(v.data);
+      bool threw = false;
+      // exercise
+      Picky::refuse = true;
+      try
+      {
+         v.reserve(10);
+      }
+      catch (const std::bad_alloc &)
+      {
+         threw = true;
+      }
+      Picky::refuse = false;
+      // verify
+      assertUnit(threw);
+      assertUnit(v.numElements == 2);
+      assertUnit(v.numCapacity < 10);
+      assertUnit(std::get<0>(v.data) == ints);
+      assertUnit(std::get<0>(v.data)[0] == 26);
+      assertUnit(std::get<0>(v.data)[1] == 49);
+      v.push_back(67, Picky());
+      assertUnit(v.numElements == 3);
+      assertUnit(std::get<0>(v.data)[2] == 67);
+   }  // teardown
+
+   // new records are zero in every column
+   void test_resize_valueInitialized()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      setupStandardFixture(v);
+      // exercise
+      v.resize(6);
+      // verify
+      assertUnit(v.numElements == 6);
+      assertUnit(std::get<0>(v.data)[0] == 26);
+      assertUnit(std::get<0>(v.data)[5] == 0);
+      assertUnit(std::get<1>(v.data)[5] == 0.0);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // a column is the raw array of that one field
+   void test_column_contiguous()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      setupStandardFixture(v);
+      // exercise
+      auto ints = v.column<0>();
+      int sum = 0;
+      for (int value : ints)
+         sum += value;
+      // verify
+      assertUnit(ints.size() == 4);
+      assertUnit(ints.data() == std::get<0>(v.data));
+      assertUnit(sum == 26 + 49 + 67 + 89);
+   }  // teardown
+
+   // the row proxy reads and writes through to the columns
+   void test_row_readWrite()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      setupStandardFixture(v);
+      // exercise
+      v[1].get<0>() = 99;
+      v[2] = std::make_tuple(11, 1.1);
+      std::tuple<int, double> record = v[1];
+      // verify
+      assertUnit(std::get<0>(record) == 99);
+      assertUnit(std::get<1>(record) == 4.9);
+      assertUnit(std::get<0>(v.data)[2] == 11);
+      assertUnit(std::get<1>(v.data)[2] == 1.1);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // shrinking drops the spare capacity of every column
+   void test_shrink_standard()
+   {  // setup
+      custom::soa_vector<int, double> v;
+      setupStandardFixture(v);
+      v.reserve(10);
+      // exercise
+      v.shrink_to_fit();
+      // verify
+      assertStandardFixture(v);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *    |2.6 |4.9 |6.7 |8.9 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::soa_vector<int, double> & v)
+   {
+      v.push_back(26, 2.6);
+      v.push_back(49, 4.9);
+      v.push_back(67, 6.7);
+      v.push_back(89, 8.9);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::soa_vector<int, double> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.numElements == 4);
+      assertIndirect(v.numCapacity == 4);
+      if (std::get<0>(v.data) != nullptr && std::get<1>(v.data) != nullptr)
+      {
+         assertIndirect(std::get<0>(v.data)[0] == 26);
+         assertIndirect(std::get<0>(v.data)[3] == 89);
+         assertIndirect(std::get<1>(v.data)[0] == 2.6);
+         assertIndirect(std::get<1>(v.data)[3] == 8.9);
+      }
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,236 @@
+/***********************************************************************
+ * Header:
+ *    TEST SORT
+ * Summary:
+ *    Unit tests for parallel_sort and parallel_stable_sort
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "sort.h"       // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/***********************************************
+ * TEST SORT
+ * Unit tests for the parallel sorts
+ ***********************************************/
+class TestSort : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Small
+      test_sort_empty();
+      test_sort_standard();
+
+      // Merge sort
+      test_sort_mergeRandom();
+      test_sort_descending();
+      test_stableSort_keepsOrder();
+      test_sort_slice();
+
+      // Sample sort
+      test_sort_sampleRandom();
+      test_sort_sampleFewKeys();
+
+      report("Sort");
+   }
+
+   /***************************************
+    * SMALL
+    ***************************************/
+
+   // nothing to sort
+   void test_sort_empty()
+   {  // setup
+      custom::vector<int> v;
+      // exercise
+      custom::parallel_sort(v);
+      custom::parallel_stable_sort(v);
+      // verify
+      assertUnit(v.size() == 0);
+   }  // teardown
+
+   // the standard fixture, out of order
+   void test_sort_standard()
+   {  // setup
+      custom::vector<int> v;
+      v.push_back(67);
+      v.push_back(26);
+      v.push_back(89);
+      v.push_back(49);
+      // exercise
+      custom::parallel_sort(v);
+      // verify
+      assertStandardFixture(v);
+   }  // teardown
+
+   /***************************************
+    * MERGE SORT
+    ***************************************/
+
+   // enough to split and merge many times on four threads
+   void test_sort_mergeRandom()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<uint32_t> v;
+      setupRandom(v, 200000, 0);
+      std::vector<uint32_t> expected(v.slice(0, v.size()).begin(), v.slice(0, v.size()).end());
+      std::sort(expected.begin(), expected.end());
+      // exercise
+      custom::parallel_sort(v, std::less<uint32_t>(), scheduler);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // a comparison other than less
+   void test_sort_descending()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<int> v;
+      for (int i = 0; i < 100000; i++)
+         v.push_back(i);
+      // exercise
+      custom::parallel_stable_sort(v, std::greater<int>(), scheduler);
+      // verify
+      bool descending = true;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != int(v.size() - 1 - i))
+            descending = false;
+      assertUnit(descending);
+   }  // teardown
+
+   // records with equal keys come out in the order they went in
+   void test_stableSort_keepsOrder()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<uint64_t> v;
+      custom::vector<uint32_t> keys;
+      setupRandom(keys, 100000, 7);
+      for (size_t i = 0; i < keys.size(); i++)
+         v.push_back(uint64_t(keys[i] % 100) << 32 | i);   // key, then position
+      // exercise
+      custom::parallel_stable_sort(v, [](uint64_t a, uint64_t b) { return (a >> 32) < (b >> 32); },
+                                   scheduler);
+      // verify
+      bool stable = true;
+      for (size_t i = 1; i < v.size(); i++)
+         if (v[i - 1] > v[i])   // the key, then the position, never goes down
+            stable = false;
+      assertUnit(stable);
+   }  // teardown
+
+   // only the slice is sorted
+   void test_sort_slice()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<int> v;
+      for (int i = 0; i < 50000; i++)
+         v.push_back(50000 - i);
+      // exercise
+      custom::parallel_sort(v.slice(100, 40000), std::less<int>(), scheduler);
+      // verify
+      bool sorted = true;
+      for (size_t i = 101; i < 40100; i++)
+         if (v[i - 1] > v[i])
+            sorted = false;
+      assertUnit(sorted);
+      assertUnit(v[0] == 50000);
+      assertUnit(v[100] == 50000 - 40099);
+      assertUnit(v[40100] == 50000 - 40100);
+   }  // teardown
+
+   /***************************************
+    * SAMPLE SORT
+    ***************************************/
+
+   // big enough for the sample sort
+   void test_sort_sampleRandom()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<uint32_t> v;
+      setupRandom(v, 1500000, 1);
+      std::vector<uint32_t> expected(v.slice(0, v.size()).begin(), v.slice(0, v.size()).end());
+      std::sort(expected.begin(), expected.end());
+      // exercise
+      custom::parallel_sort(v, std::less<uint32_t>(), scheduler);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   // so few distinct keys that most buckets are empty and one is huge
+   void test_sort_sampleFewKeys()
+   {  // setup
+      custom::task_scheduler scheduler(4);
+      custom::vector<uint32_t> v;
+      setupRandom(v, 1200000, 2);
+      for (size_t i = 0; i < v.size(); i++)
+         v[i] = (v[i] % 1000 == 0) ? v[i] : 5;
+      std::vector<uint32_t> expected(v.slice(0, v.size()).begin(), v.slice(0, v.size()).end());
+      std::sort(expected.begin(), expected.end());
+      // exercise
+      custom::parallel_sort(v, std::less<uint32_t>(), scheduler);
+      // verify
+      assertUnit(same(v, expected));
+   }  // teardown
+
+   /*************************************************************
+    * SETUP RANDOM
+    * num pseudo-random numbers, the same ones for the same seed
+    *************************************************************/
+   void setupRandom(custom::vector<uint32_t> & v, size_t num, uint32_t seed)
+   {
+      uint32_t x = 2463534242u + seed;
+      v.reserve(num);
+      for (size_t i = 0; i < num; i++)
+      {
+         x ^= x << 13;
+         x ^= x >> 17;
+         x ^= x << 5;
+         v.push_back(x);
+      }
+   }
+
+   bool same(const custom::vector<uint32_t> & v, const std::vector<uint32_t> & expected)
+   {
+      if (v.size() != expected.size())
+         return false;
+      for (size_t i = 0; i < v.size(); i++)
+         if (v[i] != expected[i])
+            return false;
+      return true;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+};
+
+#endif // DEBUG
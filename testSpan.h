@@ -0,0 +1,254 @@
+/***********************************************************************
+ * Header:
+ *    TEST SPAN
+ * Summary:
+ *    Unit tests for span, strided_view, and vector::slice
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "span.h"       // class under test
+#include "vector.h"     // for slice
+#include "unitTest.h"   // unit test baseclass
+
+#include <vector>
+
+/***********************************************
+ * TEST SPAN
+ * Unit tests for the span and strided_view classes
+ ***********************************************/
+class TestSpan : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_stdVector();
+      test_construct_toConst();
+
+      // Views
+      test_subspan_standard();
+      test_firstLast_standard();
+      test_slice_writesThrough();
+      test_slice_const();
+
+      // Strided
+      test_strided_standard();
+      test_strided_offset();
+      test_strided_iterate();
+
+      report("Span");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // an empty view of nothing
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::span<int> s;
+      // verify
+      assertUnit(s.data() == nullptr);
+      assertUnit(s.size() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // a std::vector lends its buffer, not a copy
+   void test_construct_stdVector()
+   {  // setup
+      std::vector<int> v = { 26, 49, 67, 89 };
+      // exercise
+      custom::span<int> s(v);
+      // verify
+      assertUnit(s.data() == v.data());
+      assertStandardFixture(s);
+   }  // teardown
+
+   // a span of int can be passed where a span of const int is wanted
+   void test_construct_toConst()
+   {  // setup
+      int array[] = { 26, 49, 67, 89 };
+      custom::span<int> s(array);
+      // exercise
+      custom::span<const int> sConst(s);
+      // verify
+      assertUnit(sConst.data() == array);
+      assertUnit(sConst.size() == 4);
+      assertUnit(sConst.size_bytes() == 4 * sizeof(int));
+   }  // teardown
+
+   /***************************************
+    * VIEWS
+    ***************************************/
+
+   // the middle two
+   //      0    1    2    3
+   //    +----+----+----+----+
+   //    | 26 | 49 | 67 | 89 |
+   //    +----+----+----+----+
+   //           ^^^^^^^^^
+   void test_subspan_standard()
+   {  // setup
+      int array[] = { 26, 49, 67, 89 };
+      custom::span<int> s(array);
+      // exercise
+      custom::span<int> sMiddle = s.subspan(1, 2);
+      custom::span<int> sRest   = s.subspan(3);
+      // verify
+      assertUnit(sMiddle.size() == 2);
+      assertUnit(sMiddle.data() == array + 1);
+      assertUnit(sMiddle[0] == 49);
+      assertUnit(sMiddle.back() == 67);
+      assertUnit(sRest.size() == 1);
+      assertUnit(sRest.front() == 89);
+      assertUnit(s.subspan(4).empty());
+   }  // teardown
+
+   // first and last take from either end
+   void test_firstLast_standard()
+   {  // setup
+      int array[] = { 26, 49, 67, 89 };
+      custom::span<int> s(array);
+      // exercise
+      custom::span<int> sFirst = s.first(3);
+      custom::span<int> sLast  = s.last(3);
+      // verify
+      assertUnit(sFirst.size() == 3);
+      assertUnit(sFirst.front() == 26 && sFirst.back() == 67);
+      assertUnit(sLast.size() == 3);
+      assertUnit(sLast.front() == 49 && sLast.back() == 89);
+      assertUnit(s.first(0).empty());
+   }  // teardown
+
+   // a slice is the vector's own elements
+   void test_slice_writesThrough()
+   {  // setup
+      custom::vector<int> v;
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+      // exercise
+      custom::span<int> s = v.slice(1, 2);
+      for (int & value : s)
+         value += 100;
+      // verify
+      assertUnit(s.data() == v.data + 1);
+      assertUnit(v.size() == 4);
+      assertUnit(v[0] == 26);
+      assertUnit(v[1] == 149);
+      assertUnit(v[2] == 167);
+      assertUnit(v[3] == 89);
+   }  // teardown
+
+   // a const vector hands out a read-only slice
+   void test_slice_const()
+   {  // setup
+      custom::vector<int> v;
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+      const custom::vector<int> & vConst = v;
+      // exercise
+      custom::span<const int> s = vConst.slice(0, 4);
+      // verify
+      assertStandardFixture(s);
+      assertUnit(vConst.slice(4, 0).empty());
+   }  // teardown
+
+   /***************************************
+    * STRIDED
+    ***************************************/
+
+   // every third element, where the last is not a full stride from the end
+   //      0    1    2    3    4    5    6
+   //    +----+----+----+----+----+----+----+
+   //    |  0 |  1 |  2 |  3 |  4 |  5 |  6 |
+   //    +----+----+----+----+----+----+----+
+   //      ^^             ^^             ^^
+   void test_strided_standard()
+   {  // setup
+      int array[] = { 0, 1, 2, 3, 4, 5, 6 };
+      custom::span<int> s(array);
+      // exercise
+      custom::strided_view<int> every3 = s.strided(3);
+      // verify
+      assertUnit(every3.size() == 3);
+      assertUnit(every3.stride() == 3);
+      assertUnit(every3[0] == 0);
+      assertUnit(every3[1] == 3);
+      assertUnit(every3[2] == 6);
+      assertUnit(!every3.is_contiguous());
+      assertUnit(s.strided(1).is_contiguous());
+      assertUnit(s.strided(1).contiguous().size() == 7);
+   }  // teardown
+
+   // the odd elements of interleaved pairs, and an offset past the end
+   void test_strided_offset()
+   {  // setup
+      int array[] = { 0, 1, 2, 3, 4, 5, 6 };
+      custom::span<int> s(array);
+      // exercise
+      custom::strided_view<int> odd = s.strided(2, 1);
+      odd[1] = 99;
+      // verify
+      assertUnit(odd.size() == 3);
+      assertUnit(odd[0] == 1);
+      assertUnit(array[3] == 99);
+      assertUnit(odd[2] == 5);
+      assertUnit(s.strided(2, 7).empty());
+   }  // teardown
+
+   // walking a strided view visits what operator [] does
+   void test_strided_iterate()
+   {  // setup
+      int array[] = { 26, 0, 49, 0, 67, 0, 89, 0 };
+      custom::span<int> s(array);
+      custom::strided_view<int> even = s.strided(2);
+      // exercise
+      int sum = 0;
+      int num = 0;
+      for (int value : even)
+      {
+         sum += value;
+         num++;
+      }
+      // verify
+      assertUnit(num == 4);
+      assertUnit(sum == 26 + 49 + 67 + 89);
+   }  // teardown
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   template <typename T>
+   void assertStandardFixtureParameters(const custom::span<T> & s,
+                                        int line, const char * function)
+   {
+      assertIndirect(s.size() == 4);
+      if (s.size() == 4)
+      {
+         assertIndirect(s[0] == 26);
+         assertIndirect(s[1] == 49);
+         assertIndirect(s[2] == 67);
+         assertIndirect(s[3] == 89);
+      }
+   }
+};
+
+#endif // DEBUG
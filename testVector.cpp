@@ -13,6 +13,30 @@
 
 #include "testVector.h"     // for the vector unit tests
 #include "testSpy.h"        // for the spy unit tests
+#include "testSoaVector.h"  // for the soa_vector unit tests
+#include "testAlignedVector.h" // for the aligned_vector unit tests
+#include "testHugePage.h"   // for the huge_page unit tests
+#include "testMmapVector.h" // for the mmap_vector unit tests
+#include "testSerialize.h"  // for the serialize unit tests
+#include "testVectorStream.h" // for the vector_stream unit tests
+#include "testExternalVector.h" // for the external_vector unit tests
+#include "testLogVector.h"  // for the log_vector unit tests
+#include "testCheckpoint.h" // for the checkpoint unit tests
+#include "testVectorPatch.h" // for the vector_patch unit tests
+#include "testShmVector.h"  // for the shm_vector unit tests
+#include "testArrow.h"      // for the arrow unit tests
+#include "testNullableVector.h" // for the nullable_vector unit tests
+#include "testSpan.h"       // for the span unit tests
+#include "testParallel.h"   // for the parallel unit tests
+#include "testScheduler.h"  // for the scheduler unit tests
+#include "testSort.h"       // for the sort unit tests
+#include "testRadixSort.h"  // for the radix_sort unit tests
+#include "testSimd.h"       // for the simd unit tests
+#include "testCpuFeatures.h" // for the cpu features unit tests
+#include "testExpr.h"       // for the expression template unit tests
+#include "testPipeline.h"   // for the pipeline unit tests
+#include "testScan.h"       // for the scan unit tests
+#include "testCompact.h"    // for the compaction unit tests
 int Spy::counters[] = {};
 
 
@@ -26,6 +50,30 @@ int main()
    // unit tests
    TestSpy().run();
    TestVector().run();
+   TestSoaVector().run();
+   TestAlignedVector().run();
+   TestHugePage().run();
+   TestMmapVector().run();
+   TestSerialize().run();
+   TestVectorStream().run();
+   TestExternalVector().run();
+   TestLogVector().run();
+   TestCheckpoint().run();
+   TestVectorPatch().run();
+   TestShmVector().run();
+   TestArrow().run();
+   TestNullableVector().run();
+   TestSpan().run();
+   TestParallel().run();
+   TestScheduler().run();
+   TestSort().run();
+   TestRadixSort().run();
+   TestSimd().run();
+   TestCpuFeatures().run();
+   TestExpr().run();
+   TestPipeline().run();
+   TestScan().run();
+   TestCompact().run();
 #endif // DEBUG
    
    return 0;
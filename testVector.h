@@ -117,6 +117,14 @@ public:
       test_capacity_empty();
       test_capacity_full();
 
+      // Ownership
+      test_adopt_deleter();
+      test_adopt_growFreesBuffer();
+      test_release_standard();
+      test_fromStd_zeroCopy();
+      test_toStd_roundTrip();
+      test_toStd_fromNew();
+
       report("Vector");
    }
    
@@ -873,6 +881,122 @@ public:
       teardownStandardFixture(v);
    }
    
+   /***************************************
+    * OWNERSHIP
+    ***************************************/
+
+   // a deleter that counts the buffers it frees in *context
+   static void countingDeleter(int * p, void * context)
+   {
+      (*static_cast<int *>(context))++;
+      delete [] p;
+   }
+
+   // an adopted buffer goes to its deleter, not to delete []
+   void test_adopt_deleter()
+   {  // setup
+      int numDeleted = 0;
+      int * p = new int[4];
+      p[0] = 26; p[1] = 49; p[2] = 67; p[3] = 89;
+      {
+         custom::vector<int> v;
+         // exercise
+         v.adopt(p, 4, 4, &countingDeleter, &numDeleted);
+         // verify
+         assertUnit(v.data == p);
+         assertStandardFixture(v);
+         assertUnit(numDeleted == 0);
+      }
+      assertUnit(numDeleted == 1);
+   }  // teardown
+
+   // growing out of an adopted buffer frees it with its deleter
+   void test_adopt_growFreesBuffer()
+   {  // setup
+      int numDeleted = 0;
+      int * p = new int[2];
+      p[0] = 26; p[1] = 49;
+      custom::vector<int> v;
+      v.adopt(p, 2, 2, &countingDeleter, &numDeleted);
+      // exercise
+      v.push_back(67);
+      // verify
+      assertUnit(numDeleted == 1);
+      assertUnit(v.data != p);
+      assertUnit(v.deleter == NULL);
+      assertUnit(v.size() == 3);
+      assertUnit(v[2] == 67);
+   }  // teardown
+
+   // release gives the buffer away and leaves the vector empty
+   void test_release_standard()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      int * p = v.data;
+      // exercise
+      custom::vector<int>::buffer b = v.release();
+      // verify
+      assertUnit(b.data == p);
+      assertUnit(b.size == 4);
+      assertUnit(b.capacity == 4);
+      assertUnit(b.deleter == NULL);
+      assertEmptyFixture(v);
+      // teardown
+      b.free();
+   }
+
+   // a std::vector's buffer moves over without a copy
+   void test_fromStd_zeroCopy()
+   {  // setup
+      std::vector<int> vStd;
+      vStd.reserve(6);
+      vStd.push_back(26);
+      vStd.push_back(49);
+      vStd.push_back(67);
+      vStd.push_back(89);
+      const int * p = vStd.data();
+      // exercise
+      custom::vector<int> v = custom::from_std(std::move(vStd));
+      // verify
+      assertUnit(v.data == p);
+      assertUnit(v.capacity() == 6);
+      assertUnit(v.size() == 4);
+      assertUnit(v[0] == 26);
+      assertUnit(v[3] == 89);
+   }  // teardown
+
+   // and goes back the same way
+   void test_toStd_roundTrip()
+   {  // setup
+      std::vector<int> vStd(4, 0);
+      const int * p = vStd.data();
+      custom::vector<int> v = custom::from_std(std::move(vStd));
+      v[0] = 26; v[1] = 49; v[2] = 67;
+      v.pop_back();
+      // exercise
+      std::vector<int> vBack = custom::to_std(std::move(v));
+      // verify
+      assertUnit(vBack.data() == p);
+      assertUnit(vBack.size() == 3);
+      assertUnit(vBack[2] == 67);
+      assertUnit(v.data == NULL);
+   }  // teardown
+
+   // a buffer from new [] has to be moved element by element
+   void test_toStd_fromNew()
+   {  // setup
+      custom::vector<int> v;
+      setupStandardFixture(v);
+      // exercise
+      std::vector<int> vStd = custom::to_std(std::move(v));
+      // verify
+      assertUnit(vStd.size() == 4);
+      assertUnit(vStd[0] == 26);
+      assertUnit(vStd[3] == 89);
+      assertEmptyFixture(v);
+   }  // teardown
+
    /***************************************
     * ASSIGN COPY
     ***************************************/
@@ -0,0 +1,551 @@
+/***********************************************************************
+ * Header:
+ *    TEST VECTOR PATCH
+ * Summary:
+ *    Unit tests for diff and apply
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "vector_patch.h" // class under test
+#include "unitTest.h"     // unit test baseclass
+
+#include <string>
+
+/***********************************************
+ * TEST VECTOR PATCH
+ * Unit tests for the patch between two vectors
+ ***********************************************/
+class TestVectorPatch : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Matching
+      test_matching_allSame();
+      test_matching_everyOffset();
+      test_matching_everyLevel();
+
+      // Diff
+      test_diff_same();
+      test_diff_oneChange();
+      test_diff_fill();
+      test_diff_grow();
+      test_diff_shrink();
+      test_diff_insertFront();
+      test_diff_deleteFront();
+
+      // Apply
+      test_apply_roundTrip();
+      test_apply_oneReallocation();
+      test_apply_string();
+      test_apply_wrongVector();
+      test_apply_badPatch();
+      test_apply_shifts();
+      test_apply_copyOutOfOrder();
+      test_apply_overlapDown();
+      test_apply_overlapUp();
+      test_apply_overlapString();
+
+      report("VectorPatch");
+   }
+
+   /***************************************
+    * MATCHING
+    ***************************************/
+
+   // two copies match all the way
+   void test_matching_allSame()
+   {  // setup
+      unsigned char a[100];
+      unsigned char b[100];
+      for (int i = 0; i < 100; i++)
+         a[i] = b[i] = (unsigned char)i;
+      // exercise
+      size_t num = custom::matching_bytes(a, b, 100);
+      // verify
+      assertUnit(num == 100);
+   }  // teardown
+
+   // the first difference is found wherever it is, SIMD block or tail
+   void test_matching_everyOffset()
+   {  // setup
+      unsigned char a[100];
+      unsigned char b[100];
+      for (int i = 0; i < 100; i++)
+         a[i] = b[i] = (unsigned char)i;
+      bool allFound = true;
+      // exercise
+      for (size_t i = 0; i < 100; i++)
+      {
+         b[i] = 0xff;
+         if (custom::matching_bytes(a, b, 100) != i)
+            allFound = false;
+         b[i] = a[i];
+      }
+      // verify
+      assertUnit(allFound);
+   }  // teardown
+
+   // every version this CPU can run finds the same first difference
+   void test_matching_everyLevel()
+   {  // setup
+      unsigned char a[100];
+      unsigned char b[100];
+      for (int i = 0; i < 100; i++)
+         a[i] = b[i] = (unsigned char)i;
+      bool allFound = true;
+      // exercise
+      for (int l = custom::simd::SCALAR; l <= custom::simd::detected_level(); l++)
+      {
+         custom::patch_detail::matching_fn matching =
+            custom::patch_detail::matchingAt(custom::simd::level(l));
+         for (size_t i = 0; i < 100; i++)
+         {
+            b[i] = 0xff;
+            if (matching(a, b, 100) != i || matching(a, b, i) != i)
+               allFound = false;
+            b[i] = a[i];
+         }
+         if (matching(a, b, 100) != 100)
+            allFound = false;
+      }
+      // verify
+      assertUnit(allFound);
+   }  // teardown
+
+   /***************************************
+    * DIFF
+    ***************************************/
+
+   // no change is a single KEEP
+   void test_diff_same()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      setupStandardFixture(b);
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.ops.size() == 1);
+      assertUnit(p.ops[0].kind == custom::patch<int>::KEEP);
+      assertUnit(p.ops[0].count == 4);
+      assertUnit(p.literals.empty());
+   }  // teardown
+
+   // one changed element in a long vector costs one literal
+   void test_diff_oneChange()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      for (int i = 0; i < 1000; i++)
+      {
+         a.push_back(i);
+         b.push_back(i);
+      }
+      b[500] = -1;
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.ops.size() == 3);
+      assertUnit(p.literals.size() == 1);
+      assertUnit(p.literals[0] == -1);
+      assertUnit(p.size_bytes() < 100);
+   }  // teardown
+
+   // a long run of one value is a FILL
+   void test_diff_fill()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      for (int i = 0; i < 100; i++)
+      {
+         a.push_back(i);
+         b.push_back(i < 10 || i >= 90 ? i : 7);
+      }
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.ops.size() == 3);
+      assertUnit(p.ops[1].kind == custom::patch<int>::FILL);
+      assertUnit(p.ops[1].count == 80);
+      assertUnit(p.literals.size() == 1);
+   }  // teardown
+
+   // new elements at the end are literals
+   void test_diff_grow()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      setupStandardFixture(b);
+      b.push_back(99);
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.oldSize == 4);
+      assertUnit(p.newSize == 5);
+      assertUnit(p.ops.size() == 2);
+      assertUnit(p.literals.size() == 1);
+      assertUnit(p.literals[0] == 99);
+   }  // teardown
+
+   // dropping elements from the end needs no literals
+   void test_diff_shrink()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      setupStandardFixture(b);
+      a.push_back(99);
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.newSize == 4);
+      assertUnit(p.ops.size() == 1);
+      assertUnit(p.literals.empty());
+   }  // teardown
+
+   // one element inserted near the front is a literal and a COPY of the rest
+   void test_diff_insertFront()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      for (int i = 0; i < 1000; i++)
+         a.push_back(i);
+      for (int i = 0; i < 1000; i++)
+      {
+         if (i == 3)
+            b.push_back(-1);
+         b.push_back(i);
+      }
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.ops.size() == 3);
+      assertUnit(p.ops[2].kind == custom::patch<int>::COPY);
+      assertUnit(p.ops[2].source == 3);
+      assertUnit(p.ops[2].count == 997);
+      assertUnit(p.literals.size() == 1);
+      assertUnit(p.size_bytes() < 100);
+   }  // teardown
+
+   // elements deleted near the front need no literals at all
+   void test_diff_deleteFront()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      for (int i = 0; i < 1000; i++)
+      {
+         a.push_back(i);
+         if (i < 10 || i >= 15)
+            b.push_back(i);
+      }
+      // exercise
+      custom::patch<int> p = custom::diff(a, b);
+      // verify
+      assertUnit(p.ops.size() == 2);
+      assertUnit(p.ops[1].kind == custom::patch<int>::COPY);
+      assertUnit(p.ops[1].source == 15);
+      assertUnit(p.literals.empty());
+   }  // teardown
+
+   /***************************************
+    * APPLY
+    ***************************************/
+
+   // a patched copy of a is b, for a mix of every kind of change
+   void test_apply_roundTrip()
+   {  // setup
+      custom::vector<double> a;
+      custom::vector<double> b;
+      for (int i = 0; i < 300; i++)
+         a.push_back(i * 0.5);
+      for (int i = 0; i < 350; i++)
+         b.push_back(i % 7 == 0 ? -1.0 : (i > 100 && i < 150 ? 3.0 : i * 0.5));
+      custom::patch<double> p = custom::diff(a, b);
+      // exercise
+      custom::apply(a, p);
+      // verify
+      assertUnit(a.size() == 350);
+      bool allSame = a.size() == 350;
+      for (size_t i = 0; allSame && i < 350; i++)
+         allSame = a[i] == b[i];
+      assertUnit(allSame);
+   }  // teardown
+
+   // growing past the capacity allocates exactly once, for the new size
+   void test_apply_oneReallocation()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      for (int i = 0; i < 100; i++)
+         b.push_back(i);
+      custom::patch<int> p = custom::diff(a, b);
+      // exercise
+      custom::apply(a, p);
+      // verify
+      assertUnit(a.capacity() == 100);
+      assertUnit(a.size() == 100);
+      assertUnit(a[0] == 0);
+      assertUnit(a[99] == 99);
+   }  // teardown
+
+   // a T that is not trivially copyable uses operator ==
+   void test_apply_string()
+   {  // setup
+      custom::vector<std::string> a;
+      custom::vector<std::string> b;
+      a.push_back("alpha");
+      a.push_back("beta");
+      a.push_back("gamma");
+      b.push_back("alpha");
+      b.push_back("BETA");
+      custom::patch<std::string> p = custom::diff(a, b);
+      // exercise
+      custom::apply(a, p);
+      // verify
+      assertUnit(p.literals.size() == 1);
+      assertUnit(a.size() == 2);
+      assertUnit(a[0] == "alpha");
+      assertUnit(a[1] == "BETA");
+   }  // teardown
+
+   // a patch made from another vector is refused
+   void test_apply_wrongVector()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      b.push_back(1);
+      custom::patch<int> p = custom::diff(b, a);
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::apply(a, p);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertStandardFixture(a);
+   }  // teardown
+
+   // a patch whose operations do not add up leaves the vector alone
+   void test_apply_badPatch()
+   {  // setup
+      custom::vector<int> a;
+      custom::vector<int> b;
+      setupStandardFixture(a);
+      setupStandardFixture(b);
+      b[1] = 99;
+      custom::patch<int> p = custom::diff(a, b);
+      p.literals.pop_back();
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::apply(a, p);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertStandardFixture(a);
+   }  // teardown
+
+   // COPY moving elements up and down, with changes around them
+   void test_apply_shifts()
+   {  // setup
+      custom::vector<int> base;
+      for (int i = 0; i < 500; i++)
+         base.push_back(i * 3);
+      custom::vector<int> inserted;
+      custom::vector<int> deleted;
+      for (int i = 0; i < 500; i++)
+      {
+         if (i == 50)
+            for (int j = 0; j < 20; j++)
+               inserted.push_back(-j);
+         inserted.push_back(i == 30 ? 7 : i * 3);
+         if (i < 40 || i >= 60)
+            deleted.push_back(i == 20 ? 7 : i * 3);
+      }
+      custom::vector<int> a(base);
+      custom::vector<int> b(base);
+      custom::patch<int> up   = custom::diff(a, inserted);
+      custom::patch<int> down = custom::diff(b, deleted);
+      // exercise
+      custom::apply(a, up);
+      custom::apply(b, down);
+      // verify
+      bool allSame = a.size() == inserted.size() && b.size() == deleted.size();
+      for (size_t i = 0; allSame && i < a.size(); i++)
+         allSame = a[i] == inserted[i];
+      for (size_t i = 0; allSame && i < b.size(); i++)
+         allSame = b[i] == deleted[i];
+      assertUnit(allSame);
+      assertUnit(up.ops.back().kind == custom::patch<int>::COPY);
+      assertUnit(down.ops.back().kind == custom::patch<int>::COPY);
+   }  // teardown
+
+   // COPY sources that go back down could read what another COPY wrote
+   void test_apply_copyOutOfOrder()
+   {  // setup
+      custom::vector<int> a;
+      setupStandardFixture(a);
+      custom::patch<int> p;
+      p.oldSize = p.newSize = 4;
+      custom::patch<int>::op o = {};
+      o.kind   = custom::patch<int>::COPY;
+      o.count  = 2;
+      o.source = 2;
+      p.ops.push_back(o);
+      o.source = 0;
+      p.ops.push_back(o);
+      bool threw = false;
+      // exercise
+      try
+      {
+         custom::apply(a, p);
+      }
+      catch (const std::runtime_error &)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertStandardFixture(a);
+   }  // teardown
+
+   // a COPY down by one overlaps all but one of the elements it reads
+   void test_apply_overlapDown()
+   {  // setup
+      custom::vector<int> a;
+      for (int i = 0; i < 100; i++)
+         a.push_back(i);
+      custom::patch<int> p;
+      p.oldSize = 100;
+      p.newSize = 99;
+      custom::patch<int>::op o = {};
+      o.kind   = custom::patch<int>::COPY;
+      o.count  = 99;
+      o.source = 1;
+      p.ops.push_back(o);
+      // exercise
+      custom::apply(a, p);
+      // verify
+      bool allSame = a.size() == 99;
+      for (size_t i = 0; allSame && i < a.size(); i++)
+         allSame = a[i] == int(i) + 1;
+      assertUnit(allSame);
+   }  // teardown
+
+   // a COPY up by one overlaps all but one of the elements it writes
+   void test_apply_overlapUp()
+   {  // setup
+      custom::vector<int> a;
+      for (int i = 0; i < 100; i++)
+         a.push_back(i);
+      custom::patch<int> p;
+      p.oldSize = 100;
+      p.newSize = 101;
+      custom::patch<int>::op o = {};
+      o.kind  = custom::patch<int>::REPLACE;
+      o.count = 1;
+      p.ops.push_back(o);
+      o.kind   = custom::patch<int>::COPY;
+      o.count  = 100;
+      o.source = 0;
+      p.ops.push_back(o);
+      p.literals.push_back(-1);
+      // exercise
+      custom::apply(a, p);
+      // verify
+      bool allSame = a.size() == 101 && a[0] == -1;
+      for (size_t i = 1; allSame && i < a.size(); i++)
+         allSame = a[i] == int(i) - 1;
+      assertUnit(allSame);
+   }  // teardown
+
+   // a T that is not trivially copyable shifts both ways without memmove
+   void test_apply_overlapString()
+   {  // setup
+      custom::vector<std::string> a;
+      custom::vector<std::string> b;
+      custom::vector<std::string> up;
+      custom::vector<std::string> down;
+      for (int i = 0; i < 50; i++)
+      {
+         a.push_back(std::to_string(i));
+         b.push_back(std::to_string(i));
+      }
+      up.push_back("new");
+      for (int i = 0; i < 50; i++)
+      {
+         up.push_back(std::to_string(i));
+         if (i != 0)
+            down.push_back(std::to_string(i));
+      }
+      custom::patch<std::string> pUp   = custom::diff(a, up);
+      custom::patch<std::string> pDown = custom::diff(b, down);
+      // exercise
+      custom::apply(a, pUp);
+      custom::apply(b, pDown);
+      // verify
+      bool allSame = a.size() == up.size() && b.size() == down.size();
+      for (size_t i = 0; allSame && i < a.size(); i++)
+         allSame = a[i] == up[i];
+      for (size_t i = 0; allSame && i < b.size(); i++)
+         allSame = b[i] == down[i];
+      assertUnit(allSame);
+      assertUnit(pUp.ops.back().kind == custom::patch<std::string>::COPY);
+      assertUnit(pDown.ops.back().kind == custom::patch<std::string>::COPY);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *      0    1    2    3
+    *    +----+----+----+----+
+    *    | 26 | 49 | 67 | 89 |
+    *    +----+----+----+----+
+    *************************************************************/
+   void setupStandardFixture(custom::vector<int> & v)
+   {
+      v.push_back(26);
+      v.push_back(49);
+      v.push_back(67);
+      v.push_back(89);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE PARAMETERS
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::vector<int> & v,
+                                        int line, const char * function)
+   {
+      assertIndirect(v.size() == 4);
+      if (v.size() == 4)
+      {
+         assertIndirect(v[0] == 26);
+         assertIndirect(v[1] == 49);
+         assertIndirect(v[2] == 67);
+         assertIndirect(v[3] == 89);
+      }
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,264 @@
+/***********************************************************************
+ * Header:
+ *    TEST VECTOR STREAM
+ * Summary:
+ *    Unit tests for vector_stream_reader and vector_stream_writer
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "vector_stream.h"   // classes under test
+#include "unitTest.h"        // unit test baseclass
+
+#include <cstdio>            // for std::remove
+#include <fstream>
+
+/***********************************************
+ * TEST VECTOR STREAM
+ * Unit tests for the stream reader and writer
+ ***********************************************/
+class TestVectorStream : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Checksum
+      test_checksumBuilder_pieces();
+
+      // Writer
+      test_writer_flushesFullBatches();
+      test_writer_writeWholeVector();
+
+      // Reader
+      test_reader_empty();
+      test_reader_sameBatches();
+      test_reader_acrossChunks();
+      test_reader_prefetch();
+      test_reader_noReallocate();
+      test_reader_corruptChunk();
+
+      report("VectorStream");
+   }
+
+   /***************************************
+    * CHECKSUM
+    ***************************************/
+
+   // feeding the bytes in odd pieces gives the same checksum
+   void test_checksumBuilder_pieces()
+   {  // setup
+      char bytes[100];
+      for (int i = 0; i < 100; i++)
+         bytes[i] = char(i * 7);
+      custom::checksum_builder builder;
+      // exercise
+      builder.update(bytes,      3);
+      builder.update(bytes + 3,  13);
+      builder.update(bytes + 16, 0);
+      builder.update(bytes + 16, 81);
+      // verify
+      assertUnit(builder.finish() == custom::checksum(bytes, 97));
+   }  // teardown
+
+   /***************************************
+    * WRITER
+    ***************************************/
+
+   // a chunk goes out each time the batch fills, and the rest on close
+   void test_writer_flushesFullBatches()
+   {  // setup
+      custom::vector_stream_writer<int> writer(FILE_NAME, 4);
+      // exercise
+      for (int i = 0; i < 10; i++)
+         writer.push_back(i);
+      size_t sizeBeforeClose = fileSize();
+      writer.close();
+      // verify
+      assertUnit(sizeBeforeClose == 16 + 2 * (16 + 4 * sizeof(int)));
+      assertUnit(fileSize() == 16 + 3 * 16 + 10 * sizeof(int));
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a whole vector is one chunk
+   void test_writer_writeWholeVector()
+   {  // setup
+      custom::vector<int> v;
+      for (int i = 0; i < 10; i++)
+         v.push_back(i);
+      // exercise
+      {
+         custom::vector_stream_writer<int> writer(FILE_NAME, 4);
+         writer.write(v);
+      }
+      // verify
+      assertUnit(fileSize() == 16 + 16 + 10 * sizeof(int));
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /***************************************
+    * READER
+    ***************************************/
+
+   // nothing in the stream
+   void test_reader_empty()
+   {  // setup
+      {
+         custom::vector_stream_writer<int> writer(FILE_NAME, 4);
+      }
+      custom::vector<int> batch;
+      // exercise
+      custom::vector_stream_reader<int> reader(FILE_NAME, 4);
+      bool more = reader.next(batch);
+      // verify
+      assertUnit(!more);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // batches read back the way they were written
+   void test_reader_sameBatches()
+   {  // setup
+      setupStream(10, 4);
+      custom::vector<int> batch;
+      custom::vector_stream_reader<int> reader(FILE_NAME, 4, false /*prefetch*/);
+      // exercise
+      bool first  = reader.next(batch) && batch.size() == 4 && batch[0] == 0 && batch[3] == 3;
+      bool second = reader.next(batch) && batch.size() == 4 && batch[0] == 4 && batch[3] == 7;
+      bool third  = reader.next(batch) && batch.size() == 2 && batch[0] == 8 && batch[1] == 9;
+      bool fourth = reader.next(batch);
+      // verify
+      assertUnit(first);
+      assertUnit(second);
+      assertUnit(third);
+      assertUnit(!fourth);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // the reader's batches need not match the writer's chunks
+   void test_reader_acrossChunks()
+   {  // setup
+      setupStream(100, 7);
+      custom::vector<int> batch;
+      custom::vector_stream_reader<int> reader(FILE_NAME, 10, false /*prefetch*/);
+      // exercise
+      int expected = 0;
+      int numBatches = 0;
+      bool inOrder = true;
+      while (reader.next(batch))
+      {
+         numBatches++;
+         for (size_t i = 0; i < batch.size(); i++)
+            inOrder = inOrder && batch[i] == expected++;
+      }
+      // verify
+      assertUnit(inOrder);
+      assertUnit(expected == 100);
+      assertUnit(numBatches == 10);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // the background reader gives the same answer
+   void test_reader_prefetch()
+   {  // setup
+      setupStream(1000, 64);
+      custom::vector<int> batch;
+      custom::vector_stream_reader<int> reader(FILE_NAME, 100, true /*prefetch*/);
+      // exercise
+      int expected = 0;
+      bool inOrder = true;
+      while (reader.next(batch))
+         for (size_t i = 0; i < batch.size(); i++)
+            inOrder = inOrder && batch[i] == expected++;
+      // verify
+      assertUnit(inOrder);
+      assertUnit(expected == 1000);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // once both buffers are sized, the batches just trade places
+   void test_reader_noReallocate()
+   {  // setup
+      setupStream(100, 10);
+      custom::vector<int> batch;
+      custom::vector_stream_reader<int> reader(FILE_NAME, 10, true /*prefetch*/);
+      reader.next(batch);
+      reader.next(batch);
+      int * pFirst  = &batch[0];
+      reader.next(batch);
+      int * pSecond = &batch[0];
+      // exercise
+      reader.next(batch);
+      int * pThird  = &batch[0];
+      reader.next(batch);
+      int * pFourth = &batch[0];
+      // verify
+      assertUnit(pFirst  != pSecond);
+      assertUnit(pThird  == pFirst);
+      assertUnit(pFourth == pSecond);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   // a damaged chunk is reported
+   void test_reader_corruptChunk()
+   {  // setup
+      setupStream(10, 4);
+      {
+         std::fstream f(FILE_NAME, std::ios::binary | std::ios::in | std::ios::out);
+         f.seekp(16 + 16 + 1);
+         f.put('\x7f');
+      }
+      custom::vector<int> batch;
+      custom::vector_stream_reader<int> reader(FILE_NAME, 4);
+      // exercise
+      bool thrown = false;
+      try
+      {
+         while (reader.next(batch))
+            ;
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      std::remove(FILE_NAME);
+   }
+
+   /*************************************************************
+    * SETUP STREAM
+    * The numbers 0 .. num-1 written in chunks of batchSize
+    *************************************************************/
+   void setupStream(int num, size_t batchSize)
+   {
+      custom::vector_stream_writer<int> writer(FILE_NAME, batchSize);
+      for (int i = 0; i < num; i++)
+         writer.push_back(i);
+   }
+
+   /*************************************************************
+    * FILE SIZE
+    *************************************************************/
+   static size_t fileSize()
+   {
+      std::ifstream fin(FILE_NAME, std::ios::binary | std::ios::ate);
+      return fin ? size_t(fin.tellg()) : 0;
+   }
+
+   static constexpr const char * FILE_NAME = "testVectorStream.bin";
+};
+
+#endif // DEBUG
@@ -15,6 +15,8 @@
  *    This will contain the class definition of:
  *        vector                 : A class that represents a Vector
  *        vector::iterator       : An interator through Vector
+ *        vector::slice          : A span of part of a Vector
+ *        from_std, to_std       : Trade buffers with std::vector
  * Author
  *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
  ************************************************************************/
@@ -24,6 +26,10 @@
 #include <cassert>  // because I am paranoid
 #include <new>      // std::bad_alloc
 #include <memory>   // for std::allocator
+#include <utility>  // for std::move
+#include <vector>   // for from_std and to_std
+
+#include "span.h"   // for slice
 
 #include <iostream>
 
@@ -31,6 +37,11 @@
 namespace custom
 {
 
+namespace expr
+{
+   template <class E> struct expression;   // in expr.h
+}
+
 /*****************************************
  * VECTOR
  * Just like the std :: vector <T> class
@@ -50,6 +61,8 @@ public:
    vector(const std::initializer_list<T>& l );
    vector(const vector &  rhs);
    vector(      vector && rhs);
+   template <class E>
+   vector(const expr::expression<E> & e);  // in expr.h
    ~vector();
 
    //
@@ -69,9 +82,19 @@ public:
        size_t tempCapacity = rhs.numCapacity;
        rhs.numCapacity = numCapacity;
        numCapacity = tempCapacity;
+
+       deleter_type tempDeleter = rhs.deleter;
+       rhs.deleter = deleter;
+       deleter = tempDeleter;
+
+       void * tempContext = rhs.context;
+       rhs.context = context;
+       context = tempContext;
    }
    vector & operator = (const vector & rhs);
    vector& operator = (vector&& rhs);
+   template <class E>
+   vector & operator = (const expr::expression<E> & e);  // in expr.h
 
    //
    // Iterator
@@ -92,6 +115,10 @@ public:
          T& back();
    const T& back() const;
 
+   // a view of count elements from start on, without copying them
+   span<T>       slice(size_t start, size_t count);
+   span<const T> slice(size_t start, size_t count) const;
+
    //
    // Insert
    //
@@ -109,7 +136,6 @@ public:
    void clear()
    {
        numElements = 0;
-       delete[] data;
    }
    void pop_back()
    {
@@ -126,19 +152,63 @@ public:
    size_t   capacity()      const { return numCapacity;}
    bool     empty()               { return (begin() == end() ? true : false);}
    
-   // adjust the size of the buffer
-   
-   // vector-specific interfaces
-   
+   //
+   // Ownership
+   //
+
+   // how to free a buffer that did not come from new []
+   typedef void (*deleter_type)(T * p, void * context);
+
+   // a buffer released from a vector, with all it takes to free it
+   struct buffer
+   {
+      T *          data;
+      size_t       size;        // elements in use
+      size_t       capacity;    // elements constructed
+      deleter_type deleter;     // NULL means delete []
+      void *       context;     // handed to the deleter
+
+      void free()
+      {
+         if (data != NULL)
+         {
+            if (deleter != NULL)
+               deleter(data, context);
+            else
+               delete [] data;
+         }
+         data = NULL;
+      }
+   };
+
+   // take over a buffer of capacity constructed elements, size in use
+   void   adopt(T * p, size_t size, size_t capacity,
+                deleter_type deleter = NULL, void * context = NULL);
+
+   // give the buffer away, leaving the vector empty
+   buffer release();
+
 #ifdef DEBUG // make this visible to the unit tests
 public:
 #else
 private:
 #endif
    
+   // free the buffer the way it was allocated
+   void freeBuffer()
+   {
+      buffer b = { data, numElements, numCapacity, deleter, context };
+      b.free();
+      data = NULL;
+      deleter = NULL;
+      context = NULL;
+   }
+
    T *  data;                 // user data, a dynamically-allocated array
    size_t  numCapacity;       // the capacity of the array
    size_t  numElements;       // the number of items currently used
+   deleter_type deleter;      // how to free data, or NULL for delete []
+   void *  context;           // what the deleter needs
 };
 
 /*****************************************
@@ -152,6 +222,8 @@ vector <T> :: vector()
    data = NULL;
    numCapacity = 0;
    numElements = 0;
+   deleter = NULL;
+   context = NULL;
 }
 
 /*****************************************
@@ -162,6 +234,8 @@ vector <T> :: vector()
 template <typename T>
 vector <T> :: vector(size_t num, const T & t) 
 {
+    deleter = NULL;
+    context = NULL;
     data = new T[num];
     numCapacity = num;
     numElements = num;
@@ -177,6 +251,8 @@ vector <T> :: vector(size_t num, const T & t)
 template <typename T>
 vector <T> :: vector(const std::initializer_list<T> & l) 
 {   
+   deleter = NULL;
+   context = NULL;
    numCapacity = l.size();
    numElements = 0;
    data = new T[numCapacity];
@@ -194,11 +270,16 @@ vector <T> :: vector(const std::initializer_list<T> & l)
 template <typename T>
 vector <T> :: vector(size_t num) 
 {
+    deleter = NULL;
+    context = NULL;
+    numCapacity = 0;
+    numElements = 0;
     if (num == 0) {
         data = NULL;
         return;
     }
     data = new T[num];
+    numCapacity = num;
     resize(num);
 }
 
@@ -210,6 +291,11 @@ vector <T> :: vector(size_t num)
 template <typename T>
 vector <T> :: vector (const vector & rhs) 
 {
+    deleter = NULL;
+    context = NULL;
+    data = NULL;
+    numCapacity = 0;
+    numElements = 0;
     if (rhs.data == NULL) {
         data = NULL;
         return;
@@ -231,9 +317,13 @@ vector <T> :: vector (vector && rhs)
     numElements = rhs.numElements;
     rhs.numElements = 0;
     
-    if (rhs.numCapacity > numCapacity)
-        numCapacity = rhs.numCapacity;
+    numCapacity = rhs.numCapacity;
     rhs.numCapacity = 0;
+
+    deleter = rhs.deleter;
+    rhs.deleter = NULL;
+    context = rhs.context;
+    rhs.context = NULL;
 }
 
 /*****************************************
@@ -244,12 +334,9 @@ vector <T> :: vector (vector && rhs)
 template <typename T>
 vector <T> :: ~vector()
 {
-    data = NULL;
+    freeBuffer();
     numCapacity = 0;
-    if (numElements > 0) {
-        numElements = 0; // Set to 0
-    }
-    delete[] data;
+    numElements = 0;
 }
 
 /***************************************
@@ -302,7 +389,7 @@ void vector <T> :: reserve(size_t newCapacity)
     for (int i = 0; i < numElements; i++) {
         dataNew[i] = data[i];
     }
-    delete [] data;
+    freeBuffer();
     
     data = dataNew;
     numCapacity = newCapacity;
@@ -319,13 +406,136 @@ void vector <T> :: shrink_to_fit()
 {
     if (numElements == 0) {
         numCapacity = 0;
-        data = NULL;
+        freeBuffer();
         return;
     }
 
     numCapacity = numElements;
 }
 
+/***************************************
+ * VECTOR :: ADOPT
+ * Take over a buffer someone else allocated.
+ * All capacity elements must be constructed;
+ * the first size of them are in use. When the
+ * vector is done with it (destroyed, grown, or
+ * shrunk to nothing) the buffer goes to
+ * deleter, or to delete [] if there is none.
+ *     INPUT  : p        the buffer
+ *              size     the elements in use
+ *              capacity the elements in the buffer
+ *              deleter  how to free it, and the context it needs
+ *     OUTPUT :
+ **************************************/
+template <typename T>
+void vector <T> :: adopt(T * p, size_t size, size_t capacity,
+                         deleter_type deleter, void * context)
+{
+    assert(size <= capacity);
+    assert(p != NULL || capacity == 0);
+    if (p == data)
+        return;
+
+    freeBuffer();
+    data = p;
+    numElements = size;
+    numCapacity = capacity;
+    this->deleter = deleter;
+    this->context = context;
+}
+
+/***************************************
+ * VECTOR :: RELEASE
+ * Give the buffer away without copying it.
+ * The caller frees it with buffer::free(), or
+ * however the deleter says to.
+ *     INPUT  :
+ *     OUTPUT : the buffer and how to free it
+ **************************************/
+template <typename T>
+typename vector <T> :: buffer vector <T> :: release()
+{
+    buffer b = { data, numElements, numCapacity, deleter, context };
+    data = NULL;
+    numElements = 0;
+    numCapacity = 0;
+    deleter = NULL;
+    context = NULL;
+    return b;
+}
+
+/***************************************
+ * STD VECTOR DELETER
+ * The deleter for a buffer that still belongs
+ * to a std::vector, kept alive on the heap
+ **************************************/
+template <typename T>
+void std_vector_deleter(T *, void * context)
+{
+    delete static_cast<std::vector<T> *>(context);
+}
+
+/***************************************
+ * FROM STD
+ * Turn a std::vector into one of ours without
+ * copying. The std::vector moves to the heap
+ * (a move keeps its buffer) and our vector
+ * adopts that buffer, freeing the std::vector
+ * when it is done. The spare capacity is
+ * constructed first, since we assume every
+ * slot in the buffer holds a T.
+ *
+ * This works for std::vector<T> with its
+ * default std::allocator, or any allocator
+ * whose move constructor keeps the buffer.
+ **************************************/
+template <typename T>
+vector <T> from_std(std::vector <T> && v)
+{
+    vector <T> vNew;
+    if (v.capacity() == 0)
+        return vNew;
+
+    std::vector <T> * pHeld = new std::vector <T> (std::move(v));
+    size_t size = pHeld->size();
+    pHeld->resize(pHeld->capacity());   // no reallocation: it fits
+    vNew.adopt(pHeld->data(), size, pHeld->capacity(), &std_vector_deleter<T>, pHeld);
+    return vNew;
+}
+
+/***************************************
+ * TO STD
+ * Turn one of our vectors into a std::vector.
+ * A buffer that came from from_std() goes
+ * back to its std::vector without copying.
+ * Any other buffer was not allocated by
+ * std::allocator, and std::vector cannot take
+ * over memory its allocator did not allocate,
+ * so the elements are moved (not copied) into
+ * a new std::vector.
+ **************************************/
+template <typename T>
+std::vector <T> to_std(vector <T> && v)
+{
+    typename vector <T> :: buffer b = v.release();
+    if (b.deleter == &std_vector_deleter<T>)
+    {
+        std::vector <T> * pHeld = static_cast<std::vector <T> *>(b.context);
+        assert(pHeld->data() == b.data);
+        pHeld->resize(b.size);
+        std::vector <T> vNew(std::move(*pHeld));
+        delete pHeld;
+        return vNew;
+    }
+
+    std::vector <T> vNew;
+    vNew.reserve(b.size);
+    for (size_t i = 0; i < b.size; i++)
+        vNew.push_back(std::move(b.data[i]));
+    b.free();
+    return vNew;
+}
+
 /*****************************************
  * VECTOR :: SUBSCRIPT
  * Read-Write access
@@ -387,6 +597,29 @@ const T & vector <T> :: back() const
     return data[numElements - 1];
 }
 
+/******************************************
+ * VECTOR :: SLICE
+ * A span of [start, start + count). It is
+ * only good until the buffer is reallocated.
+ *****************************************/
+template <typename T>
+span<T> vector <T> :: slice(size_t start, size_t count)
+{
+    assert(start <= numElements && count <= numElements - start);
+    return span<T>(data + start, count);
+}
+
+/******************************************
+ * VECTOR :: SLICE
+ * Read-only view
+ *****************************************/
+template <typename T>
+span<const T> vector <T> :: slice(size_t start, size_t count) const
+{
+    assert(start <= numElements && count <= numElements - start);
+    return span<const T>(data + start, count);
+}
+
 /***************************************
  * VECTOR :: PUSH BACK
  * This method will add the element 't' to the
@@ -464,7 +697,7 @@ vector <T>& vector <T> :: operator = (vector&& rhs)
     }
 
     numElements = rhs.numElements;
-    rhs.data = NULL;
+    rhs.freeBuffer();
     rhs.numElements = 0;
     
     return *this;
@@ -0,0 +1,487 @@
+/***********************************************************************
+ * Header:
+ *    VECTOR PATCH
+ * Summary:
+ *    The difference between two versions of a vector, small enough to
+ *    send to a standby copy instead of the whole vector. diff(a, b) walks
+ *    both vectors side by side and describes b as a list of operations
+ *    on a:
+ *       KEEP    count          leave count elements of a as they are
+ *       REPLACE count          overwrite count elements with the next literals
+ *       FILL    count          overwrite count elements with one literal
+ *       COPY    count source   copy count elements from a[source]
+ *    Growing or shrinking is carried by newSize. When the sizes differ,
+ *    the longest run at the back of both is found first, so what follows
+ *    an insert or a delete is one COPY from where it used to be rather
+ *    than literals. apply(a, patch) edits a in place, reallocating at
+ *    most once.
+ *
+ *    For a trivially copyable T, the unchanged runs are found by comparing
+ *    bytes sixteen at a time with SSE2, or thirty-two at a time when the
+ *    CPU we are running on turns out to have AVX2.
+ *
+ *    This will contain:
+ *        patch                  : The operations that turn a into b
+ *        diff                   : Build a patch
+ *        apply                  : Play a patch onto a vector
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // because I am paranoid
+#include <cstdint>     // for uint32_t and uint64_t
+#include <cstring>     // for memcmp and memcpy
+#include <stdexcept>   // for std::runtime_error
+#include <type_traits> // for std::is_trivially_copyable
+#include <vector>      // for the operations and the literals
+
+#include "cpu_features.h" // for simd::active_level
+#include "vector.h"
+
+#if defined(__SSE2__) || defined(CUSTOM_SIMD_X86)
+#include <immintrin.h> // for _mm_cmpeq_epi8 and friends
+#endif
+
+namespace custom
+{
+
+/*****************************************
+ * PATCH
+ * Everything needed to turn a vector of
+ * oldSize elements into the new version
+ ****************************************/
+template <typename T>
+struct patch
+{
+   enum { KEEP, REPLACE, FILL, COPY };
+
+   struct op
+   {
+      uint32_t kind;
+      uint32_t padding;
+      uint64_t count;
+      uint64_t source;   // where a COPY reads from in the old vector
+   };
+
+   patch() : oldSize(0), newSize(0) { }
+
+   // what this patch costs to send
+   size_t size_bytes() const
+   {
+      return 2 * sizeof(uint64_t) + ops.size() * sizeof(op) + literals.size() * sizeof(T);
+   }
+
+   uint64_t        oldSize;    // the patch only fits a vector this size
+   uint64_t        newSize;    // the size after the patch
+   std::vector<op> ops;        // what to do, in order. COPY sources only go up.
+   std::vector<T>  literals;   // the new elements REPLACE and FILL use
+};
+
+namespace patch_detail
+{
+   // a word at a time from i, then the last few bytes
+   inline size_t matchingWords(const unsigned char * a, const unsigned char * b,
+                               size_t i, size_t numBytes)
+   {
+      for (; i + 8 <= numBytes; i += 8)
+      {
+         uint64_t x;
+         uint64_t y;
+         memcpy(&x, a + i, 8);
+         memcpy(&y, b + i, 8);
+         if (x != y)
+            break;
+      }
+      while (i < numBytes && a[i] == b[i])
+         i++;
+      return i;
+   }
+
+   // sixteen bytes at a time where there is SSE2
+   inline size_t matchingSse2(const void * p, const void * q, size_t numBytes)
+   {
+      const unsigned char * a = static_cast<const unsigned char *>(p);
+      const unsigned char * b = static_cast<const unsigned char *>(q);
+      size_t i = 0;
+#if defined(__SSE2__)
+      for (; i + 16 <= numBytes; i += 16)
+      {
+         __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+         __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+         uint32_t same = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+         if (same != 0xffffu)
+            return i + __builtin_ctz(~same);
+      }
+#endif
+      return matchingWords(a, b, i, numBytes);
+   }
+
+#ifdef CUSTOM_SIMD_X86
+   // thirty-two bytes at a time, for a CPU with AVX2 whatever we were built for
+   __attribute__((target("avx2")))
+   inline size_t matchingAvx2(const void * p, const void * q, size_t numBytes)
+   {
+      const unsigned char * a = static_cast<const unsigned char *>(p);
+      const unsigned char * b = static_cast<const unsigned char *>(q);
+      size_t i = 0;
+      for (; i + 32 <= numBytes; i += 32)
+      {
+         __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+         __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+         uint32_t same = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+         if (same != 0xffffffffu)
+            return i + __builtin_ctz(~same);
+      }
+      return i + matchingSse2(a + i, b + i, numBytes - i);
+   }
+#endif // CUSTOM_SIMD_X86
+
+   typedef size_t (*matching_fn)(const void *, const void *, size_t);
+
+   // the best of the above for simd level l
+   inline matching_fn matchingAt(simd::level l)
+   {
+#ifdef CUSTOM_SIMD_X86
+      if (l >= simd::AVX2)
+         return &matchingAvx2;
+#else
+      (void)l;
+#endif
+      return &matchingSse2;
+   }
+} // namespace patch_detail
+
+/*****************************************
+ * MATCHING BYTES
+ * How many bytes at the front of p and q are
+ * the same. Which version runs is bound the
+ * first time it is called.
+ ****************************************/
+inline size_t matching_bytes(const void * p, const void * q, size_t numBytes)
+{
+   static const patch_detail::matching_fn bound = patch_detail::matchingAt(simd::active_level());
+   return bound(p, q, numBytes);
+}
+
+/*****************************************
+ * PATCH DETAIL
+ * Element comparisons: bytes for a trivially
+ * copyable T, operator == for everything else
+ ****************************************/
+namespace patch_detail
+{
+   template <typename T>
+   bool same(const T & a, const T & b, std::true_type)
+   {
+      return memcmp(&a, &b, sizeof(T)) == 0;
+   }
+   template <typename T>
+   bool same(const T & a, const T & b, std::false_type)
+   {
+      return a == b;
+   }
+   template <typename T>
+   bool same(const T & a, const T & b)
+   {
+      return same(a, b, std::is_trivially_copyable<T>());
+   }
+
+   // how many elements at the front of a and b are the same
+   template <typename T>
+   size_t matching(const T * a, const T * b, size_t num, std::true_type)
+   {
+      return matching_bytes(a, b, num * sizeof(T)) / sizeof(T);
+   }
+   template <typename T>
+   size_t matching(const T * a, const T * b, size_t num, std::false_type)
+   {
+      size_t i = 0;
+      while (i < num && a[i] == b[i])
+         i++;
+      return i;
+   }
+   template <typename T>
+   size_t matching(const T * a, const T * b, size_t num)
+   {
+      return matching(a, b, num, std::is_trivially_copyable<T>());
+   }
+
+   // count elements from v[from] to v[to], which may overlap
+   template <typename T>
+   void move(vector<T> & v, size_t to, size_t from, size_t count, std::true_type)
+   {
+      if (count)
+         memmove(&v[to], &v[from], count * sizeof(T));
+   }
+   template <typename T>
+   void move(vector<T> & v, size_t to, size_t from, size_t count, std::false_type)
+   {
+      if (from > to)
+         for (size_t j = 0; j < count; j++)
+            v[to + j] = v[from + j];
+      else
+         for (size_t j = count; j-- > 0; )
+            v[to + j] = v[from + j];
+   }
+   template <typename T>
+   void move(vector<T> & v, size_t to, size_t from, size_t count)
+   {
+      move(v, to, from, count, std::is_trivially_copyable<T>());
+   }
+
+   // how many elements at the back of a and b are the same, a block at a time
+   template <typename T>
+   size_t matchingBack(const T * a, const T * b, size_t num)
+   {
+      const size_t BLOCK = 64;
+      size_t match = 0;
+      while (match < num)
+      {
+         size_t step = num - match < BLOCK ? num - match : BLOCK;
+         const T * pa = a - match - step;
+         const T * pb = b - match - step;
+         if (matching(pa, pb, step) == step)
+         {
+            match += step;
+            continue;
+         }
+         while (same(pa[step - 1], pb[step - 1]))
+         {
+            match++;
+            step--;
+         }
+         break;
+      }
+      return match;
+   }
+
+   // add an operation, merging it with the last one when we can
+   template <typename T>
+   void addOp(patch<T> & p, uint32_t kind, size_t count)
+   {
+      if (count == 0)
+         return;
+      if (kind != patch<T>::FILL && kind != patch<T>::COPY &&
+          !p.ops.empty() && p.ops.back().kind == kind)
+      {
+         p.ops.back().count += count;
+         return;
+      }
+      typename patch<T>::op o = {};
+      o.kind  = kind;
+      o.count = count;
+      p.ops.push_back(o);
+   }
+
+   // describe b[first, last) with REPLACE and FILL
+   template <typename T>
+   void addLiterals(patch<T> & p, const T * b, size_t first, size_t last)
+   {
+      // a run must save more than the operations it adds to be worth a FILL
+      const size_t minFill = 2 * sizeof(typename patch<T>::op) / sizeof(T) + 2;
+
+      size_t start = first;   // the start of the pending REPLACE
+      for (size_t i = first; i < last; )
+      {
+         size_t run = 1;
+         while (i + run < last && same(b[i + run], b[i]))
+            run++;
+
+         if (run >= minFill)
+         {
+            addOp(p, patch<T>::REPLACE, i - start);
+            p.literals.insert(p.literals.end(), b + start, b + i);
+            addOp(p, patch<T>::FILL, run);
+            p.literals.push_back(b[i]);
+            start = i + run;
+         }
+         i += run;
+      }
+      addOp(p, patch<T>::REPLACE, last - start);
+      p.literals.insert(p.literals.end(), b + start, b + last);
+   }
+}
+
+namespace patch_detail
+{
+   // describe b[0, num) against a[0, num) with KEEP, REPLACE and FILL
+   template <typename T>
+   void positional(patch<T> & p, const T * pa, const T * pb, size_t num)
+   {
+      // a short unchanged run costs more as a KEEP than as part of a REPLACE
+      const size_t minKeep = 2 * sizeof(typename patch<T>::op) / sizeof(T) + 1;
+
+      size_t i = 0;
+      while (i < num)
+      {
+         // the unchanged run
+         size_t keep = matching(pa + i, pb + i, num - i);
+         addOp(p, patch<T>::KEEP, keep);
+         i += keep;
+         if (i == num)
+            break;
+
+         // the changed run, up to the next unchanged run worth keeping
+         size_t first = i;
+         while (i < num)
+         {
+            if (!same(pa[i], pb[i]))
+            {
+               i++;
+               continue;
+            }
+            size_t run = matching(pa + i, pb + i, num - i);
+            if (run >= minKeep || i + run == num)
+               break;
+            i += run;
+         }
+         addLiterals(p, pb, first, i);
+      }
+   }
+}
+
+/*****************************************
+ * DIFF
+ * The patch that turns a into b. The front
+ * is compared place by place. When the sizes
+ * differ, a run matching at the back of both
+ * becomes a COPY, so an insert or a delete
+ * costs only what changed.
+ ****************************************/
+template <typename T>
+patch<T> diff(const vector<T> & a, const vector<T> & b)
+{
+   patch<T> p;
+   p.oldSize = a.size();
+   p.newSize = b.size();
+   if (b.size() == 0)
+      return p;
+
+   const size_t minCopy = 2 * sizeof(typename patch<T>::op) / sizeof(T) + 1;
+
+   const T * pa = a.size() ? &a[0] : nullptr;
+   const T * pb = &b[0];
+   const size_t common = a.size() < b.size() ? a.size() : b.size();
+
+   // the shifted run at the back, not counting what already matches in front
+   size_t suffix = 0;
+   if (a.size() != b.size() && common > 0)
+   {
+      size_t prefix = patch_detail::matching(pa, pb, common);
+      suffix = patch_detail::matchingBack(pa + a.size(), pb + b.size(), common - prefix);
+      if (suffix < minCopy)
+         suffix = 0;
+   }
+   const size_t endA = a.size() - suffix;
+   const size_t endB = b.size() - suffix;
+   const size_t front = endA < endB ? endA : endB;
+
+   patch_detail::positional(p, pa, pb, front);
+
+   // anything else in front of the shifted run is new
+   patch_detail::addLiterals(p, pb, front, endB);
+
+   if (suffix)
+   {
+      patch_detail::addOp(p, patch<T>::COPY, suffix);
+      p.ops.back().source = endA;
+   }
+   return p;
+}
+
+/*****************************************
+ * APPLY
+ * Edit v in place to match the patch. The
+ * patch is checked before v is touched, and
+ * v is reallocated at most once.
+ *
+ * Every COPY reads from the old vector, so
+ * they all run before any literal lands. As
+ * their sources only go up, the ones moving
+ * elements down run front to back and the
+ * ones moving them up run back to front, and
+ * none writes over what another still reads.
+ ****************************************/
+template <typename T>
+void apply(vector<T> & v, const patch<T> & p)
+{
+   typedef typename patch<T>::op op;
+
+   if (v.size() != p.oldSize)
+      throw std::runtime_error("patch: the vector is not the one the patch was made from");
+
+   // the operations must cover newSize and use every literal
+   uint64_t numCovered = 0;
+   uint64_t numLiterals = 0;
+   uint64_t nextSource = 0;
+   for (size_t i = 0; i < p.ops.size(); i++)
+   {
+      const op & o = p.ops[i];
+      if (o.kind == patch<T>::KEEP && numCovered + o.count > p.oldSize)
+         throw std::runtime_error("patch: KEEP past the end of the vector");
+      if (o.kind == patch<T>::REPLACE)
+         numLiterals += o.count;
+      else if (o.kind == patch<T>::FILL)
+         numLiterals++;
+      else if (o.kind == patch<T>::COPY)
+      {
+         if (o.source > p.oldSize || o.count > p.oldSize - o.source)
+            throw std::runtime_error("patch: COPY past the end of the vector");
+         if (o.source < nextSource)
+            throw std::runtime_error("patch: COPY sources out of order");
+         nextSource = o.source + o.count;
+      }
+      else if (o.kind != patch<T>::KEEP)
+         throw std::runtime_error("patch: unknown operation");
+      numCovered += o.count;
+   }
+   if (numCovered != p.newSize || numLiterals != p.literals.size())
+      throw std::runtime_error("patch: the operations do not match the sizes");
+
+   // the one reallocation, if any. Shrinking waits until the copies are done.
+   if (p.newSize > p.oldSize)
+      v.resize(size_t(p.newSize), T());
+
+   // the copies that move elements down, front to back
+   size_t index = 0;
+   for (size_t i = 0; i < p.ops.size(); i++)
+   {
+      const op & o = p.ops[i];
+      if (o.kind == patch<T>::COPY && o.source > index)
+         patch_detail::move(v, index, size_t(o.source), size_t(o.count));
+      index += size_t(o.count);
+   }
+
+   // the copies that move elements up, back to front
+   for (size_t i = p.ops.size(); i-- > 0; )
+   {
+      const op & o = p.ops[i];
+      index -= size_t(o.count);
+      if (o.kind == patch<T>::COPY && o.source < index)
+         patch_detail::move(v, index, size_t(o.source), size_t(o.count));
+   }
+
+   // then the literals
+   const T * literal = p.literals.empty() ? nullptr : &p.literals[0];
+   for (size_t i = 0; i < p.ops.size(); i++)
+   {
+      const op & o = p.ops[i];
+      if (o.kind == patch<T>::REPLACE)
+         for (uint64_t j = 0; j < o.count; j++)
+            v[index + j] = *literal++;
+      else if (o.kind == patch<T>::FILL)
+      {
+         for (uint64_t j = 0; j < o.count; j++)
+            v[index + j] = *literal;
+         literal++;
+      }
+      index += size_t(o.count);
+   }
+
+   if (p.newSize < p.oldSize)
+      v.resize(size_t(p.newSize), T());
+}
+
+} // namespace custom
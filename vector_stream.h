@@ -0,0 +1,455 @@
+/***********************************************************************
+ * Header:
+ *    VECTOR STREAM
+ * Summary:
+ *    Read and write a sequence of elements that may be far larger than
+ *    memory, one batch at a time. The file is a short header followed by
+ *    any number of chunks, each a count, a checksum, and raw elements:
+ *
+ *       +-------+---------+-------+--------+-------------+
+ *       | magic | version | flags | endian | elementSize |
+ *       +-------+---------+-------+--------+-------------+
+ *       | count | checksum | element 0 ... element count-1 |   chunk
+ *       +-------+----------+-------------------------------+
+ *       | count | checksum | element 0 ... element count-1 |   chunk
+ *       +-------+----------+-------------------------------+
+ *
+ *    The reader hands out batches of a fixed size no matter how the
+ *    writer chunked them. With prefetching on, a background thread fills
+ *    the next batch while the caller works on this one.
+ *
+ *    This will contain the class definitions of:
+ *        vector_stream_writer   : Append elements, flushing full batches
+ *        vector_stream_reader   : Fill a reusable vector with the next batch
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell, Corbin Layton
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>            // because I am paranoid
+#include <condition_variable> // for the prefetch hand-off
+#include <cstdint>            // for uint64_t
+#include <exception>          // for std::exception_ptr
+#include <mutex>
+#include <stdexcept>          // for std::runtime_error
+#include <string>
+#include <thread>
+#include <type_traits>        // for std::is_trivially_copyable
+
+#include "serialize.h"        // for checksum, writeAll, and readUpTo
+#include "vector.h"
+
+namespace custom
+{
+
+/*****************************************
+ * STREAM HEADER
+ * The first 16 bytes of the file
+ ****************************************/
+struct stream_header
+{
+   enum { MAGIC = 0x54535643,   // "CVST"
+          VERSION = 1 };
+
+   uint32_t magic;
+   uint16_t version;
+   uint16_t flags;
+   uint32_t endian;
+   uint32_t elementSize;
+};
+static_assert(sizeof(stream_header) == 16, "the header must be 16 bytes");
+
+/*****************************************
+ * CHUNK HEADER
+ * In front of every chunk of elements
+ ****************************************/
+struct chunk_header
+{
+   uint64_t count;
+   uint64_t checksum;
+};
+
+/*****************************************
+ * VECTOR STREAM WRITER
+ * Collects elements in a batch and writes
+ * the batch out as a chunk when it is full
+ ****************************************/
+template <typename T>
+class vector_stream_writer
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "vector streams need a trivially copyable T");
+
+public:
+   vector_stream_writer(const std::string & fileName, size_t batchSize);
+   vector_stream_writer(const vector_stream_writer & rhs) = delete;
+   vector_stream_writer & operator = (const vector_stream_writer & rhs) = delete;
+   ~vector_stream_writer();
+
+   // add one element, writing a chunk if the batch fills up
+   void push_back(const T & t)
+   {
+      batch.push_back(t);
+      if (batch.size() == batchSize)
+         flush();
+   }
+
+   // write a whole batch as one chunk
+   void write(const vector<T> & v);
+
+   // write whatever is in the batch, then close the file
+   void flush();
+   void close();
+
+   size_t batch_size() const { return batchSize; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   void writeChunk(const T * p, size_t num);
+
+   int       fd;              // the open file, or -1
+   size_t    batchSize;       // the number of elements in a full batch
+   vector<T> batch;           // elements waiting to be written
+};
+
+/*****************************************
+ * VECTOR STREAM WRITER :: CONSTRUCTOR
+ * Create the file and write its header
+ ****************************************/
+template <typename T>
+vector_stream_writer <T> :: vector_stream_writer(const std::string & fileName,
+                                                 size_t batchSize) :
+   fd(-1), batchSize(batchSize)
+{
+   assert(batchSize > 0);
+#ifdef _WIN32
+   fd = _open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+   fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("vector_stream: unable to create " + fileName);
+
+   stream_header header = {};
+   header.magic       = stream_header::MAGIC;
+   header.version     = stream_header::VERSION;
+   header.endian      = serial_header::ENDIAN;
+   header.elementSize = uint32_t(sizeof(T));
+   writeAll(fd, &header, sizeof(header), nullptr, 0);
+
+   batch.reserve(batchSize);
+}
+
+/*****************************************
+ * VECTOR STREAM WRITER :: DESTRUCTOR
+ ****************************************/
+template <typename T>
+vector_stream_writer <T> :: ~vector_stream_writer()
+{
+   try
+   {
+      close();
+   }
+   catch (...)
+   {
+      // nowhere to report it from a destructor
+   }
+}
+
+/*****************************************
+ * VECTOR STREAM WRITER :: WRITE
+ * Anything already waiting goes out first
+ * so the elements stay in order
+ ****************************************/
+template <typename T>
+void vector_stream_writer <T> :: write(const vector<T> & v)
+{
+   flush();
+   if (v.size())
+      writeChunk(&v[0], v.size());
+}
+
+/*****************************************
+ * VECTOR STREAM WRITER :: FLUSH
+ * Write the batch, keeping its buffer
+ ****************************************/
+template <typename T>
+void vector_stream_writer <T> :: flush()
+{
+   if (batch.size() == 0)
+      return;
+   writeChunk(&batch[0], batch.size());
+   batch.clear();
+}
+
+/*****************************************
+ * VECTOR STREAM WRITER :: CLOSE
+ ****************************************/
+template <typename T>
+void vector_stream_writer <T> :: close()
+{
+   if (fd == -1)
+      return;
+   flush();
+   ::close(fd);
+   fd = -1;
+}
+
+/*****************************************
+ * VECTOR STREAM WRITER :: WRITE CHUNK
+ * The chunk header and elements in one writev()
+ ****************************************/
+template <typename T>
+void vector_stream_writer <T> :: writeChunk(const T * p, size_t num)
+{
+   if (fd == -1)
+      throw std::runtime_error("vector_stream: the writer is closed");
+
+   chunk_header header;
+   header.count    = num;
+   header.checksum = checksum(p, num * sizeof(T));
+   writeAll(fd, &header, sizeof(header), p, num * sizeof(T));
+}
+
+/*****************************************
+ * VECTOR STREAM READER
+ * Fills the caller's vector with the next
+ * batchSize elements. Once the caller's vector
+ * has the capacity for a batch it is never
+ * reallocated: with prefetching, next() swaps
+ * it with the batch the background thread
+ * just read, and the thread refills it.
+ ****************************************/
+template <typename T>
+class vector_stream_reader
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "vector streams need a trivially copyable T");
+
+public:
+   vector_stream_reader(const std::string & fileName, size_t batchSize,
+                        bool prefetch = true);
+   vector_stream_reader(const vector_stream_reader & rhs) = delete;
+   vector_stream_reader & operator = (const vector_stream_reader & rhs) = delete;
+   ~vector_stream_reader();
+
+   // put the next batch in v. Returns false when there is nothing left.
+   bool next(vector<T> & v);
+
+   size_t batch_size() const { return batchSize; }
+
+#ifdef DEBUG // make this visible to the unit tests
+public:
+#else
+private:
+#endif
+   size_t fill(vector<T> & v);
+   void   prefetchThread();
+
+   int              fd;             // the open file
+   size_t           batchSize;      // the number of elements in a full batch
+   uint64_t         chunkLeft;      // elements not yet read from this chunk
+   uint64_t         chunkChecksum;  // what this chunk should add up to
+   checksum_builder chunkHash;      // what it adds up to so far
+
+   // the background reader
+   bool                    prefetch;
+   std::thread             thread;
+   std::mutex              mutex;
+   std::condition_variable cv;
+   vector<T>               buffer;  // the batch the thread filled
+   bool                    ready;   // buffer holds a batch the caller has not taken
+   bool                    stop;    // the reader is being destroyed
+   std::exception_ptr      error;   // what went wrong in the thread
+};
+
+/*****************************************
+ * VECTOR STREAM READER :: CONSTRUCTOR
+ * Open the file, check the header, and start
+ * the background reader
+ ****************************************/
+template <typename T>
+vector_stream_reader <T> :: vector_stream_reader(const std::string & fileName,
+                                                 size_t batchSize, bool prefetch) :
+   fd(-1), batchSize(batchSize), chunkLeft(0), chunkChecksum(0),
+   prefetch(prefetch), ready(false), stop(false)
+{
+   assert(batchSize > 0);
+#ifdef _WIN32
+   fd = _open(fileName.c_str(), _O_RDONLY | _O_BINARY);
+#else
+   fd = open(fileName.c_str(), O_RDONLY);
+#endif
+   if (fd == -1)
+      throw std::runtime_error("vector_stream: unable to open " + fileName);
+
+   stream_header header;
+   try
+   {
+      readAll(fd, &header, sizeof(header));
+   }
+   catch (...)
+   {
+      ::close(fd);
+      throw;
+   }
+   const char * problem = nullptr;
+   if (header.magic != stream_header::MAGIC)
+      problem = "vector_stream: not a stream file";
+   else if (header.endian != serial_header::ENDIAN)
+      problem = "vector_stream: written on a machine of the other endianness";
+   else if (header.version != stream_header::VERSION)
+      problem = "vector_stream: unknown version";
+   else if (header.elementSize != sizeof(T))
+      problem = "vector_stream: element size does not match";
+   if (problem)
+   {
+      ::close(fd);
+      throw std::runtime_error(problem);
+   }
+
+   if (prefetch)
+   {
+      buffer.reserve(batchSize);
+      thread = std::thread(&vector_stream_reader::prefetchThread, this);
+   }
+}
+
+/*****************************************
+ * VECTOR STREAM READER :: DESTRUCTOR
+ * Stop the background reader first
+ ****************************************/
+template <typename T>
+vector_stream_reader <T> :: ~vector_stream_reader()
+{
+   if (thread.joinable())
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stop = true;
+      }
+      cv.notify_all();
+      thread.join();
+   }
+   ::close(fd);
+}
+
+/*****************************************
+ * VECTOR STREAM READER :: NEXT
+ ****************************************/
+template <typename T>
+bool vector_stream_reader <T> :: next(vector<T> & v)
+{
+   if (!prefetch)
+      return fill(v) > 0;
+
+   // wait for the background reader to have a batch
+   std::unique_lock<std::mutex> lock(mutex);
+   cv.wait(lock, [this] { return ready || error; });
+   if (error)
+      std::rethrow_exception(error);
+   if (buffer.size() == 0)
+      return false;   // leave "ready" set: we are at the end for good
+
+   // trade the caller's buffer for the full one and let the thread refill it
+   v.swap(buffer);
+   ready = false;
+   lock.unlock();
+   cv.notify_all();
+   return true;
+}
+
+/*****************************************
+ * VECTOR STREAM READER :: FILL
+ * Read up to batchSize elements straight into
+ * v, crossing chunk boundaries as needed.
+ * Returns the number of elements read.
+ ****************************************/
+template <typename T>
+size_t vector_stream_reader <T> :: fill(vector<T> & v)
+{
+   // only the very first batch (or a short last one) changes the size
+   v.reserve(batchSize);
+   if (v.size() != batchSize)
+      v.resize(batchSize, T());
+
+   size_t numRead = 0;
+   while (numRead < batchSize)
+   {
+      // start the next chunk
+      if (chunkLeft == 0)
+      {
+         chunk_header header;
+         if (!readUpTo(fd, &header, sizeof(header)))
+            break;
+         chunkLeft     = header.count;
+         chunkChecksum = header.checksum;
+         chunkHash     = checksum_builder();
+         if (chunkLeft == 0)
+            continue;
+      }
+
+      size_t num = batchSize - numRead;
+      if (num > chunkLeft)
+         num = size_t(chunkLeft);
+      readAll(fd, &v[numRead], num * sizeof(T));
+      chunkHash.update(&v[numRead], num * sizeof(T));
+      numRead   += num;
+      chunkLeft -= num;
+
+      // the whole chunk is in: does it add up?
+      if (chunkLeft == 0 && chunkHash.finish() != chunkChecksum)
+         throw std::runtime_error("vector_stream: checksum mismatch");
+   }
+
+   if (numRead != batchSize)
+      v.resize(numRead, T());
+   return numRead;
+}
+
+/*****************************************
+ * VECTOR STREAM READER :: PREFETCH THREAD
+ * Keep one batch read ahead of the caller
+ ****************************************/
+template <typename T>
+void vector_stream_reader <T> :: prefetchThread()
+{
+   for (;;)
+   {
+      // wait for the caller to take the last batch
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         cv.wait(lock, [this] { return !ready || stop; });
+         if (stop)
+            return;
+      }
+
+      // read without holding the lock so the caller can keep working
+      size_t numRead = 0;
+      std::exception_ptr failure;
+      try
+      {
+         numRead = fill(buffer);
+      }
+      catch (...)
+      {
+         failure = std::current_exception();
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         ready = true;
+         error = failure;
+      }
+      cv.notify_all();
+
+      if (numRead == 0 || failure)
+         return;
+   }
+}
+
+} // namespace custom